@@ -1,3 +1,9 @@
 /* ../source/area.c */
 double catchment_area(catchment *c, section *mouth, int direction, int max_steps, double step_size, int n_stream, path **streamline, bem_vectors *vectors);
+void set_mouth_tolerance(double tol);
+double get_mouth_tolerance(void);
+double catchment_area_adaptive(catchment *c, section *mouth, int direction, int max_steps, double step_size, double area_tol, int *n_stream, path ***streamline, bem_vectors *vectors);
 double Cal_SCA(catchment *c, section *mouth, int direction, int max_steps, double step_size, int n_stream, path **streamline, bem_vectors *vectors);
+void set_area_method(int method);
+int get_area_method(void);
+double catchment_area_bounding(catchment *c, section *mouth, int direction, int max_steps, double step_size, path **streamline, bem_vectors *vectors);
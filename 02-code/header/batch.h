@@ -0,0 +1,3 @@
+/* ../source/batch.c */
+void calculate_batch_in_zone(boundary *b, int m, coordinates *Q, bem_vectors *x, bem_results *R, int mask);
+void calculate_batch(catchment *c, int n, coordinates *P, bem_vectors *vectors, bem_results *R, int *new_z, int mask);
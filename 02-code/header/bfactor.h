@@ -0,0 +1,10 @@
+/* ../source/bfactor.c */
+void set_update_limit(double fraction);
+double get_update_limit(void);
+zone_factor *factor_zone(boundary *b);
+void destroy_zone_factor(zone_factor *f);
+int update_zone_factor(zone_factor *f);
+void zone_voltage_vector(zone_factor *f, double *bvv);
+void solve_zone_block(zone_factor *f, int K, double *bvv, double *bcv);
+void save_zone_factor(zone_factor *f);
+zone_factor *read_zone_factor(boundary *b);
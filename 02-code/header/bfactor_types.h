@@ -0,0 +1,32 @@
+/*----------------------------------------------------------------------------------*/
+/*------------------------------- bfactor_types.h ----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* structure for holding the factorization of one zone */
+/* bcv = (BT*B)^-1 * BT*DA * bvv, where only bvv depends on the path values.        */
+/* BT*B is kept as its Cholesky factor U (or as LU with pivots if it is not         */
+/* numerically positive definite). Matrices are column major.                       */
+/* After points of the zone have moved, update_zone_factor keeps the same U and     */
+/*   BnT*Bn = BT*B + Y*WT                                                           */
+/* of rank k, solved by Sherman-Morrison-Woodbury with Z = (BT*B)^-1 * Y and the    */
+/* LU of I + WT*Z.                                                                  */
+
+typedef struct {
+  boundary *b;      /* the zone */
+  int N;            /* boundary points; bvv has 2N rows, bcv 4N */
+  int M;            /* rows of A, D and B: 5N, and 1 more for the KCL row */
+  coordinates *xy;  /* points of the zone when it was factored */
+  double *B;        /* B when it was factored, M x 4N */
+  double *C;        /* BT*DA, 4N x 2N */
+  double *U;        /* Cholesky factor (upper) or LU of BT*B, 4N x 4N */
+  int *ipiv;        /* pivots of the LU; NULL for Cholesky */
+  int k;            /* rank of the update; 0 = none */
+  double *Bn;       /* B and DA with the points moved, M x 4N and M x 2N */
+  double *DAn;
+  double *Z;        /* (BT*B)^-1 * Y, 4N x k */
+  double *W;        /* 4N x k */
+  double *S;        /* LU of I + WT*Z, k x k */
+  int *spiv;
+} zone_factor;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
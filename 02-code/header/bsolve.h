@@ -8,3 +8,6 @@ void make_boundary_vector(boundary *b, matrix *bvv, matrix *bcv);
 double make_internal_voltage(boundary *b, matrix *bvv, matrix *bcv, coordinates P, matrix *vgv, matrix *cgv);
 void make_internal_grad_voltage(boundary *b, matrix *bvv, matrix *bcv, coordinates P, co_matrix *co_vgv, co_matrix *co_cgv, coordinates Gv);
 void make_internal_sec_grad_voltage(boundary *b, matrix *bvv, matrix *bcv, coordinates P, ten_matrix *ten_vgv, ten_matrix *ten_cgv, tensor Gv);
+double make_internal_stream_function(boundary *b, matrix *bvv, matrix *bcv, coordinates O, coordinates P);
+void make_internal_grad_stream(boundary *b, matrix *bvv, matrix *bcv, coordinates P, co_matrix *co_vgv, co_matrix *co_cgv, coordinates Gs);
+double make_internal_field(boundary *b, matrix *bvv, matrix *bcv, coordinates P, bem_vectors *x, bem_results *R, int mask);
@@ -0,0 +1,9 @@
+/* ../source/checkpoint.c */
+void set_checkpoint(double seconds);
+double get_checkpoint(void);
+void set_resume(int resume);
+int get_resume(void);
+void create_mouth_state(mouth_state *s, int n);
+void destroy_mouth_state(mouth_state *s);
+int read_checkpoint(catchment *c, int direction, int max_steps, double step_size, int n_stream, path **streamline, mouth_state *s);
+void write_checkpoint(catchment *c, int direction, int max_steps, double step_size, int n_stream, path **streamline, mouth_state *s, int force);
@@ -0,0 +1,21 @@
+/*----------------------------------------------------------------------------------*/
+/*------------------------------ checkpoint_types.h --------------------------------*/
+/*----------------------------------------------------------------------------------*/
+#define CHECKPOINT_FILE  "catcharea.ckpt"
+#define CHECKPOINT_MAGIC 0x544b4353   /* "SCKT" */
+#define CHECKPOINT_VERSION 2
+
+/*----------------------------------------------------------------------------------*/
+/* structure for holding the progress of the mouth loop of catchment_area */
+
+typedef struct {
+  int n;            /* points across the mouth */
+  int next;         /* first mouth point not done yet */
+  int k;            /* streamline drawn into next */
+  double C_sum;     /* sum of the trapezoids up to next-1 */
+  double *L;        /* L of every point done */
+  double *s_theta;  /* sin(theta) of every point done */
+} mouth_state;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,7 @@
+/* ../source/direction.c */
+void set_direction_method(int method);
+int get_direction_method(void);
+int direction_method_from_name(char *name);
+char *direction_method_name(int method);
+void newton_follow_stream(int direction, coordinates dV, tensor d2V, coordinates dP, double r);
+int newton_follow_stream_batch(int direction, int n, double *gx, double *gy, double *vxx, double *vxy, double *r, double *dx, double *dy);
@@ -0,0 +1,6 @@
+/* ../source/edit.c */
+void set_edited(char *dir);
+char *get_edited(void);
+void set_edit_check(int check);
+int get_edit_check(void);
+double edited_area(catchment *c, section *mouth, int max_steps, double step_size, int n_stream, path **streamline, bem_vectors *vectors);
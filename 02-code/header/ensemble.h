@@ -0,0 +1,6 @@
+/* ../source/ensemble.c */
+void set_ensemble(int n);
+int get_ensemble(void);
+void set_ensemble_sigma(double s);
+double get_ensemble_sigma(void);
+double ensemble_area(catchment *c, section *mouth, int max_steps, double step_size, int n_stream, path **streamline, bem_vectors *vectors);
@@ -0,0 +1,4 @@
+/* ../source/flowacc.c */
+void set_flow_accumulation(double cell);
+double get_flow_accumulation(void);
+int flow_accumulation(catchment *c, bem_vectors *vectors, char *name);
@@ -0,0 +1,11 @@
+/* ../source/logging.c */
+void set_log_level(int level);
+int get_log_level(void);
+void set_log_categories(int mask);
+int get_log_categories(void);
+void set_log_progress(double seconds);
+double get_log_progress(void);
+char *log_level_name(int level);
+int log_level_from_name(char *name);
+int log_categories_from_names(char *names);
+int log_progress(int category);
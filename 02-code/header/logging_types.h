@@ -0,0 +1,34 @@
+/*----------------------------------------------------------------------------------*/
+/*-------------------------------- logging_types.h ---------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* levels of messages (a message is shown if its level is up to get_log_level()) */
+
+#define LOG_ERROR 0
+#define LOG_WARN  1
+#define LOG_INFO  2   /* once per zone, per streamline or per run (default) */
+#define LOG_DEBUG 3   /* once per call, per step */
+
+/* categories of messages */
+
+#define LOG_MATRIX 1   /* multiply_matrix, invert_this_matrix */
+#define LOG_LINALG 2   /* LAPACK and BLAS calls of matrix_inv */
+#define LOG_ZONE   4   /* solving a zone: bsolve, vcalc */
+#define LOG_STREAM 8   /* following streamlines */
+#define LOG_ALL    15
+
+/* messages above LOG_MAX_LEVEL are not compiled at all (-DLOG_MAX_LEVEL=LOG_INFO) */
+
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL LOG_DEBUG
+#endif
+
+/* the test is a compare against two globals, so it can sit on a hot path */
+
+extern int log_level;
+extern int log_mask;
+
+#define log_on(level,category) \
+  ((level)<=LOG_MAX_LEVEL && (level)<=log_level && ((category) & log_mask))
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
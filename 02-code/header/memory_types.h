@@ -23,6 +23,13 @@ typedef struct {
   tensor  d2V;        /* second derivatives of voltage */
 } bem_results;
 
+/* parts of bem_results to calculate (evaluation mask) */
+
+#define EVAL_V   1    /* V */
+#define EVAL_DV  2    /* dV */
+#define EVAL_D2V 4    /* d2V; the 2x2 tensor vectors cost the most */
+#define EVAL_ALL 7
+
 /*----------------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------------*/
 /* structure for holding definition of raster over which to do calculations */
@@ -0,0 +1,12 @@
+/* ../source/memtrack.c */
+int set_memory_tag(int tag);
+int get_memory_tag(void);
+int set_memory_phase(int new_phase);
+int get_memory_phase(void);
+char *memory_tag_name(int tag);
+char *memory_phase_name(int phase);
+memory_totals *get_memory_tag_totals(int tag);
+memory_totals *get_memory_totals(void);
+memory_phase *get_memory_phase_marks(int phase);
+void *tracked_malloc(size_t bytes, int tag);
+void tracked_free(void *p);
@@ -0,0 +1,40 @@
+/*----------------------------------------------------------------------------------*/
+/*-------------------------------- memtrack_types.h --------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* subsystems the tracked allocations are charged to (set_memory_tag) */
+
+#define MEM_MATRIX   0   /* create_matrix, create_co_matrix, create_ten_matrix */
+#define MEM_PATH     1   /* create_path: contours, boundary loops, streamlines */
+#define MEM_VECTORS  2   /* create_bem_vectors: geometry vectors of the evaluations */
+#define MEM_SOLVER   3   /* workspace of make_bcv (A, D, B, BT*B) and of bfactor.c */
+#define MEM_ZONE     4   /* bvv and bcv kept for each zone solved */
+#define MEM_TAGS     5
+
+/* phases the high-water marks are kept for (set_memory_phase) */
+
+#define MEM_SETUP    0
+#define MEM_BEM      1   /* tracing, apart from the zone solves */
+#define MEM_SOLVE    2   /* solve_zone and factor_zone */
+#define MEM_FINAL    3
+#define MEM_PHASES   4
+
+/*----------------------------------------------------------------------------------*/
+/* what has been allocated for a subsystem */
+
+typedef struct {
+  long allocations;
+  long frees;
+  long live;          /* bytes allocated and not freed */
+  long peak;          /* largest live */
+} memory_totals;
+
+/* high-water marks of a phase (live bytes when it starts count as well) */
+
+typedef struct {
+  long allocations;
+  long peak;                /* largest live of all subsystems together */
+  long tag_peak[MEM_TAGS];  /* largest live of each subsystem */
+} memory_phase;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
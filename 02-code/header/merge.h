@@ -0,0 +1,10 @@
+/* ../source/merge.c */
+void set_merge_tolerance(double t);
+double get_merge_tolerance(void);
+void clear_merge_table(void);
+void merge_begin(catchment *c, int direction);
+void merge_new_zone(double GH0);
+void merge_zone_time(double t_sum);
+void merge_point(coordinates P, int zone, double t_sum);
+int merge_lookup(coordinates P, int zone, double *t_rest, double *L_after);
+void merge_end(double t_tail, double L_tail);
@@ -0,0 +1,5 @@
+/* ../source/packet.c */
+void set_packet_size(int n);
+int get_packet_size(void);
+void packet_field(boundary *b, double *bvv, double *bcv, int n, coordinates *P, bem_results *R);
+void packet_streamline_loop(int n, coordinates *P, catchment *c, int direction, int max_steps, double step_size, path **streamline, bem_vectors *vectors, bem_results *R, double *L);
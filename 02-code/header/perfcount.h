@@ -0,0 +1,14 @@
+/* ../source/perfcount.c */
+void set_perf_counters(int on);
+int get_perf_counters(void);
+void set_perf_fp_event(unsigned long config);
+unsigned long get_perf_fp_event(void);
+int open_perf_counters(void);
+void close_perf_counters(void);
+char *get_perf_note(void);
+int perf_event_counted(int event);
+char *perf_event_name(int event);
+char *perf_phase_name(int phase);
+perf_totals *get_perf_phase(int phase);
+void perf_begin(perf_sample *s);
+void perf_end(perf_sample *s, int phase, double flops);
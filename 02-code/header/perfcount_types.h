@@ -0,0 +1,43 @@
+/*----------------------------------------------------------------------------------*/
+/*------------------------------- perfcount_types.h --------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* events counted (an event the machine does not have is left out) */
+
+#define PERF_TASK_CLOCK   0   /* CPU time of all threads (software, nearly always there) */
+#define PERF_CYCLES       1
+#define PERF_INSTRUCTIONS 2
+#define PERF_LLC_REFS     3   /* last level cache references */
+#define PERF_LLC_MISSES   4
+#define PERF_FP_OPS       5   /* raw event given by --perf-fp (model specific) */
+#define PERF_EVENTS       6
+
+/* phases the counts are added to; multiply, inversion and tracing are inside bem */
+
+#define PERF_SETUP     0
+#define PERF_BEM       1
+#define PERF_MULTIPLY  2
+#define PERF_INVERSION 3
+#define PERF_TRACING   4
+#define PERF_FINAL     5
+#define PERF_PHASES    6
+
+#define PERF_MAX_TASKS 256   /* threads that are already running when counting starts */
+
+/* counts at the start of a piece of work (t<0: not counted) */
+
+typedef struct {
+  double count[PERF_EVENTS];
+  double t;
+} perf_sample;
+
+/* what has been counted in a phase */
+
+typedef struct {
+  long calls;
+  double seconds;           /* wall time */
+  double count[PERF_EVENTS];
+  double flops;             /* flops of the model (2mnk, 2n^3/3) if known */
+} perf_totals;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -12,7 +12,7 @@
 #define PERFORMANCE_SUMMARY_H
 
 /*******************************************************************************
- * Performance Summary Structure
+ * Performance Summary Structure (stream_types.h comes first: STOP_REASONS)
  ******************************************************************************/
 
 typedef struct {
@@ -52,11 +52,22 @@ typedef struct {
     int num_zones;                  /* Number of catchment zones */
     int max_points;                 /* Max points in any zone */
     
+    /* Streamline integration */
+    int stream_method;              /* 0=Fixed, 1=Taylor, 2=Dormand-Prince */
+    int num_streamlines;            /* Number of streamlines traced */
+    long stream_steps;              /* Accepted steps over all streamlines */
+    long stream_rejected;           /* Rejected steps over all streamlines */
+    long bem_evaluations;           /* BEM point evaluations by the tracer */
+    int stop_counts[STOP_REASONS];  /* Streamlines ended for each STOP_ reason */
+    
     /* Memory tracking */
     long initial_memory_kb;         /* Initial memory usage (KB) */
     long peak_memory_kb;            /* Peak memory usage (KB) */
     long final_memory_kb;           /* Final memory usage (KB) */
     
+    /* Result */
+    double catchment_area;          /* C_area of the mouth */
+    
 } PerformanceSummary;
 
 /*******************************************************************************
@@ -79,6 +90,8 @@ void update_multiply_time(double time_sec, int rows, int cols, int k);
 void update_inversion_time(double time_sec, int n);
 void update_finalization_time(double time_sec);
 void update_memory_usage(long vmrss_kb, long vmsize_kb);
+void update_streamline_stats(int steps, int rejected, long evaluations,
+                             int reason);
 
 /* Legacy compatibility - maps to update_inversion_time */
 void update_matrix_inversion_stats(double time_sec);
@@ -88,6 +101,8 @@ void set_performance_config(int multiply_method, int inversion_method,
                             int num_threads, int block_size);
 void set_problem_parameters(double step, double rm, double dr, 
                             int zones, int points);
+void set_stream_config(int stream_method);
+void set_catchment_area_result(double area);
 
 /* Output functions */
 void print_performance_summary(void);
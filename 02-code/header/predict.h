@@ -0,0 +1,6 @@
+/* ../source/predict.c */
+void set_predictor(int k, double t);
+void get_predictor(int *k, double *t);
+void start_predictor(predictor *p);
+int predict_field(predictor *p, coordinates P, bem_results *R);
+void correct_predictor(predictor *p, coordinates P, bem_results *R, int same);
@@ -0,0 +1,16 @@
+/*----------------------------------------------------------------------------------*/
+/*------------------------------- predict_types.h ----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* structure for holding the gradient predictor of one streamline */
+
+typedef struct {
+  int k;               /* steps that may be predicted after an exact evaluation */
+  int skipped;         /* steps predicted since the last exact evaluation */
+  int anchored;        /* 1 once P0, R0 hold an exact evaluation */
+  coordinates P0;      /* point of the last exact evaluation */
+  bem_results R0;      /* V, dV and d2V there */
+  int predicted;       /* steps predicted so far */
+} predictor;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,8 @@
+/* ../source/regress.c */
+void set_regress(char *dir);
+char *get_regress(void);
+void set_regress_output(char *file);
+void set_regress_baseline(char *file);
+void set_regress_variants(char *list);
+void set_regress_tolerances(double area, double time);
+int run_regression(int argc, char **argv);
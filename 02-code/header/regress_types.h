@@ -0,0 +1,23 @@
+/*----------------------------------------------------------------------------------*/
+/*--------------------------------- regress_types.h --------------------------------*/
+/*----------------------------------------------------------------------------------*/
+#define REGRESS_MAX_CASES  128
+#define REGRESS_WORK       "regress_work"   /* directory the runs are done in */
+#define REGRESS_MIN_SECONDS 0.05            /* time differences below this are noise */
+
+/*----------------------------------------------------------------------------------*/
+/* structure for holding the result of one case (one data set, one Ds variant) */
+
+typedef struct {
+  char name[64];      /* data set, e.g. 01-Super-low */
+  char variant[32];   /* contour files used, e.g. Ds30 */
+  int status;         /* 0 = ran and wrote performance_results.csv */
+  int zones,points;
+  double setup,bem,multiply,inversion,final,total;   /* seconds */
+  double rss;         /* peak resident set of the run, MB */
+  long evaluations;
+  double area;        /* C_area */
+} regress_case;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
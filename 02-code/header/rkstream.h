@@ -0,0 +1,11 @@
+/* ../source/rkstream.c */
+void set_stream_method(int method);
+int get_stream_method(void);
+int stream_method_from_name(char *name);
+char *stream_method_name(int method);
+void set_stream_tolerances(double atol, double rtol);
+void set_stream_step_bounds(double h_min, double h_max);
+void get_stream_control(stream_control *s);
+void get_stream_stats(stream_stats *s);
+void report_stream_stats(stream_stats *s);
+double rk_streamline_loop(coordinates P, catchment *c, int direction, int max_steps, double step_size, path *streamline, bem_vectors *vectors, bem_results *v1);
@@ -0,0 +1,4 @@
+/* ../source/sca.c */
+void set_sca_map(double cell);
+double get_sca_map(void);
+int sca_map(unsigned char *data, catchment *c, bem_vectors *vectors, int max_steps, double step_size, char *name);
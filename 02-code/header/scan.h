@@ -3,6 +3,8 @@ void put_raster(char *data, raster *ras);
 void show_raster(raster *ras);
 double x_raster(raster *ras, int i);
 double y_raster(raster *ras, int j);
+void catchment_raster(catchment *c, double cell, raster *ras);
+void write_flt_raster(char *name, raster *ras, double cell, double *value, double nodata);
 void put_section(char *data, section *sec);
 void put_sectionV2(int Nseg, coordinates PA, coordinates PB, section *sec);
 void show_section(section *sec);
@@ -0,0 +1,8 @@
+/* ../source/stopping.c */
+void set_stop_criteria(double g, int w, double q, int n);
+void get_stop_criteria(double *g, int *w, double *q, int *n);
+char *stop_reason_name(int reason);
+stop_tracker *create_stop_tracker(int max_points);
+stop_tracker *destroy_stop_tracker(stop_tracker *t);
+void start_stop_tracker(stop_tracker *t, double step_size);
+int check_stop(stop_tracker *t, coordinates P, double G, double step);
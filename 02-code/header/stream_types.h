@@ -0,0 +1,74 @@
+/*----------------------------------------------------------------------------------*/
+/*-------------------------------- stream_types.h ----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* streamline integration methods */
+
+#define STREAM_FIXED  0   /* fixed step through edit1_my_follow_stream (original) */
+#define STREAM_TAYLOR 1   /* 2nd order Taylor step using d2V, embedded 1st order */
+#define STREAM_DOPRI  2   /* Dormand-Prince 5(4) with error control */
+
+/* ways of finding the step direction on the circle of radius r */
+
+#define DIRECTION_QUARTIC 0  /* roots of quartics in cos and sin (original) */
+#define DIRECTION_NEWTON  1  /* Newton iterations on the circle, no trig */
+
+/* reasons for a streamline to end */
+
+#define STOP_NONE      0  /* still going */
+#define STOP_OUTSIDE   1  /* left the catchment */
+#define STOP_MAX_STEPS 2  /* used all max_steps */
+#define STOP_FLAT      3  /* |dV| below gmin: no direction to follow */
+#define STOP_STALLED   4  /* little net movement over the last window of steps */
+#define STOP_LOOP      5  /* came back to cells it had already passed through */
+#define STOP_MERGED    6  /* joined a streamline traced before (merge.c) */
+#define STOP_REASONS   7
+
+/* ways of finding the catchment area from the mouth */
+
+#define AREA_TRAPEZOID 0  /* L*sin(theta) over mouth->n streamlines (original) */
+#define AREA_SHOELACE  1  /* polygon of the two bounding streamlines */
+
+/* most streamlines traced together by packet_streamline_loop */
+
+#define MAX_PACKET 8
+
+/*----------------------------------------------------------------------------------*/
+/* structure for holding the settings of the streamline integrator */
+
+typedef struct {
+  int method;       /* STREAM_FIXED, STREAM_TAYLOR or STREAM_DOPRI */
+  double atol;      /* absolute tolerance on position per step */
+  double rtol;      /* relative tolerance (fraction of the step length) */
+  double h_min;     /* smallest step length allowed */
+  double h_max;     /* largest step length allowed */
+} stream_control;
+
+/*----------------------------------------------------------------------------------*/
+/* structure for holding the counters of one streamline */
+
+typedef struct {
+  int steps;        /* accepted steps (points stored in the streamline) */
+  int rejected;     /* steps rejected by error control or zone crossing */
+  long evaluations; /* number of bem evaluations (V, dV and d2V at a point) */
+  int new_zones;    /* number of times a new zone was entered */
+  int reason;       /* STOP_OUTSIDE, STOP_MAX_STEPS, ... */
+} stream_stats;
+
+/*----------------------------------------------------------------------------------*/
+/* structure for holding the early stopping tests of one streamline */
+
+typedef struct {
+  int window;          /* number of steps looked back for net movement */
+  int count;           /* points seen so far */
+  coordinates *ring;   /* last window+1 points */
+  double *length;      /* path length up to each point in ring */
+  double cell;         /* size of cells used to spot revisits */
+  int revisits;        /* revisits seen so far */
+  int size;            /* hash table size (power of 2) */
+  int used;            /* hash table entries in use */
+  long long *key;      /* cell keys (0 = empty) */
+  int *step;           /* last point number in each cell */
+} stop_tracker;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
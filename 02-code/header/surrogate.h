@@ -0,0 +1,6 @@
+/* ../source/surrogate.c */
+void set_surrogate_tolerance(double tol);
+double get_surrogate_tolerance(void);
+int surrogate_field(boundary *b, coordinates P, bem_results *R);
+void surrogate_zone_solved(boundary *b, bem_vectors *x);
+void report_surrogates(void);
@@ -0,0 +1,36 @@
+/*----------------------------------------------------------------------------------*/
+/*------------------------------ surrogate_types.h ---------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* kinds of quadtree cell */
+
+#define CELL_SPLIT  0   /* has 4 children */
+#define CELL_HERMITE 1  /* leaf; field interpolated from its 4 corners */
+#define CELL_EXACT  2   /* leaf touching a contour (or outside); bem evaluation */
+
+/*----------------------------------------------------------------------------------*/
+/* structure for holding the surrogate field of one zone */
+/* The root cell is the square (origin, size) around the zone. Children of cell i  */
+/* are child[i]..child[i]+3 in the order (low x,low y), (high x,low y),             */
+/* (low x,high y), (high x,high y); the corners of a leaf use the same order.       */
+/* The surrogates of all zones are chained by next in the order they were made.     */
+
+typedef struct surrogate_s {
+  boundary *b;          /* the zone */
+  unsigned long key;    /* hash of the zone's points; names the saved file */
+  double tol;           /* relative error allowed in dV */
+  coordinates origin;   /* lower left corner of the root cell */
+  double size;          /* side of the root cell */
+  int n_cells;          /* number of cells */
+  int max_cells;
+  char *kind;           /* CELL_SPLIT, CELL_HERMITE or CELL_EXACT */
+  int *child;           /* first child of a split cell */
+  int *corner;          /* 4 sample numbers of a hermite cell */
+  int n_samples;        /* number of samples */
+  int max_samples;
+  bem_results *sample;  /* V, dV and d2V at the sample points */
+  long hits;            /* evaluations done from the surrogate */
+  struct surrogate_s *next;  /* surrogate made after this one; NULL = last */
+} surrogate;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
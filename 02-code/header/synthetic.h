@@ -0,0 +1,10 @@
+/* ../source/synthetic.c */
+void set_synthetic_reference(char *file);
+char *get_synthetic_reference(void);
+int synthetic_shape_from_name(char *name);
+char *synthetic_shape_name(int shape);
+double exact_synthetic_field(synthetic *s, coordinates P, coordinates dV);
+double synthetic_path_error(synthetic *s, int n, coordinates *xy);
+void make_synthetic(synthetic *s, int shape, int n, int zones, int holes);
+int write_synthetic(synthetic *s, char *dir);
+void read_synthetic_reference(char *file, synthetic *s);
@@ -0,0 +1,38 @@
+/*----------------------------------------------------------------------------------*/
+/*------------------------------- synthetic_types.h --------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* shapes of the synthetic catchments (gencatch --shape) */
+
+#define SYNTH_CIRCLES 0   /* concentric circles, a ring between each two is a zone */
+#define SYNTH_HOLES   1   /* a disc with circular holes, one zone */
+#define SYNTH_SQUARE  2   /* a square, one zone (as 01-input/Square) */
+
+/* exact fields */
+
+#define FIELD_LOG     0   /* V = a + b ln|P-centre| (radial flow paths) */
+#define FIELD_LINEAR  1   /* V = a + b x (flow paths parallel to the x axis) */
+
+#define SYNTH_MAX_HOLES 8
+#define SYNTH_MOUTH   20  /* steps across the mouth (P(0) to P(SYNTH_MOUTH)) */
+#define SYNTH_REFERENCE "reference.txt"
+
+/*----------------------------------------------------------------------------------*/
+/* structure for holding a synthetic catchment and its exact solution */
+
+typedef struct {
+  int shape;
+  int n;                         /* points on the outer loop */
+  int zones;                     /* rings (circles only) */
+  int holes;                     /* holes (holes only) */
+  double r_inner,r_outer;        /* radii; r_outer = side of the square */
+  double hole_x[SYNTH_MAX_HOLES],hole_y[SYNTH_MAX_HOLES],hole_r;
+  int field;
+  double a,b;                    /* V = a + b ln r or V = a + b x */
+  double centre[2];
+  char mouth[96];                /* for put_section */
+  double area;                   /* area between the 2 bounding flow paths */
+  double limit;                  /* what C_area goes to as the steps go to 0 */
+} synthetic;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
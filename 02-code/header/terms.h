@@ -21,6 +21,15 @@ double Tj(double x, double y1, double y2);
 double Tk(double x, double y1, double y2);
 double Tl(double x, double y1, double y2);
 double Tm(double x, double y1, double y2);
+double Vconj_PoffS(double x, double y1, double y2);
+double Wconj_PoffS(double x, double y1, double y2);
+double Jconj_PoffS(double x, double y1, double y2, double a);
+double Kconj_PoffS(double x, double y1, double y2, double a);
+double Lconj_PoffS(double x, double y1, double y2, double a);
+double Mconj_PoffS(double x, double y1, double y2, double a);
+double Sv(double x, double y1, double y2);
+double Sw(double x, double y1, double y2);
+double Sa(double x, double y1, double y2, double a, int k);
 void V1(double x, double y1, double y2, coordinates v);
 void W1(double x, double y1, double y2, coordinates w);
 void J1(double x, double y1, double y2, coordinates j);
@@ -0,0 +1,3 @@
+/* ../source/tile.c */
+void share_solved_zones(catchment *c);
+double *scan_raster_tiles(unsigned char *data, raster *ras, int n_out, tile_function f, void *arg);
@@ -0,0 +1,20 @@
+/*----------------------------------------------------------------------------------*/
+/*---------------------------------- tile_types.h ----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* side of a square tile of raster points */
+
+#define TILE_SIZE 8
+
+/* tiles of one Morton block handed to a thread at a time */
+
+#define TILE_CHUNK 4
+
+/*----------------------------------------------------------------------------------*/
+/* work done at the n points P of a tile, with a thread's own catchment and vectors */
+/* tile_function(c,vectors,n,P,out,arg): out has n_out numbers for each point       */
+
+typedef void (*tile_function)(catchment *c, bem_vectors *vectors, int n,
+			      coordinates *P, double *out, void *arg);
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,6 @@
+/* ../source/trace.c */
+void set_trace(char *file);
+char *get_trace(void);
+void trace_begin(trace_span *s, char *name, char *category);
+double trace_end(trace_span *s);
+void write_trace(void);
@@ -0,0 +1,27 @@
+/*----------------------------------------------------------------------------------*/
+/*--------------------------------- trace_types.h ----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* structure for holding one timed span (kept by the caller, like a struct timeval) */
+/* A span with category NULL is only timed; the others also go to the trace file   */
+/* when tracing is on.                                                              */
+
+typedef struct {
+  char *name;       /* what is timed */
+  char *category;   /* "phase", "zone", "linalg", "stream", "tile", "io" or NULL */
+  double start;     /* seconds */
+  int depth;        /* spans open in this thread when it began */
+} trace_span;
+
+/* structure for holding one finished span in the trace */
+
+typedef struct {
+  char *name;
+  char *category;
+  double start;     /* seconds after the trace was started */
+  double length;    /* seconds */
+  int thread;       /* OpenMP thread number */
+  int depth;
+} trace_event;
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
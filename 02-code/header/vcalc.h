@@ -1,6 +1,14 @@
 /* ../source/vcalc.c */
+long get_bem_evaluations(void);
+long get_thread_bem_evaluations(void);
+void add_bem_evaluations(long n);
 double voltage_on_path(catchment *c, double s, int segment, path *this_path);
 double voltage_outside_catchment(void);
-double calculate_in_same_zone(boundary *b, coordinates P, bem_vectors *x, bem_results *R);
-double calculate_in_new_zone(boundary *b, coordinates P, bem_vectors *x, bem_results *R);
-double calculate_inside_catchment(catchment *c, coordinates P, bem_vectors *vectors, bem_results *voltage, int *new_z);
+double calculate_in_same_zone(boundary *b, coordinates P, bem_vectors *x, bem_results *R, int mask);
+void calculate_packet_in_zone(boundary *b, int n, coordinates *P, bem_vectors *x, bem_results *R);
+void solve_zone(boundary *b, bem_vectors *x);
+double calculate_in_new_zone(boundary *b, coordinates P, bem_vectors *x, bem_results *R, int mask);
+void stream_function_along(catchment *c, int n, coordinates *xy, bem_vectors *x, double *psi);
+int stream_gradient(catchment *c, coordinates P, bem_vectors *x, coordinates Gs);
+double calculate_inside_catchment(catchment *c, coordinates P, bem_vectors *vectors, bem_results *voltage, int *new_z, int mask);
+double calculate_in_zone(catchment *c, int this_zone, coordinates P, bem_vectors *vectors, bem_results *voltage, int *new_z, int mask);
@@ -1,5 +1,6 @@
 /*--------------------------------------------------------*/
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 /*--------------------------------------------------------*/
 #include "boundary_types.h"
@@ -7,12 +8,76 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "stream_types.h"
+#include "checkpoint_types.h"
 
+#include "catchment.h"
+#include "checkpoint.h"
+#include "merge.h"
+#include "packet.h"
+#include "path.h"
+#include "rkstream.h"
 #include "scan.h"
 #include "streamline.h"
+#include "surrogate.h"
+#include "vcalc.h"
 
 #include "area.h"
 /*--------------------------------------------------------*/
+/*----------- streamlines of the mouth in packets --------*/
+/*--------------------------------------------------------*/
+/* L and R at every mouth point, packet_size at a time.   */
+/* Point i draws into the same streamline as in the loop  */
+/* of catchment_area; when several points share one only  */
+/* the last draws into it.                                */
+/*--------------------------------------------------------*/
+static void mouth_packets(c,mouth,direction,max_steps,step_size,
+			  n_stream,streamline,vectors,L,R)
+     catchment *c;
+     section *mouth;
+     int direction,max_steps;
+     double step_size;
+     int n_stream;
+     path **streamline;
+     bem_vectors *vectors;
+     double *L;
+     bem_results *R;
+{
+  coordinates P[MAX_PACKET];
+  path *lane_path[MAX_PACKET];
+  int *use,i,k,m,n,size;
+
+  n=mouth->n-1;
+  use=(int *)malloc(mouth->n*sizeof(int));
+  if(use==(int *)NULL)
+    {
+      printf("Cannot allocate memory for mouth streamlines\n");
+      exit(0);
+    }
+  use[0]=0;
+  k=1;
+  for(i=1;i<mouth->n;i++)
+    {
+      use[i]=k;
+      if(i*(n_stream-1)>=k*n) k=k+1;
+    }
+
+  size=get_packet_size();
+  for(i=0;i<mouth->n;i=i+size)
+    {
+      m=(mouth->n-i<size) ? mouth->n-i : size;
+      for(k=0;k<m;k++)
+	{
+	  xy_section(mouth,i+k,P[k]);
+	  if(i+k+1<mouth->n && use[i+k+1]==use[i+k]) lane_path[k]=(path *)NULL;
+	  else lane_path[k]=streamline[use[i+k]];
+	}
+      packet_streamline_loop(m,P,c,direction,max_steps,step_size,lane_path,
+			     vectors,&R[i],&L[i]);
+    }
+  free((void *)use);
+}
+/*--------------------------------------------------------*/
 /*----------- catchment area loop ------------------------*/
 /*--------------------------------------------------------*/
 double catchment_area(c,mouth,direction,max_steps,step_size,
@@ -26,12 +91,13 @@ double catchment_area(c,mouth,direction,max_steps,step_size,
      path **streamline;
      bem_vectors *vectors;
 {
-  bem_results R;
+  bem_results R,*R_all;
   coordinates P;
-  double dx,dy,dw,C_sum;
+  double dx,dy,dw,C_sum,*L_all;
   double L_old,L_new,s_theta_old,s_theta_new;
   double cosq_theta;  
-  int i,n,k;
+  int i,n,k,packets,first,ckpt;
+  mouth_state s;
   
   i=0;
   C_sum=0.0;
@@ -39,20 +105,58 @@ double catchment_area(c,mouth,direction,max_steps,step_size,
   dx=(mouth->P2[0]-mouth->P1[0])/(double)n;
   dy=(mouth->P2[1]-mouth->P1[1])/(double)n;
   dw=mouth->step;   /* step size across mouth */
+
+  /* packets only with the fixed step and no merging */
+  packets=(get_packet_size()>1 && get_stream_method()==STREAM_FIXED &&
+	   get_merge_tolerance()<=0.0);
+  L_all=(double *)NULL;
+  R_all=(bem_results *)NULL;
+  if(packets)
+    {
+      L_all=(double *)malloc(mouth->n*sizeof(double));
+      R_all=(bem_results *)malloc(mouth->n*sizeof(bem_results));
+      if(L_all==(double *)NULL || R_all==(bem_results *)NULL)
+	{
+	  printf("Cannot allocate memory for mouth streamlines\n");
+	  exit(0);
+	}
+      mouth_packets(c,mouth,direction,max_steps,step_size,
+		    n_stream,streamline,vectors,L_all,R_all);
+    }
+  /* checkpoints only where the next streamline does not depend on earlier ones */
+  ckpt=(!packets && (get_checkpoint()>0.0 || get_resume()) &&
+	get_merge_tolerance()<=0.0 && get_surrogate_tolerance()<=0.0);
+  if(ckpt) create_mouth_state(&s,mouth->n);
   xy_section(mouth,0,P);
 
-  L_old=streamline_loop(P,c,direction,max_steps,step_size,streamline[0],vectors,&R) ;
-  cosq_theta=(dx*R.dV[0]+dy*R.dV[1])/dw;
-  cosq_theta=cosq_theta*cosq_theta/(R.dV[0]*R.dV[0]+R.dV[1]*R.dV[1]);
-  if(cosq_theta>1.0) cosq_theta=1.0;
-  s_theta_old=sqrt(1.0-cosq_theta);
-  C_sum=0.0;
-  k=1;
+  if(ckpt && get_resume() &&
+     read_checkpoint(c,direction,max_steps,step_size,n_stream,streamline,&s))
+    {
+      first=s.next;
+      k=s.k;
+      C_sum=s.C_sum;
+      L_old=s.L[first-1];
+      s_theta_old=s.s_theta[first-1];
+    }
+  else
+    {
+      if(packets) { L_old=L_all[0]; R=R_all[0]; }
+      else L_old=streamline_loop(P,c,direction,max_steps,step_size,streamline[0],vectors,&R) ;
+      cosq_theta=(dx*R.dV[0]+dy*R.dV[1])/dw;
+      cosq_theta=cosq_theta*cosq_theta/(R.dV[0]*R.dV[0]+R.dV[1]*R.dV[1]);
+      if(cosq_theta>1.0) cosq_theta=1.0;
+      s_theta_old=sqrt(1.0-cosq_theta);
+      C_sum=0.0;
+      k=1;
+      first=1;
+      if(ckpt) { s.L[0]=L_old; s.s_theta[0]=s_theta_old; }
+    }
 
-  for(i=1;i<mouth->n;i++)
+  for(i=first;i<mouth->n;i++)
     {
       xy_section(mouth,i,P);
-      if(i*(n_stream-1)>=k*n){
+      if(packets) { L_new=L_all[i]; R=R_all[i]; }
+      else if(i*(n_stream-1)>=k*n){
 	L_new=streamline_loop(P,c,direction,max_steps,step_size,streamline[k],vectors,&R);
 	k=k+1; }
       else{
@@ -64,14 +168,510 @@ double catchment_area(c,mouth,direction,max_steps,step_size,
       C_sum=C_sum+L_old*s_theta_old+L_new*s_theta_new;
       L_old=L_new;
       s_theta_old=s_theta_new;
+      if(ckpt)
+	{
+	  s.next=i+1;
+	  s.k=k;
+	  s.C_sum=C_sum;
+	  s.L[i]=L_new;
+	  s.s_theta[i]=s_theta_new;
+	  write_checkpoint(c,direction,max_steps,step_size,n_stream,streamline,&s,
+			   i==mouth->n-1);
+	}
     }
+  if(ckpt) destroy_mouth_state(&s);
   C_sum=C_sum*dw/2.0;
+  if(packets)
+    {
+      free((void *)L_all);
+      free((void *)R_all);
+    }
   printf("\n dw=%f C_sum=%f",dw,C_sum);
   return(C_sum);
 }
 /*--------------------------------------------------------*/
+/*------- adaptive catchment area loop -------------------*/
+/*--------------------------------------------------------*/
+/* The coarse set is the two ends and the middle of the   */
+/* mouth. The mouth is a set of panels, each integrated   */
+/* by the trapezoid rule. When a panel [a,b] is refined a */
+/* streamline is traced at its midpoint m; the trapezoid  */
+/* rules on 1 and 2 panels                                */
+/*   T1 = (b-a)*(fa+fb)/2,  T2 = (b-a)*(fa+2fm+fb)/4      */
+/* give e = |T2-T1|/3 for the error left in T2, charged   */
+/* half to each of the two new panels. The panel with the */
+/* largest error is refined until the sum of the errors   */
+/* is below area_tol, so a smooth L*sin(theta) is done    */
+/* with a few streamlines. Panels are not halved more     */
+/* than MAX_DEPTH times, so where L jumps (streamlines    */
+/* going to another outlet) refinement stops.             */
+/* f = L*sin(theta) as in catchment_area.                 */
+/*--------------------------------------------------------*/
+#define MAX_DEPTH 10
+/*--------------------------------------------------------*/
+static double mouth_tol=0.0;   /* <=0 = uniform points */
+
+/* state of the adaptive loop */
+static catchment *a_c;
+static section *a_mouth;
+static bem_vectors *a_vectors;
+static int a_direction,a_max_steps;
+static double a_step_size,a_width;
+static int a_n,a_max;
+static path **a_path;
+static double *a_w;
+
+/* panels: ends, function values at the ends, error estimate */
+static int n_pn,max_pn;
+static double *pn_a,*pn_b,*pn_fa,*pn_fb,*pn_e;
+static int *pn_depth;
+/*--------------------------------------------------------*/
+void set_mouth_tolerance(tol)
+     double tol;
+{
+  mouth_tol=tol;
+}
+/*--------------------------------------------------------*/
+double get_mouth_tolerance()
+{
+  return(mouth_tol);
+}
+/*--------------------------------------------------------*/
+static void *grow(p,n,size)
+     void *p;
+     int n,size;
+{
+  p=realloc(p,(size_t)n*size);
+  if(p==NULL)
+    {
+      printf("Cannot allocate memory for mouth streamlines\n");
+      exit(0);
+    }
+  return(p);
+}
+/*--------------------------------------------------------*/
+/* streamline from distance w along the mouth; f=L*sin    */
+/*--------------------------------------------------------*/
+static double mouth_sample(w)
+     double w;
+{
+  bem_results R;
+  coordinates P;
+  double ex,ey,L,cosq_theta;
+  int i;
+
+  if(a_n>=a_max)
+    {
+      a_max=2*a_max;
+      a_path=(path **)grow(a_path,a_max,sizeof(path *));
+      a_w=(double *)grow(a_w,a_max,sizeof(double));
+      for(i=a_n;i<a_max;i++) a_path[i]=(path *)NULL;
+    }
+  if(a_path[a_n]==(path *)NULL) a_path[a_n]=create_path(a_max_steps,1,0);
+
+  ex=(a_mouth->P2[0]-a_mouth->P1[0])/a_width;
+  ey=(a_mouth->P2[1]-a_mouth->P1[1])/a_width;
+  P[0]=a_mouth->P1[0]+w*ex;
+  P[1]=a_mouth->P1[1]+w*ey;
+  L=streamline_loop(P,a_c,a_direction,a_max_steps,a_step_size,
+		    a_path[a_n],a_vectors,&R);
+  a_w[a_n]=w;
+  a_n=a_n+1;
+
+  cosq_theta=ex*R.dV[0]+ey*R.dV[1];
+  cosq_theta=cosq_theta*cosq_theta/(R.dV[0]*R.dV[0]+R.dV[1]*R.dV[1]);
+  if(cosq_theta>1.0) cosq_theta=1.0;
+  return(L*sqrt(1.0-cosq_theta));
+}
+/*--------------------------------------------------------*/
+/* new panel [a,b] with error estimate e                  */
+/*--------------------------------------------------------*/
+static void add_panel(a,b,fa,fb,e,depth)
+     double a,b,fa,fb,e;
+     int depth;
+{
+  if(n_pn>=max_pn)
+    {
+      max_pn=2*max_pn+16;
+      pn_a=(double *)grow(pn_a,max_pn,sizeof(double));
+      pn_b=(double *)grow(pn_b,max_pn,sizeof(double));
+      pn_fa=(double *)grow(pn_fa,max_pn,sizeof(double));
+      pn_fb=(double *)grow(pn_fb,max_pn,sizeof(double));
+      pn_e=(double *)grow(pn_e,max_pn,sizeof(double));
+      pn_depth=(int *)grow(pn_depth,max_pn,sizeof(int));
+    }
+  pn_a[n_pn]=a;
+  pn_b[n_pn]=b;
+  pn_fa[n_pn]=fa;
+  pn_fb[n_pn]=fb;
+  pn_e[n_pn]=e;
+  pn_depth[n_pn]=depth;
+  n_pn=n_pn+1;
+}
+/*--------------------------------------------------------*/
+/* trace the midpoint of [a,b] and put its two halves in  */
+/* place of panel k (k<0: as new panels)                  */
+/*--------------------------------------------------------*/
+static void split_panel(k,a,b,fa,fb,depth)
+     int k;
+     double a,b,fa,fb;
+     int depth;
+{
+  double m,fm,T1,T2,e;
+
+  m=0.5*(a+b);
+  fm=mouth_sample(m);
+  T1=(b-a)*(fa+fb)/2.0;
+  T2=(b-a)*(fa+2.0*fm+fb)/4.0;
+  e=fabs(T2-T1)/3.0;
+  if(k>=0)
+    {
+      n_pn=n_pn-1;
+      pn_a[k]=pn_a[n_pn];   pn_b[k]=pn_b[n_pn];
+      pn_fa[k]=pn_fa[n_pn]; pn_fb[k]=pn_fb[n_pn];
+      pn_e[k]=pn_e[n_pn];   pn_depth[k]=pn_depth[n_pn];
+    }
+  add_panel(a,m,fa,fm,0.5*e,depth+1);
+  add_panel(m,b,fm,fb,0.5*e,depth+1);
+}
+/*--------------------------------------------------------*/
+/* n_stream and streamline come in holding the paths of   */
+/* the mouth points and go out holding all paths used,    */
+/* in order across the mouth                              */
+/*--------------------------------------------------------*/
+double catchment_area_adaptive(c,mouth,direction,max_steps,step_size,
+			       area_tol,n_stream,streamline,vectors)
+     catchment *c;
+     section *mouth;
+     int direction; /* 1 = go to max; 0 = go to min */
+     int max_steps;
+     double step_size;
+     double area_tol;
+     int *n_stream;
+     path ***streamline;
+     bem_vectors *vectors;
+{
+  double C_sum,E_sum,e_max,w,fa,fb;
+  path *p;
+  int i,j,k;
+
+  a_c=c;
+  a_mouth=mouth;
+  a_vectors=vectors;
+  a_direction=direction;
+  a_max_steps=max_steps;
+  a_step_size=step_size;
+  a_width=sqrt((mouth->P2[0]-mouth->P1[0])*(mouth->P2[0]-mouth->P1[0])+
+	       (mouth->P2[1]-mouth->P1[1])*(mouth->P2[1]-mouth->P1[1]));
+  a_max=(*n_stream>3) ? (*n_stream) : 3;
+  a_path=(path **)malloc(a_max*sizeof(path *));
+  a_w=(double *)malloc(a_max*sizeof(double));
+  if(a_path==(path **)NULL || a_w==(double *)NULL)
+    {
+      printf("Cannot allocate memory for mouth streamlines\n");
+      exit(0);
+    }
+  for(i=0;i<a_max;i++)
+    a_path[i]=(i<(*n_stream)) ? (*streamline)[i] : (path *)NULL;
+  a_n=0;
+  n_pn=max_pn=0;
+  pn_a=pn_b=pn_fa=pn_fb=pn_e=(double *)NULL;
+  pn_depth=(int *)NULL;
+
+  /* coarse set: the ends and the middle */
+  fa=mouth_sample(0.0);
+  fb=mouth_sample(a_width);
+  split_panel(-1,0.0,a_width,fa,fb,0);
+
+  /* refine the panel with the largest error until the sum is small enough */
+  for(;;)
+    {
+      E_sum=0.0;
+      e_max=0.0;
+      k=(-1);
+      for(i=0;i<n_pn;i++)
+	{
+	  E_sum=E_sum+pn_e[i];
+	  if(pn_depth[i]<MAX_DEPTH && pn_e[i]>e_max)
+	    {
+	      e_max=pn_e[i];
+	      k=i;
+	    }
+	}
+      if(E_sum<=area_tol || k<0) break;
+      split_panel(k,pn_a[k],pn_b[k],pn_fa[k],pn_fb[k],pn_depth[k]);
+    }
+
+  C_sum=0.0;
+  for(i=0;i<n_pn;i++)
+    C_sum=C_sum+(pn_b[i]-pn_a[i])*(pn_fa[i]+pn_fb[i])/2.0;
+
+  /* paths not used */
+  for(i=a_n;i<a_max;i++)
+    if(a_path[i]!=(path *)NULL) a_path[i]=destroy_path(a_path[i]);
+
+  /* put the streamlines in order across the mouth */
+  for(i=1;i<a_n;i++)
+    {
+      w=a_w[i];
+      p=a_path[i];
+      for(j=i;j>0 && a_w[j-1]>w;j--)
+	{
+	  a_w[j]=a_w[j-1];
+	  a_path[j]=a_path[j-1];
+	}
+      a_w[j]=w;
+      a_path[j]=p;
+    }
+
+  free((void *)(*streamline));
+  free((void *)a_w);
+  free((void *)pn_a);
+  free((void *)pn_b);
+  free((void *)pn_fa);
+  free((void *)pn_fb);
+  free((void *)pn_e);
+  free((void *)pn_depth);
+  (*streamline)=a_path;
+  (*n_stream)=a_n;
+  printf("\n streamlines=%d error=%f C_sum=%f",a_n,E_sum,C_sum);
+  return(C_sum);
+}
+/*--------------------------------------------------------*/
 /*--------------------- SCA index ------------------------*/
 /*--------------------------------------------------------*/
+/*-------- area between the two bounding streamlines -----*/
+/*--------------------------------------------------------*/
+/* The catchment of the mouth is bounded by the mouth,    */
+/* the streamlines from its two ends and the contour both */
+/* leave through. Only those two streamlines are traced;  */
+/* the polygon is closed along the contour between their  */
+/* last points, one way round or the other: the right way */
+/* gives an area with the sign of mouth x flow direction. */
+/* Its area is found with the shoelace formula.           */
+/*                                                        */
+/* The true edges are the level sets of the stream        */
+/* function psi (vcalc.c) through the ends of the mouth.  */
+/* psi is sampled along each traced streamline; where it  */
+/* has drifted by d the level set is d/|grad psi| to one  */
+/* side, and that strip is added to or taken off the      */
+/* polygon, the side given by the sign of the flux        */
+/* psi(right)-psi(left) through the mouth.                */
+/*--------------------------------------------------------*/
+#define LEVEL_SAMPLE 8   /* streamline steps between samples of psi */
+/*--------------------------------------------------------*/
+static int area_method=AREA_TRAPEZOID;
+static int n_poly,max_poly;
+static coordinates *poly;
+/*--------------------------------------------------------*/
+void set_area_method(method)
+     int method;
+{
+  area_method=method;
+}
+/*--------------------------------------------------------*/
+int get_area_method()
+{
+  return(area_method);
+}
+/*--------------------------------------------------------*/
+static void add_vertex(xy)
+     coordinates xy;
+{
+  if(n_poly>=max_poly)
+    {
+      max_poly=2*max_poly+256;
+      poly=(coordinates *)grow(poly,max_poly,sizeof(coordinates));
+    }
+  poly[n_poly][0]=xy[0];
+  poly[n_poly][1]=xy[1];
+  n_poly=n_poly+1;
+}
+/*--------------------------------------------------------*/
+static double shoelace()
+{
+  double a;
+  int i,k;
+
+  a=0.0;
+  for(i=0;i<n_poly;i++)
+    {
+      k=(i+1)%n_poly;
+      a=a+poly[i][0]*poly[k][1]-poly[k][0]*poly[i][1];
+    }
+  return(0.5*a);
+}
+/*--------------------------------------------------------*/
+/* polygon: mouth, right streamline, contour from its end */
+/* (segment sr) to the left one's (segment sl) forwards   */
+/* or backwards, left streamline back to the mouth        */
+/*--------------------------------------------------------*/
+static double bounding_polygon(left,right,contour,sr,sl,forward)
+     path *left,*right,*contour;
+     int sr,sl,forward;
+{
+  coordinates xy;
+  int i,n;
+
+  n_poly=0;
+  for(i=0;i<right->points;i++)
+    {
+      get_path_xy(right,i,xy);
+      add_vertex(xy);
+    }
+  if(contour!=(path *)NULL)
+    {
+      n=contour->points;
+      if(forward)
+	for(i=(sr+1)%n;;i=(i+1)%n)
+	  {
+	    get_path_xy(contour,i,xy);
+	    add_vertex(xy);
+	    if(i==sl) break;
+	  }
+      else
+	for(i=sr;i!=sl;i=(i+n-1)%n)
+	  {
+	    get_path_xy(contour,i,xy);
+	    add_vertex(xy);
+	  }
+    }
+  for(i=left->points-1;i>=0;i--)
+    {
+      get_path_xy(left,i,xy);
+      add_vertex(xy);
+    }
+  return(shoelace());
+}
+/*--------------------------------------------------------*/
+/* area of the strip between a traced streamline and the  */
+/* level set of psi through its first point (the integral */
+/* of psi/|grad psi| along it), drift = psi at its end    */
+/*--------------------------------------------------------*/
+static double level_set_strip(c,line,vectors,drift)
+     catchment *c;
+     path *line;
+     bem_vectors *vectors;
+     double *drift;
+{
+  coordinates *xy,P,Q,G;
+  double *psi,*l,s,g,g0,a;
+  int n,i,k;
+
+  n=(line->points+LEVEL_SAMPLE-2)/LEVEL_SAMPLE+1;
+  xy=(coordinates *)grow((void *)NULL,n,sizeof(coordinates));
+  psi=(double *)grow((void *)NULL,n,sizeof(double));
+  l=(double *)grow((void *)NULL,n,sizeof(double));
+
+  /* every LEVEL_SAMPLE-th point and the last, with the length along the line */
+  get_path_xy(line,0,P);
+  xy[0][0]=P[0];  xy[0][1]=P[1];
+  l[0]=0.0;
+  s=0.0;
+  k=1;
+  for(i=1;i<line->points;i++)
+    {
+      get_path_xy(line,i,Q);
+      s=s+sqrt((Q[0]-P[0])*(Q[0]-P[0])+(Q[1]-P[1])*(Q[1]-P[1]));
+      if(i%LEVEL_SAMPLE==0 || i==line->points-1)
+	{
+	  xy[k][0]=Q[0];  xy[k][1]=Q[1];
+	  l[k]=s;
+	  k=k+1;
+	}
+      P[0]=Q[0];  P[1]=Q[1];
+    }
+  stream_function_along(c,n,xy,vectors,psi);
+
+  /* trapezoid in length of psi/|grad psi| (outside: |grad psi| as last inside) */
+  a=0.0;
+  g0=0.0;
+  for(k=0;k<n;k++)
+    {
+      g=(stream_gradient(c,xy[k],vectors,G)<0) ? g0 : sqrt(G[0]*G[0]+G[1]*G[1]);
+      if(k>0 && g>0.0 && g0>0.0)
+	a=a+(psi[k-1]/g0+psi[k]/g)*(l[k]-l[k-1])/2.0;
+      g0=g;
+    }
+  *drift=psi[n-1];
+  free((void *)xy);
+  free((void *)psi);
+  free((void *)l);
+  return(a);
+}
+/*--------------------------------------------------------*/
+double catchment_area_bounding(c,mouth,direction,max_steps,step_size,
+			       streamline,vectors)
+     catchment *c;
+     section *mouth;
+     int direction; /* 1 = go to max; 0 = go to min */
+     int max_steps; /* +ve = number of steps; -ve = don't check */
+     double step_size;
+     path **streamline; /* 2 streamlines: left and right end */
+     bem_vectors *vectors;
+{
+  bem_results R;
+  stream_stats stats;
+  coordinates P,Q,T,E,ends[2];
+  path *left,*right,*contour,*p;
+  double d,s,sign,A_forward,A_backward,A,psi[2],F,A_left,A_right,d_left,d_right;
+  int sl,sr,ok;
+
+  left=streamline[0];
+  right=streamline[1];
+  xy_section(mouth,0,P);
+  streamline_loop(P,c,direction,max_steps,step_size,left,vectors,&R);
+  get_stream_stats(&stats);
+  ok=(stats.reason==STOP_OUTSIDE);
+  xy_section(mouth,mouth->n-1,Q);
+  streamline_loop(Q,c,direction,max_steps,step_size,right,vectors,&R);
+  get_stream_stats(&stats);
+  ok=ok && (stats.reason==STOP_OUTSIDE);
+  if(left->points<2 || right->points<2)
+    {
+      printf("\n bounding streamlines too short for an area\n");
+      return(0.0);
+    }
+
+  /* side of the mouth the streamlines go to (streamline_loop moves P and Q) */
+  xy_section(mouth,0,P);
+  xy_section(mouth,mouth->n-1,Q);
+  get_path_xy(right,1,T);
+  sign=(Q[0]-P[0])*(T[1]-Q[1])-(Q[1]-P[1])*(T[0]-Q[0]);
+
+  /* contour both leave through */
+  get_path_xy(left,left->points-1,E);
+  check_each_path(c,E,&d,&s,&sl,&contour);
+  get_path_xy(right,right->points-1,E);
+  check_each_path(c,E,&d,&s,&sr,&p);
+  if(p!=contour || !ok)
+    {
+      printf("\n bounding streamlines do not leave through one contour;"
+	     " closing with a straight line");
+      contour=(path *)NULL;
+    }
+  A_forward=bounding_polygon(left,right,contour,sr,sl,1);
+  if(contour==(path *)NULL) A=A_forward;
+  else
+    {
+      A_backward=bounding_polygon(left,right,contour,sr,sl,0);
+      A=(A_forward*sign>A_backward*sign) ? A_forward : A_backward;
+    }
+  A=fabs(A);
+
+  /* level sets of psi through the ends of the mouth */
+  ends[0][0]=P[0];  ends[0][1]=P[1];
+  ends[1][0]=Q[0];  ends[1][1]=Q[1];
+  stream_function_along(c,2,ends,vectors,psi);
+  F=psi[1];
+  A_left=level_set_strip(c,left,vectors,&d_left);
+  A_right=level_set_strip(c,right,vectors,&d_right);
+  printf("\n polygon=%f flux=%f drift=%e,%e (of flux)",A,F,d_left/F,d_right/F);
+  A=A-((F<0.0) ? -1.0 : 1.0)*(A_right-A_left);
+  printf(" C_sum=%f",A);
+  return(A);
+}
+/*--------------------------------------------------------*/
 double Cal_SCA(c,mouth,direction,max_steps,step_size,
 	     n_stream,streamline,vectors) 
      catchment *c;
@@ -0,0 +1,253 @@
+/*----------------------------------- batch.c --------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* V, dV and d2V at many points at once                                             */
+/*                                                                                  */
+/* calculate_inside_catchment takes one point at a time: a 1x2N and a 1x4N row of   */
+/* geometry terms, each multiplied into bvv or bcv. Here the points are grouped by  */
+/* zone and, BATCH_BLOCK points at a time, the rows are built in parallel into one  */
+/* (K*q) x 6N matrix G, q = 1, 2 and 4 for V, dV and d2V: a row [vgv | cgv] for V   */
+/* and, for dV and d2V, one row per component of the co/ten terms (stored with 2    */
+/* or 4 numbers per term, so they are taken apart component by component). Then    */
+/*   Y = G * B,     B = [-bvv ; bcv]                                                */
+/* is a single product that holds all components of all K points.                  */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+
+#include "cblas.h"
+
+#include "catchment.h"
+#include "co_matrix.h"
+#include "linear_sys.h"
+#include "matrix.h"
+#include "ten_matrix.h"
+#include "vcalc.h"
+
+#include "batch.h"
+/*----------------------------------------------------------------------------------*/
+#define BATCH_BLOCK 32   /* points in one dgemm */
+/*----------------------------------------------------------------------------------*/
+static void *batch_memory(n)
+     size_t n;
+{
+  void *p;
+
+  p=malloc(n);
+  if(p==NULL)
+    {
+      printf("Cannot allocate memory for batch evaluation\n");
+      exit(0);
+    }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+/* the q components of the term rows of one point (q numbers per term, as made by   */
+/* the co/ten geometry vectors) into q rows of G, component by component           */
+/*----------------------------------------------------------------------------------*/
+static void batch_rows(N,q,T,G)
+     int N,q;
+     double *T,*G;
+{
+  int j,k;
+
+  for(k=0;k<q;k++)
+    for(j=0;j<6*N;j++)
+      G[(size_t)k*6*N+j]=T[j*q+k];
+}
+/*----------------------------------------------------------------------------------*/
+/* m points Q in zone b, which has been solved (bvv and bcv in x) */
+/*----------------------------------------------------------------------------------*/
+void calculate_batch_in_zone(b,m,Q,x,R,mask)
+     boundary *b;
+     int m;
+     coordinates *Q;
+     bem_vectors *x;
+     bem_results *R;
+     int mask;
+{
+  double *B,*G,*T,*Y,*bvv,*bcv;
+  int N,i,j,k,K,q,rows,first,base_dv,base_d2v;
+
+  N=0;
+  for(k=0;k<b->components;k++) N=N+b->loop[k]->points;
+  q=((mask & EVAL_V) ? 1 : 0)+((mask & EVAL_DV) ? 2 : 0)+((mask & EVAL_D2V) ? 4 : 0);
+  if(q==0)
+    {
+      for(i=0;i<m;i++) memset(&R[i],0,sizeof(bem_results));
+      return;
+    }
+
+  /* B = [-bvv ; bcv], the same for every component */
+  B=(double *)batch_memory((size_t)6*N*sizeof(double));
+  bvv=startof_matrix(x->bvv);
+  bcv=startof_matrix(x->bcv);
+  for(j=0;j<2*N;j++) B[j]=(-bvv[j]);
+  for(j=0;j<4*N;j++) B[2*N+j]=bcv[j];
+
+  G=(double *)batch_memory((size_t)BATCH_BLOCK*q*6*N*sizeof(double));
+  T=(double *)NULL;
+  if(mask & (EVAL_DV|EVAL_D2V))
+    T=(double *)batch_memory((size_t)BATCH_BLOCK*24*N*sizeof(double));
+  Y=(double *)batch_memory((size_t)BATCH_BLOCK*q*sizeof(double));
+  add_bem_evaluations((long)m);
+
+  reverse_zone(b);
+  for(first=0;first<m;first=first+BATCH_BLOCK)
+    {
+      K=(m-first<BATCH_BLOCK) ? m-first : BATCH_BLOCK;
+      base_dv=(mask & EVAL_V) ? K : 0;
+      base_d2v=base_dv+((mask & EVAL_DV) ? 2*K : 0);
+      rows=K*q;
+
+      /* geometry rows, one point per iteration: V in row i, dV in rows base_dv+2i+c, */
+      /* d2V in rows base_d2v+4i+c ([0][0], [0][1], [1][0], [1][1])                  */
+#pragma omp parallel for schedule(dynamic)
+      for(i=0;i<K;i++)
+	{
+	  matrix row,row2;
+	  co_matrix co_row,co_row2;
+	  ten_matrix ten_row,ten_row2;
+	  double *t;
+
+	  t=T+(size_t)i*24*N;
+	  if(mask & EVAL_V)
+	    {
+	      attach_matrix(&row,1,2*N,G+(size_t)i*6*N);
+	      attach_matrix(&row2,1,4*N,G+(size_t)i*6*N+2*N);
+	      make_voltage_geometry_vector(Q[first+i],b,&row);
+	      make_current_geometry_vector(Q[first+i],b,&row2);
+	    }
+	  if(mask & EVAL_DV)
+	    {
+	      attach_co_matrix(&co_row,1,2*N,(coordinates *)t);
+	      attach_co_matrix(&co_row2,1,4*N,(coordinates *)(t+4*N));
+	      make_co_voltage_geometry_vector(Q[first+i],b,&co_row);
+	      make_co_current_geometry_vector(Q[first+i],b,&co_row2);
+	      batch_rows(N,2,t,G+(size_t)(base_dv+2*i)*6*N);
+	    }
+	  if(mask & EVAL_D2V)
+	    {
+	      attach_ten_matrix(&ten_row,1,2*N,(tensor *)t);
+	      attach_ten_matrix(&ten_row2,1,4*N,(tensor *)(t+8*N));
+	      make_ten_voltage_geometry_vector(Q[first+i],b,&ten_row);
+	      make_ten_current_geometry_vector(Q[first+i],b,&ten_row2);
+	      batch_rows(N,4,t,G+(size_t)(base_d2v+4*i)*6*N);
+	    }
+	}
+
+      /* every component of every point: Y = G * B */
+      cblas_dgemv(CblasRowMajor,CblasNoTrans,rows,6*N,1.0,G,6*N,B,1,0.0,Y,1);
+      for(i=0;i<K;i++)
+	{
+	  R[first+i].V=(mask & EVAL_V) ? Y[i] : 0.0;
+	  if(mask & EVAL_DV)
+	    {
+	      R[first+i].dV[0]=Y[base_dv+2*i]/(2.0*M_PI);
+	      R[first+i].dV[1]=Y[base_dv+2*i+1]/(2.0*M_PI);
+	    }
+	  else
+	    {
+	      R[first+i].dV[0]=0.0; R[first+i].dV[1]=0.0;
+	    }
+	  if(mask & EVAL_D2V)
+	    {
+	      R[first+i].d2V[0][0]=Y[base_d2v+4*i]/(2.0*M_PI);
+	      R[first+i].d2V[0][1]=Y[base_d2v+4*i+1]/(2.0*M_PI);
+	      R[first+i].d2V[1][0]=Y[base_d2v+4*i+2]/(2.0*M_PI);
+	      R[first+i].d2V[1][1]=Y[base_d2v+4*i+3]/(2.0*M_PI);
+	    }
+	  else
+	    {
+	      R[first+i].d2V[0][0]=0.0; R[first+i].d2V[0][1]=0.0;
+	      R[first+i].d2V[1][0]=0.0; R[first+i].d2V[1][1]=0.0;
+	    }
+	}
+    }
+  reverse_zone(b);
+
+  free((void *)B);
+  free((void *)G);
+  if(T!=(double *)NULL) free((void *)T);
+  free((void *)Y);
+}
+/*----------------------------------------------------------------------------------*/
+/* calculate_inside_catchment for n points P: results in R, new_z as there          */
+/* (-1 outside, 1 for the point at which a zone was solved, otherwise 0)            */
+/*----------------------------------------------------------------------------------*/
+void calculate_batch(c,n,P,vectors,R,new_z,mask)
+     catchment *c;
+     int n;
+     coordinates *P;
+     bem_vectors *vectors;
+     bem_results *R;
+     int *new_z;
+     int mask;
+{
+  coordinates *Q;
+  bem_results *S;
+  int *zone,*index,i,m,z,done;
+
+  zone=(int *)batch_memory(n*sizeof(int));
+  index=(int *)batch_memory(n*sizeof(int));
+  Q=(coordinates *)batch_memory(n*sizeof(coordinates));
+  S=(bem_results *)batch_memory(n*sizeof(bem_results));
+
+  for(i=0;i<n;i++)
+    {
+      zone[i]=check_each_zone(c,P[i]);
+      new_z[i]=(zone[i]<0) ? (-1) : 0;
+      if(zone[i]<0)
+	{
+	  R[i].V=0.0;
+	  R[i].dV[0]=0.0;     R[i].dV[1]=0.0;
+	  R[i].d2V[0][0]=0.0; R[i].d2V[0][1]=0.0;
+	  R[i].d2V[1][0]=0.0; R[i].d2V[1][1]=0.0;
+	}
+    }
+
+  /* the zone solved last first, then the others in order of the points */
+  z=c->previous_zone;
+  do
+    {
+      m=0;
+      for(i=0;i<n;i++)
+	if(zone[i]==z && z>=0)
+	  {
+	    index[m]=i;
+	    Q[m][0]=P[i][0];
+	    Q[m][1]=P[i][1];
+	    m=m+1;
+	  }
+      if(m>0)
+	{
+	  if(z!=c->previous_zone)
+	    {
+	      c->previous_zone=z;
+	      new_z[index[0]]=1;
+	      solve_zone(c->zones[z],vectors);
+	    }
+	  calculate_batch_in_zone(c->zones[z],m,Q,vectors,S,mask);
+	  for(i=0;i<m;i++) R[index[i]]=S[i];
+	  for(i=0;i<m;i++) zone[index[i]]=(-1);
+	}
+      done=1;
+      for(i=0;i<n && done;i++)
+	if(zone[i]>=0) { z=zone[i]; done=0; }
+    }
+  while(!done);
+
+  free((void *)zone);
+  free((void *)index);
+  free((void *)Q);
+  free((void *)S);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
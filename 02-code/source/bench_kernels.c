@@ -0,0 +1,577 @@
+/*--------------------------------- bench_kernels.c --------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* timings of the kernels the solver and the tracer spend their time in             */
+/*                                                                                  */
+/* The zone is an annulus between two circles of --n points each, with the values   */
+/* of the harmonic V=V1+(V2-V1)ln(r/r1)/ln(r2/r1) on them, so the field found at a  */
+/* point can be checked as well. The zone is solved once (solve_zone) and then     */
+/* each kernel is called over BENCH_POINTS points inside it (and the segments of    */
+/* the outer circle):                                                               */
+/*   convert_PQ, every term of terms.c and its derivatives (on and off segment     */
+/*   inputs as the matrices and vectors use them), distance_to_path,                */
+/*   check_each_zone, every fill_*_geometry_vector and calculate_in_same_zone.      */
+/* A sample is a run of calls long enough for --min-time; after --warmup samples    */
+/* that are thrown away, --reps samples are taken and the median and percentiles   */
+/* of the time of one call are written to --json (one kernel per line). With        */
+/* --baseline the medians are compared with those of an earlier file and the        */
+/* program returns 1 if one is slower by more than --tolerance.                     */
+/*                                                                                  */
+/*   bench_kernels --n=400 --reps=31 --json=base.json                               */
+/*   bench_kernels --n=400 --baseline=base.json --tolerance=0.1                     */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "logging_types.h"
+
+#include "boundary.h"
+#include "catchment.h"
+#include "geometry.h"
+#include "linear_sys.h"
+#include "logging.h"
+#include "memory.h"
+#include "path.h"
+#include "terms.h"
+#include "vcalc.h"
+/*----------------------------------------------------------------------------------*/
+#define BENCH_POINTS  64     /* points in the zone the kernels are called at */
+#define BENCH_KERNELS 128
+#define BENCH_MAX_REPS 1001
+
+#define R_INNER 500.0        /* radii and values of the circles */
+#define R_OUTER 1000.0
+#define V_INNER 1400.0
+#define V_OUTER 1600.0
+/*----------------------------------------------------------------------------------*/
+typedef double (*term3_f)(double x, double y1, double y2);
+typedef double (*term2_f)(double y1, double y2);
+typedef void (*term_co_f)(double x, double y1, double y2, coordinates v);
+typedef void (*term_ten_f)(double x, double y1, double y2, tensor v);
+typedef void (*bench_f)(void *arg, int i);
+
+typedef struct {
+  char *name;
+  void *f;
+  int on;           /* 1 = inputs of P on the segment */
+} term_entry;
+
+typedef struct {
+  double x,y1,y2;
+} term_input;
+
+typedef struct {
+  char name[48];
+  long inner;       /* calls in a sample */
+  double median,p10,p90,p99,min,mean;   /* ns per call */
+} bench_result;
+/*----------------------------------------------------------------------------------*/
+static int n_points=200;
+static int reps=31;
+static int warmup=3;
+static double min_time=0.001;
+static char *only=(char *)NULL;
+static char *json_file="bench_kernels.json";
+static char *baseline=(char *)NULL;
+static double tolerance=0.10;
+
+static catchment *c;
+static boundary *b;
+static path *outer,*inner;
+static bem_vectors *vectors;
+static matrix bvv,bcv;
+static coordinates P[BENCH_POINTS];
+static term_input off_input[BENCH_POINTS],on_input[BENCH_POINTS];
+static bench_result results[BENCH_KERNELS];
+static char *fills[7]={
+  "fill_voltage_geometry_vector","fill_current_geometry_vector",
+  "fill_kcl_geometry_vector","fill_co_voltage_geometry_vector",
+  "fill_co_current_geometry_vector","fill_ten_voltage_geometry_vector",
+  "fill_ten_current_geometry_vector"};
+static int n_results=0;
+static volatile double sink;
+/*----------------------------------------------------------------------------------*/
+static double seconds_now()
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return((double)t.tv_sec+(double)t.tv_nsec*1.0e-9);
+}
+/*----------------------------------------------------------------------------------*/
+static double exact_V(Q)
+     coordinates Q;
+{
+  double r;
+
+  r=hypot(Q[0],Q[1]);
+  return(V_INNER+(V_OUTER-V_INNER)*log(r/R_INNER)/log(R_OUTER/R_INNER));
+}
+/*----------------------------------------------------------------------------------*/
+static path *circle(n,radius,value)
+     int n;
+     double radius,value;
+{
+  path *p;
+  coordinates xy;
+  int k;
+
+  p=create_path(n,1,1);
+  close_path(p);
+  for(k=0;k<n;k++)
+    {
+      xy[0]=radius*cos(2.0*M_PI*k/n);
+      xy[1]=radius*sin(2.0*M_PI*k/n);
+      put_path_xy(p,k,xy);
+      put_path_value(p,k,value);
+    }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+/* the annulus as a catchment of one zone, as get_catchment would have made it */
+/*----------------------------------------------------------------------------------*/
+static void make_zone()
+{
+  coordinates Qa,Qb,Q;
+  double r,t,x,y1,y2;
+  int i,k;
+
+  c=create_catchment(1,2);
+  outer=circle(n_points,R_OUTER,V_OUTER);
+  inner=circle(n_points,R_INNER,V_INNER);
+  c->path_list[0].path_p=outer;
+  strcpy(c->path_list[0].name,"outer");
+  c->path_list[1].path_p=inner;
+  strcpy(c->path_list[1].name,"inner");
+  c->num_paths=2;
+
+  b=create_boundary(2);
+  b->loop[0]=outer;
+  b->loop[1]=inner;
+  mark_curve(b);
+  mark_paths(b);
+  c->zones[0]=b;
+  c->num_zones=1;
+
+  for(i=0;i<BENCH_POINTS;i++)
+    {
+      t=fmod(i*0.6180339887,1.0);
+      r=R_INNER+(R_OUTER-R_INNER)*(0.1+0.8*fmod(i*0.7548776662,1.0));
+      P[i][0]=r*cos(2.0*M_PI*t);
+      P[i][1]=r*sin(2.0*M_PI*t);
+
+      k=(i*7)%n_points;
+      get_path_xy(outer,k,Qa);
+      get_path_xy(outer,k+1,Qb);
+      convert_PQ(Qa,Qb,P[i],&x,&y1,&y2);
+      off_input[i].x=x;
+      off_input[i].y1=y1;
+      off_input[i].y2=y2;
+
+      t=0.25*(i%5);             /* the collocation points of the segment */
+      Q[0]=Qa[0]+t*(Qb[0]-Qa[0]);
+      Q[1]=Qa[1]+t*(Qb[1]-Qa[1]);
+      convert_PQ(Qa,Qb,Q,&x,&y1,&y2);
+      on_input[i].x=x;
+      on_input[i].y1=y1;
+      on_input[i].y2=y2;
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/* the kernels, one call at input i */
+/*----------------------------------------------------------------------------------*/
+static void run_term3(arg,i)
+     void *arg;
+     int i;
+{
+  term_entry *e;
+  term_input *in;
+
+  e=(term_entry *)arg;
+  in=(e->on) ? &on_input[i%BENCH_POINTS] : &off_input[i%BENCH_POINTS];
+  sink=((term3_f)e->f)(in->x,in->y1,in->y2);
+}
+/*----------------------------------------------------------------------------------*/
+static void run_term2(arg,i)
+     void *arg;
+     int i;
+{
+  term_entry *e;
+  term_input *in;
+
+  e=(term_entry *)arg;
+  in=&on_input[i%BENCH_POINTS];
+  sink=((term2_f)e->f)(in->y1,in->y2);
+}
+/*----------------------------------------------------------------------------------*/
+static void run_term_co(arg,i)
+     void *arg;
+     int i;
+{
+  term_entry *e;
+  term_input *in;
+  coordinates v;
+
+  e=(term_entry *)arg;
+  in=&off_input[i%BENCH_POINTS];
+  ((term_co_f)e->f)(in->x,in->y1,in->y2,v);
+  sink=v[0];
+}
+/*----------------------------------------------------------------------------------*/
+static void run_term_ten(arg,i)
+     void *arg;
+     int i;
+{
+  term_entry *e;
+  term_input *in;
+  tensor v;
+
+  e=(term_entry *)arg;
+  in=&off_input[i%BENCH_POINTS];
+  ((term_ten_f)e->f)(in->x,in->y1,in->y2,v);
+  sink=v[0][0];
+}
+/*----------------------------------------------------------------------------------*/
+static void run_convert_PQ(arg,i)
+     void *arg;
+     int i;
+{
+  coordinates Qa,Qb;
+  double x,y1,y2;
+  int k;
+
+  k=(i*7)%n_points;
+  get_path_xy(outer,k,Qa);
+  get_path_xy(outer,k+1,Qb);
+  convert_PQ(Qa,Qb,P[i%BENCH_POINTS],&x,&y1,&y2);
+  sink=x;
+}
+/*----------------------------------------------------------------------------------*/
+static void run_distance_to_path(arg,i)
+     void *arg;
+     int i;
+{
+  double d,s;
+  int segment;
+
+  sink=distance_to_path(P[i%BENCH_POINTS],outer,&d,&s,&segment);
+}
+/*----------------------------------------------------------------------------------*/
+static void run_check_each_zone(arg,i)
+     void *arg;
+     int i;
+{
+  sink=check_each_zone(c,P[i%BENCH_POINTS]);
+}
+/*----------------------------------------------------------------------------------*/
+static void run_fill(arg,i)
+     void *arg;
+     int i;
+{
+  coordinates *Q;
+
+  Q=&P[i%BENCH_POINTS];
+  switch((char **)arg-fills)   /* the outer circle, vectors as solve_zone sized them */
+    {
+    case 0: fill_voltage_geometry_vector(*Q,0,outer,vectors->vgv); break;
+    case 1: fill_current_geometry_vector(*Q,0,outer,vectors->cgv); break;
+    case 2: fill_kcl_geometry_vector(0,outer,vectors->cgv); break;
+    case 3: fill_co_voltage_geometry_vector(*Q,0,outer,vectors->co_vgv); break;
+    case 4: fill_co_current_geometry_vector(*Q,0,outer,vectors->co_cgv); break;
+    case 5: fill_ten_voltage_geometry_vector(*Q,0,outer,vectors->ten_vgv); break;
+    case 6: fill_ten_current_geometry_vector(*Q,0,outer,vectors->ten_cgv); break;
+    }
+}
+/*----------------------------------------------------------------------------------*/
+static void run_calculate_in_same_zone(arg,i)
+     void *arg;
+     int i;
+{
+  bem_results R;
+
+  sink=calculate_in_same_zone(b,P[i%BENCH_POINTS],vectors,&R,EVAL_ALL);
+}
+/*----------------------------------------------------------------------------------*/
+/* timing */
+/*----------------------------------------------------------------------------------*/
+static int compare_double(p,q)
+     const void *p,*q;
+{
+  double a,b;
+
+  a=*(double *)p;
+  b=*(double *)q;
+  return((a>b)-(a<b));
+}
+/*----------------------------------------------------------------------------------*/
+static double percentile(x,n,p)
+     double *x;
+     int n;
+     double p;
+{
+  double r;
+  int k;
+
+  r=p*(n-1);
+  k=(int)r;
+  if(k>=n-1) return(x[n-1]);
+  return(x[k]+(r-k)*(x[k+1]-x[k]));
+}
+/*----------------------------------------------------------------------------------*/
+static double run_sample(f,arg,inner_calls)
+     bench_f f;
+     void *arg;
+     long inner_calls;
+{
+  double t;
+  long k;
+
+  t=seconds_now();
+  for(k=0;k<inner_calls;k++) f(arg,(int)k);
+  return(seconds_now()-t);
+}
+/*----------------------------------------------------------------------------------*/
+static void bench(name,f,arg)
+     char *name;
+     bench_f f;
+     void *arg;
+{
+  bench_result *r;
+  double sample[BENCH_MAX_REPS],sum;
+  long inner_calls;
+  int k;
+
+  if(only!=(char *)NULL && strstr(name,only)==(char *)NULL) return;
+  if(n_results==BENCH_KERNELS)
+    {
+      printf("More than %d kernels\n",BENCH_KERNELS);
+      exit(0);
+    }
+
+  inner_calls=1;                    /* a sample of at least min_time */
+  while(run_sample(f,arg,inner_calls)<min_time && inner_calls<(1L<<30))
+    inner_calls=inner_calls*2;
+  for(k=0;k<warmup;k++) run_sample(f,arg,inner_calls);
+
+  sum=0.0;
+  for(k=0;k<reps;k++)
+    {
+      sample[k]=run_sample(f,arg,inner_calls)/inner_calls*1.0e9;
+      sum=sum+sample[k];
+    }
+  qsort(sample,reps,sizeof(double),compare_double);
+
+  r=&results[n_results++];
+  strncpy(r->name,name,sizeof(r->name)-1);
+  r->name[sizeof(r->name)-1]='\0';
+  r->inner=inner_calls;
+  r->median=percentile(sample,reps,0.5);
+  r->p10=percentile(sample,reps,0.1);
+  r->p90=percentile(sample,reps,0.9);
+  r->p99=percentile(sample,reps,0.99);
+  r->min=sample[0];
+  r->mean=sum/reps;
+  printf("  %-34s %12.1f ns  (p10 %.1f, p90 %.1f)\n",r->name,r->median,r->p10,r->p90);
+  fflush(stdout);
+}
+/*----------------------------------------------------------------------------------*/
+static void write_json(file,solve_time,max_error)
+     char *file;
+     double solve_time,max_error;
+{
+  FILE *output;
+  bench_result *r;
+  int i;
+
+  output=fopen(file,"w");
+  if(output==(FILE *)NULL)
+    {
+      printf("Cannot open benchmark file: '%s'\n",file);
+      exit(0);
+    }
+  fprintf(output,"{\n");
+  fprintf(output,"  \"benchmark\": \"bench_kernels\",\n");
+  fprintf(output,"  \"n\": %d,\n",n_points);
+  fprintf(output,"  \"reps\": %d,\n",reps);
+  fprintf(output,"  \"warmup\": %d,\n",warmup);
+  fprintf(output,"  \"min_time\": %g,\n",min_time);
+  fprintf(output,"  \"solve_zone_s\": %.6f,\n",solve_time);
+  fprintf(output,"  \"max_error_V\": %.6e,\n",max_error);
+  fprintf(output,"  \"kernels\": [\n");
+  for(i=0;i<n_results;i++)
+    {
+      r=&results[i];
+      fprintf(output,"    {\"name\": \"%s\", \"inner\": %ld, \"median_ns\": %.3f, "
+	      "\"p10_ns\": %.3f, \"p90_ns\": %.3f, \"p99_ns\": %.3f, \"min_ns\": %.3f, "
+	      "\"mean_ns\": %.3f}%s\n",r->name,r->inner,r->median,r->p10,r->p90,r->p99,
+	      r->min,r->mean,(i<n_results-1) ? "," : "");
+    }
+  fprintf(output,"  ]\n}\n");
+  fclose(output);
+  printf("\nTimings written to: %s\n",file);
+}
+/*----------------------------------------------------------------------------------*/
+/* medians against those of file (as written by write_json); number of slower ones */
+/*----------------------------------------------------------------------------------*/
+static int compare_baseline(file)
+     char *file;
+{
+  FILE *input;
+  char line[512],name[48],*p;
+  double base;
+  int i,n,found,slower;
+
+  input=fopen(file,"r");
+  if(input==(FILE *)NULL)
+    {
+      printf("Cannot open baseline file: '%s'\n",file);
+      exit(0);
+    }
+  printf("\nAgainst %s (slower by more than %.0f%% is marked):\n",file,tolerance*100.0);
+  printf("  %-34s %12s %12s %8s\n","kernel","baseline ns","now ns","ratio");
+  slower=0;
+  found=0;
+  while(fgets(line,sizeof(line),input)!=(char *)NULL)
+    {
+      if(sscanf(line," \"n\": %d",&n)==1 && n!=n_points)
+	printf("  (baseline has n=%d, this run n=%d)\n",n,n_points);
+      if(sscanf(line," {\"name\": \"%47[^\"]\"",name)!=1) continue;
+      p=strstr(line,"\"median_ns\":");
+      if(p==(char *)NULL || sscanf(p,"\"median_ns\": %lf",&base)!=1) continue;
+      for(i=0;i<n_results;i++)
+	if(strcmp(results[i].name,name)==0) break;
+      if(i==n_results) continue;
+      found=found+1;
+      printf("  %-34s %12.1f %12.1f %8.3f%s\n",name,base,results[i].median,
+	     results[i].median/base,
+	     (results[i].median>base*(1.0+tolerance)) ? "  SLOWER" :
+	     (results[i].median<base*(1.0-tolerance)) ? "  faster" : "");
+      if(results[i].median>base*(1.0+tolerance)) slower=slower+1;
+    }
+  fclose(input);
+  printf("  %d kernels compared, %d slower\n",found,slower);
+  return(slower);
+}
+/*----------------------------------------------------------------------------------*/
+static void parse_options(argc,argv)
+     int argc;
+     char **argv;
+{
+  char *value;
+  int i;
+
+  for(i=1;i<argc;i++)
+    {
+      value=strchr(argv[i],'=');
+      if(strncmp(argv[i],"--",2)!=0 || value==(char *)NULL)
+	{
+	  printf("unknown option '%s'\n",argv[i]);
+	  exit(0);
+	}
+      value=value+1;
+      if(strncmp(argv[i],"--n=",4)==0) n_points=atoi(value);
+      else if(strncmp(argv[i],"--reps=",7)==0) reps=atoi(value);
+      else if(strncmp(argv[i],"--warmup=",9)==0) warmup=atoi(value);
+      else if(strncmp(argv[i],"--min-time=",11)==0) min_time=atof(value);
+      else if(strncmp(argv[i],"--only=",7)==0) only=value;
+      else if(strncmp(argv[i],"--json=",7)==0) json_file=value;
+      else if(strncmp(argv[i],"--baseline=",11)==0) baseline=value;
+      else if(strncmp(argv[i],"--tolerance=",12)==0) tolerance=atof(value);
+      else
+	{
+	  printf("unknown option '%s'\n",argv[i]);
+	  exit(0);
+	}
+    }
+  if(n_points<8 || reps<1 || reps>BENCH_MAX_REPS || warmup<0)
+    {
+      printf("need --n>=8, 1<=--reps<=%d and --warmup>=0\n",BENCH_MAX_REPS);
+      exit(0);
+    }
+}
+/*----------------------------------------------------------------------------------*/
+int main(argc,argv)
+     int argc;
+     char **argv;
+{
+  static term_entry terms[]={
+    {"Vterm_PonS",(void *)Vterm_PonS,1},{"Wterm_PonS",(void *)Wterm_PonS,1},
+    {"Jterm_PonS",(void *)Jterm_PonS,1},{"Kterm_PonS",(void *)Kterm_PonS,1},
+    {"Lterm_PonS",(void *)Lterm_PonS,1},{"Mterm_PonS",(void *)Mterm_PonS,1},
+    {"Vterm_PoffS",(void *)Vterm_PoffS,0},{"Wterm_PoffS",(void *)Wterm_PoffS,0},
+    {"Jterm_PoffS",(void *)Jterm_PoffS,0},{"Kterm_PoffS",(void *)Kterm_PoffS,0},
+    {"Lterm_PoffS",(void *)Lterm_PoffS,0},{"Mterm_PoffS",(void *)Mterm_PoffS,0},
+    {"Tv",(void *)Tv,0},{"Tw",(void *)Tw,0},{"Tj",(void *)Tj,0},
+    {"Tk",(void *)Tk,0},{"Tl",(void *)Tl,0},{"Tm",(void *)Tm,0},
+    {"X1v",(void *)X1v,0},{"Y1v",(void *)Y1v,0},{"X1w",(void *)X1w,0},
+    {"Y1w",(void *)Y1w,0},{"X1j",(void *)X1j,0},{"Y1j",(void *)Y1j,0},
+    {"X1k",(void *)X1k,0},{"Y1k",(void *)Y1k,0},{"X1l",(void *)X1l,0},
+    {"Y1l",(void *)Y1l,0},{"X1m",(void *)X1m,0},{"Y1m",(void *)Y1m,0},
+    {"X2v",(void *)X2v,0},{"Z2v",(void *)Z2v,0},{"X2w",(void *)X2w,0},
+    {"Z2w",(void *)Z2w,0},{"X2j",(void *)X2j,0},{"Z2j",(void *)Z2j,0},
+    {"X2k",(void *)X2k,0},{"Z2k",(void *)Z2k,0},{"X2l",(void *)X2l,0},
+    {"Z2l",(void *)Z2l,0},{"X2m",(void *)X2m,0},{"Z2m",(void *)Z2m,0}};
+  static term_entry u_terms[]={
+    {"Uj",(void *)Uj,1},{"Uk",(void *)Uk,1},{"Ul",(void *)Ul,1},{"Um",(void *)Um,1}};
+  static term_entry co_terms[]={
+    {"V1",(void *)V1,0},{"W1",(void *)W1,0},{"J1",(void *)J1,0},
+    {"K1",(void *)K1,0},{"L1",(void *)L1,0},{"M1",(void *)M1,0}};
+  static term_entry ten_terms[]={
+    {"V2",(void *)V2,0},{"W2",(void *)W2,0},{"J2",(void *)J2,0},
+    {"K2",(void *)K2,0},{"L2",(void *)L2,0},{"M2",(void *)M2,0}};
+  bem_results R;
+  double solve_time,error,max_error;
+  int i;
+
+  parse_options(argc,argv);
+  set_log_level(LOG_WARN);
+
+  make_zone();
+  vectors=create_bem_vectors(&bvv,&bcv,max_points_in_any_zone(c));
+  solve_time=seconds_now();
+  solve_zone(b,vectors);
+  solve_time=seconds_now()-solve_time;
+
+  max_error=0.0;
+  for(i=0;i<BENCH_POINTS;i++)
+    {
+      calculate_in_same_zone(b,P[i],vectors,&R,EVAL_V);
+      error=fabs(R.V-exact_V(P[i]));
+      if(error>max_error) max_error=error;
+    }
+
+  printf("Kernel timings: annulus of 2 x %d points, %d reps after %d warm-up, "
+	 "samples of %g s\n",n_points,reps,warmup,min_time);
+  printf("  solve_zone:                        %.6f s\n",solve_time);
+  printf("  max |V - exact| at %d points:      %.3e\n\n",BENCH_POINTS,max_error);
+
+  bench("convert_PQ",run_convert_PQ,NULL);
+  for(i=0;i<(int)(sizeof(terms)/sizeof(term_entry));i++)
+    bench(terms[i].name,run_term3,&terms[i]);
+  for(i=0;i<(int)(sizeof(u_terms)/sizeof(term_entry));i++)
+    bench(u_terms[i].name,run_term2,&u_terms[i]);
+  for(i=0;i<(int)(sizeof(co_terms)/sizeof(term_entry));i++)
+    bench(co_terms[i].name,run_term_co,&co_terms[i]);
+  for(i=0;i<(int)(sizeof(ten_terms)/sizeof(term_entry));i++)
+    bench(ten_terms[i].name,run_term_ten,&ten_terms[i]);
+  bench("distance_to_path",run_distance_to_path,NULL);
+  bench("check_each_zone",run_check_each_zone,NULL);
+  reverse_zone(b);                 /* as make_internal_field has it */
+  for(i=0;i<7;i++)
+    bench(fills[i],run_fill,&fills[i]);
+  reverse_zone(b);
+  bench("calculate_in_same_zone",run_calculate_in_same_zone,NULL);
+
+  write_json(json_file,solve_time,max_error);
+  if(baseline!=(char *)NULL && compare_baseline(baseline)>0) return(1);
+  return(0);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,677 @@
+/*--------------------------------- bench_linalg.c ---------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* scaling of the linear algebra of solve_zone, on the shapes it has for a zone of  */
+/* N points: B is (5N+1) x 4N and                                                   */
+/*   btb      BT*B, 4N x 4N: multiply_matrix_sequential, _openmp_hybrid,            */
+/*            _cache_hybrid, _simd_hybrid, multiply_matrix_openblas (dgemm) and     */
+/*            cblas_dsyrk (the upper half only)                                     */
+/*   gemv     BT*DAV: multiply_matrix (the loop it falls back to for a vector)      */
+/*            and cblas_dgemv                                                       */
+/*   dot      1 x 4N times 4N x 1, as a point is evaluated: multiply_matrix and     */
+/*            cblas_ddot                                                            */
+/*   lu       LAPACKE_dgetrf of BT*B                                                */
+/*   inverse  mat_inv (LAPACK) and the Gauss-Jordan of invert_this_matrix           */
+/*   solve    BT*B x = BT*DAV: inverse then multiply_matrix (as bsolve does it),    */
+/*            getrf+getrs and potrf+potrs (Cholesky)                                */
+/* for each N of --n and each thread count of --threads (OpenMP and OpenBLAS).      */
+/* Inputs that a kernel overwrites are copied back before each call, outside the    */
+/* time. The time of a call is the min and median of --reps samples; the rate is    */
+/* from the min, and the efficiency is against the rate of a square dgemm of        */
+/* --peak-n at the same thread count. The error is the largest difference from the  */
+/* library result over its largest element (for solve, the relative residual).      */
+/* --csv gets one line per kernel, backend, N and thread count; --crossover gets,   */
+/* for each backend of our own and each library backend of the same kernel, the     */
+/* smallest N from which the library is faster at every larger N (-1 if never).     */
+/*                                                                                  */
+/*   bench_linalg --n=25,50,100,200,400 --threads=1,8 --reps=5                      */
+/*                                                                                  */
+/* The sequential, OpenMP and Gauss-Jordan backends are not run for N over          */
+/* --slow-max-n.                                                                    */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <omp.h>
+/*----------------------------------------------------------------------------------*/
+#include "logging_types.h"
+#include "matrix_multiply_optimized.h"   /* and matrix_types.h */
+
+#include "cblas.h"
+#include "lapacke.h"
+
+#include "logging.h"
+#include "matrix.h"
+/*----------------------------------------------------------------------------------*/
+#define LINALG_MAX_N       32
+#define LINALG_MAX_THREADS 16
+#define LINALG_MAX_REPS    101
+#define LINALG_MAX_RESULTS 4096
+/*----------------------------------------------------------------------------------*/
+extern int mat_inv(double *A, unsigned n);
+
+typedef void (*linalg_f)(void);
+typedef double (*flops_f)(void);
+
+typedef struct {
+  char *kernel;
+  char *backend;
+  int library;      /* 1 = OpenBLAS or LAPACK */
+  int slow;         /* 1 = not run for N over --slow-max-n */
+  linalg_f prepare; /* puts back the input a call overwrites, or NULL */
+  linalg_f run;
+  linalg_f check;   /* sets error after a call, or NULL */
+  flops_f flops;
+} linalg_op;
+
+typedef struct {
+  char kernel[16];
+  char backend[24];
+  int library;
+  int n,rows,columns,threads;
+  double min,median,gflops,efficiency,error;
+} linalg_result;
+/*----------------------------------------------------------------------------------*/
+static int n_list[LINALG_MAX_N]={25,50,100,200};
+static int n_count=4;
+static int thread_list[LINALG_MAX_THREADS];
+static int thread_count=0;
+static int reps=3;
+static double min_time=0.01;
+static int slow_max_n=200;
+static int peak_n=1024;
+static char *csv_file="bench_linalg.csv";
+static char *crossover_file="bench_linalg_crossover.csv";
+
+static int N,M,n;                 /* points, rows of B, columns of B */
+static matrix *B,BT,*G,*X,*W,*INV,*DAV,*BTDAV,*Y,*U,*S;
+static double *rhs,*sol;
+static int *ipiv;
+static double error,dot,dot_ref,g_norm;
+static unsigned long seed=12345;
+
+static linalg_result results[LINALG_MAX_RESULTS];
+static int n_results=0;
+/*----------------------------------------------------------------------------------*/
+static double seconds_now()
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return((double)t.tv_sec+(double)t.tv_nsec*1.0e-9);
+}
+/*----------------------------------------------------------------------------------*/
+static double random_value()
+{
+  seed=seed*6364136223846793005UL+1442695040888963407UL;
+  return((double)(seed>>11)/(double)(1UL<<53)*2.0-1.0);
+}
+/*----------------------------------------------------------------------------------*/
+static double max_difference(x,y,count)
+     double *x,*y;
+     int count;
+{
+  double d,big;
+  int i;
+
+  d=0.0;
+  big=0.0;
+  for(i=0;i<count;i++)
+    {
+      if(fabs(x[i]-y[i])>d) d=fabs(x[i]-y[i]);
+      if(fabs(y[i])>big) big=fabs(y[i]);
+    }
+  return((big>0.0) ? d/big : d);
+}
+/*----------------------------------------------------------------------------------*/
+/* the matrices of a zone of N points */
+/*----------------------------------------------------------------------------------*/
+static void make_problem(points)
+     int points;
+{
+  double norm;
+  int i;
+
+  N=points;
+  M=5*N+1;
+  n=4*N;
+  B=create_matrix(M,n);
+  for(i=0;i<M*n;i++) B->value[i]=random_value();
+  attach_matrix(&BT,M,n,B->value);               /* share data of B */
+  transpose_matrix(&BT,&BT);
+
+  G=create_matrix(n,n);                          /* BT*B, the reference */
+  multiply_matrix_openblas(&BT,B,G);
+  X=create_matrix(n,n);
+  W=create_matrix(n,n);
+  INV=create_matrix(n,n);
+  memcpy(INV->value,G->value,sizeof(double)*n*n);
+  mat_inv(INV->value,n);
+
+  DAV=create_matrix(M,1);
+  for(i=0;i<M;i++) DAV->value[i]=random_value();
+  BTDAV=create_matrix(n,1);
+  Y=create_matrix(n,1);
+  cblas_dgemv(CblasColMajor,CblasTrans,M,n,1.0,B->value,M,DAV->value,1,0.0,Y->value,1);
+  U=create_matrix(1,n);
+  memcpy(U->value,G->value,sizeof(double)*n);   /* a row as a point has it */
+  S=create_matrix(1,1);
+  dot_ref=cblas_ddot(n,U->value,1,Y->value,1);
+  g_norm=0.0;                                    /* infinity norm of G */
+  for(i=0;i<n;i++)
+    {
+      norm=cblas_dasum(n,&G->value[i],n);
+      if(norm>g_norm) g_norm=norm;
+    }
+
+  rhs=(double *)malloc(sizeof(double)*n);
+  sol=(double *)malloc(sizeof(double)*n);
+  ipiv=(int *)malloc(sizeof(int)*n);
+  if(rhs==(double *)NULL || sol==(double *)NULL || ipiv==(int *)NULL)
+    {
+      printf("error allocating memory for N=%d\n",N);
+      exit(0);
+    }
+  memcpy(rhs,Y->value,sizeof(double)*n);
+}
+/*----------------------------------------------------------------------------------*/
+static void free_problem()
+{
+  B=destroy_matrix(B);
+  G=destroy_matrix(G);
+  X=destroy_matrix(X);
+  W=destroy_matrix(W);
+  INV=destroy_matrix(INV);
+  DAV=destroy_matrix(DAV);
+  BTDAV=destroy_matrix(BTDAV);
+  Y=destroy_matrix(Y);
+  U=destroy_matrix(U);
+  S=destroy_matrix(S);
+  free(rhs);
+  free(sol);
+  free(ipiv);
+}
+/*----------------------------------------------------------------------------------*/
+/* flops of the kernels */
+/*----------------------------------------------------------------------------------*/
+static double flops_gemm() { return(2.0*M*(double)n*n); }
+static double flops_syrk() { return((double)M*n*(n+1)); }
+static double flops_gemv() { return(2.0*M*(double)n); }
+static double flops_dot() { return(2.0*n); }
+static double flops_lu() { return(2.0/3.0*(double)n*n*n); }
+static double flops_inverse() { return(2.0*(double)n*n*n); }
+static double flops_solve_inverse() { return(2.0*(double)n*n*n+2.0*(double)n*n); }
+static double flops_solve_lu() { return(2.0/3.0*(double)n*n*n+2.0*(double)n*n); }
+static double flops_solve_cholesky() { return(1.0/3.0*(double)n*n*n+2.0*(double)n*n); }
+/*----------------------------------------------------------------------------------*/
+/* the kernels */
+/*----------------------------------------------------------------------------------*/
+static void run_sequential() { multiply_matrix_sequential(&BT,B,X); }
+static void run_openmp() { multiply_matrix_openmp_hybrid(&BT,B,X); }
+static void run_cache() { multiply_matrix_cache_hybrid(&BT,B,X,get_block_size()); }
+static void run_simd() { multiply_matrix_simd_hybrid(&BT,B,X,get_block_size()); }
+static void run_dgemm() { multiply_matrix_openblas(&BT,B,X); }
+
+static void run_dsyrk()
+{
+  cblas_dsyrk(CblasColMajor,CblasUpper,CblasTrans,n,M,1.0,B->value,M,0.0,X->value,n);
+}
+/*----------------------------------------------------------------------------------*/
+static void run_gemv_loop() { multiply_matrix(&BT,DAV,BTDAV); }
+
+static void run_dgemv()
+{
+  cblas_dgemv(CblasColMajor,CblasTrans,M,n,1.0,B->value,M,DAV->value,1,0.0,
+	      BTDAV->value,1);
+}
+/*----------------------------------------------------------------------------------*/
+static void run_dot_loop()
+{
+  multiply_matrix(U,Y,S);
+  dot=S->value[0];
+}
+
+static void run_ddot()
+{
+  dot=cblas_ddot(n,U->value,1,Y->value,1);
+}
+/*----------------------------------------------------------------------------------*/
+static void prepare_copy()
+{
+  memcpy(W->value,G->value,sizeof(double)*n*n);
+  W->transpose=0;
+  W->invert=0;
+  memcpy(sol,rhs,sizeof(double)*n);
+}
+
+static void run_dgetrf()
+{
+  LAPACKE_dgetrf(LAPACK_COL_MAJOR,n,n,W->value,n,ipiv);
+}
+
+static void run_mat_inv() { mat_inv(W->value,n); }
+
+static void run_gauss_jordan() { invert_this_matrix(W); }
+/*----------------------------------------------------------------------------------*/
+static void run_solve_inverse()
+{
+  matrix x,b;
+
+  mat_inv(W->value,n);
+  attach_matrix(&b,n,1,rhs);
+  attach_matrix(&x,n,1,sol);
+  multiply_matrix(W,&b,&x);
+}
+
+static void run_solve_lu()
+{
+  LAPACKE_dgetrf(LAPACK_COL_MAJOR,n,n,W->value,n,ipiv);
+  LAPACKE_dgetrs(LAPACK_COL_MAJOR,'N',n,1,W->value,n,ipiv,sol,n);
+}
+
+static void run_solve_cholesky()
+{
+  LAPACKE_dpotrf(LAPACK_COL_MAJOR,'U',n,W->value,n);
+  LAPACKE_dpotrs(LAPACK_COL_MAJOR,'U',n,1,W->value,n,sol,n);
+}
+/*----------------------------------------------------------------------------------*/
+/* checks against the library results */
+/*----------------------------------------------------------------------------------*/
+static void check_btb() { error=max_difference(X->value,G->value,n*n); }
+
+static void check_upper()
+{
+  double d,big;
+  int i,j;
+
+  d=0.0;
+  big=0.0;
+  for(j=0;j<n;j++)
+    for(i=0;i<=j;i++)
+      {
+	if(fabs(X->value[j*n+i]-G->value[j*n+i])>d) d=fabs(X->value[j*n+i]-G->value[j*n+i]);
+	if(fabs(G->value[j*n+i])>big) big=fabs(G->value[j*n+i]);
+      }
+  error=d/big;
+}
+
+static void check_gemv() { error=max_difference(BTDAV->value,Y->value,n); }
+
+static void check_dot() { error=max_difference(&dot,&dot_ref,1); }
+
+static void check_inverse() { error=max_difference(W->value,INV->value,n*n); }
+
+static void check_solve()
+{
+  double *r,big;
+  int i;
+
+  /* |G sol - rhs| / (|G| |sol|), infinity norms */
+  r=X->value;
+  memcpy(r,rhs,sizeof(double)*n);
+  cblas_dgemv(CblasColMajor,CblasNoTrans,n,n,1.0,G->value,n,sol,1,-1.0,r,1);
+  big=0.0;
+  for(i=0;i<n;i++)
+    if(fabs(sol[i])>big) big=fabs(sol[i]);
+  error=fabs(r[cblas_idamax(n,r,1)])/(g_norm*big);
+}
+/*----------------------------------------------------------------------------------*/
+static linalg_op ops[]={
+  {"btb","sequential",0,1,NULL,run_sequential,check_btb,flops_gemm},
+  {"btb","openmp",0,1,NULL,run_openmp,check_btb,flops_gemm},
+  {"btb","cache",0,0,NULL,run_cache,check_btb,flops_gemm},
+  {"btb","simd",0,0,NULL,run_simd,check_btb,flops_gemm},
+  {"btb","dgemm",1,0,NULL,run_dgemm,check_btb,flops_gemm},
+  {"btb","dsyrk",1,0,NULL,run_dsyrk,check_upper,flops_syrk},
+  {"gemv","multiply_matrix",0,0,NULL,run_gemv_loop,check_gemv,flops_gemv},
+  {"gemv","dgemv",1,0,NULL,run_dgemv,check_gemv,flops_gemv},
+  {"dot","multiply_matrix",0,0,NULL,run_dot_loop,check_dot,flops_dot},
+  {"dot","ddot",1,0,NULL,run_ddot,check_dot,flops_dot},
+  {"lu","dgetrf",1,0,prepare_copy,run_dgetrf,NULL,flops_lu},
+  {"inverse","gauss_jordan",0,1,prepare_copy,run_gauss_jordan,check_inverse,flops_inverse},
+  {"inverse","mat_inv",1,0,prepare_copy,run_mat_inv,check_inverse,flops_inverse},
+  {"solve","inverse_multiply",0,0,prepare_copy,run_solve_inverse,check_solve,
+   flops_solve_inverse},
+  {"solve","getrf_getrs",1,0,prepare_copy,run_solve_lu,check_solve,flops_solve_lu},
+  {"solve","potrf_potrs",1,0,prepare_copy,run_solve_cholesky,check_solve,
+   flops_solve_cholesky}};
+/*----------------------------------------------------------------------------------*/
+/* timing */
+/*----------------------------------------------------------------------------------*/
+static int compare_double(p,q)
+     const void *p,*q;
+{
+  double a,b;
+
+  a=*(double *)p;
+  b=*(double *)q;
+  return((a>b)-(a<b));
+}
+/*----------------------------------------------------------------------------------*/
+/* seconds of inner calls; the inputs are put back outside the time */
+/*----------------------------------------------------------------------------------*/
+static double run_sample(op,inner)
+     linalg_op *op;
+     long inner;
+{
+  double start,total;
+  long j;
+
+  if(op->prepare==(linalg_f)NULL)
+    {
+      start=seconds_now();
+      for(j=0;j<inner;j++) op->run();
+      return(seconds_now()-start);
+    }
+  total=0.0;
+  for(j=0;j<inner;j++)
+    {
+      op->prepare();
+      start=seconds_now();
+      op->run();
+      total+=seconds_now()-start;
+    }
+  return(total);
+}
+/*----------------------------------------------------------------------------------*/
+/* min and median of the time of one call */
+/*----------------------------------------------------------------------------------*/
+static void time_op(op,min,median)
+     linalg_op *op;
+     double *min,*median;
+{
+  double sample[LINALG_MAX_REPS],first;
+  long inner;
+  int r;
+
+  first=run_sample(op,1);              /* warm up, and the size of a sample */
+  error=0.0;
+  if(op->check!=(linalg_f)NULL) op->check();
+  inner=(first>0.0 && first<min_time) ? (long)(min_time/first)+1 : 1;
+
+  for(r=0;r<reps;r++)
+    sample[r]=run_sample(op,inner)/inner;
+  qsort(sample,reps,sizeof(double),compare_double);
+  *min=sample[0];
+  *median=(reps%2==1) ? sample[reps/2] : 0.5*(sample[reps/2-1]+sample[reps/2]);
+}
+/*----------------------------------------------------------------------------------*/
+static void set_threads(threads)
+     int threads;
+{
+  omp_set_num_threads(threads);
+  openblas_set_num_threads(threads);
+}
+/*----------------------------------------------------------------------------------*/
+/* GFLOP/s of a square dgemm of peak_n, the best of the reps */
+/*----------------------------------------------------------------------------------*/
+static double measure_peak()
+{
+  double *a,*b,*c,t,best;
+  int i,r;
+
+  a=(double *)malloc(sizeof(double)*peak_n*peak_n);
+  b=(double *)malloc(sizeof(double)*peak_n*peak_n);
+  c=(double *)malloc(sizeof(double)*peak_n*peak_n);
+  if(a==(double *)NULL || b==(double *)NULL || c==(double *)NULL)
+    {
+      printf("error allocating memory for --peak-n=%d\n",peak_n);
+      exit(0);
+    }
+  for(i=0;i<peak_n*peak_n;i++)
+    {
+      a[i]=random_value();
+      b[i]=random_value();
+    }
+  best=0.0;
+  for(r=0;r<=reps;r++)
+    {
+      t=seconds_now();
+      cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,peak_n,peak_n,peak_n,1.0,
+		  a,peak_n,b,peak_n,0.0,c,peak_n);
+      t=seconds_now()-t;
+      if(r>0 && (best==0.0 || t<best)) best=t;   /* the first is a warm up */
+    }
+  free(a);
+  free(b);
+  free(c);
+  return(2.0*peak_n*(double)peak_n*peak_n/best*1.0e-9);
+}
+/*----------------------------------------------------------------------------------*/
+/* output */
+/*----------------------------------------------------------------------------------*/
+static void write_csv(file)
+     char *file;
+{
+  FILE *output;
+  linalg_result *r;
+  int i;
+
+  output=fopen(file,"w");
+  if(output==(FILE *)NULL)
+    {
+      printf("cannot write %s\n",file);
+      exit(0);
+    }
+  fprintf(output,"kernel,backend,library,N,rows,columns,threads,seconds_min,"
+	  "seconds_median,gflops,efficiency,max_rel_error\n");
+  for(i=0;i<n_results;i++)
+    {
+      r=&results[i];
+      fprintf(output,"%s,%s,%d,%d,%d,%d,%d,%.9f,%.9f,%.4f,%.4f,%.3e\n",r->kernel,
+	      r->backend,r->library,r->n,r->rows,r->columns,r->threads,r->min,
+	      r->median,r->gflops,r->efficiency,r->error);
+    }
+  fclose(output);
+}
+/*----------------------------------------------------------------------------------*/
+static linalg_result *find_result(kernel,backend,points,threads)
+     char *kernel,*backend;
+     int points,threads;
+{
+  int i;
+
+  for(i=0;i<n_results;i++)
+    if(results[i].n==points && results[i].threads==threads &&
+       strcmp(results[i].kernel,kernel)==0 && strcmp(results[i].backend,backend)==0)
+      return(&results[i]);
+  return((linalg_result *)NULL);
+}
+/*----------------------------------------------------------------------------------*/
+/* for each backend of ours against each library backend of the same kernel, the    */
+/* smallest N from which the library is faster at every N both were run at          */
+/*----------------------------------------------------------------------------------*/
+static void write_crossover(file)
+     char *file;
+{
+  FILE *output;
+  linalg_result *ours,*lib;
+  double speedup;
+  int a,b,t,k,cross,last;
+
+  output=fopen(file,"w");
+  if(output==(FILE *)NULL)
+    {
+      printf("cannot write %s\n",file);
+      exit(0);
+    }
+  fprintf(output,"kernel,backend,library_backend,threads,crossover_N,last_N,"
+	  "library_speedup_at_last_N\n");
+  printf("\nCrossovers (N from which the library is faster):\n");
+  for(a=0;a<(int)(sizeof(ops)/sizeof(linalg_op));a++)
+    for(b=0;b<(int)(sizeof(ops)/sizeof(linalg_op));b++)
+      {
+	if(ops[a].library || !ops[b].library || strcmp(ops[a].kernel,ops[b].kernel)!=0)
+	  continue;
+	for(t=0;t<thread_count;t++)
+	  {
+	    cross=-1;
+	    last=-1;
+	    speedup=0.0;
+	    for(k=0;k<n_count;k++)
+	      {
+		ours=find_result(ops[a].kernel,ops[a].backend,n_list[k],thread_list[t]);
+		lib=find_result(ops[b].kernel,ops[b].backend,n_list[k],thread_list[t]);
+		if(ours==(linalg_result *)NULL || lib==(linalg_result *)NULL) continue;
+		speedup=ours->min/lib->min;
+		if(speedup>1.0)
+		  {
+		    if(cross<0) cross=n_list[k];
+		  }
+		else
+		  cross=-1;
+		last=n_list[k];
+	      }
+	    if(last<0) continue;
+	    fprintf(output,"%s,%s,%s,%d,%d,%d,%.3f\n",ops[a].kernel,ops[a].backend,
+		    ops[b].backend,thread_list[t],cross,last,speedup);
+	    printf("  %-8s %-16s vs %-12s %2d thread%s  ",ops[a].kernel,ops[a].backend,
+		   ops[b].backend,thread_list[t],(thread_list[t]==1) ? " " : "s");
+	    if(cross<0)
+	      printf("never        (%.2fx at N=%d)\n",speedup,last);
+	    else
+	      printf("N >= %-7d (%.2fx at N=%d)\n",cross,speedup,last);
+	  }
+      }
+  fclose(output);
+}
+/*----------------------------------------------------------------------------------*/
+/* --n=25,50,100 */
+/*----------------------------------------------------------------------------------*/
+static int parse_list(value,list,most,max_threads)
+     char *value;
+     int *list,most,max_threads;
+{
+  char *p;
+  int count;
+
+  count=0;
+  p=value;
+  while(*p!='\0')
+    {
+      if(count==most)
+	{
+	  printf("at most %d values in '%s'\n",most,value);
+	  exit(0);
+	}
+      list[count]=(strncmp(p,"max",3)==0) ? max_threads : atoi(p);
+      if(list[count]<1)
+	{
+	  printf("bad value in '%s'\n",value);
+	  exit(0);
+	}
+      if(count==0 || list[count]!=list[count-1]) count++;
+      p=strchr(p,',');
+      if(p==(char *)NULL) break;
+      p++;
+    }
+  return(count);
+}
+/*----------------------------------------------------------------------------------*/
+static void parse_options(argc,argv)
+     int argc;
+     char **argv;
+{
+  char *value;
+  int i,max_threads;
+
+  max_threads=omp_get_max_threads();
+  thread_list[0]=1;
+  thread_list[1]=max_threads;
+  thread_count=(max_threads>1) ? 2 : 1;
+  for(i=1;i<argc;i++)
+    {
+      value=strchr(argv[i],'=');
+      value=(value==(char *)NULL) ? "" : value+1;
+      if(strncmp(argv[i],"--n=",4)==0)
+	n_count=parse_list(value,n_list,LINALG_MAX_N,max_threads);
+      else if(strncmp(argv[i],"--threads=",10)==0)
+	thread_count=parse_list(value,thread_list,LINALG_MAX_THREADS,max_threads);
+      else if(strncmp(argv[i],"--reps=",7)==0) reps=atoi(value);
+      else if(strncmp(argv[i],"--min-time=",11)==0) min_time=atof(value);
+      else if(strncmp(argv[i],"--slow-max-n=",13)==0) slow_max_n=atoi(value);
+      else if(strncmp(argv[i],"--peak-n=",9)==0) peak_n=atoi(value);
+      else if(strncmp(argv[i],"--csv=",6)==0) csv_file=value;
+      else if(strncmp(argv[i],"--crossover=",12)==0) crossover_file=value;
+      else
+	{
+	  printf("unknown option '%s'\n",argv[i]);
+	  exit(0);
+	}
+    }
+  if(n_count<1 || thread_count<1 || reps<1 || reps>LINALG_MAX_REPS || peak_n<16)
+    {
+      printf("need --n and --threads, 1<=--reps<=%d and --peak-n>=16\n",LINALG_MAX_REPS);
+      exit(0);
+    }
+}
+/*----------------------------------------------------------------------------------*/
+int main(argc,argv)
+     int argc;
+     char **argv;
+{
+  linalg_op *op;
+  linalg_result *r;
+  double peak[LINALG_MAX_THREADS],min,median;
+  int i,k,t;
+
+  parse_options(argc,argv);
+  set_log_level(LOG_WARN);
+  set_inversion_method(1);      /* invert_this_matrix is only the Gauss-Jordan backend */
+
+  printf("Linear algebra scaling: B is (5N+1) x 4N, %d reps, samples of %g s, "
+	 "block size %d\n",reps,min_time,get_block_size());
+  for(t=0;t<thread_count;t++)
+    {
+      set_threads(thread_list[t]);
+      peak[t]=measure_peak();
+      printf("  peak (dgemm %d, %2d thread%s): %8.2f GFLOP/s\n",peak_n,thread_list[t],
+	     (thread_list[t]==1) ? " " : "s",peak[t]);
+    }
+
+  for(k=0;k<n_count;k++)
+    {
+      make_problem(n_list[k]);
+      printf("\nN=%d: B %d x %d, BT*B %d x %d\n",N,M,n,n,n);
+      for(t=0;t<thread_count;t++)
+	{
+	  set_threads(thread_list[t]);
+	  for(i=0;i<(int)(sizeof(ops)/sizeof(linalg_op));i++)
+	    {
+	      op=&ops[i];
+	      if(op->slow && N>slow_max_n) continue;
+	      if(n_results==LINALG_MAX_RESULTS)
+		{
+		  printf("more than %d results\n",LINALG_MAX_RESULTS);
+		  exit(0);
+		}
+	      time_op(op,&min,&median);
+	      r=&results[n_results++];
+	      strcpy(r->kernel,op->kernel);
+	      strcpy(r->backend,op->backend);
+	      r->library=op->library;
+	      r->n=N;
+	      r->rows=M;
+	      r->columns=n;
+	      r->threads=thread_list[t];
+	      r->min=min;
+	      r->median=median;
+	      r->gflops=op->flops()/min*1.0e-9;
+	      r->efficiency=r->gflops/peak[t];
+	      r->error=error;
+	      printf("  %-8s %-16s %2d thread%s %10.3e s %8.2f GFLOP/s %5.1f%%  err %.1e\n",
+		     r->kernel,r->backend,r->threads,(r->threads==1) ? " " : "s",r->min,
+		     r->gflops,100.0*r->efficiency,r->error);
+	    }
+	}
+      free_problem();
+    }
+
+  write_csv(csv_file);
+  write_crossover(crossover_file);
+  printf("\nResults in %s and %s\n",csv_file,crossover_file);
+  return(0);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
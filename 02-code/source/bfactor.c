@@ -0,0 +1,595 @@
+/*----------------------------------- bfactor.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* solutions of one zone for many sets of path values                               */
+/*                                                                                  */
+/* make_bcv_use_KCL and make_bcv_no_KCL find                                        */
+/*   bcv = (BT*B)^-1 * BT * DA * bvv                                                */
+/* for the one bvv made from the path values. A, D and B only depend on the         */
+/* geometry of the zone, so when only the values change (an ensemble of contour     */
+/* elevations) the zone is factored once:                                           */
+/*   C = BT*DA               (4N x 2N)                                              */
+/*   BT*B = UT*U             (Cholesky; LU if BT*B is not positive definite)        */
+/* and the K columns of a block of bvv are solved together:                         */
+/*   bcv = C*bvv             (dgemm)                                                */
+/*   UT*Y = bcv, U*bcv = Y   (dtrsm, dtrsm)                                         */
+/* The zone is reversed as in solve_zone while A, D, B and bvv are made.            */
+/*                                                                                  */
+/* When a few points of the zone are moved, update_zone_factor makes A, D and B     */
+/* again (that is O(N^2); the factorization is O(N^3)). Only the rows and columns   */
+/* of B for the segments next to the moved points change:                           */
+/*   Bn = B + E,  E nonzero in the columns s of those segments and in rows r        */
+/*   BnT*Bn - BT*B = BnT*E + ET*B = Y*WT,  rank k = 2*(columns s + rows r)          */
+/* so the factor of BT*B is kept and                                                */
+/*   (BT*B + Y*WT)^-1 = G - Z*(I + WT*Z)^-1*WT*G,  G = (BT*B)^-1, Z = G*Y           */
+/* costs k more triangular solves and a k x k LU. The updates are always made       */
+/* against the last factorization; when k is over get_update_limit() of 4N the      */
+/* zone is factored again instead.                                                  */
+/*                                                                                  */
+/* save_zone_factor keeps B, C and U in the catchment directory as                 */
+/* factor_<key>.bin, key being a hash of the zone's points (the values do not enter */
+/* B), and read_zone_factor takes them back in a later run.                         */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "memtrack_types.h"
+#include "logging_types.h"
+#include "bfactor_types.h"
+
+#include "cblas.h"
+#include "lapacke.h"
+
+#include "bsolve.h"
+#include "catchment.h"
+#include "file.h"
+#include "linear_sys.h"
+#include "logging.h"
+#include "matrix.h"
+#include "memtrack.h"
+#include "path.h"
+
+#include "bfactor.h"
+/*----------------------------------------------------------------------------------*/
+#define FACTOR_MAGIC 0x42464331
+/*----------------------------------------------------------------------------------*/
+static double update_limit=0.25;   /* largest rank of an update, as a fraction of 4N */
+/*----------------------------------------------------------------------------------*/
+void set_update_limit(fraction)
+     double fraction;
+{
+  update_limit=fraction;
+}
+/*----------------------------------------------------------------------------------*/
+double get_update_limit()
+{
+  return(update_limit);
+}
+/*----------------------------------------------------------------------------------*/
+static void *factor_memory(n)
+     size_t n;
+{
+  void *p;
+
+  p=tracked_malloc(n,MEM_SOLVER);
+  if(p==NULL)
+    {
+      printf("Cannot allocate memory for zone factorization\n");
+      exit(0);
+    }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+/* DA (M x 2N) and B (M x 4N) of the zone as in make_boundary_current_vector */
+/*----------------------------------------------------------------------------------*/
+static void zone_matrices(f,DA,B)
+     zone_factor *f;
+     double *DA,*B;
+{
+  matrix A,D,DAm,Bm,KCL;
+  double *values;
+  int N,M;
+
+  N=f->N;
+  M=f->M;
+  values=(double *)factor_memory(((size_t)2*M*N+4*N)*sizeof(double));
+  attach_matrix(&A,M,2*N,DA);
+  attach_matrix(&DAm,M,2*N,DA);              /* write on top of A */
+  attach_matrix(&D,M,2*N,values);
+  attach_matrix(&KCL,1,4*N,after_matrix(&D));
+  attach_matrix(&Bm,M,4*N,B);
+
+  reverse_zone(f->b);
+  make_voltage_geometry_matrix(f->b,&A);
+  make_diagonal_matrix(f->b,&D);
+  make_current_geometry_matrix(f->b,&Bm);
+  if(M>5*N)
+    {
+      zero_last_matrix_row(&A);
+      zero_last_matrix_row(&D);
+      make_kcl_geometry_vector(f->b,&KCL);
+      fill_last_matrix_row(&Bm,&KCL);
+    }
+  reverse_zone(f->b);
+  add_matrix(&D,&A,&DAm);
+  tracked_free((void *)values);
+}
+/*----------------------------------------------------------------------------------*/
+/* points of the zone in the order of the columns of B */
+/*----------------------------------------------------------------------------------*/
+static void zone_points(f,xy)
+     zone_factor *f;
+     coordinates *xy;
+{
+  path *path_i;
+  int i,j;
+
+  reverse_zone(f->b);
+  for(i=0;i<f->b->components;i++)
+    {
+      path_i=f->b->loop[i];
+      for(j=0;j<path_i->points;j++) get_path_xy(path_i,j,xy[j]);
+      xy=xy+path_i->points;
+    }
+  reverse_zone(f->b);
+}
+/*----------------------------------------------------------------------------------*/
+/* C and the factor of BT*B from f->B */
+/*----------------------------------------------------------------------------------*/
+static void factor_matrices(f,DA)
+     zone_factor *f;
+     double *DA;
+{
+  int N,M,info;
+
+  N=f->N;
+  M=f->M;
+  cblas_dgemm(CblasColMajor,CblasTrans,CblasNoTrans,4*N,2*N,M,
+	      1.0,f->B,M,DA,M,0.0,f->C,4*N);
+  cblas_dsyrk(CblasColMajor,CblasUpper,CblasTrans,4*N,M,
+	      1.0,f->B,M,0.0,f->U,4*N);
+  if(f->ipiv!=(int *)NULL) tracked_free((void *)f->ipiv);
+  f->ipiv=(int *)NULL;
+  info=LAPACKE_dpotrf(LAPACK_COL_MAJOR,'U',4*N,f->U,4*N);
+  if(info!=0)
+    {
+      /* not positive definite in floating point: LU of the whole BT*B */
+      cblas_dgemm(CblasColMajor,CblasTrans,CblasNoTrans,4*N,4*N,M,
+		  1.0,f->B,M,f->B,M,0.0,f->U,4*N);
+      f->ipiv=(int *)factor_memory(4*N*sizeof(int));
+      info=LAPACKE_dgetrf(LAPACK_COL_MAJOR,4*N,4*N,f->U,4*N,f->ipiv);
+      if(info!=0)
+	{
+	  printf("Zone factorization failed: BT*B is singular (%d)\n",info);
+	  exit(0);
+	}
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/* X (4N x K) = (BT*B)^-1 * X */
+/*----------------------------------------------------------------------------------*/
+static void factor_solve(f,K,X)
+     zone_factor *f;
+     int K;
+     double *X;
+{
+  int N;
+
+  N=f->N;
+  if(f->ipiv==(int *)NULL)
+    {
+      cblas_dtrsm(CblasColMajor,CblasLeft,CblasUpper,CblasTrans,CblasNonUnit,
+		  4*N,K,1.0,f->U,4*N,X,4*N);
+      cblas_dtrsm(CblasColMajor,CblasLeft,CblasUpper,CblasNoTrans,CblasNonUnit,
+		  4*N,K,1.0,f->U,4*N,X,4*N);
+    }
+  else
+    LAPACKE_dgetrs(LAPACK_COL_MAJOR,'N',4*N,K,f->U,4*N,f->ipiv,X,4*N);
+}
+/*----------------------------------------------------------------------------------*/
+static void clear_update(f)
+     zone_factor *f;
+{
+  if(f->k>0)
+    {
+      tracked_free((void *)f->Bn);
+      tracked_free((void *)f->DAn);
+      tracked_free((void *)f->Z);
+      tracked_free((void *)f->W);
+      tracked_free((void *)f->S);
+      tracked_free((void *)f->spiv);
+    }
+  f->k=0;
+  f->Bn=f->DAn=f->Z=f->W=f->S=(double *)NULL;
+  f->spiv=(int *)NULL;
+}
+/*----------------------------------------------------------------------------------*/
+/* factor zone b */
+/*----------------------------------------------------------------------------------*/
+zone_factor *factor_zone(b)
+     boundary *b;
+{
+  zone_factor *f;
+  double *DA;
+  int N,j,finite,phase;
+
+  phase=set_memory_phase(MEM_SOLVE);
+  f=(zone_factor *)factor_memory(sizeof(zone_factor));
+  N=0;
+  finite=0;
+  for(j=0;j<b->components;j++)
+    {
+      N=N+b->loop[j]->points;
+      if(b->level[j]==0) finite=1; /* KCL row as make_bcv_use_KCL */
+    }
+  f->b=b;
+  f->N=N;
+  f->M=(finite) ? 5*N+1 : 5*N;
+  f->xy=(coordinates *)factor_memory(N*sizeof(coordinates));
+  f->B=(double *)factor_memory((size_t)4*f->M*N*sizeof(double));
+  f->C=(double *)factor_memory((size_t)8*N*N*sizeof(double));
+  f->U=(double *)factor_memory((size_t)16*N*N*sizeof(double));
+  f->ipiv=(int *)NULL;
+  f->k=0;
+  clear_update(f);
+
+  DA=(double *)factor_memory((size_t)2*f->M*N*sizeof(double));
+  zone_points(f,f->xy);
+  zone_matrices(f,DA,f->B);
+  factor_matrices(f,DA);
+  tracked_free((void *)DA);
+  set_memory_phase(phase);
+  if(log_on(LOG_INFO,LOG_ZONE))
+    printf("  Zone factorization:   N = %d (%s)\n",N,(f->ipiv==(int *)NULL) ? "Cholesky" : "LU");
+  return(f);
+}
+/*----------------------------------------------------------------------------------*/
+void destroy_zone_factor(f)
+     zone_factor *f;
+{
+  if(f==(zone_factor *)NULL) return;
+  clear_update(f);
+  tracked_free((void *)f->xy);
+  tracked_free((void *)f->B);
+  tracked_free((void *)f->C);
+  tracked_free((void *)f->U);
+  if(f->ipiv!=(int *)NULL) tracked_free((void *)f->ipiv);
+  tracked_free((void *)f);
+}
+/*----------------------------------------------------------------------------------*/
+/* bring f up to date with the present points of its zone; returns the rank of the  */
+/* update (0 if no point has moved since the factorization or it was done again)    */
+/*----------------------------------------------------------------------------------*/
+int update_zone_factor(f)
+     zone_factor *f;
+{
+  coordinates *xy;
+  double *Bn,*DAn,*E,*Y,*W,*S;
+  char *moved,*col,*row;
+  int N,M,i,j,k,n,o,c,r,q,ns,nr,points,*cols,*rows,*spiv,info;
+  path *path_i;
+
+  N=f->N;
+  M=f->M;
+  xy=(coordinates *)factor_memory(N*sizeof(coordinates));
+  moved=(char *)factor_memory(N*sizeof(char));
+  zone_points(f,xy);
+  points=0;
+  for(j=0;j<N;j++)
+    {
+      moved[j]=(xy[j][0]!=f->xy[j][0] || xy[j][1]!=f->xy[j][1]);
+      points=points+moved[j];
+    }
+  clear_update(f);
+  if(points==0)
+    {
+      tracked_free((void *)xy);
+      tracked_free((void *)moved);
+      return(0);
+    }
+
+  Bn=(double *)factor_memory((size_t)4*M*N*sizeof(double));
+  DAn=(double *)factor_memory((size_t)2*M*N*sizeof(double));
+  zone_matrices(f,DAn,Bn);
+
+  /* columns of the segments on either side of a moved point */
+  col=(char *)factor_memory(4*N*sizeof(char));
+  for(c=0;c<4*N;c++) col[c]=0;
+  o=0;
+  for(i=0;i<f->b->components;i++)
+    {
+      path_i=f->b->loop[i];
+      n=path_i->points;
+      for(j=0;j<n;j++)
+	if(moved[o+j])
+	  for(q=0;q<4;q++)
+	    {
+	      col[4*(o+j)+q]=1;
+	      col[4*(o+(j+n-1)%n)+q]=1;
+	    }
+      o=o+n;
+    }
+  /* rows that change outside those columns */
+  row=(char *)factor_memory(M*sizeof(char));
+  for(r=0;r<M;r++) row[r]=0;
+  for(c=0;c<4*N;c++)
+    if(!col[c])
+      for(r=0;r<M;r++)
+	if(Bn[(size_t)c*M+r]!=f->B[(size_t)c*M+r]) row[r]=1;
+  cols=(int *)factor_memory(4*N*sizeof(int));
+  rows=(int *)factor_memory(M*sizeof(int));
+  ns=nr=0;
+  for(c=0;c<4*N;c++) if(col[c]) cols[ns++]=c;
+  for(r=0;r<M;r++) if(row[r]) rows[nr++]=r;
+  k=2*(ns+nr);
+
+  if(k>update_limit*4*N)
+    {
+      /* too many changes: factor again from the new matrices */
+      memcpy(f->B,Bn,(size_t)4*M*N*sizeof(double));
+      memcpy(f->xy,xy,N*sizeof(coordinates));
+      factor_matrices(f,DAn);
+      if(log_on(LOG_INFO,LOG_ZONE))
+	printf("  Zone update:          %d points moved, rank %d > %g: factored again\n",
+	       points,k,update_limit*4*N);
+      tracked_free((void *)Bn);
+      tracked_free((void *)DAn);
+      k=0;
+    }
+  else
+    {
+      /* E in the columns, then Y = [BnT*E(:,s) | Bn(r,:)T | I(:,s) | E(r,~s)T] */
+      /*                        W = [I(:,s) | E(r,~s)T | BT*E(:,s) | B(r,:)T]  */
+      E=(double *)factor_memory((size_t)M*ns*sizeof(double));
+      Y=(double *)factor_memory((size_t)4*N*k*sizeof(double));
+      W=(double *)factor_memory((size_t)4*N*k*sizeof(double));
+      for(q=0;q<ns;q++)
+	for(r=0;r<M;r++)
+	  E[(size_t)q*M+r]=Bn[(size_t)cols[q]*M+r]-f->B[(size_t)cols[q]*M+r];
+      memset(Y,0,(size_t)4*N*k*sizeof(double));
+      memset(W,0,(size_t)4*N*k*sizeof(double));
+      cblas_dgemm(CblasColMajor,CblasTrans,CblasNoTrans,4*N,ns,M,
+		  1.0,Bn,M,E,M,0.0,Y,4*N);
+      cblas_dgemm(CblasColMajor,CblasTrans,CblasNoTrans,4*N,ns,M,
+		  1.0,f->B,M,E,M,0.0,W+(size_t)4*N*(ns+nr),4*N);
+      for(q=0;q<ns;q++)
+	{
+	  Y[(size_t)4*N*(ns+nr+q)+cols[q]]=1.0;
+	  W[(size_t)4*N*q+cols[q]]=1.0;
+	}
+      for(q=0;q<nr;q++)
+	for(c=0;c<4*N;c++)
+	  {
+	    r=rows[q];
+	    Y[(size_t)4*N*(ns+q)+c]=Bn[(size_t)c*M+r];
+	    W[(size_t)4*N*(2*ns+nr+q)+c]=f->B[(size_t)c*M+r];
+	    if(!col[c])
+	      {
+		Y[(size_t)4*N*(2*ns+nr+q)+c]=Bn[(size_t)c*M+r]-f->B[(size_t)c*M+r];
+		W[(size_t)4*N*(ns+q)+c]=Y[(size_t)4*N*(2*ns+nr+q)+c];
+	      }
+	  }
+      tracked_free((void *)E);
+
+      /* Z = (BT*B)^-1 * Y  and the LU of I + WT*Z */
+      factor_solve(f,k,Y);
+      S=(double *)factor_memory((size_t)k*k*sizeof(double));
+      spiv=(int *)factor_memory(k*sizeof(int));
+      cblas_dgemm(CblasColMajor,CblasTrans,CblasNoTrans,k,k,4*N,
+		  1.0,W,4*N,Y,4*N,0.0,S,k);
+      for(q=0;q<k;q++) S[(size_t)q*k+q]=S[(size_t)q*k+q]+1.0;
+      info=LAPACKE_dgetrf(LAPACK_COL_MAJOR,k,k,S,k,spiv);
+      if(info!=0)
+	{
+	  printf("Zone update failed: I + WT*Z is singular (%d)\n",info);
+	  exit(0);
+	}
+      f->k=k;
+      f->Bn=Bn;
+      f->DAn=DAn;
+      f->Z=Y;
+      f->W=W;
+      f->S=S;
+      f->spiv=spiv;
+      if(log_on(LOG_INFO,LOG_ZONE))
+	printf("  Zone update:          %d points moved, rank %d of %d\n",points,k,4*N);
+    }
+  tracked_free((void *)xy);
+  tracked_free((void *)moved);
+  tracked_free((void *)col);
+  tracked_free((void *)row);
+  tracked_free((void *)cols);
+  tracked_free((void *)rows);
+  return(k);
+}
+/*----------------------------------------------------------------------------------*/
+/* bvv (2N numbers) from the present path values of the zone */
+/*----------------------------------------------------------------------------------*/
+void zone_voltage_vector(f,bvv)
+     zone_factor *f;
+     double *bvv;
+{
+  path *path_i;
+  int i;
+
+  reverse_zone(f->b);
+  for(i=0;i<f->b->components;i++)
+    {
+      path_i=f->b->loop[i];
+      fill_boundary_voltage_vector(path_i,bvv);
+      bvv=bvv+2*path_i->points;
+    }
+  reverse_zone(f->b);
+}
+/*----------------------------------------------------------------------------------*/
+/* K columns: bvv (2N x K) in, bcv (4N x K) out */
+/*----------------------------------------------------------------------------------*/
+void solve_zone_block(f,K,bvv,bcv)
+     zone_factor *f;
+     int K;
+     double *bvv,*bcv;
+{
+  double *T;
+  int N,M,k;
+
+  N=f->N;
+  M=f->M;
+  k=f->k;
+  if(k==0)
+    {
+      cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,4*N,K,2*N,
+		  1.0,f->C,4*N,bvv,2*N,0.0,bcv,4*N);
+      factor_solve(f,K,bcv);
+      return;
+    }
+
+  /* BnT*DAn*bvv, then Woodbury */
+  T=(double *)factor_memory((size_t)((M>k) ? M : k)*K*sizeof(double));
+  cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,M,K,2*N,
+	      1.0,f->DAn,M,bvv,2*N,0.0,T,M);
+  cblas_dgemm(CblasColMajor,CblasTrans,CblasNoTrans,4*N,K,M,
+	      1.0,f->Bn,M,T,M,0.0,bcv,4*N);
+  factor_solve(f,K,bcv);
+  cblas_dgemm(CblasColMajor,CblasTrans,CblasNoTrans,k,K,4*N,
+	      1.0,f->W,4*N,bcv,4*N,0.0,T,k);
+  LAPACKE_dgetrs(LAPACK_COL_MAJOR,'N',k,K,f->S,k,f->spiv,T,k);
+  cblas_dgemm(CblasColMajor,CblasNoTrans,CblasNoTrans,4*N,K,k,
+	      -1.0,f->Z,4*N,T,k,1.0,bcv,4*N);
+  tracked_free((void *)T);
+}
+/*----------------------------------------------------------------------------------*/
+/* name of the file holding the factor of zone b with points xy (FNV-1a over them) */
+/*----------------------------------------------------------------------------------*/
+static void factor_file(b,N,xy,n,name)
+     boundary *b;
+     int N;
+     coordinates *xy;
+     int n;
+     char *name;
+{
+  unsigned long h;
+  unsigned char *byte;
+  char file[32];
+  int i,k;
+
+  h=2166136261UL;
+  byte=(unsigned char *)xy;
+  for(k=0;k<N*(int)sizeof(coordinates);k++)
+    h=((h^byte[k])*16777619UL) & 0xffffffffUL;
+  for(i=0;i<b->components;i++)
+    h=((h^(unsigned long)(b->loop[i]->points+b->level[i]))*16777619UL) & 0xffffffffUL;
+  catchment_path(n,(unsigned char *)name);
+  sprintf(file,"factor_%08lx.bin",h);
+  strncat(name,file,n-strlen(name)-1);
+}
+/*----------------------------------------------------------------------------------*/
+/* keep the factorization f (as made, not its update) for later runs */
+/*----------------------------------------------------------------------------------*/
+void save_zone_factor(f)
+     zone_factor *f;
+{
+  FILE *output;
+  char name[160];
+  int head[4],N;
+
+  N=f->N;
+  factor_file(f->b,N,f->xy,160,name);
+  output=fopen(name,"wb");
+  if(output==(FILE *)NULL)
+    {
+      printf("Cannot save zone factorization to '%s'\n",name);
+      return;
+    }
+  head[0]=FACTOR_MAGIC;
+  head[1]=N;
+  head[2]=f->M;
+  head[3]=(f->ipiv==(int *)NULL) ? 0 : 1;
+  fwrite(head,sizeof(int),4,output);
+  fwrite(f->xy,sizeof(coordinates),N,output);
+  fwrite(f->B,sizeof(double),(size_t)4*f->M*N,output);
+  fwrite(f->C,sizeof(double),(size_t)8*N*N,output);
+  fwrite(f->U,sizeof(double),(size_t)16*N*N,output);
+  if(head[3]) fwrite(f->ipiv,sizeof(int),4*N,output);
+  fclose(output);
+}
+/*----------------------------------------------------------------------------------*/
+/* factorization of zone b saved by an earlier run with the same points; NULL if   */
+/* there is none                                                                    */
+/*----------------------------------------------------------------------------------*/
+zone_factor *read_zone_factor(b)
+     boundary *b;
+{
+  zone_factor *f;
+  coordinates *xy;
+  FILE *input;
+  char name[160];
+  int head[4],N,j,finite,ok,phase;
+
+  N=0;
+  finite=0;
+  for(j=0;j<b->components;j++)
+    {
+      N=N+b->loop[j]->points;
+      if(b->level[j]==0) finite=1;
+    }
+  phase=set_memory_phase(MEM_SOLVE);
+  f=(zone_factor *)factor_memory(sizeof(zone_factor));
+  f->b=b;
+  f->N=N;
+  f->M=(finite) ? 5*N+1 : 5*N;
+  f->xy=(coordinates *)factor_memory(N*sizeof(coordinates));
+  zone_points(f,f->xy);
+  factor_file(b,N,f->xy,160,name);
+  input=fopen(name,"rb");
+  if(input==(FILE *)NULL)
+    {
+      tracked_free((void *)f->xy);
+      tracked_free((void *)f);
+      set_memory_phase(phase);
+      return((zone_factor *)NULL);
+    }
+  xy=(coordinates *)factor_memory(N*sizeof(coordinates));
+  f->B=(double *)factor_memory((size_t)4*f->M*N*sizeof(double));
+  f->C=(double *)factor_memory((size_t)8*N*N*sizeof(double));
+  f->U=(double *)factor_memory((size_t)16*N*N*sizeof(double));
+  f->ipiv=(int *)NULL;
+  ok=(fread(head,sizeof(int),4,input)==4 && head[0]==FACTOR_MAGIC &&
+      head[1]==N && head[2]==f->M &&
+      fread(xy,sizeof(coordinates),N,input)==(size_t)N &&
+      memcmp(xy,f->xy,N*sizeof(coordinates))==0 &&
+      fread(f->B,sizeof(double),(size_t)4*f->M*N,input)==(size_t)4*f->M*N &&
+      fread(f->C,sizeof(double),(size_t)8*N*N,input)==(size_t)8*N*N &&
+      fread(f->U,sizeof(double),(size_t)16*N*N,input)==(size_t)16*N*N);
+  if(ok && head[3])
+    {
+      f->ipiv=(int *)factor_memory(4*N*sizeof(int));
+      ok=(fread(f->ipiv,sizeof(int),4*N,input)==(size_t)(4*N));
+    }
+  fclose(input);
+  tracked_free((void *)xy);
+  if(!ok)
+    {
+      printf("Zone factorization in '%s' does not fit the zone; not used\n",name);
+      tracked_free((void *)f->xy);
+      tracked_free((void *)f->B);
+      tracked_free((void *)f->C);
+      tracked_free((void *)f->U);
+      if(f->ipiv!=(int *)NULL) tracked_free((void *)f->ipiv);
+      tracked_free((void *)f);
+      set_memory_phase(phase);
+      return((zone_factor *)NULL);
+    }
+  f->k=0;
+  clear_update(f);
+  set_memory_phase(phase);
+  if(log_on(LOG_INFO,LOG_ZONE))
+    printf("  Zone factorization:   N = %d read from '%s'\n",N,name);
+  return(f);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
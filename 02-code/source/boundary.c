@@ -7,8 +7,10 @@
 #include <stdio.h>
 /*----------------------------------------------------------------------------------*/
 #include "boundary_types.h"
+#include "memtrack_types.h"
 
 #include "file.h"
+#include "memtrack.h"
 #include "path.h"
 
 #include "boundary.h"
@@ -92,8 +94,8 @@ boundary *destroy_boundary(b)
 	}
       free((void *)loops);
     }
-  if(b->bvv!=(double *)NULL) free((void *)b->bvv);
-  if(b->bcv!=(double *)NULL) free((void *)b->bcv);
+  if(b->bvv!=(double *)NULL) tracked_free((void *)b->bvv);
+  if(b->bcv!=(double *)NULL) tracked_free((void *)b->bcv);
   free((void *)b);
   return((boundary *)NULL);
 }
@@ -15,12 +15,21 @@
 #include "co_matrix_types.h"
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "memtrack_types.h"
+#include "logging_types.h"
+#include "trace_types.h"
 
 #include "co_matrix.h"
+#include "geometry.h"
 #include "linear_sys.h"
+#include "logging.h"
 #include "matrix.h"
+#include "memtrack.h"
 #include "path.h"
 #include "ten_matrix.h"
+#include "terms.h"
+#include "trace.h"
 
 #include "bsolve.h"
 
@@ -78,7 +87,7 @@ void make_boundary_voltage_vector(b,bvv)
 
   if(b->bvv==(double *)NULL)
     {
-      bvv->value=(double *)malloc(get_num_rows(bvv)*sizeof(double));
+      bvv->value=(double *)tracked_malloc(get_num_rows(bvv)*sizeof(double),MEM_ZONE);
       b->bvv=bvv->value;
       paths = b->components;
       result = bvv->value;
@@ -162,14 +171,14 @@ void make_bcv_no_KCL(b,V,J)
 
   if(b->bcv==(double *)NULL)
     {
-      J->value=(double *)malloc(get_num_rows(J)*sizeof(double));
+      J->value=(double *)tracked_malloc(get_num_rows(J)*sizeof(double),MEM_ZONE);
       b->bcv=J->value;
       N=0;
       for(j=0;j<b->components;j++)
 	{
 	  N=N+b->loop[j]->points;
 	}
-      values=(double *)malloc(9*N*(4*N+1)*sizeof(double));
+      values=(double *)tracked_malloc(9*N*(4*N+1)*sizeof(double),MEM_SOLVER);
 
       /*-----------------------------*/
       attach_matrix(&A,5*N,2*N,values);
@@ -177,7 +186,7 @@ void make_bcv_no_KCL(b,V,J)
       attach_matrix(&DA,5*N,2*N,values);            /* write on top of A */
       attach_matrix(&DAV,5*N,1,after_matrix(&D)); 
       
-      printf("\nmake voltage matrix A and D\n");
+      if(log_on(LOG_INFO,LOG_ZONE)) printf("\nmake voltage matrix A and D\n");
       make_voltage_geometry_matrix(b,&A);
       make_diagonal_matrix(b,&D);  
       add_matrix(&D,&A,&DA); 
@@ -190,15 +199,16 @@ void make_bcv_no_KCL(b,V,J)
       attach_matrix(&BTDAV,4*N,1,after_matrix(&BTB));
 
 /*-------Checking BTB is NULL --------*/      
-printf("DEBUG: BTB attached: rows=%d cols=%d value=%p\n",
-       BTB.rows, BTB.columns, (void*)BTB.value);
+if(log_on(LOG_DEBUG,LOG_ZONE))
+  printf("DEBUG: BTB attached: rows=%d cols=%d value=%p\n",
+         BTB.rows, BTB.columns, (void*)BTB.value);
 if (BTB.value == NULL) {
     printf("ERROR: BTB.value is NULL right after attach_matrix!\n");
     exit(1);
 }
 /*---------------------------------*/
 
-      printf("make current matrix B\n");
+      if(log_on(LOG_INFO,LOG_ZONE)) printf("make current matrix B\n");
       make_current_geometry_matrix(b,&B);
       transpose_matrix(&BT,&BT);                   /* makes transpose but does not destroy B */
       
@@ -206,7 +216,7 @@ if (BTB.value == NULL) {
       invert_matrix(&BTB,&BTB);
       multiply_matrix(&BT,&DAV,&BTDAV);
       multiply_matrix(&BTB,&BTDAV,J);
-      free((void *)values);
+      tracked_free((void *)values);
     }
   else
     {
@@ -231,32 +241,37 @@ void make_bcv_use_KCL(b,V,J)
   long vmrss, vmsize;
   struct rusage r_usage;
 
-  struct timeval start,finish;
+  trace_span span;
   double duration;
 
-  struct timeval inv_start,inv_finish;
+  trace_span inv_span;
   double inv_duration;
 
-  struct timeval mul_start1,mul_finish1,mul_start2,mul_finish2;
+  trace_span mul_span1,mul_span2;
   double mul_duration1, mul_duration2;
 
-  struct timeval all_start,all_finish;
+  trace_span all_span;
   double all_duration;
 
   // Phase timing
-  struct timeval phase_start, phase_finish;
+  trace_span phase_span;
   double phase1_time, phase2_time, phase3_time, phase4_time;
+  int verbose;
 
   if(b->bcv==(double *)NULL)
     {
-      printf("\n");
-      printf("================================================================================\n");
-      printf("           STARTING BOUNDARY CURRENT VECTOR COMPUTATION (KCL)\n");
-      printf("================================================================================\n");
+      verbose=log_on(LOG_INFO,LOG_ZONE);
+      if(verbose)
+      {
+        printf("\n");
+        printf("================================================================================\n");
+        printf("           STARTING BOUNDARY CURRENT VECTOR COMPUTATION (KCL)\n");
+        printf("================================================================================\n");
+      }
       
-      gettimeofday(&all_start, NULL);
+      trace_begin(&all_span,"make_bcv_use_KCL","zone");
       
-      J->value=(double *)malloc(get_num_rows(J)*sizeof(double));
+      J->value=(double *)tracked_malloc(get_num_rows(J)*sizeof(double),MEM_ZONE);
       b->bcv=J->value;
       N=0;
       for(j=0;j<b->components;j++)
@@ -264,34 +279,46 @@ void make_bcv_use_KCL(b,V,J)
 	  N=N+b->loop[j]->points;
 	}
       
-      printf("\nProblem size: N = %d boundary points\n", N);
-      printf("Matrix dimensions:\n");
-      printf("  A, D, DA:  %d x %d\n", 5*N+1, 2*N);
-      printf("  B, BT:     %d x %d\n", 5*N+1, 4*N);
-      printf("  BTB:       %d x %d\n", 4*N, 4*N);
+      if(verbose)
+      {
+        printf("\nProblem size: N = %d boundary points\n", N);
+        printf("Matrix dimensions:\n");
+        printf("  A, D, DA:  %d x %d\n", 5*N+1, 2*N);
+        printf("  B, BT:     %d x %d\n", 5*N+1, 4*N);
+        printf("  BTB:       %d x %d\n", 4*N, 4*N);
+      }
       
       size_t memory_required = (size_t)(9*N+1) * (4*N+1) * sizeof(double);
-      printf("\nAllocating %.2f MB for computation matrices\n", memory_required / (1024.0*1024.0));
+      if(verbose)
+      {
+        printf("\nAllocating %.2f MB for computation matrices\n", memory_required / (1024.0*1024.0));
       
-      get_memory_usage_kb(&vmrss, &vmsize);
-      printf("Memory before allocation: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
-             vmrss/1024.0, vmsize/1024.0);
+        get_memory_usage_kb(&vmrss, &vmsize);
+        printf("Memory before allocation: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
+               vmrss/1024.0, vmsize/1024.0);
+      }
       
-      values=(double *)malloc(memory_required);
+      values=(double *)tracked_malloc(memory_required,MEM_SOLVER);
       if (values == NULL) {
           printf("ERROR: Failed to allocate memory!\n");
           exit(1);
       }
       
-      get_memory_usage_kb(&vmrss, &vmsize);
-      printf("Memory after allocation: VmRSS=%.2f MB, VmSize=%.2f MB\n\n", 
-             vmrss/1024.0, vmsize/1024.0);
+      if(verbose)
+      {
+        get_memory_usage_kb(&vmrss, &vmsize);
+        printf("Memory after allocation: VmRSS=%.2f MB, VmSize=%.2f MB\n\n", 
+               vmrss/1024.0, vmsize/1024.0);
+      }
 
 /*---------------------------------------------------*/
-printf("================================================================================\n");
-printf("PHASE 1: Voltage Geometry Matrix Setup\n");
-printf("================================================================================\n");
-gettimeofday(&phase_start, NULL);   
+if(verbose)
+{
+  printf("================================================================================\n");
+  printf("PHASE 1: Voltage Geometry Matrix Setup\n");
+  printf("================================================================================\n");
+}
+trace_begin(&phase_span,"voltage geometry matrix setup","zone");
 
       /*-----------------------------*/
       attach_matrix(&A,5*N+1,2*N,values);
@@ -299,47 +326,50 @@ gettimeofday(&phase_start, NULL);
       attach_matrix(&DA,5*N+1,2*N,values);            /* write on top of A */
       attach_matrix(&DAV,5*N+1,1,after_matrix(&D)); 
       
-      gettimeofday(&start, NULL);
+      trace_begin(&span,"make_voltage_geometry_matrix","linalg");
       make_voltage_geometry_matrix(b,&A);
-      gettimeofday(&finish, NULL);
-      duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-      printf("  make_voltage_geometry_matrix: %.6f sec\n", duration);
+      duration=trace_end(&span);
+      if(verbose)
+        printf("  make_voltage_geometry_matrix: %.6f sec\n", duration);
       
       zero_last_matrix_row(&A);
       
-      gettimeofday(&start, NULL);
+      trace_begin(&span,"make_diagonal_matrix","linalg");
       make_diagonal_matrix(b,&D);  
-      gettimeofday(&finish, NULL);
-      duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-      printf("  make_diagonal_matrix: %.6f sec\n", duration);
+      duration=trace_end(&span);
+      if(verbose)
+        printf("  make_diagonal_matrix: %.6f sec\n", duration);
       
       zero_last_matrix_row(&D);
       
-      gettimeofday(&start, NULL);
+      trace_begin(&span,"add_matrix","linalg");
       add_matrix(&D,&A,&DA); 
-      gettimeofday(&finish, NULL);
-      duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-      printf("  add_matrix: %.6f sec\n", duration);
+      duration=trace_end(&span);
+      if(verbose)
+        printf("  add_matrix: %.6f sec\n", duration);
       
-      gettimeofday(&start, NULL);
+      trace_begin(&span,"multiply_matrix (DA*V)","linalg");
       multiply_matrix(&DA,V,&DAV);
-      gettimeofday(&finish, NULL);
-      duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-      printf("  multiply_matrix (DA*V): %.6f sec\n", duration);
+      duration=trace_end(&span);
+      if(verbose)
+        printf("  multiply_matrix (DA*V): %.6f sec\n", duration);
       
             /* ⭐ ADD THESE LINES: */
       long long flops_dav = 2LL * (5*N+1) * 2*N * 1;
       update_multiply_matrix_stats(duration, flops_dav);
 
-gettimeofday(&phase_finish, NULL);
-phase1_time = ((double)(phase_finish.tv_sec-phase_start.tv_sec)*1000000 + (double)(phase_finish.tv_usec-phase_start.tv_usec)) / 1000000;
-printf("PHASE 1 Total: %.6f seconds\n\n", phase1_time);
+phase1_time = trace_end(&phase_span);
+if(verbose)
+  printf("PHASE 1 Total: %.6f seconds\n\n", phase1_time);
 
 /*---------------------------------------------------*/
-printf("================================================================================\n");
-printf("PHASE 2: Current Geometry Matrix Setup\n");
-printf("================================================================================\n");
-gettimeofday(&phase_start, NULL);   
+if(verbose)
+{
+  printf("================================================================================\n");
+  printf("PHASE 2: Current Geometry Matrix Setup\n");
+  printf("================================================================================\n");
+}
+trace_begin(&phase_span,"current geometry matrix setup","zone");
 
       /*-----------------------------*/
       attach_matrix(&B,5*N+1,4*N,values);            /* write on top of A,D,DA */  
@@ -348,56 +378,64 @@ gettimeofday(&phase_start, NULL);
       attach_matrix(&BTDAV,4*N,1,after_matrix(&BTB));
       attach_matrix(&KCL,1,4*N,after_matrix(&BTB));  /* KCL comes after BTB */
 
-gettimeofday(&start, NULL);  
+trace_begin(&span,"make_current_geometry_matrix","linalg");
       make_current_geometry_matrix(b,&B);
-gettimeofday(&finish, NULL);
-duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-printf("  make_current_geometry_matrix: %.6f sec\n", duration);
+duration=trace_end(&span);
+if(verbose)
+  printf("  make_current_geometry_matrix: %.6f sec\n", duration);
 
-gettimeofday(&start, NULL);  
+trace_begin(&span,"make_kcl_geometry_vector","linalg");
       make_kcl_geometry_vector(b,&KCL);
-gettimeofday(&finish, NULL);
-duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-printf("  make_kcl_geometry_vector: %.6f sec\n", duration);
+duration=trace_end(&span);
+if(verbose)
+  printf("  make_kcl_geometry_vector: %.6f sec\n", duration);
 
-gettimeofday(&start, NULL);  
+trace_begin(&span,"fill_last_matrix_row","linalg");
       fill_last_matrix_row(&B,&KCL);
-gettimeofday(&finish, NULL);
-duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-printf("  fill_last_matrix_row: %.6f sec\n", duration);
+duration=trace_end(&span);
+if(verbose)
+  printf("  fill_last_matrix_row: %.6f sec\n", duration);
 
-gettimeofday(&start, NULL);  
+trace_begin(&span,"transpose_matrix","linalg");
       transpose_matrix(&BT,&BT);
-gettimeofday(&finish, NULL);
-duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-printf("  transpose_matrix: %.6f sec\n", duration);
+duration=trace_end(&span);
+if(verbose)
+  printf("  transpose_matrix: %.6f sec\n", duration);
 
-gettimeofday(&phase_finish, NULL);
-phase2_time = ((double)(phase_finish.tv_sec-phase_start.tv_sec)*1000000 + (double)(phase_finish.tv_usec-phase_start.tv_usec)) / 1000000;
-printf("PHASE 2 Total: %.6f seconds\n\n", phase2_time);
+phase2_time = trace_end(&phase_span);
+if(verbose)
+  printf("PHASE 2 Total: %.6f seconds\n\n", phase2_time);
 
 /*---------------------------------------------------*/
-printf("================================================================================\n");
-printf("PHASE 3: Matrix Multiplication (BT * B)\n");
-printf("================================================================================\n");
+if(verbose)
+{
+  printf("================================================================================\n");
+  printf("PHASE 3: Matrix Multiplication (BT * B)\n");
+  printf("================================================================================\n");
+}
 
-  printf("  Matrix B info:\n    ");
-  show_matrix_info(&B);
-  printf("  Matrix BT info:\n    ");
-  show_matrix_info(&BT);
+  if(verbose)
+  {
+    printf("  Matrix B info:\n    ");
+    show_matrix_info(&B);
+    printf("  Matrix BT info:\n    ");
+    show_matrix_info(&BT);
 
-  get_memory_usage_kb(&vmrss, &vmsize);
-  printf("  Memory before BTB multiply: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
-         vmrss/1024.0, vmsize/1024.0);
+    get_memory_usage_kb(&vmrss, &vmsize);
+    printf("  Memory before BTB multiply: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
+           vmrss/1024.0, vmsize/1024.0);
+  }
 
-gettimeofday(&mul_start1, NULL);        
+trace_begin(&mul_span1,"multiply_matrix (BT*B)","linalg");
       multiply_matrix(&BT,&B,&BTB);
-gettimeofday(&mul_finish1, NULL);
-mul_duration1 = ((double)(mul_finish1.tv_sec-mul_start1.tv_sec)*1000000 + (double)(mul_finish1.tv_usec-mul_start1.tv_usec)) / 1000000;
+mul_duration1 = trace_end(&mul_span1);
 
-  get_memory_usage_kb(&vmrss, &vmsize);
-  printf("  Memory after BTB multiply: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
-         vmrss/1024.0, vmsize/1024.0);
+  if(verbose)
+  {
+    get_memory_usage_kb(&vmrss, &vmsize);
+    printf("  Memory after BTB multiply: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
+           vmrss/1024.0, vmsize/1024.0);
+  }
 
   // Calculate FLOPS for BT*B multiplication
   long long flops_btb = 2LL * (5*N+1) * 4*N * 4*N;
@@ -406,98 +444,118 @@ mul_duration1 = ((double)(mul_finish1.tv_sec-mul_start1.tv_sec)*1000000 + (doubl
   /* ⭐ ADD THIS LINE: */
 update_multiply_matrix_stats(mul_duration1, flops_btb);
 
-printf("PHASE 3 Total: %.6f seconds\n\n", mul_duration1);
+if(verbose)
+{
+  printf("PHASE 3 Total: %.6f seconds\n\n", mul_duration1);
 
-printf("  multiply_matrix (BT*B): %.6f sec (%.2f GFLOPS)\n", mul_duration1, gflops_btb);
-printf("PHASE 3 Total: %.6f seconds\n\n", mul_duration1);
+  printf("  multiply_matrix (BT*B): %.6f sec (%.2f GFLOPS)\n", mul_duration1, gflops_btb);
+  printf("PHASE 3 Total: %.6f seconds\n\n", mul_duration1);
+}
 
 /*---------------------------------------------------*/
-printf("================================================================================\n");
-printf("PHASE 4: Matrix Inversion\n");
-printf("================================================================================\n");
+if(verbose)
+{
+  printf("================================================================================\n");
+  printf("PHASE 4: Matrix Inversion\n");
+  printf("================================================================================\n");
+}
 
-  get_memory_usage_kb(&vmrss, &vmsize);
-  printf("  Memory before inversion: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
-         vmrss/1024.0, vmsize/1024.0);
+  if(verbose)
+  {
+    get_memory_usage_kb(&vmrss, &vmsize);
+    printf("  Memory before inversion: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
+           vmrss/1024.0, vmsize/1024.0);
+  }
 
-gettimeofday(&inv_start, NULL);   
+trace_begin(&inv_span,"invert_this_matrix (BTB)","linalg");
       //invert_matrix(&BTB,&BTB);
       invert_this_matrix(&BTB);    /* LAPACK or Gauss–Jordan runs here */
-gettimeofday(&inv_finish, NULL);
-inv_duration = ((double)(inv_finish.tv_sec-inv_start.tv_sec)*1000000 + (double)(inv_finish.tv_usec-inv_start.tv_usec)) / 1000000;
+inv_duration = trace_end(&inv_span);
 
-  get_memory_usage_kb(&vmrss, &vmsize);
-  printf("  Memory after inversion: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
-         vmrss/1024.0, vmsize/1024.0);
+  if(verbose)
+  {
+    get_memory_usage_kb(&vmrss, &vmsize);
+    printf("  Memory after inversion: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
+           vmrss/1024.0, vmsize/1024.0);
+  }
 
-printf("PHASE 4 Total: %.6f seconds\n\n", inv_duration);
+if(verbose)
+  printf("PHASE 4 Total: %.6f seconds\n\n", inv_duration);
 
 /*---------------------------------------------------*/
-printf("================================================================================\n");
-printf("PHASE 5: Final Matrix Multiplications\n");
-printf("================================================================================\n");
+if(verbose)
+{
+  printf("================================================================================\n");
+  printf("PHASE 5: Final Matrix Multiplications\n");
+  printf("================================================================================\n");
+}
 
-gettimeofday(&mul_start2, NULL);    
+trace_begin(&mul_span2,"final matrix multiplications","zone");
 
-      gettimeofday(&start, NULL);
+      trace_begin(&span,"multiply_matrix (BT*DAV)","linalg");
       multiply_matrix(&BT,&DAV,&BTDAV);
-      gettimeofday(&finish, NULL);
-      duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-      printf("  multiply_matrix (BT*DAV): %.6f sec\n", duration);
+      duration=trace_end(&span);
+      if(verbose)
+        printf("  multiply_matrix (BT*DAV): %.6f sec\n", duration);
       
        /* ⭐ ADD THESE LINES: */
       long long flops_btdav = 2LL * 4*N * (5*N+1) * 1;
       update_multiply_matrix_stats(duration, flops_btdav);
 
-      gettimeofday(&start, NULL);
+      trace_begin(&span,"multiply_matrix (BTB*BTDAV)","linalg");
       multiply_matrix(&BTB,&BTDAV,J);
-      gettimeofday(&finish, NULL);
-      duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-      printf("  multiply_matrix (BTB*BTDAV): %.6f sec\n", duration);
+      duration=trace_end(&span);
+      if(verbose)
+        printf("  multiply_matrix (BTB*BTDAV): %.6f sec\n", duration);
 
       /* ⭐ ADD THESE LINES: */
       long long flops_final = 2LL * 4*N * 4*N * 1;
       update_multiply_matrix_stats(duration, flops_final);
 
-gettimeofday(&mul_finish2, NULL);
-mul_duration2 = ((double)(mul_finish2.tv_sec-mul_start2.tv_sec)*1000000 + (double)(mul_finish2.tv_usec-mul_start2.tv_usec)) / 1000000;
-printf("PHASE 5 Total: %.6f seconds\n\n", mul_duration2);
+mul_duration2 = trace_end(&mul_span2);
+if(verbose)
+  printf("PHASE 5 Total: %.6f seconds\n\n", mul_duration2);
 
 /*---------------------------------------------------*/
-gettimeofday(&all_finish, NULL);
-all_duration = ((double)(all_finish.tv_sec-all_start.tv_sec)*1000000 + (double)(all_finish.tv_usec-all_start.tv_usec)) / 1000000;
-
-printf("================================================================================\n");
-printf("                    BOUNDARY COMPUTATION SUMMARY\n");
-printf("================================================================================\n");
-printf("\nTIMING BREAKDOWN:\n");
-printf("  Phase 1 (Voltage Setup):        %10.6f sec (%5.1f%%)\n", phase1_time, phase1_time/all_duration*100);
-printf("  Phase 2 (Current Setup):        %10.6f sec (%5.1f%%)\n", phase2_time, phase2_time/all_duration*100);
-printf("  Phase 3 (BT*B multiply):        %10.6f sec (%5.1f%%)\n", mul_duration1, mul_duration1/all_duration*100);
-printf("  Phase 4 (Matrix Inversion):     %10.6f sec (%5.1f%%)\n", inv_duration, inv_duration/all_duration*100);
-printf("  Phase 5 (Final multiplies):     %10.6f sec (%5.1f%%)\n", mul_duration2, mul_duration2/all_duration*100);
-printf("  -----------------------------------------------------------\n");
-printf("  TOTAL:                          %10.6f sec\n\n", all_duration);
-
-printf("OPERATION TOTALS:\n");
-printf("  All Matrix Multiplications:     %10.6f sec (%5.1f%%)\n", 
-       mul_duration1+mul_duration2, (mul_duration1+mul_duration2)/all_duration*100);
-printf("  Matrix Inversion:               %10.6f sec (%5.1f%%)\n", 
-       inv_duration, inv_duration/all_duration*100);
-printf("  Other Operations:               %10.6f sec (%5.1f%%)\n", 
-       all_duration-(mul_duration1+mul_duration2+inv_duration),
-       (all_duration-(mul_duration1+mul_duration2+inv_duration))/all_duration*100);
-
-getrusage(RUSAGE_SELF,&r_usage);
-get_memory_usage_kb(&vmrss, &vmsize);
-
-printf("\nMEMORY USAGE:\n");
-printf("  VmRSS (resident):               %.2f MB\n", vmrss/1024.0);
-printf("  VmSize (virtual):               %.2f MB\n", vmsize/1024.0);
-printf("  Max RSS:                        %.2f MB\n", r_usage.ru_maxrss/1024.0);
-printf("================================================================================\n\n");
-
-      free((void *)values);
+all_duration = trace_end(&all_span);
+
+if(verbose)
+{
+  printf("================================================================================\n");
+  printf("                    BOUNDARY COMPUTATION SUMMARY\n");
+  printf("================================================================================\n");
+  printf("\nTIMING BREAKDOWN:\n");
+  printf("  Phase 1 (Voltage Setup):        %10.6f sec (%5.1f%%)\n", phase1_time, phase1_time/all_duration*100);
+  printf("  Phase 2 (Current Setup):        %10.6f sec (%5.1f%%)\n", phase2_time, phase2_time/all_duration*100);
+  printf("  Phase 3 (BT*B multiply):        %10.6f sec (%5.1f%%)\n", mul_duration1, mul_duration1/all_duration*100);
+  printf("  Phase 4 (Matrix Inversion):     %10.6f sec (%5.1f%%)\n", inv_duration, inv_duration/all_duration*100);
+  printf("  Phase 5 (Final multiplies):     %10.6f sec (%5.1f%%)\n", mul_duration2, mul_duration2/all_duration*100);
+  printf("  -----------------------------------------------------------\n");
+  printf("  TOTAL:                          %10.6f sec\n\n", all_duration);
+
+  printf("OPERATION TOTALS:\n");
+  printf("  All Matrix Multiplications:     %10.6f sec (%5.1f%%)\n", 
+         mul_duration1+mul_duration2, (mul_duration1+mul_duration2)/all_duration*100);
+  printf("  Matrix Inversion:               %10.6f sec (%5.1f%%)\n", 
+         inv_duration, inv_duration/all_duration*100);
+  printf("  Other Operations:               %10.6f sec (%5.1f%%)\n", 
+         all_duration-(mul_duration1+mul_duration2+inv_duration),
+         (all_duration-(mul_duration1+mul_duration2+inv_duration))/all_duration*100);
+}
+
+if(verbose)
+{
+  getrusage(RUSAGE_SELF,&r_usage);
+  get_memory_usage_kb(&vmrss, &vmsize);
+
+  printf("\nMEMORY USAGE:\n");
+  printf("  VmRSS (resident):               %.2f MB\n", vmrss/1024.0);
+  printf("  VmSize (virtual):               %.2f MB\n", vmsize/1024.0);
+  printf("  Max RSS:                        %.2f MB\n", r_usage.ru_maxrss/1024.0);
+  printf("================================================================================\n\n");
+}
+
+      tracked_free((void *)values);
 
     }
   else
@@ -627,6 +685,103 @@ void make_internal_sec_grad_voltage(b,bvv,bcv,P,ten_vgv,ten_cgv,Gv)
   Gv[1][0]=Gv[1][0]/(2.0*M_PI);
   Gv[1][1]=Gv[1][1]/(2.0*M_PI);
 }
+/*----------------------------------------------------------------------------------*/
+/*  make the stream function psi at point P, from psi=0 at point O: the conjugate  */
+/*  of V (d psi/dx=-dV/dy, d psi/dy=dV/dx) on the same boundary vectors. psi goes   */
+/*  up by the flux of each loop round it, so it is taken along the straight line   */
+/*  from O to P, which should not leave the zone                                   */
+/*----------------------------------------------------------------------------------*/
+double make_internal_stream_function(b,bvv,bcv,O,P)
+     boundary *b;
+     matrix *bvv, *bcv;
+     coordinates O, P;
+{
+  coordinates Qa, Qb;
+  double x, y1, y2, a, V, W, J, K, L, M, v, c;
+  int k, offset_j, segment_j, i;
+  path *path_j;
+
+  v=0.0;
+  c=0.0;
+  offset_j=0;
+  for(k=0;k<b->components;k++)
+    {
+      path_j=b->loop[k];
+      for(segment_j=0;segment_j<path_j->points;segment_j++)
+	{
+	  get_path_xy(path_j,segment_j,Qa);
+	  get_path_xy(path_j,segment_j+1,Qb);
+
+	  /* at P, angles from the direction of O seen from Qa */
+	  a=atanv(O,P,Qa);
+	  convert_PQ(Qa, Qb, P, &x, &y1, &y2);
+	  V=Vconj_PoffS(x,y1,y2);
+	  W=Wconj_PoffS(x,y1,y2);
+	  J=Jconj_PoffS(x,y1,y2,a);
+	  K=Kconj_PoffS(x,y1,y2,a);
+	  L=Lconj_PoffS(x,y1,y2,a);
+	  M=Mconj_PoffS(x,y1,y2,a);
+
+	  /* less the same at O */
+	  convert_PQ(Qa, Qb, O, &x, &y1, &y2);
+	  V=V-Vconj_PoffS(x,y1,y2);
+	  W=W-Wconj_PoffS(x,y1,y2);
+	  J=J-Jconj_PoffS(x,y1,y2,0.0);
+	  K=K-Kconj_PoffS(x,y1,y2,0.0);
+	  L=L-Lconj_PoffS(x,y1,y2,0.0);
+	  M=M-Mconj_PoffS(x,y1,y2,0.0);
+
+	  p2c_2basis(V,W,&V,&W);
+	  p2c_4basis(J,K,L,M,&J,&K,&L,&M);
+	  i=2*(offset_j+segment_j);
+	  v=v+V*bvv->value[i]+W*bvv->value[i+1];
+	  i=4*(offset_j+segment_j);
+	  c=c+J*bcv->value[i]+K*bcv->value[i+1]+L*bcv->value[i+2]+M*bcv->value[i+3];
+	}
+      offset_j=offset_j+path_j->points;
+    }
+  return(c-v);
+}
+/*----------------------------------------------------------------------------------*/
+/*  make the gradient of the stream function at point P (dV turned through 90)    */
+/*----------------------------------------------------------------------------------*/
+void make_internal_grad_stream(b,bvv,bcv,P,co_vgv,co_cgv,Gs)
+     boundary *b;
+     matrix *bvv, *bcv;
+     co_matrix *co_vgv, *co_cgv;
+     coordinates P,Gs;
+{
+  coordinates Gv;
+
+  make_internal_grad_voltage(b,bvv,bcv,P,co_vgv,co_cgv,Gv);
+  Gs[0]=-Gv[1];
+  Gs[1]=Gv[0];
+}
+/*----------------------------------------------------------------------------------*/
+/*  make the parts of V, dV and d2V at point P asked for in mask (EVAL_V, ...); */
+/*  the others are set to 0 */
+/*----------------------------------------------------------------------------------*/
+double make_internal_field(b,bvv,bcv,P,x,R,mask)
+     boundary *b;
+     matrix *bvv, *bcv;
+     coordinates P;
+     bem_vectors *x;
+     bem_results *R;
+     int mask;
+{
+  R->V=0.0;
+  R->dV[0]=0.0;     R->dV[1]=0.0;
+  R->d2V[0][0]=0.0; R->d2V[0][1]=0.0;
+  R->d2V[1][0]=0.0; R->d2V[1][1]=0.0;
+
+  if(mask & EVAL_V)
+    R->V=make_internal_voltage(b,bvv,bcv,P,x->vgv,x->cgv);
+  if(mask & EVAL_DV)
+    make_internal_grad_voltage(b,bvv,bcv,P,x->co_vgv,x->co_cgv,R->dV);
+  if(mask & EVAL_D2V)
+    make_internal_sec_grad_voltage(b,bvv,bcv,P,x->ten_vgv,x->ten_cgv,R->d2V);
+  return(R->V);
+}
 
 /*----------------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------------*/
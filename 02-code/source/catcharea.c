@@ -11,15 +11,44 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "memtrack_types.h"
+#include "predict_types.h"
+#include "stream_types.h"
+#include "checkpoint_types.h"
+#include "logging_types.h"
+#include "trace_types.h"
+#include "perfcount_types.h"
+#include "synthetic_types.h"
+#include "bfactor_types.h"
 
 #include "area.h"
+#include "bfactor.h"
 #include "catchment.h"
+#include "checkpoint.h"
+#include "direction.h"
+#include "edit.h"
+#include "ensemble.h"
 #include "file.h"
+#include "flowacc.h"
+#include "logging.h"
 #include "memory.h"
+#include "memtrack.h"
+#include "merge.h"
+#include "packet.h"
 #include "path.h"
+#include "perfcount.h"
+#include "predict.h"
+#include "regress.h"
+#include "rkstream.h"
+#include "sca.h"
 #include "scan.h"
+#include "stopping.h"
 #include "streamline.h"
+#include "surrogate.h"
+#include "synthetic.h"
+#include "trace.h"
 #include "trapfloat.h"
+#include "vcalc.h"
 
 #include <omp.h>
 #include "catcharea.h"
@@ -42,6 +71,221 @@ extern int get_dgemm_type(void);
 extern const char* get_dgemm_type_name(void);
 extern void print_expected_performance(void);
 /*--------------------------------------------------------*/
+/* Errors against the exact solution of a synthetic        */
+/* catchment (gencatch): V and dV at the mouth points, the */
+/* distance of the streamlines from the exact flow paths   */
+/* and C_area against the exact area and against the      */
+/* value it goes to with smaller steps (see synthetic.c).  */
+/*--------------------------------------------------------*/
+static void report_reference(synthetic *s, catchment *c, bem_vectors *vectors,
+                             section *mouth, double C_area, int n_stream,
+                             path **streamlines)
+{
+  bem_results R;
+  coordinates P, dV;
+  double V, V_error = 0.0, dV_error = 0.0, d, path_error = 0.0;
+  int i, new_z;
+
+  for (i = 0; i < mouth->n; i++)
+  {
+    xy_section(mouth, i, P);
+    calculate_inside_catchment(c, P, vectors, &R, &new_z, EVAL_V | EVAL_DV);
+    V = exact_synthetic_field(s, P, dV);
+    if (fabs(R.V - V) > V_error)
+      V_error = fabs(R.V - V);
+    d = hypot(R.dV[0] - dV[0], R.dV[1] - dV[1]) / hypot(dV[0], dV[1]);
+    if (d > dV_error)
+      dV_error = d;
+  }
+  for (i = 0; i < n_stream; i++)
+    if (streamlines[i] != NULL && streamlines[i]->xy != NULL)
+    {
+      d = synthetic_path_error(s, streamlines[i]->points, streamlines[i]->xy);
+      if (d > path_error)
+        path_error = d;
+    }
+
+  printf("\n  Synthetic catchment:  %s (%s)\n", synthetic_shape_name(s->shape),
+         get_synthetic_reference());
+  printf("  Max |V - exact|:      %.3e at %d mouth points\n", V_error, mouth->n);
+  printf("  Max dV error:         %.3e (relative to |dV|)\n", dV_error);
+  printf("  Flow path error:      %.3e (farthest streamline point from the exact path)\n",
+         path_error);
+  printf("  Exact area:           %.6f (relative error %+.3e)\n", s->area,
+         (C_area - s->area) / s->area);
+  printf("  Limit of C_area:      %.6f (relative error %+.3e)\n", s->limit,
+         (C_area - s->limit) / s->limit);
+}
+/*--------------------------------------------------------*/
+/* Options of the form --key=value may appear anywhere on  */
+/* the command line. They are applied and removed, so the  */
+/* positional arguments keep their usual meaning.          */
+/*--------------------------------------------------------*/
+static int parse_options(int argc, char *argv[])
+{
+  stream_control sc;
+  char *value;
+  int i, n, method, window, revisits, k;
+  double gmin, ratio, ptol;
+
+  get_stream_control(&sc);
+  get_stop_criteria(&gmin, &window, &ratio, &revisits);
+  get_predictor(&k, &ptol);
+  n = 1;
+  for (i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--", 2) != 0)
+    {
+      argv[n++] = argv[i];
+      continue;
+    }
+    if (strcmp(argv[i], "--resume") == 0)
+    {
+      set_resume(1);
+      continue;
+    }
+    value = strchr(argv[i], '=');
+    if (value == NULL)
+    {
+      printf("option '%s' needs a value (--key=value)\n", argv[i]);
+      exit(0);
+    }
+    value++;
+    if (strncmp(argv[i], "--integrator=", 13) == 0)
+    {
+      method = stream_method_from_name(value);
+      if (method < 0)
+      {
+        printf("unknown integrator '%s' (fixed, taylor or dopri)\n", value);
+        exit(0);
+      }
+      sc.method = method;
+    }
+    else if (strncmp(argv[i], "--direction=", 12) == 0)
+    {
+      method = direction_method_from_name(value);
+      if (method < 0)
+      {
+        printf("unknown direction method '%s' (quartic or newton)\n", value);
+        exit(0);
+      }
+      set_direction_method(method);
+    }
+    else if (strncmp(argv[i], "--atol=", 7) == 0)
+      sc.atol = atof(value);
+    else if (strncmp(argv[i], "--rtol=", 7) == 0)
+      sc.rtol = atof(value);
+    else if (strncmp(argv[i], "--hmin=", 7) == 0)
+      sc.h_min = atof(value);
+    else if (strncmp(argv[i], "--hmax=", 7) == 0)
+      sc.h_max = atof(value);
+    else if (strncmp(argv[i], "--gmin=", 7) == 0)
+      gmin = atof(value);
+    else if (strncmp(argv[i], "--stall-window=", 15) == 0)
+      window = atoi(value);
+    else if (strncmp(argv[i], "--stall-ratio=", 14) == 0)
+      ratio = atof(value);
+    else if (strncmp(argv[i], "--revisits=", 11) == 0)
+      revisits = atoi(value);
+    else if (strncmp(argv[i], "--merge=", 8) == 0)
+      set_merge_tolerance(atof(value));
+    else if (strncmp(argv[i], "--mouth-tol=", 12) == 0)
+      set_mouth_tolerance(atof(value));
+    else if (strncmp(argv[i], "--packet=", 9) == 0)
+      set_packet_size(atoi(value));
+    else if (strncmp(argv[i], "--surrogate=", 12) == 0)
+      set_surrogate_tolerance(atof(value));
+    else if (strncmp(argv[i], "--area=", 7) == 0)
+    {
+      if (strcmp(value, "trapezoid") == 0)
+        set_area_method(AREA_TRAPEZOID);
+      else if (strcmp(value, "shoelace") == 0)
+        set_area_method(AREA_SHOELACE);
+      else
+      {
+        printf("unknown area method '%s' (trapezoid or shoelace)\n", value);
+        exit(0);
+      }
+    }
+    else if (strncmp(argv[i], "--sca-map=", 10) == 0)
+      set_sca_map(atof(value));
+    else if (strncmp(argv[i], "--accumulate=", 13) == 0)
+      set_flow_accumulation(atof(value));
+    else if (strncmp(argv[i], "--ensemble=", 11) == 0)
+      set_ensemble(atoi(value));
+    else if (strncmp(argv[i], "--ensemble-sigma=", 17) == 0)
+      set_ensemble_sigma(atof(value));
+    else if (strncmp(argv[i], "--edited=", 9) == 0)
+      set_edited(value);
+    else if (strncmp(argv[i], "--edit-check=", 13) == 0)
+      set_edit_check(atoi(value));
+    else if (strncmp(argv[i], "--update-limit=", 15) == 0)
+      set_update_limit(atof(value));
+    else if (strncmp(argv[i], "--checkpoint=", 13) == 0)
+      set_checkpoint(atof(value));
+    else if (strncmp(argv[i], "--trace=", 8) == 0)
+      set_trace(value);
+    else if (strncmp(argv[i], "--reference=", 12) == 0)
+      set_synthetic_reference(value);
+    else if (strncmp(argv[i], "--regress=", 10) == 0)
+      set_regress(value);
+    else if (strncmp(argv[i], "--regress-out=", 14) == 0)
+      set_regress_output(value);
+    else if (strncmp(argv[i], "--regress-baseline=", 19) == 0)
+      set_regress_baseline(value);
+    else if (strncmp(argv[i], "--regress-variants=", 19) == 0)
+      set_regress_variants(value);
+    else if (strncmp(argv[i], "--regress-area-tol=", 19) == 0)
+      set_regress_tolerances(atof(value), -1.0);
+    else if (strncmp(argv[i], "--regress-time-tol=", 19) == 0)
+      set_regress_tolerances(-1.0, atof(value));
+    else if (strncmp(argv[i], "--perf=", 7) == 0)
+      set_perf_counters(atoi(value));
+    else if (strncmp(argv[i], "--perf-fp=", 10) == 0)
+      set_perf_fp_event(strtoul(value, NULL, 0));
+    else if (strncmp(argv[i], "--log=", 6) == 0)
+    {
+      method = log_level_from_name(value);
+      if (method < 0)
+      {
+        printf("unknown log level '%s' (error, warn, info or debug)\n", value);
+        exit(0);
+      }
+      set_log_level(method);
+    }
+    else if (strncmp(argv[i], "--log-cat=", 10) == 0)
+    {
+      method = log_categories_from_names(value);
+      if (method < 0)
+      {
+        printf("unknown log category in '%s' (matrix, linalg, zone, stream or all)\n",
+               value);
+        exit(0);
+      }
+      set_log_categories(method);
+    }
+    else if (strncmp(argv[i], "--log-progress=", 15) == 0)
+      set_log_progress(atof(value));
+    else if (strncmp(argv[i], "--predict=", 10) == 0)
+      k = atoi(value);
+    else if (strncmp(argv[i], "--predict-tol=", 14) == 0)
+      ptol = atof(value);
+    else
+    {
+      printf("unknown option '%s'\n", argv[i]);
+      exit(0);
+    }
+  }
+  argv[n] = NULL;
+
+  set_stream_method(sc.method);
+  set_stream_tolerances(sc.atol, sc.rtol);
+  set_stream_step_bounds(sc.h_min, sc.h_max);
+  set_stop_criteria(gmin, window, ratio, revisits);
+  set_predictor(k, ptol);
+  return (n);
+}
+/*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
 int main(int argc, char *argv[])
 {
@@ -50,11 +294,13 @@ int main(int argc, char *argv[])
   // STEP 1: Initialize performance tracking
   // ═══════════════════════════════════════════════════════════
   init_performance_summary();
-
-  struct timeval total_start, total_end;
-  gettimeofday(&total_start, NULL);
   // ═══════════════════════════════════════════════════════════
 
+  argc = parse_options(argc, argv);
+  if (get_regress() != NULL) // every data set in a catcharea of its own
+    return (run_regression(argc, argv));
+  open_perf_counters(); // before the OpenMP threads, which then inherit the counters
+
   //---------- OPTIMIZE PATCH ------------------
   int multiply_method = 3; // Default: full optimization
   int block_size = 64;     // Default: 64 for large matrices
@@ -107,12 +353,13 @@ int main(int argc, char *argv[])
   matrix bvv, bcv;
   path **streamlines;
   section mouth;
+  synthetic reference;
   coordinates PA, PB;
 
-  struct timeval all_start, all_finish;
+  trace_span all_span, io_span;
   double all_duration;
 
-  struct timeval phase_start, phase_finish;
+  trace_span phase_span;
   double init_time, bem_time, catchment_time, total_time;
 
   struct rusage r_usage_start, r_usage_end;
@@ -150,7 +397,7 @@ int main(int argc, char *argv[])
   printf("================================================================================\n");
   printf("\n");
 
-  gettimeofday(&all_start, NULL);
+  trace_begin(&all_span, "catcharea", "phase");
 
   /*--------------------------------------------------------*/
   /* PHASE 1: Initialization */
@@ -158,7 +405,7 @@ int main(int argc, char *argv[])
   printf("================================================================================\n");
   printf("PHASE 1: Initialization and Setup\n");
   printf("================================================================================\n");
-  gettimeofday(&phase_start, NULL);
+  trace_begin(&phase_span, "initialization", "phase");
 
   trap_floating_errors();
   buf_size = 512 * 12 + 1;
@@ -166,8 +413,10 @@ int main(int argc, char *argv[])
 
   num_zones = catchment_zones(data);
   c = create_catchment(num_zones, 30);
+  trace_begin(&io_span, "get_catchment", "io");
   get_catchment(data, c);
   plot_catchment(c, "catchment.out");
+  trace_end(&io_span);
   max_points = max_points_in_any_zone(c);
 
   printf("  Catchment zones:      %d\n", num_zones);
@@ -204,8 +453,10 @@ int main(int argc, char *argv[])
   // ═══════════════════════════════════════════════════════════
   // STEP 3: Start Setup phase
   // ═══════════════════════════════════════════════════════════
-  struct timeval setup_start, setup_end;
-  gettimeofday(&setup_start, NULL);
+  trace_span setup_span;
+  perf_sample setup_sample;
+  trace_begin(&setup_span, "setup", NULL);
+  perf_begin(&setup_sample);
   // ═══════════════════════════════════════════════════════════
 
   /* Set the inversion method */
@@ -217,10 +468,90 @@ int main(int argc, char *argv[])
   printf("  Max steps:            %d\n", max_steps);
   printf("  Inversion method:     %s\n",
          inversion_method ? "SEQUENTIAL" : "PARALLEL");
+  {
+    stream_control sc;
+    get_stream_control(&sc);
+    printf("  Streamline method:    %s", stream_method_name(sc.method));
+    if (sc.method != STREAM_FIXED)
+      printf(" (atol=%g, rtol=%g, hmin=%g, hmax=%g)",
+             sc.atol, sc.rtol, sc.h_min, sc.h_max);
+    printf("\n");
+    printf("  Step direction:       %s\n",
+           direction_method_name(get_direction_method()));
+    if (get_merge_tolerance() > 0.0)
+      printf("  Merge streamlines:    within %g\n", get_merge_tolerance());
+    if (get_packet_size() > 1)
+      printf("  Streamline packets:   %d lanes%s\n", get_packet_size(),
+             (sc.method == STREAM_FIXED && get_merge_tolerance() <= 0.0)
+                 ? "" : " (not used: needs fixed steps, no merging)");
+    if (get_area_method() == AREA_SHOELACE)
+      printf("  Catchment area:       2 bounding streamlines, on the level sets of psi\n");
+    if (get_mouth_tolerance() > 0.0)
+      printf("  Mouth points:         adaptive, area tolerance %g\n",
+             get_mouth_tolerance());
+    {
+      int k;
+      double ptol;
+      get_predictor(&k, &ptol);
+      if (k > 0)
+        printf("  Gradient predictor:   up to %d steps, tolerance %g%s\n", k, ptol,
+               (sc.method == STREAM_FIXED &&
+                (get_packet_size() <= 1 || get_merge_tolerance() > 0.0))
+                   ? "" : " (not used: needs fixed steps, no packets)");
+    }
+    if (get_surrogate_tolerance() > 0.0)
+      printf("  Field surrogate:      quadtree per zone, tolerance %g\n",
+             get_surrogate_tolerance());
+    if (get_sca_map() > 0.0)
+      printf("  SCA map:              cells of %g (instead of the mouth area)\n",
+             get_sca_map());
+    if (get_flow_accumulation() > 0.0)
+      printf("  Flow accumulation:    cells of %g (instead of the mouth area)\n",
+             get_flow_accumulation());
+    if (get_ensemble() > 0)
+      printf("  Ensemble:             %d realisations of the path values, sigma %g\n",
+             get_ensemble(), get_ensemble_sigma());
+    if (get_edited()[0] != '\0')
+      printf("  Edited contours:      %s (zone factors updated up to rank %g*4N)%s\n",
+             get_edited(), get_update_limit(),
+             get_edit_check() ? ", checked" : "");
+    if (get_checkpoint() > 0.0 || get_resume())
+    {
+      if (get_checkpoint() > 0.0)
+        printf("  Checkpoints:          every %g s to %s", get_checkpoint(),
+               CHECKPOINT_FILE);
+      else
+        printf("  Checkpoints:          none written");
+      printf("%s%s\n", get_resume() ? ", resume from the last one" : "",
+             (get_area_method() == AREA_TRAPEZOID && get_mouth_tolerance() <= 0.0 &&
+              (get_packet_size() <= 1 || sc.method != STREAM_FIXED ||
+               get_merge_tolerance() > 0.0) &&
+              get_merge_tolerance() <= 0.0 && get_surrogate_tolerance() <= 0.0)
+                 ? "" : " (not used: needs the plain mouth loop, no packets,"
+                        " merging or surrogate)");
+    }
+    if (get_trace() != NULL)
+      printf("  Trace:                %s\n", get_trace());
+    if (get_perf_note()[0] != '\0')
+      printf("  Counters:             %s\n", get_perf_note());
+    if (get_synthetic_reference() != NULL)
+      printf("  Reference:            %s (mouth and exact solution)\n",
+             get_synthetic_reference());
+    if (get_log_level() != LOG_INFO || get_log_categories() != LOG_ALL)
+      printf("  Messages:             up to %s, categories 0x%x\n",
+             log_level_name(get_log_level()), get_log_categories());
+    set_stream_config(sc.method);
+  }
   printf("\n");
 
-  // mouth-01
-  put_section("P(0) = (581559.0,943674.0)  P(4) = (581743.0,943675.0)", &mouth);
+  // mouth-01 (or the mouth of a synthetic catchment)
+  if (get_synthetic_reference() != NULL)
+  {
+    read_synthetic_reference(get_synthetic_reference(), &reference);
+    put_section(reference.mouth, &mouth);
+  }
+  else
+    put_section("P(0) = (581559.0,943674.0)  P(4) = (581743.0,943675.0)", &mouth);
   show_section(&mouth);
   max_streams = mouth.n;
 
@@ -232,10 +563,7 @@ int main(int argc, char *argv[])
     streamlines[i] = create_path(max_steps, 1, 0);
   }
 
-  gettimeofday(&phase_finish, NULL);
-  init_time = ((double)(phase_finish.tv_sec - phase_start.tv_sec) * 1000000 +
-               (double)(phase_finish.tv_usec - phase_start.tv_usec)) /
-              1000000;
+  init_time = trace_end(&phase_span);
 
   get_memory_usage_kb(&vmrss_end, &vmsize_end);
   printf("\n  Initialization time:  %.6f seconds\n", init_time);
@@ -246,9 +574,8 @@ int main(int argc, char *argv[])
   // ═══════════════════════════════════════════════════════════
   // STEP 3: End Setup phase
   // ═══════════════════════════════════════════════════════════
-  gettimeofday(&setup_end, NULL);
-  double setup_time = (setup_end.tv_sec - setup_start.tv_sec) +
-                      (setup_end.tv_usec - setup_start.tv_usec) / 1000000.0;
+  double setup_time = trace_end(&setup_span);
+  perf_end(&setup_sample, PERF_SETUP, 0.0);
   update_setup_time(setup_time);
 
   // Set problem parameters
@@ -263,8 +590,11 @@ int main(int argc, char *argv[])
   // ═══════════════════════════════════════════════════════════
   // STEP 4: Start BEM computation phase
   // ═══════════════════════════════════════════════════════════
-  struct timeval bem_start, bem_end;
-  gettimeofday(&bem_start, NULL);
+  trace_span bem_span;
+  perf_sample bem_sample;
+  trace_begin(&bem_span, "bem", NULL);
+  perf_begin(&bem_sample);
+  set_memory_phase(MEM_BEM);
   // ═══════════════════════════════════════════════════════════
 
   /*--------------------------------------------------------*/
@@ -277,15 +607,33 @@ int main(int argc, char *argv[])
   printf("Detailed timing will be shown below.\n");
   printf("================================================================================\n\n");
 
-  gettimeofday(&phase_start, NULL);
-
-  C_area = catchment_area(c, &mouth, 0, max_steps, step_size, max_streams,
-                          streamlines, vectors); // stream down
-
-  gettimeofday(&phase_finish, NULL);
-  bem_time = ((double)(phase_finish.tv_sec - phase_start.tv_sec) * 1000000 +
-              (double)(phase_finish.tv_usec - phase_start.tv_usec)) /
-             1000000;
+  trace_begin(&phase_span, "bem computation", "phase");
+
+  C_area = 0.0;
+  if (get_sca_map() > 0.0)
+    sca_map((unsigned char *)data, c, vectors, max_steps, step_size,
+            "sca_map"); // stream up from every cell
+  else if (get_flow_accumulation() > 0.0)
+    flow_accumulation(c, vectors, "flow"); // one evaluation per cell
+  else if (get_ensemble() > 0)
+    C_area = ensemble_area(c, &mouth, max_steps, step_size, max_streams,
+                           streamlines, vectors); // stream down, each realisation
+  else if (get_edited()[0] != '\0')
+    C_area = edited_area(c, &mouth, max_steps, step_size, max_streams,
+                         streamlines, vectors); // stream down, edited contours
+  else if (get_area_method() == AREA_SHOELACE)
+    C_area = catchment_area_bounding(c, &mouth, 0, max_steps, step_size,
+                                     streamlines, vectors); // stream down
+  else if (get_mouth_tolerance() > 0.0)
+    C_area = catchment_area_adaptive(c, &mouth, 0, max_steps, step_size,
+                                     get_mouth_tolerance(), &max_streams,
+                                     &streamlines, vectors); // stream down
+  else
+    C_area = catchment_area(c, &mouth, 0, max_steps, step_size, max_streams,
+                            streamlines, vectors); // stream down
+  set_catchment_area_result(C_area);
+
+  bem_time = trace_end(&phase_span);
 
   get_memory_usage_kb(&vmrss_end, &vmsize_end);
 
@@ -296,14 +644,14 @@ int main(int argc, char *argv[])
   printf("  BEM computation time: %.6f seconds\n", bem_time);
   printf("  Memory after BEM:     VmRSS=%.2f MB, VmSize=%.2f MB\n",
          vmrss_end / 1024.0, vmsize_end / 1024.0);
+  report_surrogates();
   printf("================================================================================\n\n");
 
   // ═══════════════════════════════════════════════════════════
   // STEP 4: End BEM computation phase
   // ═══════════════════════════════════════════════════════════
-  gettimeofday(&bem_end, NULL);
-  bem_time = (bem_end.tv_sec - bem_start.tv_sec) +
-             (bem_end.tv_usec - bem_start.tv_usec) / 1000000.0;
+  bem_time = trace_end(&bem_span);
+  perf_end(&bem_sample, PERF_BEM, 0.0);
   update_bem_time(bem_time);
 
   // Track peak memory
@@ -314,8 +662,11 @@ int main(int argc, char *argv[])
   // ═══════════════════════════════════════════════════════════
   // STEP 5: Start Finalization phase
   // ═══════════════════════════════════════════════════════════
-  struct timeval final_start, final_end;
-  gettimeofday(&final_start, NULL);
+  trace_span final_span;
+  perf_sample final_sample;
+  trace_begin(&final_span, "finalization", NULL);
+  perf_begin(&final_sample);
+  set_memory_phase(MEM_FINAL);
   // ═══════════════════════════════════════════════════════════
 
   /*--------------------------------------------------------*/
@@ -324,20 +675,26 @@ int main(int argc, char *argv[])
   printf("================================================================================\n");
   printf("PHASE 3: Post-processing and Output\n");
   printf("================================================================================\n");
-  gettimeofday(&phase_start, NULL);
+  trace_begin(&phase_span, "post-processing", "phase");
 
-  plot_streamlines(c, max_streams, streamlines, "test.out");
-  printf("\n  Catchment area:       %.6f\n", C_area);
+  if (get_sca_map() <= 0.0 && get_flow_accumulation() <= 0.0)
+  {
+    trace_begin(&io_span, "plot_streamlines", "io");
+    plot_streamlines(c, (get_area_method() == AREA_SHOELACE) ? 2 : max_streams,
+                     streamlines, "test.out");
+    trace_end(&io_span);
+    printf("\n  Catchment area:       %.6f\n", C_area);
+    if (get_synthetic_reference() != NULL)
+      report_reference(&reference, c, vectors, &mouth, C_area, max_streams,
+                       streamlines);
+  }
 
   for (i = 0; i < max_streams; i++)
   {
     streamlines[i] = destroy_path(streamlines[i]);
   }
 
-  gettimeofday(&phase_finish, NULL);
-  catchment_time = ((double)(phase_finish.tv_sec - phase_start.tv_sec) * 1000000 +
-                    (double)(phase_finish.tv_usec - phase_start.tv_usec)) /
-                   1000000;
+  catchment_time = trace_end(&phase_span);
 
   printf("  Post-processing time: %.6f seconds\n", catchment_time);
   printf("================================================================================\n\n");
@@ -345,10 +702,7 @@ int main(int argc, char *argv[])
   /*--------------------------------------------------------*/
   /* Final timing and memory summary */
   /*--------------------------------------------------------*/
-  gettimeofday(&all_finish, NULL);
-  all_duration = ((double)(all_finish.tv_sec - all_start.tv_sec) * 1000000 +
-                  (double)(all_finish.tv_usec - all_start.tv_usec)) /
-                 1000000;
+  all_duration = trace_end(&all_span);
 
   getrusage(RUSAGE_SELF, &r_usage_end);
   get_memory_usage_kb(&vmrss_end, &vmsize_end);
@@ -414,9 +768,8 @@ int main(int argc, char *argv[])
   // ═══════════════════════════════════════════════════════════
   // STEP 5: End Finalization phase
   // ═══════════════════════════════════════════════════════════
-  gettimeofday(&final_end, NULL);
-  double final_time = (final_end.tv_sec - final_start.tv_sec) +
-                      (final_end.tv_usec - final_start.tv_usec) / 1000000.0;
+  double final_time = trace_end(&final_span);
+  perf_end(&final_sample, PERF_FINAL, 0.0);
   update_finalization_time(final_time);
   // ═══════════════════════════════════════════════════════════
 
@@ -439,6 +792,8 @@ int main(int argc, char *argv[])
 
   // Export to CSV file (optional)
   export_performance_csv("performance_results.csv");
+  write_trace();
+  close_perf_counters();
   /* Legacy compatibility for older benchmark scripts:
    echo an easily greppable one-line summary of matrix multiply time. */
   {
@@ -0,0 +1,363 @@
+/*---------------------------------- checkpoint.c ----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* checkpoints of the mouth loop of catchment_area                                  */
+/*                                                                                  */
+/* Every get_checkpoint() seconds (and at the end) the work done so far is written  */
+/* to CHECKPOINT_FILE:                                                              */
+/*  - the bvv and bcv of every zone solved so far,                                  */
+/*  - L and sin(theta) of every mouth point done, the partial C_sum and the number */
+/*    of the next point,                                                            */
+/*  - the points of the streamlines drawn so far (for test.out).                    */
+/* The file is written under another name and then renamed, so a run stopped while */
+/* writing leaves the last checkpoint as it was. With --resume the zones get their  */
+/* vectors back (make_boundary_vector then uses them as if calculated last time)   */
+/* and the loop goes on from the next point with the same numbers, so C_sum is the  */
+/* same to the last bit as in a run that was not stopped. The file holds a hash of */
+/* the points of the catchment and their values, and the settings of the loop and  */
+/* of the streamlines (integrator, tolerances, direction method, stopping tests,   */
+/* predictor); a checkpoint of another run is refused.                             */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "checkpoint_types.h"
+#include "memtrack_types.h"
+#include "predict_types.h"
+#include "stream_types.h"
+
+#include "direction.h"
+#include "memtrack.h"
+#include "path.h"
+#include "predict.h"
+#include "rkstream.h"
+#include "stopping.h"
+
+#include "checkpoint.h"
+/*----------------------------------------------------------------------------------*/
+#define HEAD_INTS   12       /* integer settings in the header */
+#define HEAD_VALUES 8        /* real settings in the header */
+/*----------------------------------------------------------------------------------*/
+static double every=0.0;       /* seconds between checkpoints; <=0 = none */
+static int resume=0;
+static double last_write;
+/*----------------------------------------------------------------------------------*/
+void set_checkpoint(seconds)
+     double seconds;
+{
+  every=seconds;
+}
+/*----------------------------------------------------------------------------------*/
+double get_checkpoint()
+{
+  return(every);
+}
+/*----------------------------------------------------------------------------------*/
+void set_resume(r)
+     int r;
+{
+  resume=r;
+}
+/*----------------------------------------------------------------------------------*/
+int get_resume()
+{
+  return(resume);
+}
+/*----------------------------------------------------------------------------------*/
+static double seconds_now()
+{
+  struct timeval t;
+
+  gettimeofday(&t,NULL);
+  return((double)t.tv_sec+(double)t.tv_usec/1000000.0);
+}
+/*----------------------------------------------------------------------------------*/
+void create_mouth_state(s,n)
+     mouth_state *s;
+     int n;
+{
+  s->n=n;
+  s->next=0;
+  s->k=0;
+  s->C_sum=0.0;
+  s->L=(double *)malloc(n*sizeof(double));
+  s->s_theta=(double *)malloc(n*sizeof(double));
+  if(s->L==(double *)NULL || s->s_theta==(double *)NULL)
+    {
+      printf("Cannot allocate memory for checkpoints\n");
+      exit(0);
+    }
+  last_write=seconds_now();
+}
+/*----------------------------------------------------------------------------------*/
+void destroy_mouth_state(s)
+     mouth_state *s;
+{
+  free((void *)s->L);
+  free((void *)s->s_theta);
+}
+/*----------------------------------------------------------------------------------*/
+/* hash of the points of all zones and their values (FNV-1a) */
+/*----------------------------------------------------------------------------------*/
+static unsigned long checkpoint_key(c)
+     catchment *c;
+{
+  unsigned long h;
+  unsigned char *byte;
+  int i,j;
+  size_t k,n;
+  path *p;
+
+  h=2166136261UL;
+  for(i=0;i<c->num_zones;i++)
+    for(j=0;j<c->zones[i]->components;j++)
+      {
+	p=c->zones[i]->loop[j];
+	byte=(unsigned char *)p->xy;
+	n=(size_t)p->points*sizeof(coordinates);
+	for(k=0;k<n;k++) h=(h^byte[k])*16777619UL;
+	byte=(unsigned char *)p->value;
+	n=(size_t)p->points*sizeof(double);
+	for(k=0;k<n;k++) h=(h^byte[k])*16777619UL;
+      }
+  return(h);
+}
+/*----------------------------------------------------------------------------------*/
+static int zone_points(b)
+     boundary *b;
+{
+  int j,N;
+
+  N=0;
+  for(j=0;j<b->components;j++) N=N+b->loop[j]->points;
+  return(N);
+}
+/*----------------------------------------------------------------------------------*/
+static void checkpoint_write(p,size,n,output)
+     void *p;
+     size_t size,n;
+     FILE *output;
+{
+  if(fwrite(p,size,n,output)!=n)
+    {
+      printf("Cannot write checkpoint file: '%s'\n",CHECKPOINT_FILE);
+      exit(0);
+    }
+}
+/*----------------------------------------------------------------------------------*/
+static void checkpoint_read(p,size,n,input)
+     void *p;
+     size_t size,n;
+     FILE *input;
+{
+  if(fread(p,size,n,input)!=n)
+    {
+      printf("Checkpoint file '%s' is incomplete\n",CHECKPOINT_FILE);
+      exit(0);
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/* the settings that must be the same to go on from a checkpoint */
+/*----------------------------------------------------------------------------------*/
+static void checkpoint_header(c,n,direction,max_steps,step_size,n_stream,head,value,key)
+     catchment *c;
+     int n,direction,max_steps;
+     double step_size;
+     int n_stream;
+     int *head;
+     double *value;
+     unsigned long *key;
+{
+  stream_control sc;
+
+  get_stream_control(&sc);
+  head[0]=CHECKPOINT_MAGIC;
+  head[1]=CHECKPOINT_VERSION;
+  head[2]=c->num_zones;
+  head[3]=n;
+  head[4]=n_stream;
+  head[5]=max_steps;
+  head[6]=direction;
+  head[7]=sc.method;
+  head[8]=get_direction_method();
+  get_stop_criteria(&value[5],&head[9],&value[6],&head[10]);
+  get_predictor(&head[11],&value[7]);
+  value[0]=step_size;
+  value[1]=sc.atol;
+  value[2]=sc.rtol;
+  value[3]=sc.h_min;
+  value[4]=sc.h_max;
+  *key=checkpoint_key(c);
+}
+/*----------------------------------------------------------------------------------*/
+/* s and the zones of c from CHECKPOINT_FILE; returns 0 if there is no file */
+/*----------------------------------------------------------------------------------*/
+int read_checkpoint(c,direction,max_steps,step_size,n_stream,streamline,s)
+     catchment *c;
+     int direction,max_steps;
+     double step_size;
+     int n_stream;
+     path **streamline;
+     mouth_state *s;
+{
+  FILE *input;
+  boundary *b;
+  int head[HEAD_INTS],file_head[HEAD_INTS],i,j,N,solved;
+  unsigned long key,file_key;
+  double value[HEAD_VALUES],file_value[HEAD_VALUES];
+
+  input=fopen(CHECKPOINT_FILE,"rb");
+  if(input==(FILE *)NULL)
+    {
+      printf("  Resume:               no file '%s', starting from the first point\n",
+	     CHECKPOINT_FILE);
+      return(0);
+    }
+  checkpoint_header(c,s->n,direction,max_steps,step_size,n_stream,head,value,&key);
+  checkpoint_read(file_head,sizeof(int),2,input);
+  if(file_head[0]!=head[0] || file_head[1]!=head[1])
+    {
+      printf("Checkpoint file '%s' is not a checkpoint of this version\n",CHECKPOINT_FILE);
+      exit(0);
+    }
+  checkpoint_read(&file_head[2],sizeof(int),HEAD_INTS-2,input);
+  checkpoint_read(file_value,sizeof(double),HEAD_VALUES,input);
+  checkpoint_read(&file_key,sizeof(unsigned long),1,input);
+  for(i=0;i<HEAD_INTS;i++)
+    if(file_head[i]!=head[i]) break;
+  for(j=0;j<HEAD_VALUES;j++)
+    if(file_value[j]!=value[j]) break;
+  if(i<HEAD_INTS || j<HEAD_VALUES || file_key!=key)
+    {
+      printf("Checkpoint file '%s' is from another catchment or other settings\n",
+	     CHECKPOINT_FILE);
+      exit(0);
+    }
+
+  checkpoint_read(&s->next,sizeof(int),1,input);
+  checkpoint_read(&s->k,sizeof(int),1,input);
+  checkpoint_read(&s->C_sum,sizeof(double),1,input);
+  if(s->next<1 || s->next>s->n)
+    {
+      printf("Checkpoint file '%s' is damaged\n",CHECKPOINT_FILE);
+      exit(0);
+    }
+  checkpoint_read(s->L,sizeof(double),s->next,input);
+  checkpoint_read(s->s_theta,sizeof(double),s->next,input);
+
+  solved=0;
+  for(i=0;i<c->num_zones;i++)
+    {
+      b=c->zones[i];
+      checkpoint_read(&N,sizeof(int),1,input);
+      if(N==0) continue;
+      if(N!=zone_points(b))
+	{
+	  printf("Checkpoint file '%s' does not fit zone %d\n",CHECKPOINT_FILE,i);
+	  exit(0);
+	}
+      if(b->bvv==(double *)NULL) b->bvv=(double *)tracked_malloc(2*N*sizeof(double),MEM_ZONE);
+      if(b->bcv==(double *)NULL) b->bcv=(double *)tracked_malloc(4*N*sizeof(double),MEM_ZONE);
+      if(b->bvv==(double *)NULL || b->bcv==(double *)NULL)
+	{
+	  printf("Cannot allocate memory for checkpoints\n");
+	  exit(0);
+	}
+      checkpoint_read(b->bvv,sizeof(double),2*N,input);
+      checkpoint_read(b->bcv,sizeof(double),4*N,input);
+      solved=solved+1;
+    }
+
+  for(i=0;i<n_stream;i++)
+    {
+      checkpoint_read(&N,sizeof(int),1,input);
+      if(N>max_steps)
+	{
+	  printf("Checkpoint file '%s' has a streamline that is too long\n",CHECKPOINT_FILE);
+	  exit(0);
+	}
+      streamline[i]->points=N;
+      checkpoint_read(streamline[i]->xy,sizeof(coordinates),N,input);
+    }
+  fclose(input);
+  printf("  Resume:               %d of %d mouth points done, %d zones solved\n",
+	 s->next,s->n,solved);
+  return(1);
+}
+/*----------------------------------------------------------------------------------*/
+/* s and the zones of c to CHECKPOINT_FILE if get_checkpoint() seconds have gone    */
+/* since the last one (or force)                                                    */
+/*----------------------------------------------------------------------------------*/
+void write_checkpoint(c,direction,max_steps,step_size,n_stream,streamline,s,force)
+     catchment *c;
+     int direction,max_steps;
+     double step_size;
+     int n_stream;
+     path **streamline;
+     mouth_state *s;
+     int force;
+{
+  FILE *output;
+  boundary *b;
+  char file[128];
+  int head[HEAD_INTS],i,N,zero;
+  unsigned long key;
+  double value[HEAD_VALUES];
+
+  if(every<=0.0) return;
+  if(!force && seconds_now()-last_write<every) return;
+
+  sprintf(file,"%s.tmp",CHECKPOINT_FILE);
+  output=fopen(file,"wb");
+  if(output==(FILE *)NULL)
+    {
+      printf("Cannot open checkpoint file: '%s'\n",file);
+      exit(0);
+    }
+  checkpoint_header(c,s->n,direction,max_steps,step_size,n_stream,head,value,&key);
+  checkpoint_write(head,sizeof(int),HEAD_INTS,output);
+  checkpoint_write(value,sizeof(double),HEAD_VALUES,output);
+  checkpoint_write(&key,sizeof(unsigned long),1,output);
+
+  checkpoint_write(&s->next,sizeof(int),1,output);
+  checkpoint_write(&s->k,sizeof(int),1,output);
+  checkpoint_write(&s->C_sum,sizeof(double),1,output);
+  checkpoint_write(s->L,sizeof(double),s->next,output);
+  checkpoint_write(s->s_theta,sizeof(double),s->next,output);
+
+  zero=0;
+  for(i=0;i<c->num_zones;i++)
+    {
+      b=c->zones[i];
+      if(b->bvv==(double *)NULL || b->bcv==(double *)NULL)
+	{
+	  checkpoint_write(&zero,sizeof(int),1,output);
+	  continue;
+	}
+      N=zone_points(b);
+      checkpoint_write(&N,sizeof(int),1,output);
+      checkpoint_write(b->bvv,sizeof(double),2*N,output);
+      checkpoint_write(b->bcv,sizeof(double),4*N,output);
+    }
+
+  for(i=0;i<n_stream;i++)
+    {
+      N=streamline[i]->points;
+      checkpoint_write(&N,sizeof(int),1,output);
+      checkpoint_write(streamline[i]->xy,sizeof(coordinates),N,output);
+    }
+  if(fclose(output)!=0 || rename(file,CHECKPOINT_FILE)!=0)
+    {
+      printf("Cannot write checkpoint file: '%s'\n",CHECKPOINT_FILE);
+      exit(0);
+    }
+  last_write=seconds_now();
+  printf("\n  Checkpoint:           %d of %d mouth points done\n",s->next,s->n);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
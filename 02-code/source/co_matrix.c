@@ -9,8 +9,10 @@
 #include "boundary_types.h" 
 #include "matrix_types.h" 
 #include "co_matrix_types.h" 
+#include "memtrack_types.h"
 
 #include "matrix.h" 
+#include "memtrack.h"
 
 #include "co_matrix.h" 
 /*----------------------------------------------------------------------------------*/
@@ -24,13 +26,13 @@ co_matrix *create_co_matrix(rows,columns)
  co_matrix *x; 
  coordinates *data; 
  
- x=(co_matrix *)malloc(sizeof(co_matrix)); 
+ x=(co_matrix *)tracked_malloc(sizeof(co_matrix),-1); 
  if(x==(co_matrix *)NULL) 
    { 
  printf("error allocating memory for matrix\n"); 
  exit(0); 
    } 
- data=(coordinates *)malloc(rows*columns*sizeof(coordinates)); 
+ data=(coordinates *)tracked_malloc(rows*columns*sizeof(coordinates),-1); 
  if(data==(coordinates *)NULL) 
    { 
  printf("error allocating memory for matrix\n"); 
@@ -68,8 +70,8 @@ co_matrix *destroy_co_matrix(x)
 { 
   if(x!=(co_matrix *)NULL)
     {
-      if(x->value!=(coordinates *)NULL) free((void *)x->value); 
-      free((void *)x); 
+      if(x->value!=(coordinates *)NULL) tracked_free((void *)x->value); 
+      tracked_free((void *)x); 
     }
   return((void *)NULL); 
 } 
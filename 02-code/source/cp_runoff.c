@@ -11,6 +11,7 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "tile_types.h"
 
 #include "catchment.h"
 #include "file.h"
@@ -18,24 +19,96 @@
 #include "path.h"
 #include "scan.h"
 #include "streamline.h"
+#include "tile.h"
 #include "trapfloat.h"
 
 #include "runoff.h"
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
+static int max_steps;
+static double step_size;
+/*--------------------------------------------------------*/
+/* keep the points of a streamline: count, then x,y pairs */
+/*--------------------------------------------------------*/
+static void keep_streamline(streamline,out)
+     path *streamline;
+     double *out;
+{
+  coordinates xy;
+  int j;
+
+  out[0]=streamline->points;
+  for(j=0;j<streamline->points;j++)
+    {
+      get_path_xy(streamline,j,xy);
+      out[1+2*j]=xy[0];
+      out[2+2*j]=xy[1];
+    }
+}
+/*--------------------------------------------------------*/
+/* streamlines up and down from the points of one tile */
+/*--------------------------------------------------------*/
+static void runoff_tile(c,vectors,n,P,out,arg)
+     catchment *c;
+     bem_vectors *vectors;
+     int n;
+     coordinates *P;
+     double *out;
+     void *arg;
+{
+  bem_results voltage;
+  coordinates Pstart;
+  int i;
+  path *streamup, *streamdown;
+
+  streamup=create_path(max_steps,1,0);
+  streamdown=create_path(max_steps,1,0);
+  for(i=0;i<n;i++)
+    {
+      Pstart[0]=P[i][0];
+      Pstart[1]=P[i][1];
+      streamup->points=max_steps;
+      streamline_loop(Pstart,c,1,max_steps,step_size,
+		      streamup,vectors,&voltage) ;
+      Pstart[0]=P[i][0];
+      Pstart[1]=P[i][1];
+      streamdown->points=max_steps;
+      streamline_loop(Pstart,c,0,max_steps,step_size,
+		      streamdown,vectors,&voltage) ;
+      keep_streamline(streamup,out+i*(2+4*max_steps));
+      keep_streamline(streamdown,out+i*(2+4*max_steps)+1+2*max_steps);
+    }
+  destroy_path(streamup);
+  destroy_path(streamdown);
+}
+/*--------------------------------------------------------*/
+/* put kept points back into a streamline */
+/*--------------------------------------------------------*/
+static void restore_streamline(streamline,out)
+     path *streamline;
+     double *out;
+{
+  coordinates xy;
+  int j;
+
+  streamline->points=(int)out[0];
+  for(j=0;j<streamline->points;j++)
+    {
+      xy[0]=out[1+2*j];
+      xy[1]=out[2+2*j];
+      put_path_xy(streamline,j,xy);
+    }
+}
+/*--------------------------------------------------------*/
 int main()
 {
   char data[]="c_valley.txt"; 
 
   FILE *output;
-  bem_results voltage;
-  bem_vectors *vectors;
   catchment *c;
-  coordinates P, Pstart;
-  double L,step_size;
-  int i,j,k,max_points,num_zones,max_steps;
-  matrix bvv, bcv;
+  double *out,*here;
+  int i,j,max_points,num_zones;
   path *streamup, *streamdown;
   raster ras;
 
@@ -49,7 +122,6 @@ int main()
 
   max_points=max_points_in_any_zone(c);
   printf("maximum points in any zone is %d\n",max_points);
-  vectors=create_bem_vectors(&bvv,&bcv,max_points);
 
   max_steps=20;
   step_size=0.1;
@@ -60,41 +132,28 @@ int main()
   
   put_raster("P(0,0)=(0.0,0.0) P(20,20)=(20.0,20.0)",&ras);
   show_raster(&ras);
-  k=0;
+  out=scan_raster_tiles(data,&ras,2+4*max_steps,runoff_tile,(void *)NULL);
 /*------------------------------------------------------*/
-/* this loop scans a grid of x and y */
+/* this loop writes out the streamlines, row by row */
 /*------------------------------------------------------*/
   for(j=0;j<ras.ny;j++)
    {
-      P[1]=y_raster(&ras,j);
       for(i=0;i<ras.nx;i++)
 	{
-	  P[0]=x_raster(&ras,i);    	  
- 	  Pstart[0]=P[0];
-	  Pstart[1]=P[1];
- 	  streamup->points=max_steps;
- 	  L=streamline_loop(Pstart,c,1,max_steps,step_size,
- 			    streamup,vectors,&voltage) ;
-  	  Pstart[0]=P[0];
-	  Pstart[1]=P[1];
- 	  streamdown->points=max_steps;
- 	  L=streamline_loop(Pstart,c,0,max_steps,step_size,
- 			    streamdown,vectors,&voltage) ;
+	  here=out+(j*ras.nx+i)*(2+4*max_steps);
+	  restore_streamline(streamup,here);
+	  restore_streamline(streamdown,here+1+2*max_steps);
  	  plot_1_streamline(c,streamup,output);
  	  plot_1_streamline(c,streamdown,output);
 	}
-      if(k%50==0) printf("\n");
-      printf("#"); fflush(stdout);
-      k=k+1;
    }
 /*------------------------------------------------------*/
 
-  printf("\n");
   fclose(output);
   destroy_path(streamup);
   destroy_path(streamdown);
   destroy_catchment(c);
-  destroy_bem_vectors(vectors);
+  free((void *)out);
   return(0);
 }
 /*--------------------------------------------------------*/
@@ -7,11 +7,13 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "tile_types.h"
 
 #include "catchment.h"
 #include "file.h"
 #include "memory.h"
 #include "scan.h"
+#include "tile.h"
 #include "trapfloat.h"
 #include "streamline.h"
 #include "deep.h"
@@ -20,19 +22,44 @@
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
+static int max_steps;
+static double step_size;
+/*--------------------------------------------------------*/
+/* depth at the points of one tile */
+/*--------------------------------------------------------*/
+static void depth_tile(c,vectors,n,P,out,arg)
+     catchment *c;
+     bem_vectors *vectors;
+     int n;
+     coordinates *P;
+     double *out;
+     void *arg;
+{
+  bem_results voltage;
+  coordinates Pstart;
+  double L;
+  int i;
+
+  for(i=0;i<n;i++)
+    {
+      Pstart[0]=P[i][0];
+      Pstart[1]=P[i][1];
+      L=streamline_loop(Pstart,c,1,max_steps,step_size,
+			(path *)NULL,vectors,&voltage) ;
+      out[i]=depth(P[i],L,voltage.dV);
+    }
+}
+/*--------------------------------------------------------*/
 int main()
 {
   char data[]="c_valley2.txt"; 
 
   FILE *output1, *output2;
-  bem_results voltage;
-  bem_vectors *vectors;
   catchment *c;
   char *buffer[2];
-  coordinates P, Pstart;
-  double L,step_size,d;
-  int buf_size,i,j,k,column,max_points,num_zones,max_steps;
-  matrix bvv, bcv;
+  coordinates P;
+  double d,*out;
+  int buf_size,i,j,column,max_points,num_zones;
   raster ras;
 
   trap_floating_errors();
@@ -48,7 +75,6 @@ int main()
 
   max_points=max_points_in_any_zone(c);
   printf("maximum points in any zone is %d\n",max_points);
-  vectors=create_bem_vectors(&bvv,&bcv,max_points);
 
   max_steps=300;
   step_size=0.1;
@@ -57,25 +83,21 @@ int main()
   put_raster("P(0,0)=(0.0,0.0) P(50,50)=(20.0,20.0)",&ras); /* slow */
 
   show_raster(&ras);
+  out=scan_raster_tiles(data,&ras,1,depth_tile,(void *)NULL);
 
   output1=open_file(0,"depth.out","w");
   output2=open_file(0,"depth2.out","w");
   column=0;
-  k=0;
 /*------------------------------------------------------*/
-/* this loop scans a grid of x and y */
+/* this loop writes out the grid of x and y, row by row */
 /*------------------------------------------------------*/
   for(j=0;j<ras.ny;j++)
    {
       P[1]=y_raster(&ras,j);
       for(i=0;i<ras.nx;i++)
 	{
-	  P[0]=x_raster(&ras,i);    	  
- 	  Pstart[0]=P[0];	  
-	  Pstart[1]=P[1];
- 	  L=streamline_loop(Pstart,c,1,max_steps,step_size,
- 			    (path *)NULL,vectors,&voltage) ;
- 	  d=depth(P,L,voltage.dV);
+	  P[0]=x_raster(&ras,i);
+	  d=out[j*ras.nx+i];
 
  	  column=put_buffer(buf_size,buffer[0],column,"%14.5e",d);
  	  put_buffer(64,buffer[1],
@@ -88,17 +110,13 @@ int main()
       column=0;
       put_next_line(output1,buffer[0]);
       put_next_line(output2,"");
-      if(k%50==0) printf("\n");
-      printf("#"); fflush(stdout);
-      k=k+1;
    }
 /*------------------------------------------------------*/
 
-  printf("\n");
   fclose(output1);
   fclose(output2);
   destroy_catchment(c);
-  destroy_bem_vectors(vectors);
+  free((void *)out);
   free((void *)buffer[0]);
   return(0);
 }
@@ -0,0 +1,239 @@
+/*---------------------------------- direction.c -----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* direction of steepest ascent/descent on a circle of radius r                     */
+/*                                                                                  */
+/* edit1_my_follow_stream uses the 2nd order model                                  */
+/*   h(t) = r*(a1*cos(t)+b1*sin(t)) + r*r*(a2*cos(2t)+b2*sin(2t))                   */
+/* and finds all stationary points through a quartic in cos(t) and one in sin(t).   */
+/* With u=(cos(t),sin(t)) the same model is                                         */
+/*   h(u) = r*g.u + r*r*u'Qu,   g=(a1,b1),  Q=[a2 b2; b2 -a2]                        */
+/* and a stationary point on |u|=1 satisfies                                        */
+/*   F(u) = w.(g+2rQu) = 0,     w=(-u[1],u[0])                                       */
+/* Newton on the angle, written with u and w only (no trig):                        */
+/*   F' = -u.g + 2r*(w'Qw - u'Qu),   u <- normalise(u - F/F' * w)                    */
+/* started from u=+g/|g| (max) or -g/|g| (min). If the curvature term is large      */
+/* against |g| there can be other extrema, so the eigenvectors of Q are also used   */
+/* as starting points and the best result is kept.                                  */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "stream_types.h"
+
+#include "direction.h"
+/*----------------------------------------------------------------------------------*/
+#define NEWTON_STEPS 8       /* iterations from each starting point */
+#define BATCH_STEPS 4        /* fixed iterations of the batched version */
+#define NEWTON_TOL 1.0e-13   /* stop when the rotation is below this */
+#define MAX_TURN 0.5         /* largest rotation (tan of angle) per iteration */
+#define CURVED 0.25          /* 2r|Q|/|g| above this: try the other starts too */
+/*----------------------------------------------------------------------------------*/
+static int direction_method=DIRECTION_QUARTIC;
+/*----------------------------------------------------------------------------------*/
+void set_direction_method(method)
+     int method;
+{
+  if(method!=DIRECTION_QUARTIC && method!=DIRECTION_NEWTON)
+    {
+      printf("unknown direction method %d\n",method);
+      exit(0);
+    }
+  direction_method=method;
+}
+/*----------------------------------------------------------------------------------*/
+int get_direction_method()
+{
+  return(direction_method);
+}
+/*----------------------------------------------------------------------------------*/
+int direction_method_from_name(name)
+     char *name;
+{
+  if(strcmp(name,"quartic")==0) return(DIRECTION_QUARTIC);
+  if(strcmp(name,"newton")==0)  return(DIRECTION_NEWTON);
+  return(-1);
+}
+/*----------------------------------------------------------------------------------*/
+char *direction_method_name(method)
+     int method;
+{
+  if(method==DIRECTION_NEWTON) return("newton");
+  return("quartic");
+}
+/*----------------------------------------------------------------------------------*/
+/* Newton iterations on the circle from u; returns the model value h/r at u */
+/*----------------------------------------------------------------------------------*/
+static double newton_on_circle(sign,gx,gy,a2,b2,r,u)
+     double sign,gx,gy,a2,b2,r;
+     double u[2];
+{
+  double wx,wy,qx,qy,F,dF,du,n;
+  int i;
+
+  for(i=0;i<NEWTON_STEPS;i++)
+    {
+      wx=-u[1];
+      wy=u[0];
+      qx=a2*u[0]+b2*u[1];       /* Qu */
+      qy=b2*u[0]-a2*u[1];
+      F=wx*(gx+2.0*r*qx)+wy*(gy+2.0*r*qy);
+      /* w'Qw - u'Qu = -2u'Qu for the trace free Q */
+      dF=-(u[0]*gx+u[1]*gy)-4.0*r*(u[0]*qx+u[1]*qy);
+      /* safeguard: F' must have the sign of a max (dF<0) or min (dF>0) */
+      if(sign*dF<0.0) du=-F/dF;
+      else du=sign*F/(fabs(dF)+fabs(F)+1.0e-300);
+      if(du>MAX_TURN) du=MAX_TURN;
+      if(du<-MAX_TURN) du=-MAX_TURN;
+      u[0]=u[0]+du*wx;
+      u[1]=u[1]+du*wy;
+      n=sqrt(u[0]*u[0]+u[1]*u[1]);
+      u[0]=u[0]/n;
+      u[1]=u[1]/n;
+      if(fabs(du)<NEWTON_TOL) break;
+    }
+  qx=a2*u[0]+b2*u[1];
+  qy=b2*u[0]-a2*u[1];
+  return(gx*u[0]+gy*u[1]+r*(u[0]*qx+u[1]*qy));
+}
+/*----------------------------------------------------------------------------------*/
+/* same result as edit1_my_follow_stream, found by newton_on_circle */
+/*----------------------------------------------------------------------------------*/
+void newton_follow_stream(direction,dV,d2V,dP,r)
+     int direction;
+     coordinates dV,dP;
+     tensor d2V;
+     double r;
+{
+  double sign,gx,gy,a2,b2,G,q,h,best,u[2],v[2],e[4][2];
+  int k;
+
+  sign=(direction!=0) ? 1.0 : -1.0;
+  gx=dV[0];
+  gy=dV[1];
+  a2=0.5*d2V[0][0];
+  b2=0.5*d2V[0][1];
+  G=sqrt(gx*gx+gy*gy);
+  q=sqrt(a2*a2+b2*b2);  /* eigenvalues of Q are +q and -q */
+
+  if(G==0.0 && q==0.0)
+    {
+      dP[0]=0.0;
+      dP[1]=0.0;
+      return;
+    }
+  if(G>0.0)
+    {
+      u[0]=sign*gx/G;
+      u[1]=sign*gy/G;
+      best=sign*newton_on_circle(sign,gx,gy,a2,b2,r,u);
+    }
+  else
+    {
+      u[0]=1.0;
+      u[1]=0.0;
+      best=-HUGE_VAL;
+    }
+
+  if(2.0*r*q>CURVED*G)
+    {
+      /* eigenvectors of Q: (a2+q,b2) for +q and (-b2,a2+q) for -q */
+      if(a2>=0.0) { e[0][0]=a2+q; e[0][1]=b2;   e[1][0]=-b2;  e[1][1]=a2+q; }
+      else        { e[0][0]=b2;   e[0][1]=q-a2; e[1][0]=a2-q; e[1][1]=b2;   }
+      for(k=0;k<2;k++)
+	{
+	  h=sqrt(e[k][0]*e[k][0]+e[k][1]*e[k][1]);
+	  e[k][0]=e[k][0]/h;
+	  e[k][1]=e[k][1]/h;
+	  e[k+2][0]=-e[k][0];
+	  e[k+2][1]=-e[k][1];
+	}
+      for(k=0;k<4;k++)
+	{
+	  v[0]=e[k][0];
+	  v[1]=e[k][1];
+	  h=sign*newton_on_circle(sign,gx,gy,a2,b2,r,v);
+	  if(h>best)
+	    {
+	      best=h;
+	      u[0]=v[0];
+	      u[1]=v[1];
+	    }
+	}
+    }
+  dP[0]=r*u[0];
+  dP[1]=r*u[1];
+}
+/*----------------------------------------------------------------------------------*/
+/* batched version for n streamlines, structure of arrays                           */
+/*   gx,gy = dV;  vxx,vxy = d2V[0][0],d2V[0][1];  r = radius;  dx,dy = steps         */
+/* Every lane does the same fixed number of iterations from -/+g/|g| so the loop    */
+/* vectorises. Lanes where the curvature term is large, or |g| is zero, are         */
+/* done again by newton_follow_stream. Returns the number of such lanes.            */
+/*----------------------------------------------------------------------------------*/
+int newton_follow_stream_batch(direction,n,gx,gy,vxx,vxy,r,dx,dy)
+     int direction,n;
+     double *gx,*gy,*vxx,*vxy,*r,*dx,*dy;
+{
+  double sign;
+  int i,redo;
+  coordinates dV,dP;
+  tensor d2V;
+
+  sign=(direction!=0) ? 1.0 : -1.0;
+  redo=0;
+#pragma omp simd reduction(+:redo)
+  for(i=0;i<n;i++)
+    {
+      double a2,b2,G,ux,uy,wx,wy,qx,qy,F,dF,du,m;
+      int k;
+
+      a2=0.5*vxx[i];
+      b2=0.5*vxy[i];
+      G=sqrt(gx[i]*gx[i]+gy[i]*gy[i]);
+      m=(G>0.0) ? G : 1.0;
+      ux=sign*gx[i]/m;
+      uy=sign*gy[i]/m;
+      for(k=0;k<BATCH_STEPS;k++)
+	{
+	  wx=-uy;
+	  wy=ux;
+	  qx=a2*ux+b2*uy;
+	  qy=b2*ux-a2*uy;
+	  F=wx*(gx[i]+2.0*r[i]*qx)+wy*(gy[i]+2.0*r[i]*qy);
+	  dF=-(ux*gx[i]+uy*gy[i])-4.0*r[i]*(ux*qx+uy*qy);
+	  /* 2r|Q| < CURVED*|g| keeps dF on the right side of zero */
+	  du=fmin(MAX_TURN,fmax(-MAX_TURN,-F/dF));
+	  ux=ux+du*wx;
+	  uy=uy+du*wy;
+	  m=1.0/sqrt(1.0+du*du);
+	  ux=ux*m;
+	  uy=uy*m;
+	}
+      dx[i]=r[i]*ux;
+      dy[i]=r[i]*uy;
+      if(G==0.0 || 2.0*r[i]*sqrt(a2*a2+b2*b2)>CURVED*G)
+	{
+	  dx[i]=HUGE_VAL;  /* marked for the scalar version */
+	  redo=redo+1;
+	}
+    }
+  if(redo>0)
+    {
+      for(i=0;i<n;i++)
+	{
+	  if(dx[i]!=HUGE_VAL) continue;
+	  dV[0]=gx[i];   dV[1]=gy[i];
+	  d2V[0][0]=vxx[i]; d2V[0][1]=vxy[i];
+	  d2V[1][0]=vxy[i]; d2V[1][1]=-vxx[i];
+	  newton_follow_stream(direction,dV,d2V,dP,r[i]);
+	  dx[i]=dP[0];
+	  dy[i]=dP[1];
+	}
+    }
+  return(redo);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,328 @@
+/*------------------------------------ edit.c --------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* catchment area after points of the contours have been edited                     */
+/*                                                                                  */
+/* The edited contour files are in another catchment directory, under the same      */
+/* names as in the zone files (a file that is not there is unchanged). Points may   */
+/* be moved and their values changed, but not added or removed. Each edited file is */
+/* read beside its path, and only the zones of the edited paths are factored        */
+/* (bfactor.c), with the contours as read; the factor is saved in the catchment     */
+/* directory, so later runs on other edits of the same catchment read it instead.   */
+/* The edits are then put into the paths. A zone with moved points is brought up    */
+/* to date by update_zone_factor (a rank k change of the segments next to the       */
+/* moved points, or a new factorization when k is too big); a zone where only       */
+/* values changed keeps its factor. The bcv of the changed zones are solved from    */
+/* the factor and the mouth loop of catchment_area is run once on the edited        */
+/* catchment. The other zones are solved as usual, when a streamline reaches them.  */
+/*                                                                                  */
+/* With set_edit_check(1) every changed zone is also factored afresh from the       */
+/* edited points and its bcv is compared with the updated one.                      */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "memtrack_types.h"
+#include "bfactor_types.h"
+
+#include "area.h"
+#include "bfactor.h"
+#include "file.h"
+#include "memtrack.h"
+#include "merge.h"
+#include "vcalc.h"
+
+#include "edit.h"
+/*----------------------------------------------------------------------------------*/
+#define NBYTES 96
+/*----------------------------------------------------------------------------------*/
+static char edited[128]="";    /* directory of the edited contours; "" = none */
+static int edit_check=0;       /* 1 = compare with a fresh factorization */
+/*----------------------------------------------------------------------------------*/
+void set_edited(dir)
+     char *dir;
+{
+  strncpy(edited,dir,128);
+  edited[127]='\0';
+}
+/*----------------------------------------------------------------------------------*/
+char *get_edited()
+{
+  return(edited);
+}
+/*----------------------------------------------------------------------------------*/
+void set_edit_check(check)
+     int check;
+{
+  edit_check=check;
+}
+/*----------------------------------------------------------------------------------*/
+int get_edit_check()
+{
+  return(edit_check);
+}
+/*----------------------------------------------------------------------------------*/
+static double seconds_now()
+{
+  struct timeval t;
+
+  gettimeofday(&t,NULL);
+  return((double)t.tv_sec+(double)t.tv_usec/1000000.0);
+}
+/*----------------------------------------------------------------------------------*/
+static void *edit_memory(n)
+     size_t n;
+{
+  void *p;
+
+  p=malloc(n);
+  if(p==NULL)
+    {
+      printf("Cannot allocate memory for the edited contours\n");
+      exit(0);
+    }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+/* read the edited file of path p (if there is one) into xy and value, beside the   */
+/* path; *moved and *values are the numbers of points moved and of values changed   */
+/*----------------------------------------------------------------------------------*/
+static void read_edited_path(name,p,xy,value,moved,values)
+     char *name;
+     path *p;
+     coordinates *xy;
+     double *value;
+     int *moved,*values;
+{
+  unsigned char buffer[NBYTES];
+  char file[256];
+  FILE *input;
+  int j,n;
+
+  *moved=0;
+  *values=0;
+  strncpy(file,edited,256);
+  file[255]='\0';
+  strncat(file,name,255-strlen(file));
+  input=fopen(file,"r");
+  if(input==(FILE *)NULL) return;          /* not edited */
+  fclose(input);
+
+  n=count_lines(0,file);
+  if(n!=p->points)
+    {
+      printf("Edited contour '%s' has %d points, not %d (points can be moved",
+	     file,n,p->points);
+      printf(" but not added or removed)\n");
+      exit(0);
+    }
+  input=open_file(0,file,"r");
+  for(j=0;j<n;j++)
+    {
+      get_next_line_verbose(input,1,NBYTES,buffer);
+      if(sscanf((char *)buffer," %lf %lf %lf",&xy[j][0],&xy[j][1],&value[j])!=3)
+	{
+	  printf("Fewer than 3 data values/line in file '%s'\n",file);
+	  exit(0);
+	}
+      /* in the order of the file, as get_path put them */
+      if(xy[j][0]!=p->xy[j][0] || xy[j][1]!=p->xy[j][1]) *moved=*moved+1;
+      if(value[j]!=p->value[j]) *values=*values+1;
+    }
+  fclose(input);
+}
+/*----------------------------------------------------------------------------------*/
+/* largest |x-y| relative to the largest |y| */
+/*----------------------------------------------------------------------------------*/
+static double relative_difference(n,x,y)
+     int n;
+     double *x,*y;
+{
+  double d,big;
+  int j;
+
+  d=0.0;
+  big=0.0;
+  for(j=0;j<n;j++)
+    {
+      if(fabs(x[j]-y[j])>d) d=fabs(x[j]-y[j]);
+      if(fabs(y[j])>big) big=fabs(y[j]);
+    }
+  return((big>0.0) ? d/big : d);
+}
+/*----------------------------------------------------------------------------------*/
+/* factor of zone b as read: saved by an earlier run, or made and saved */
+/*----------------------------------------------------------------------------------*/
+static zone_factor *edit_factor(b,made)
+     boundary *b;
+     int *made;
+{
+  zone_factor *f;
+
+  f=read_zone_factor(b);
+  if(f!=(zone_factor *)NULL) return(f);
+  f=factor_zone(b);
+  save_zone_factor(f);
+  *made=*made+1;
+  return(f);
+}
+/*----------------------------------------------------------------------------------*/
+/* C_area of the catchment with the edited contours */
+/*----------------------------------------------------------------------------------*/
+double edited_area(c,mouth,max_steps,step_size,n_stream,streamline,vectors)
+     catchment *c;
+     section *mouth;
+     int max_steps;
+     double step_size;
+     int n_stream;
+     path **streamline;
+     bem_vectors *vectors;
+{
+  zone_factor **f,*g;
+  boundary *b;
+  path *p;
+  coordinates **xy;
+  double **value,*bcv,t,t_factor,t_update,t_fresh,d,err;
+  int *moved,*values,*change,i,j,k,l,N,rank,paths,points,changed,made,updated,again;
+
+  printf("\n  Edited contours:      %s\n",edited);
+
+  /* the edits, path by path, beside the paths */
+  xy=(coordinates **)edit_memory(c->num_paths*sizeof(coordinates *));
+  value=(double **)edit_memory(c->num_paths*sizeof(double *));
+  moved=(int *)edit_memory(c->num_paths*sizeof(int));
+  values=(int *)edit_memory(c->num_paths*sizeof(int));
+  paths=0;
+  for(i=0;i<c->num_paths;i++)
+    {
+      p=c->path_list[i].path_p;
+      xy[i]=(coordinates *)edit_memory(p->points*sizeof(coordinates));
+      value[i]=(double *)edit_memory(p->points*sizeof(double));
+      read_edited_path(c->path_list[i].name,p,xy[i],value[i],&moved[i],&values[i]);
+      if(moved[i]>0 || values[i]>0)
+	{
+	  printf("  Edited path:          %s, %d points moved, %d values changed\n",
+		 c->path_list[i].name,moved[i],values[i]);
+	  paths=paths+1;
+	}
+    }
+  if(paths==0) printf("  Edited path:          none (no file differs from its path)\n");
+
+  /* the zones of the edited paths, factored with the points as read */
+  f=(zone_factor **)edit_memory(c->num_zones*sizeof(zone_factor *));
+  change=(int *)edit_memory(c->num_zones*sizeof(int));
+  made=0;
+  t=seconds_now();
+  for(k=0;k<c->num_zones;k++)
+    {
+      b=c->zones[k];
+      change[k]=0;
+      f[k]=(zone_factor *)NULL;
+      for(l=0;l<b->components;l++)
+	for(i=0;i<c->num_paths;i++)
+	  if(c->path_list[i].path_p==b->loop[l])
+	    change[k]=change[k]||(moved[i]>0 || values[i]>0);
+      if(change[k]) f[k]=edit_factor(b,&made);
+    }
+  t_factor=seconds_now()-t;
+
+  /* the edits put into the paths */
+  for(i=0;i<c->num_paths;i++)
+    {
+      if(moved[i]==0 && values[i]==0) continue;
+      p=c->path_list[i].path_p;
+      for(j=0;j<p->points;j++)
+	{
+	  p->xy[j][0]=xy[i][j][0];
+	  p->xy[j][1]=xy[i][j][1];
+	  p->value[j]=value[i][j];
+	}
+    }
+  if(paths>0) clear_merge_table();   /* the key of the catchment points has changed */
+
+  /* the changed zones: update, solve and put in place */
+  changed=updated=again=rank=0;
+  t=seconds_now();
+  for(k=0;k<c->num_zones;k++)
+    {
+      if(!change[k]) continue;
+      b=c->zones[k];
+      changed=changed+1;
+      points=0;
+      for(l=0;l<b->components;l++)
+	for(i=0;i<c->num_paths;i++)
+	  if(c->path_list[i].path_p==b->loop[l]) points=points+moved[i];
+      if(points>0)
+	{
+	  l=update_zone_factor(f[k]);
+	  if(l>0) { updated=updated+1; rank=rank+l; }
+	  else again=again+1;
+	}
+      N=f[k]->N;
+      if(b->bvv==(double *)NULL) b->bvv=(double *)tracked_malloc(2*N*sizeof(double),MEM_ZONE);
+      if(b->bcv==(double *)NULL) b->bcv=(double *)tracked_malloc(4*N*sizeof(double),MEM_ZONE);
+      if(b->bvv==(double *)NULL || b->bcv==(double *)NULL)
+	{
+	  printf("Cannot allocate memory for the edited contours\n");
+	  exit(0);
+	}
+      zone_voltage_vector(f[k],b->bvv);
+      solve_zone_block(f[k],1,b->bvv,b->bcv);
+    }
+  c->previous_zone=(-1);       /* the vectors of a changed zone are attached afresh */
+  t_update=seconds_now()-t;
+  printf("  Zones changed:        %d of %d (%d updated, rank %d in all; %d factored again)\n",
+	 changed,c->num_zones,updated,rank,again);
+  printf("  Zones factored:       %d read, %d made and saved (%.4f s), update and solve %.4f s\n",
+	 changed-made,made,t_factor,t_update);
+
+  /* the check: a fresh factorization of every changed zone */
+  if(edit_check)
+    {
+      err=0.0;
+      t_fresh=0.0;
+      for(k=0;k<c->num_zones;k++)
+	{
+	  if(!change[k]) continue;
+	  b=c->zones[k];
+	  t=seconds_now();
+	  g=factor_zone(b);
+	  N=g->N;
+	  bcv=(double *)edit_memory((size_t)4*N*sizeof(double));
+	  zone_voltage_vector(g,b->bvv);
+	  solve_zone_block(g,1,b->bvv,bcv);
+	  t_fresh=t_fresh+seconds_now()-t;
+	  d=relative_difference(4*N,b->bcv,bcv);
+	  if(d>err) err=d;
+	  free((void *)bcv);
+	  destroy_zone_factor(g);
+	}
+      printf("  Check:                updated bcv within %.2e of a fresh factorization",err);
+      printf(" (%.4f s)\n",t_fresh);
+    }
+
+  for(k=0;k<c->num_zones;k++) destroy_zone_factor(f[k]);
+  for(i=0;i<c->num_paths;i++)
+    {
+      free((void *)xy[i]);
+      free((void *)value[i]);
+    }
+  free((void *)f);
+  free((void *)xy);
+  free((void *)value);
+  free((void *)moved);
+  free((void *)values);
+  free((void *)change);
+
+  for(i=0;i<n_stream;i++) streamline[i]->points=max_steps;   /* as made */
+  return(catchment_area(c,mouth,0,max_steps,step_size,n_stream,streamline,vectors));
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
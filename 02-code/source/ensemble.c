@@ -0,0 +1,282 @@
+/*---------------------------------- ensemble.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* catchment area for an ensemble of contour elevations                             */
+/*                                                                                  */
+/* Realisation 0 has the path values as read. In realisation r>0 every point of     */
+/* every path gets sigma*n added, n a normal random number (the survey error of     */
+/* each point). Only bvv depends on the values, so each zone is factored once       */
+/* (bfactor.c) and the bvv of all realisations are solved as one block with         */
+/* solve_zone_block. Realisation 0 is checked against the bcv of solve_zone. Then   */
+/* the zones are given the bvv and bcv of each realisation in turn (with its path   */
+/* values) and the mouth loop of catchment_area is run again. Merging, the          */
+/* surrogate and checkpoints would keep what was found for another realisation, so  */
+/* they are switched off. The areas go to ENSEMBLE_FILE.                            */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "bfactor_types.h"
+#include "checkpoint_types.h"
+
+#include "area.h"
+#include "bfactor.h"
+#include "checkpoint.h"
+#include "merge.h"
+#include "surrogate.h"
+#include "vcalc.h"
+
+#include "ensemble.h"
+/*----------------------------------------------------------------------------------*/
+#define ENSEMBLE_FILE "ensemble.csv"
+/*----------------------------------------------------------------------------------*/
+static int realisations=0;     /* <=0 = no ensemble */
+static double sigma=0.1;       /* standard deviation of the values */
+static unsigned long seed=1;
+/*----------------------------------------------------------------------------------*/
+void set_ensemble(n)
+     int n;
+{
+  realisations=n;
+}
+/*----------------------------------------------------------------------------------*/
+int get_ensemble()
+{
+  return(realisations);
+}
+/*----------------------------------------------------------------------------------*/
+void set_ensemble_sigma(s)
+     double s;
+{
+  sigma=s;
+}
+/*----------------------------------------------------------------------------------*/
+double get_ensemble_sigma()
+{
+  return(sigma);
+}
+/*----------------------------------------------------------------------------------*/
+static double seconds_now()
+{
+  struct timeval t;
+
+  gettimeofday(&t,NULL);
+  return((double)t.tv_sec+(double)t.tv_usec/1000000.0);
+}
+/*----------------------------------------------------------------------------------*/
+/* normal random number (Box-Muller on a 64 bit LCG, the same every run) */
+/*----------------------------------------------------------------------------------*/
+static double normal_value()
+{
+  double u1,u2;
+
+  seed=seed*6364136223846793005UL+1442695040888963407UL;
+  u1=((double)(seed>>11)+0.5)/(double)(1UL<<53);
+  seed=seed*6364136223846793005UL+1442695040888963407UL;
+  u2=((double)(seed>>11)+0.5)/(double)(1UL<<53);
+  return(sqrt(-2.0*log(u1))*cos(2.0*M_PI*u2));
+}
+/*----------------------------------------------------------------------------------*/
+static void *ensemble_memory(n)
+     size_t n;
+{
+  void *p;
+
+  p=malloc(n);
+  if(p==NULL)
+    {
+      printf("Cannot allocate memory for the ensemble\n");
+      exit(0);
+    }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+/* values of all paths of c: base + noise (noise NULL: base) */
+/*----------------------------------------------------------------------------------*/
+static void put_values(c,base,noise)
+     catchment *c;
+     double *base,*noise;
+{
+  path *p;
+  int i,j,o;
+
+  o=0;
+  for(i=0;i<c->num_paths;i++)
+    {
+      p=c->path_list[i].path_p;
+      for(j=0;j<p->points;j++)
+	p->value[j]=base[o+j]+((noise==(double *)NULL) ? 0.0 : noise[o+j]);
+      o=o+p->points;
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/* C_area of realisation 0; the areas of all realisations are written to            */
+/* ENSEMBLE_FILE                                                                    */
+/*----------------------------------------------------------------------------------*/
+double ensemble_area(c,mouth,max_steps,step_size,n_stream,streamline,vectors)
+     catchment *c;
+     section *mouth;
+     int max_steps;
+     double step_size;
+     int n_stream;
+     path **streamline;
+     bem_vectors *vectors;
+{
+  zone_factor **f;
+  boundary *b;
+  double **bvv,**bcv,*base,*noise,*area,t,t_zone,t_factor,t_solve,d,big,err,mean,var;
+  int K,k,r,i,j,o,N,total;
+  FILE *output;
+
+  K=realisations;
+  printf("\n  Ensemble:             %d realisations, sigma %g\n",K,sigma);
+  if(get_surrogate_tolerance()>0.0)
+    {
+      printf("  Field surrogate:      not used for the ensemble\n");
+      set_surrogate_tolerance(0.0);
+    }
+  if(get_merge_tolerance()>0.0)
+    {
+      printf("  Merge streamlines:    not used for the ensemble\n");
+      set_merge_tolerance(0.0);
+    }
+  if(get_checkpoint()>0.0 || get_resume())
+    {
+      printf("  Checkpoints:          not used for the ensemble\n");
+      set_checkpoint(0.0);
+      set_resume(0);
+    }
+
+  /* every zone solved as in the mouth loop, for the check */
+  t=seconds_now();
+  for(k=0;k<c->num_zones;k++) solve_zone(c->zones[k],vectors);
+  t_zone=seconds_now()-t;
+
+  /* values of the realisations */
+  total=0;
+  for(i=0;i<c->num_paths;i++) total=total+c->path_list[i].path_p->points;
+  base=(double *)ensemble_memory(total*sizeof(double));
+  noise=(double *)ensemble_memory((size_t)K*total*sizeof(double));
+  o=0;
+  for(i=0;i<c->num_paths;i++)
+    {
+      memcpy(base+o,c->path_list[i].path_p->value,
+	     c->path_list[i].path_p->points*sizeof(double));
+      o=o+c->path_list[i].path_p->points;
+    }
+  for(j=0;j<total;j++) noise[j]=0.0;
+  for(j=total;j<K*total;j++) noise[j]=sigma*normal_value();
+
+  /* one factorization per zone, one block solve for all realisations */
+  f=(zone_factor **)ensemble_memory(c->num_zones*sizeof(zone_factor *));
+  bvv=(double **)ensemble_memory(c->num_zones*sizeof(double *));
+  bcv=(double **)ensemble_memory(c->num_zones*sizeof(double *));
+  t=seconds_now();
+  for(k=0;k<c->num_zones;k++) f[k]=factor_zone(c->zones[k]);
+  t_factor=seconds_now()-t;
+
+  t=seconds_now();
+  for(k=0;k<c->num_zones;k++)
+    {
+      N=f[k]->N;
+      bvv[k]=(double *)ensemble_memory((size_t)2*N*K*sizeof(double));
+      bcv[k]=(double *)ensemble_memory((size_t)4*N*K*sizeof(double));
+      for(r=0;r<K;r++)
+	{
+	  put_values(c,base,noise+(size_t)r*total);
+	  zone_voltage_vector(f[k],bvv[k]+(size_t)2*N*r);
+	}
+      solve_zone_block(f[k],K,bvv[k],bcv[k]);
+    }
+  put_values(c,base,(double *)NULL);
+  t_solve=seconds_now()-t;
+
+  /* realisation 0 against solve_zone */
+  err=0.0;
+  for(k=0;k<c->num_zones;k++)
+    {
+      b=c->zones[k];
+      N=f[k]->N;
+      d=0.0;
+      big=0.0;
+      for(j=0;j<4*N;j++)
+	{
+	  if(fabs(bcv[k][j]-b->bcv[j])>d) d=fabs(bcv[k][j]-b->bcv[j]);
+	  if(fabs(b->bcv[j])>big) big=fabs(b->bcv[j]);
+	}
+      d=(big>0.0) ? d/big : d;
+      if(d>err) err=d;
+    }
+  printf("  Check:                bcv of realisation 0 within %.2e of solve_zone\n",err);
+  printf("  Zones solved:         %.4f s (solve_zone, %d zones)\n",t_zone,c->num_zones);
+  printf("  Zones factored:       %.4f s, block solve %.4f s (%.6f s per realisation)\n",
+	 t_factor,t_solve,t_solve/K);
+
+  /* the mouth loop for each realisation */
+  area=(double *)ensemble_memory(K*sizeof(double));
+  for(r=0;r<K;r++)
+    {
+      put_values(c,base,noise+(size_t)r*total);
+      for(k=0;k<c->num_zones;k++)
+	{
+	  b=c->zones[k];
+	  N=f[k]->N;
+	  memcpy(b->bvv,bvv[k]+(size_t)2*N*r,2*N*sizeof(double));
+	  memcpy(b->bcv,bcv[k]+(size_t)4*N*r,4*N*sizeof(double));
+	}
+      for(i=0;i<n_stream;i++) streamline[i]->points=max_steps;   /* as made */
+      area[r]=catchment_area(c,mouth,0,max_steps,step_size,n_stream,streamline,vectors);
+    }
+  put_values(c,base,(double *)NULL);
+  for(k=0;k<c->num_zones;k++)
+    {
+      b=c->zones[k];
+      N=f[k]->N;
+      memcpy(b->bvv,bvv[k],2*N*sizeof(double));
+      memcpy(b->bcv,bcv[k],4*N*sizeof(double));
+    }
+
+  mean=0.0;
+  for(r=0;r<K;r++) mean=mean+area[r];
+  mean=mean/K;
+  var=0.0;
+  for(r=0;r<K;r++) var=var+(area[r]-mean)*(area[r]-mean);
+  var=(K>1) ? var/(K-1) : 0.0;
+  printf("\n  Ensemble areas:       mean %f, standard deviation %f (%d realisations)\n",
+	 mean,sqrt(var),K);
+
+  output=fopen(ENSEMBLE_FILE,"w");
+  if(output==(FILE *)NULL)
+    printf("Cannot write ensemble file: '%s'\n",ENSEMBLE_FILE);
+  else
+    {
+      fprintf(output,"Realisation,C_area\n");
+      for(r=0;r<K;r++) fprintf(output,"%d,%.6f\n",r,area[r]);
+      fclose(output);
+      printf("  Ensemble written:     %s\n",ENSEMBLE_FILE);
+    }
+
+  t=area[0];
+  for(k=0;k<c->num_zones;k++)
+    {
+      destroy_zone_factor(f[k]);
+      free((void *)bvv[k]);
+      free((void *)bcv[k]);
+    }
+  free((void *)f);
+  free((void *)bvv);
+  free((void *)bcv);
+  free((void *)base);
+  free((void *)noise);
+  free((void *)area);
+  return(t);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,215 @@
+/*----------------------------------- flowacc.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* upslope area and length of every cell from one evaluation of the field per cell */
+/*                                                                                  */
+/* risk, depth and sca_map follow a streamline from every cell, which costs up to   */
+/* max_steps evaluations per cell. Here V and dV are found once at the centre of    */
+/* every cell (calculate_batch) and the water of a cell goes down the gradient,     */
+/* -dV, to its 8 neighbours in the D-infinity way: the direction lies between two   */
+/* neighbours, which share the water in proportion to the angles. A neighbour only  */
+/* takes water if it is inside the catchment and has a lower V; otherwise the other */
+/* one takes it all, and if neither can the water leaves the raster there.          */
+/* Since water only goes to lower V, one sweep of the cells in order of decreasing  */
+/* V passes every cell after all the cells draining into it:                        */
+/*   A(k) = cell^2 + sum of the shares of A coming in                               */
+/*   L(k) = mean over the water coming in of (L upslope + distance between centres) */
+/* The two maps are written as <name>_area and <name>_length (.flt and .hdr).       */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+
+#include "batch.h"
+#include "catchment.h"
+#include "scan.h"
+#include "vcalc.h"
+
+#include "flowacc.h"
+/*----------------------------------------------------------------------------------*/
+#define FLOW_NODATA (-9999.0)
+/*----------------------------------------------------------------------------------*/
+typedef struct {
+  double V;
+  int k;
+} flow_order;
+/*----------------------------------------------------------------------------------*/
+static double cell_size=0.0;   /* <=0 = no maps */
+
+/* neighbours anticlockwise from east */
+static int next_i[8]={ 1, 1, 0,-1,-1,-1, 0, 1};
+static int next_j[8]={ 0, 1, 1, 1, 0,-1,-1,-1};
+/*----------------------------------------------------------------------------------*/
+void set_flow_accumulation(cell)
+     double cell;
+{
+  cell_size=cell;
+}
+/*----------------------------------------------------------------------------------*/
+double get_flow_accumulation()
+{
+  return(cell_size);
+}
+/*----------------------------------------------------------------------------------*/
+static void *flow_memory(n)
+     size_t n;
+{
+  void *p;
+
+  p=malloc(n);
+  if(p==NULL)
+    {
+      printf("Cannot allocate memory for flow accumulation\n");
+      exit(0);
+    }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+/* highest V first */
+/*----------------------------------------------------------------------------------*/
+static int compare_flow_order(a,b)
+     const void *a,*b;
+{
+  double Va,Vb;
+
+  Va=((flow_order *)a)->V;
+  Vb=((flow_order *)b)->V;
+  if(Va>Vb) return(-1);
+  if(Va<Vb) return(1);
+  return(((flow_order *)a)->k-((flow_order *)b)->k);
+}
+/*----------------------------------------------------------------------------------*/
+/* neighbour d of cell k if it can take water from k, otherwise -1 */
+/*----------------------------------------------------------------------------------*/
+static int flow_receiver(ras,k,d,inside,R)
+     raster *ras;
+     int k,d;
+     int *inside;
+     bem_results *R;
+{
+  int i,j,r;
+
+  i=k%ras->nx+next_i[d];
+  j=k/ras->nx+next_j[d];
+  if(i<0 || i>=ras->nx || j<0 || j>=ras->ny) return(-1);
+  r=j*ras->nx+i;
+  if(!inside[r] || R[r].V>=R[k].V) return(-1);
+  return(r);
+}
+/*----------------------------------------------------------------------------------*/
+/* upslope area and length of every cell of side get_flow_accumulation() over c;   */
+/* returns the number of cells inside                                               */
+/*----------------------------------------------------------------------------------*/
+int flow_accumulation(c,vectors,name)
+     catchment *c;
+     bem_vectors *vectors;
+     char *name;
+{
+  raster ras;
+  coordinates *P;
+  bem_results *R;
+  flow_order *order;
+  double *A,*L,*inflow,*Lsum,cell,theta,frac,w[2],dist[2],A_max;
+  int *inside,*new_z,n,m,i,j,k,s,d,r[2];
+  long before;
+  char file[128];
+
+  cell=cell_size;
+  catchment_raster(c,cell,&ras);
+  n=ras.nx*ras.ny;
+  printf("\n  Flow accumulation:    %d x %d cells of %g\n",ras.nx,ras.ny,cell);
+
+  P=(coordinates *)flow_memory(n*sizeof(coordinates));
+  R=(bem_results *)flow_memory(n*sizeof(bem_results));
+  new_z=(int *)flow_memory(n*sizeof(int));
+  inside=(int *)flow_memory(n*sizeof(int));
+  order=(flow_order *)flow_memory(n*sizeof(flow_order));
+  A=(double *)flow_memory(n*sizeof(double));
+  L=(double *)flow_memory(n*sizeof(double));
+  inflow=(double *)flow_memory(n*sizeof(double));
+  Lsum=(double *)flow_memory(n*sizeof(double));
+
+  for(j=0;j<ras.ny;j++)
+    for(i=0;i<ras.nx;i++)
+      {
+	P[j*ras.nx+i][0]=x_raster(&ras,i);
+	P[j*ras.nx+i][1]=y_raster(&ras,j);
+      }
+
+  /* the field, once per cell */
+  before=get_bem_evaluations();
+  calculate_batch(c,n,P,vectors,R,new_z,EVAL_V|EVAL_DV);
+  printf("  Field evaluations:    %ld\n",get_bem_evaluations()-before);
+
+  m=0;
+  for(k=0;k<n;k++)
+    {
+      inside[k]=(new_z[k]>=0);
+      A[k]=L[k]=inflow[k]=Lsum[k]=0.0;
+      if(!inside[k]) continue;
+      order[m].V=R[k].V;
+      order[m].k=k;
+      m=m+1;
+    }
+  qsort((void *)order,m,sizeof(flow_order),compare_flow_order);
+
+  /* one sweep down the field */
+  A_max=0.0;
+  for(s=0;s<m;s++)
+    {
+      k=order[s].k;
+      A[k]=A[k]+cell*cell;
+      if(inflow[k]>0.0) L[k]=Lsum[k]/inflow[k];
+      if(A[k]>A_max) A_max=A[k];
+      if(R[k].dV[0]==0.0 && R[k].dV[1]==0.0) continue;
+
+      theta=atan2(-R[k].dV[1],-R[k].dV[0]);
+      if(theta<0.0) theta=theta+2.0*M_PI;
+      d=(int)floor(theta/(M_PI/4.0));
+      frac=theta/(M_PI/4.0)-d;
+      d=d%8;
+      r[0]=flow_receiver(&ras,k,d,inside,R);
+      r[1]=flow_receiver(&ras,k,(d+1)%8,inside,R);
+      w[0]=1.0-frac;
+      w[1]=frac;
+      if(r[0]<0) { w[1]=w[1]+w[0]; w[0]=0.0; }
+      if(r[1]<0) { w[0]=w[0]+w[1]; w[1]=0.0; }
+      dist[0]=(d%2==0) ? cell : sqrt(2.0)*cell;
+      dist[1]=(d%2==0) ? sqrt(2.0)*cell : cell;
+      for(i=0;i<2;i++)
+	if(r[i]>=0 && w[i]>0.0)
+	  {
+	    A[r[i]]=A[r[i]]+w[i]*A[k];
+	    inflow[r[i]]=inflow[r[i]]+w[i]*A[k];
+	    Lsum[r[i]]=Lsum[r[i]]+w[i]*A[k]*(L[k]+dist[i]);
+	  }
+    }
+
+  for(k=0;k<n;k++)
+    if(!inside[k]) A[k]=L[k]=FLOW_NODATA;
+  sprintf(file,"%.100s_area",name);
+  write_flt_raster(file,&ras,cell,A,FLOW_NODATA);
+  sprintf(file,"%.100s_length",name);
+  write_flt_raster(file,&ras,cell,L,FLOW_NODATA);
+  printf("  Largest upslope area: %f\n",A_max);
+  printf("  Maps written:         %s_area.flt, %s_length.flt (%d cells inside)\n",
+	 name,name,m);
+
+  free((void *)P);
+  free((void *)R);
+  free((void *)new_z);
+  free((void *)inside);
+  free((void *)order);
+  free((void *)A);
+  free((void *)L);
+  free((void *)inflow);
+  free((void *)Lsum);
+  return(m);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
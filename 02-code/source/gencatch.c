@@ -0,0 +1,99 @@
+/*---------------------------------- gencatch.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* writes a synthetic catchment with an exact solution (see synthetic.c)            */
+/*                                                                                  */
+/*   gencatch --shape=circles --n=2000 --zones=3 --dir=ring                         */
+/*   CATCHMENT=ring/ catcharea --reference=ring/reference.txt 1.0                   */
+/*                                                                                  */
+/* --shape   circles (rings between --zones+1 circles), holes (a disc with --holes */
+/*           holes) or square                                                       */
+/* --n       points on the outer loop; the others get points in proportion to      */
+/*           their length                                                           */
+/* --dir     directory to write to (it must be there)                               */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "synthetic_types.h"
+
+#include "synthetic.h"
+/*----------------------------------------------------------------------------------*/
+#define MAX_PATHS 30     /* paths catcharea reserves for a catchment */
+/*----------------------------------------------------------------------------------*/
+int main(argc,argv)
+     int argc;
+     char **argv;
+{
+  synthetic s;
+  char *value,*dir;
+  int i,shape,n,zones,holes,most;
+
+  shape=SYNTH_CIRCLES;
+  n=400;
+  zones=1;
+  holes=3;
+  dir=".";
+  for(i=1;i<argc;i++)
+    {
+      value=strchr(argv[i],'=');
+      value=(value==(char *)NULL) ? "" : value+1;
+      if(strncmp(argv[i],"--shape=",8)==0)
+	{
+	  shape=synthetic_shape_from_name(value);
+	  if(shape<0)
+	    {
+	      printf("unknown shape '%s' (circles, holes or square)\n",value);
+	      exit(0);
+	    }
+	}
+      else if(strncmp(argv[i],"--n=",4)==0) n=atoi(value);
+      else if(strncmp(argv[i],"--zones=",8)==0) zones=atoi(value);
+      else if(strncmp(argv[i],"--holes=",8)==0) holes=atoi(value);
+      else if(strncmp(argv[i],"--dir=",6)==0) dir=value;
+      else
+	{
+	  printf("usage: gencatch [--shape=circles|holes|square] [--n=points] "
+		 "[--zones=rings] [--holes=holes] [--dir=directory]\n");
+	  exit(0);
+	}
+    }
+  if(n<16)
+    {
+      printf("--n=%d: at least 16 points on the outer loop\n",n);
+      exit(0);
+    }
+  if(zones<1 || zones+1>MAX_PATHS)
+    {
+      printf("--zones=%d: between 1 and %d rings\n",zones,MAX_PATHS-1);
+      exit(0);
+    }
+  if(holes<0 || holes>SYNTH_MAX_HOLES)
+    {
+      printf("--holes=%d: between 0 and %d holes\n",holes,SYNTH_MAX_HOLES);
+      exit(0);
+    }
+
+  make_synthetic(&s,shape,n,zones,holes);
+  most=write_synthetic(&s,dir);
+
+  printf("Synthetic catchment '%s' in %s/\n",synthetic_shape_name(shape),dir);
+  if(shape==SYNTH_CIRCLES)
+    printf("  %d ring%s between r=%g and r=%g, V = %.6f %+.6f ln r\n",s.zones,
+	   (s.zones==1) ? "" : "s",s.r_inner,s.r_outer,s.a,s.b);
+  else if(shape==SYNTH_HOLES)
+    printf("  disc of r=%g with %d hole%s of r=%g, V = %.6f %+.6f x\n",s.r_outer,
+	   s.holes,(s.holes==1) ? "" : "s",s.hole_r,s.a,s.b);
+  else
+    printf("  square of side %g, V = %.6f %+.6f x\n",s.r_outer,s.a,s.b);
+  printf("  most points in a zone: %d\n",most);
+  printf("  mouth: %s\n",s.mouth);
+  printf("  area:  %.6f (between the bounding flow paths)\n",s.area);
+  printf("  limit: %.6f (of C_area, as streamline_loop measures the width of the flow)\n",
+	 s.limit);
+  printf("  CATCHMENT=%s/ catcharea --reference=%s/%s 1.0\n",dir,dir,SYNTH_REFERENCE);
+  return(0);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -7,18 +7,42 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "tile_types.h"
 
 #include "catchment.h"
 #include "file.h"
 #include "memory.h"
 #include "scan.h"
+#include "tile.h"
 #include "trapfloat.h"
 #include "vcalc.h"
+#include "batch.h"
 
 #include "height.h"
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
+/* V at the points of one tile */
+/*--------------------------------------------------------*/
+static void height_tile(c,vectors,n,P,out,arg)
+     catchment *c;
+     bem_vectors *vectors;
+     int n;
+     coordinates *P;
+     double *out;
+     void *arg;
+{
+  bem_results field[TILE_SIZE*TILE_SIZE];
+  int i,new_z[TILE_SIZE*TILE_SIZE];
+
+  calculate_batch(c,n,P,vectors,field,new_z,EVAL_V);
+  for(i=0;i<n;i++)
+    {
+      if(new_z[i]==(-1)) printf("point is outside catchment\n");
+      out[i]=field[i].V;
+    }
+}
+/*--------------------------------------------------------*/
 int main()
 {
   /*  char data[]="c_valley.txt"; */
@@ -29,14 +53,11 @@ int main()
   char data[]="c_valley.txt"; 
 
   FILE *output1, *output2;
-  bem_results voltage;
-  bem_vectors *vectors;
   catchment *c;
   char *buffer[2];
   coordinates P;
-  double pp;
-  int buf_size,i,j,k,column,max_points,num_zones,new_z;
-  matrix bvv, bcv;
+  double pp,*out;
+  int buf_size,i,j,column,max_points,num_zones;
   raster ras;
 
   trap_floating_errors();
@@ -52,7 +73,6 @@ int main()
 
   max_points=max_points_in_any_zone(c);
   printf("maximum points in any zone is %d\n",max_points);
-  vectors=create_bem_vectors(&bvv,&bcv,max_points);
   /*
   put_raster("P(0,0)=(0.0,0.0) P(100,100)=(20.0,20.0)",&ras);
   put_raster("P(0,0)=(0.0,0.0) P(50,50)=(20.0,20.0)",&ras);
@@ -62,24 +82,23 @@ int main()
 
   put_raster("P(0,0)=(0.0,0.0) P(20,20)=(20.0,20.0)",&ras);
   show_raster(&ras);
+  out=scan_raster_tiles(data,&ras,1,height_tile,(void *)NULL);
 
   printf("\n------after scan----\n");
 
   output1=open_file(0,"height.out","w");
   output2=open_file(0,"height2.out","w");
   column=0;
-  k=0;
 /*------------------------------------------------------*/
-/* this loop scans a grid of x and y */
+/* this loop writes out the grid of x and y, row by row */
 /*------------------------------------------------------*/
   for(j=0;j<ras.ny;j++)
    {
       P[1]=y_raster(&ras,j);
       for(i=0;i<ras.nx;i++)
 	{
-	  P[0]=x_raster(&ras,i);    	  
-	  pp=calculate_inside_catchment(c,P,vectors,&voltage,&new_z);
-	  if(new_z==(-1)) printf("point is outside catchment\n");
+	  P[0]=x_raster(&ras,i);
+	  pp=out[j*ras.nx+i];
 
 	  column=put_buffer(buf_size,buffer[0],column,"%14.5e",pp);
 
@@ -93,17 +112,13 @@ int main()
       column=0;
       put_next_line(output1,buffer[0]);
       put_next_line(output2,"");
-      if(k%50==0) printf("\n");
-      printf("#"); fflush(stdout);
-      k=k+1;
    }
 /*------------------------------------------------------*/
 
-  printf("\n");
   fclose(output1);
   fclose(output2);
   destroy_catchment(c);
-  destroy_bem_vectors(vectors);
+  free((void *)out);
   free((void *)buffer[0]);
   return(0);
 }
@@ -14,6 +14,7 @@
 #include "scan.h"
 #include "trapfloat.h"
 #include "vcalc.h"
+#include "batch.h"
 
 #include "hsection.h"
 /*--------------------------------------------------------*/
@@ -25,13 +26,13 @@ int main()
   char data[]="c_valley.txt"; 
 
   FILE *output;
-  bem_results voltage;
+  bem_results voltage,*field;
   bem_vectors *vectors;
   catchment *c;
   char *buffer;
-  coordinates P;
+  coordinates P,*row;
   double pp;
-  int buf_size,i,column,max_points,num_zones,new_z;
+  int buf_size,i,column,max_points,num_zones,*new_z;
   matrix bvv, bcv;
   section mouth;
 
@@ -50,17 +51,24 @@ int main()
   put_section("P(0) = (4.0,5.0) P(100) = (5.0,4.0)",&mouth);
   show_section(&mouth);
   printf("step size across mouth is %f\n",mouth.step);
+  row=(coordinates *)malloc(mouth.n*sizeof(coordinates));
+  field=(bem_results *)malloc(mouth.n*sizeof(bem_results));
+  new_z=(int *)malloc(mouth.n*sizeof(int));
 
   output=open_file(0,"hsection.out","w");
   column=0;
 /*------------------------------------------------------*/
 /* this loop scans across the mouth */
 /*------------------------------------------------------*/
+  for(i=0;i<mouth.n;i++) xy_section(&mouth,i,row[i]);
+  calculate_batch(c,mouth.n,row,vectors,field,new_z,EVAL_V);
   for(i=0;i<mouth.n;i++)
     {
-      xy_section(&mouth,i,P);    	  
-      pp=calculate_inside_catchment(c,P,vectors,&voltage,&new_z);
-      if(new_z==(-1)) printf("point is outside catchment\n");
+      P[0]=row[i][0];
+      P[1]=row[i][1];
+      voltage=field[i];
+      pp=voltage.V;
+      if(new_z[i]==(-1)) printf("point is outside catchment\n");
       
       column=put_buffer(buf_size,buffer,column,"%14.5e ",i*mouth.step);
       column=put_buffer(buf_size,buffer,column,"%14.5e\n",pp);
@@ -76,6 +84,9 @@ int main()
   fclose(output);
   destroy_catchment(c);
   destroy_bem_vectors(vectors);
+  free((void *)row);
+  free((void *)field);
+  free((void *)new_z);
   free((void *)buffer);
   return(0);
 }
@@ -0,0 +1,141 @@
+/*----------------------------------- logging.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* levels and categories of the diagnostic messages                                */
+/*                                                                                  */
+/* A message is printed under                                                       */
+/*   if(log_on(LOG_DEBUG,LOG_MATRIX)) printf(...);                                  */
+/* which is a branch on log_level and log_mask (and nothing at all for a level      */
+/* above LOG_MAX_LEVEL). Messages once per call or per step are LOG_DEBUG, so by    */
+/* default only those once per zone or streamline are printed. Progress marks      */
+/* (steps of a streamline, rows of an inversion) go through log_progress, which     */
+/* lets one through at most every get_log_progress() seconds in all threads.        */
+/* Errors that stop the program are printed as before, whatever the level.          */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+/*----------------------------------------------------------------------------------*/
+#include "logging_types.h"
+
+#include "logging.h"
+/*----------------------------------------------------------------------------------*/
+int log_level=LOG_INFO;
+int log_mask=LOG_ALL;
+
+static double progress_every=1.0;   /* seconds between progress marks */
+static double last_progress=0.0;
+
+static char *level_names[4]={"error","warn","info","debug"};
+static char *category_names[4]={"matrix","linalg","zone","stream"};
+/*----------------------------------------------------------------------------------*/
+void set_log_level(level)
+     int level;
+{
+  log_level=level;
+}
+/*----------------------------------------------------------------------------------*/
+int get_log_level()
+{
+  return(log_level);
+}
+/*----------------------------------------------------------------------------------*/
+void set_log_categories(mask)
+     int mask;
+{
+  log_mask=mask;
+}
+/*----------------------------------------------------------------------------------*/
+int get_log_categories()
+{
+  return(log_mask);
+}
+/*----------------------------------------------------------------------------------*/
+void set_log_progress(seconds)
+     double seconds;
+{
+  progress_every=seconds;
+}
+/*----------------------------------------------------------------------------------*/
+double get_log_progress()
+{
+  return(progress_every);
+}
+/*----------------------------------------------------------------------------------*/
+char *log_level_name(level)
+     int level;
+{
+  if(level<LOG_ERROR || level>LOG_DEBUG) return("unknown");
+  return(level_names[level]);
+}
+/*----------------------------------------------------------------------------------*/
+/* level from its name; -1 if unknown */
+/*----------------------------------------------------------------------------------*/
+int log_level_from_name(name)
+     char *name;
+{
+  int i;
+
+  for(i=LOG_ERROR;i<=LOG_DEBUG;i++)
+    if(strcmp(name,level_names[i])==0) return(i);
+  return(-1);
+}
+/*----------------------------------------------------------------------------------*/
+/* mask from names separated by commas ("zone,stream" or "all"); -1 if one is unknown */
+/*----------------------------------------------------------------------------------*/
+int log_categories_from_names(names)
+     char *names;
+{
+  char *p,*end;
+  size_t n;
+  int i,mask;
+
+  mask=0;
+  for(p=names;*p!='\0';p=(*end==',') ? end+1 : end)
+    {
+      end=strchr(p,',');
+      if(end==(char *)NULL) end=p+strlen(p);
+      n=(size_t)(end-p);
+      if(n==3 && strncmp(p,"all",3)==0)
+	{
+	  mask=LOG_ALL;
+	  continue;
+	}
+      for(i=0;i<4;i++)
+	if(strlen(category_names[i])==n && strncmp(p,category_names[i],n)==0) break;
+      if(i==4) return(-1);
+      mask=mask|(1<<i);
+    }
+  return(mask);
+}
+/*----------------------------------------------------------------------------------*/
+/* 1 if a progress mark of this category is to be printed now; last_progress is    */
+/* read without the lock, which is only taken when the interval has passed (and    */
+/* checked again under it, since another thread may have printed in between)       */
+/*----------------------------------------------------------------------------------*/
+int log_progress(category)
+     int category;
+{
+  struct timeval t;
+  double now,last;
+  int show;
+
+  if(!log_on(LOG_INFO,category)) return(0);
+  gettimeofday(&t,NULL);
+  now=(double)t.tv_sec+(double)t.tv_usec/1000000.0;
+#pragma omp atomic read
+  last=last_progress;
+  if(now-last<progress_every) return(0);
+  show=0;
+#pragma omp critical (log_progress)
+  {
+    if(now-last_progress>=progress_every)
+      {
+#pragma omp atomic write
+	last_progress=now;
+	show=1;
+      }
+  }
+  return(show);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -15,8 +15,18 @@
 #include <x86intrin.h>
 /*----------------------------------------------------------------------------------*/
 #include "matrix_types.h"
+#include "logging_types.h"
+#include "perfcount_types.h"
+#include "memtrack_types.h"
+#include "boundary_types.h"
+#include "stream_types.h"
+#include "trace_types.h"
 
 #include "file.h"
+#include "logging.h"
+#include "memtrack.h"
+#include "perfcount.h"
+#include "trace.h"
 
 #include "matrix.h"
 
@@ -94,13 +104,13 @@ int rows, columns;
   matrix *x;
   double *data;
 
-  x = (matrix *)malloc(sizeof(matrix));
+  x = (matrix *)tracked_malloc(sizeof(matrix), -1);
   if (x == (matrix *)NULL)
   {
     printf("error allocating memory for matrix\n");
     exit(0);
   }
-  data = (double *)malloc(rows * columns * sizeof(double));
+  data = (double *)tracked_malloc(rows * columns * sizeof(double), -1);
   if (data == (double *)NULL)
   {
     printf("error allocating memory for matrix\n");
@@ -139,8 +149,8 @@ matrix *x;
   if (x != (matrix *)NULL)
   {
     if (x->value != (double *)NULL)
-      free((void *)x->value);
-    free((void *)x);
+      tracked_free((void *)x->value);
+    tracked_free((void *)x);
   }
   return ((void *)NULL);
 }
@@ -912,6 +922,7 @@ void multiply_matrix(a, b, x)
   int b_col_num = get_num_columns(b);
   int a_row_num = get_num_rows(a);
   int b_row_num = get_num_rows(b);
+  perf_sample sample;
 
   check_multiply_shape(a, b);
   check_multiply_size(a, b, x);
@@ -922,12 +933,14 @@ void multiply_matrix(a, b, x)
   // Handle invert flags
   if (a->invert == 1)
   {
-    printf("\nmultiply_matrix() with (a->invert==1)\n");
+    if (log_on(LOG_DEBUG, LOG_MATRIX))
+      printf("\nmultiply_matrix() with (a->invert==1)\n");
     invert_this_matrix(a);
   }
   if (b->invert == 1)
   {
-    printf("\nmultiply_matrix() with (b->invert==1)\n");
+    if (log_on(LOG_DEBUG, LOG_MATRIX))
+      printf("\nmultiply_matrix() with (b->invert==1)\n");
     invert_this_matrix(b);
   }
 
@@ -943,32 +956,38 @@ void multiply_matrix(a, b, x)
   // Use optimized multiplication for large matrices
   if (x->rows > 1 && x->columns > 1)
   {
-    printf("\n------- Using Optimized Multiply (Method %d) -------\n",
-           get_multiply_method());
-    printf("Matrix A: (%dx%d), transpose=%d\n", a->rows, a->columns, a->transpose);
-    printf("Matrix B: (%dx%d), transpose=%d\n", b->rows, b->columns, b->transpose);
-    printf("Matrix X: (%dx%d)\n", x->rows, x->columns);
-
-    if ((a->rows == a->columns) && (b->rows == b->columns))
+    if (log_on(LOG_DEBUG, LOG_MATRIX))
     {
-      printf("Square matrix multiplication\n");
+      printf("\n------- Using Optimized Multiply (Method %d) -------\n",
+             get_multiply_method());
+      printf("Matrix A: (%dx%d), transpose=%d\n", a->rows, a->columns, a->transpose);
+      printf("Matrix B: (%dx%d), transpose=%d\n", b->rows, b->columns, b->transpose);
+      printf("Matrix X: (%dx%d)\n", x->rows, x->columns);
+
+      if ((a->rows == a->columns) && (b->rows == b->columns))
+      {
+        printf("Square matrix multiplication\n");
+      }
     }
 
     // Before multiplication
     double start_time = omp_get_wtime();
+    perf_begin(&sample);
 
     // Call optimized multiplication
     multiply_matrix_optimized(a, b, x);
 
     // After multiplication
     double mult_time = omp_get_wtime() - start_time;
+    perf_end(&sample, PERF_MULTIPLY, 2.0 * a->rows * b->columns * a->columns);
     update_multiply_time(mult_time, a->rows, b->columns, a->columns);
 
   }
   else
   {
     // Small matrix - use original sequential code
-    printf("\n------- Using Sequential (small matrix) -------\n");
+    if (log_on(LOG_DEBUG, LOG_MATRIX))
+      printf("\n------- Using Sequential (small matrix) -------\n");
 
     if (a->transpose == 0)
     {
@@ -1275,9 +1294,11 @@ void invert_this_matrix(a)
     matrix *a;
 {
   int n, j;
-  struct timeval inv_start, inv_finish;
+  trace_span span;
   double inv_duration;
   long vmrss_before, vmsize_before, vmrss_after, vmsize_after;
+  int verbose;
+  perf_sample sample;
 
   a->invert = 0;
   n = get_num_columns(a);
@@ -1290,37 +1311,40 @@ void invert_this_matrix(a)
 /*----------------------------------------------------------------------------------*/
 
   /* Print method being used */
-  if (use_sequential_inversion == 0)
+  verbose = log_on(LOG_INFO, LOG_MATRIX);
+  if (verbose)
   {
-    printf("\n[PARALLEL INVERSION] Inverting (%dx%d) using LAPACK\n", n, n);
-  }
-  else
-  {
-    printf("\n[SEQUENTIAL INVERSION] Inverting (%dx%d) using Gauss-Jordan\n", n, n);
-  }
+    if (use_sequential_inversion == 0)
+      printf("\n[PARALLEL INVERSION] Inverting (%dx%d) using LAPACK\n", n, n);
+    else
+      printf("\n[SEQUENTIAL INVERSION] Inverting (%dx%d) using Gauss-Jordan\n", n, n);
 
-  /* Get memory before */
-  get_memory_usage_kb(&vmrss_before, &vmsize_before);
-  printf("Memory before: VmRSS=%.2f MB\n", vmrss_before / 1024.0);
+    /* Get memory before */
+    get_memory_usage_kb(&vmrss_before, &vmsize_before);
+    printf("Memory before: VmRSS=%.2f MB\n", vmrss_before / 1024.0);
+  }
 
-double inv_start_time = omp_get_wtime();
+perf_begin(&sample);
 
-  printf("Inverting the matrix, Please wait..\n");
-  gettimeofday(&inv_start, NULL);
+  if (verbose)
+    printf("Inverting the matrix, Please wait..\n");
+  trace_begin(&span, "invert_this_matrix", "linalg");
 
   if (use_sequential_inversion == 0)
   {
     /*-------------- Parallel (LAPACK) -----------*/
-    printf("Using LAPACK mat_inv() - parallel LU decomposition\n");
+    if (verbose)
+      printf("Using LAPACK mat_inv() - parallel LU decomposition\n");
     mat_inv(a->value, n);
   }
   else
   {
     /*-------------- Sequential (Manual) -----------*/
-    printf("Using manual Gauss-Jordan - sequential\n");
+    if (verbose)
+      printf("Using manual Gauss-Jordan - sequential\n");
     for (j = 0; j < n; j++)
     {
-      if (j % 50 == 0 && j > 0)
+      if (j % 50 == 0 && j > 0 && log_progress(LOG_MATRIX))
       {
         printf("Progress: %d/%d rows (%.1f%%)\n", j, n, (100.0 * j) / n);
         fflush(stdout);
@@ -1328,16 +1352,14 @@ double inv_start_time = omp_get_wtime();
       scale_row(a, j);
       reduce_column(a, j);
     }
-    printf("Progress: %d/%d rows (100.0%%)\n", n, n);
+    if (verbose)
+      printf("Progress: %d/%d rows (100.0%%)\n", n, n);
   }
 
-  gettimeofday(&inv_finish, NULL);
-  inv_duration = ((double)(inv_finish.tv_sec - inv_start.tv_sec) * 1000000 +
-                  (double)(inv_finish.tv_usec - inv_start.tv_usec)) /
-                 1000000;
+  inv_duration = trace_end(&span);
 
-double inv_time = omp_get_wtime() - inv_start_time;
-update_inversion_time(inv_time, a->rows);
+perf_end(&sample, PERF_INVERSION, 2.0 * n * n * n / 3.0);
+update_inversion_time(inv_duration, a->rows);
 
   /*----------------------------------------------------------------------------------*/
   /* ⭐⭐⭐ CRITICAL FIX - ADD THIS LINE ⭐⭐⭐ */
@@ -1346,6 +1368,9 @@ update_inversion_time(inv_time, a->rows);
   update_matrix_inversion_stats(inv_duration);
   /*----------------------------------------------------------------------------------*/
 
+  if (!verbose)
+    return;
+
   /* Get memory after */
   get_memory_usage_kb(&vmrss_after, &vmsize_after);
 
@@ -1375,7 +1400,7 @@ update_inversion_time(inv_time, a->rows);
  *
  *   update_matrix_inversion_stats(inv_duration);
  *
- * This line is placed RIGHT AFTER calculating inv_duration (line after gettimeofday)
+ * This line is placed RIGHT AFTER inv_duration is returned by trace_end
  * and BEFORE getting memory after.
  *
  * This single line passes the timing data to matrix_inv.c where global statistics
@@ -1397,51 +1422,6 @@ update_inversion_time(inv_time, a->rows);
  */
 /*----------------------------------------------------------------------------------*/
 
-/*----------------------------------------------------------------------------------*/
-/*
-void invert_this_matrix(a)
-    matrix *a;
-{
-  int n, j;
-
-  struct timeval inv_start, inv_finish;
-  double inv_duration;
-
-  a->invert = 0;
-  n = get_num_columns(a);
-  printf("Inverting matrix (%dx%d) \n", n, n);
-
-  //---------------------------------------------------
-  printf("\n-----------[matrix.c]-invert_this_matrix -----------\n");
-  printf("Inverting the matrix, Please wait..\n");
-  gettimeofday(&inv_start, NULL);
-  //---------------------------------------------------
-
-  //-------------- Parallel -----------
-  mat_inv(a->value, n);
-
-  //-------------- Sequential -----------
-
-
-  //  for(j=0;j<n;j++)
-  //    {
-  //      //if(j%50==0) printf("\n");
-  //      //printf("*"); fflush(stdout);
-  //      scale_row(a,j);
-  //      reduce_column(a,j);
-  //   }
-
-
-  gettimeofday(&inv_finish, NULL);
-  inv_duration = ((double)(inv_finish.tv_sec - inv_start.tv_sec) * 1000000 + (double)(inv_finish.tv_usec - inv_start.tv_usec)) / 1000000;
-  printf("############# Matrix inversion took: %lf seconds\n", inv_duration);
-  printf("------ (%dx%d) Matrix inversion is done. -------- \n", n, n);
-
-
-  // printf("\n\n----------- End -----------\n");
-}
-*/
-
 /*------------------------------------------------*/
 /*------------reduce_column----------------*/
 void reduce_column(a, col)
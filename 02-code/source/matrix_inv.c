@@ -10,6 +10,7 @@
 #include <math.h>   // สำหรับ fabs()
 /*----------------------------------------------------------------------------------*/
 #include "matrix_types.h"
+#include "memtrack_types.h"
 
 #include <time.h>
 #include <omp.h>
@@ -20,7 +21,14 @@
 #include "sys/time.h"
 #include <sys/resource.h>
 #include "openblas_config.h"
+#include "boundary_types.h"
+#include "stream_types.h"
 #include "performance_summary.h"
+#include "trace_types.h"
+#include "logging_types.h"
+#include "trace.h"
+#include "logging.h"
+#include "memtrack.h"
 
 // OpenBLAS runtime query functions
 extern int openblas_get_num_threads(void);
@@ -37,8 +45,6 @@ typedef struct {
     long total_dgemm_calls;
     long total_mat_inv_calls;
     long long total_flops;
-    size_t peak_memory_bytes;
-    size_t current_allocated_bytes;
 } matrix_perf_stats;
 
 static matrix_perf_stats g_perf_stats = {0};
@@ -46,20 +52,6 @@ static matrix_perf_stats g_perf_stats = {0};
 // Fallback prototype
 static lapack_int mat_inv_gauss_fallback(double *A, unsigned n);
 
-/*----------------------------------------------------------------------------------*/
-/* Memory tracking */
-/*----------------------------------------------------------------------------------*/
-void update_memory_stats(size_t bytes_allocated) {
-    g_perf_stats.current_allocated_bytes += bytes_allocated;
-    if (g_perf_stats.current_allocated_bytes > g_perf_stats.peak_memory_bytes) {
-        g_perf_stats.peak_memory_bytes = g_perf_stats.current_allocated_bytes;
-    }
-}
-
-void free_memory_stats(size_t bytes_freed) {
-    g_perf_stats.current_allocated_bytes -= bytes_freed;
-}
-
 /*----------------------------------------------------------------------------------*/
 /* Get current memory usage */
 /*----------------------------------------------------------------------------------*/
@@ -147,7 +139,7 @@ void print_matrix_performance_summary() {
     printf("MEMORY USAGE:\n");
     printf("-------------\n");
     printf("  Peak allocated (tracked):            %.2f MB\n", 
-           g_perf_stats.peak_memory_bytes / (1024.0 * 1024.0));
+           get_memory_totals()->peak / (1024.0 * 1024.0));
     printf("  VmRSS (resident set):                %.2f MB\n", vmrss / 1024.0);
     printf("  VmSize (virtual memory):             %.2f MB\n", vmsize / 1024.0);
     printf("  Max RSS (rusage):                    %.2f MB\n", r_usage.ru_maxrss / 1024.0);
@@ -260,25 +252,26 @@ void mat_mul(double *A, double *B, double *X, int m, int k, int n)
     double alpha = 1.0;
     double beta = 0.0;
 
-    struct timeval start, finish;
+    trace_span span;
     double duration;
     long vmrss, vmsize;
+    int verbose = log_on(LOG_DEBUG, LOG_LINALG);
 
     // Track memory before operation
-    get_memory_usage_kb(&vmrss, &vmsize);
+    if (verbose) {
+        get_memory_usage_kb(&vmrss, &vmsize);
     
-    printf("=== DGEMM Operation ===\n");
-    printf("Matrix dimensions: m=%d, n=%d, k=%d\n", m, n, k);
-    printf("Memory before: VmRSS=%.2f MB, VmSize=%.2f MB\n", vmrss/1024.0, vmsize/1024.0);
+        printf("=== DGEMM Operation ===\n");
+        printf("Matrix dimensions: m=%d, n=%d, k=%d\n", m, n, k);
+        printf("Memory before: VmRSS=%.2f MB, VmSize=%.2f MB\n", vmrss/1024.0, vmsize/1024.0);
+    }
 
-    gettimeofday(&start, NULL);
+    trace_begin(&span, "dgemm", "linalg");
 
     cblas_dgemm(CblasRowMajor, CblasTrans, CblasTrans,
                 m, n, k, alpha, A, k, B, n, beta, X, n);
 
-    gettimeofday(&finish, NULL);
-
-    duration = ((double)(finish.tv_sec - start.tv_sec) * 1000000 + (double)(finish.tv_usec - start.tv_usec)) / 1000000;
+    duration = trace_end(&span);
     
     // Calculate FLOPS
     long long flops = 2LL * m * n * k;
@@ -290,10 +283,12 @@ void mat_mul(double *A, double *B, double *X, int m, int k, int n)
     g_perf_stats.total_flops += flops;
 
     // Track memory after operation
-    get_memory_usage_kb(&vmrss, &vmsize);
+    if (verbose) {
+        get_memory_usage_kb(&vmrss, &vmsize);
     
-    printf("DGEMM completed in %.6f seconds (%.2f GFLOPS)\n", duration, gflops);
-    printf("Memory after: VmRSS=%.2f MB, VmSize=%.2f MB\n\n", vmrss/1024.0, vmsize/1024.0);
+        printf("DGEMM completed in %.6f seconds (%.2f GFLOPS)\n", duration, gflops);
+        printf("Memory after: VmRSS=%.2f MB, VmSize=%.2f MB\n\n", vmrss/1024.0, vmsize/1024.0);
+    }
 }
 
 /*----------------------------------------------------------------------------------*/
@@ -303,12 +298,14 @@ lapack_int mat_inv(double *A, unsigned n)
 {
     lapack_int ipiv[n + 1];
     lapack_int ret;
-    struct timeval start, finish, start_total;
+    trace_span span;
     double duration, dgetrf_time, dgetri_time;
     long vmrss_before, vmsize_before, vmrss_after, vmsize_after;
     int actual_threads = 1;  // Default to 1 if query fails
+    int verbose = log_on(LOG_INFO, LOG_LINALG);
 
-    get_memory_usage_kb(&vmrss_before, &vmsize_before);
+    if (verbose)
+        get_memory_usage_kb(&vmrss_before, &vmsize_before);
     
     if (A == NULL) {
         fprintf(stderr, "mat_inv ERROR: A is NULL (n=%u)\n", n);
@@ -319,59 +316,66 @@ lapack_int mat_inv(double *A, unsigned n)
     // DIAGNOSTIC OUTPUT - Shows actual threading configuration
     // ========================================================================
     
-    printf("=== LAPACK Matrix Inversion (DIAGNOSTIC) ===\n");
-    printf("Matrix size: %u x %u\n", n, n);
-    printf("\nEnvironment Variables:\n");
-    printf("  OMP_NUM_THREADS:      %s\n", getenv("OMP_NUM_THREADS") ?: "not set");
-    printf("  OPENBLAS_NUM_THREADS: %s\n", getenv("OPENBLAS_NUM_THREADS") ?: "not set");
-    printf("  OMP_PROC_BIND:        %s\n", getenv("OMP_PROC_BIND") ?: "not set");
-    printf("  OMP_PLACES:           %s\n", getenv("OMP_PLACES") ?: "not set");
+    if (verbose) {
+        printf("=== LAPACK Matrix Inversion (DIAGNOSTIC) ===\n");
+        printf("Matrix size: %u x %u\n", n, n);
+        printf("\nEnvironment Variables:\n");
+        printf("  OMP_NUM_THREADS:      %s\n", getenv("OMP_NUM_THREADS") ?: "not set");
+        printf("  OPENBLAS_NUM_THREADS: %s\n", getenv("OPENBLAS_NUM_THREADS") ?: "not set");
+        printf("  OMP_PROC_BIND:        %s\n", getenv("OMP_PROC_BIND") ?: "not set");
+        printf("  OMP_PLACES:           %s\n", getenv("OMP_PLACES") ?: "not set");
+    }
     
     // Query OpenBLAS runtime configuration
     actual_threads = openblas_get_num_threads();
     int parallel_mode = openblas_get_parallel();
     
-    printf("\nOpenBLAS Runtime Configuration:\n");
-    printf("  Actual threads in use: %d\n", actual_threads);
-    printf("  Parallel mode: %d\n", parallel_mode);
+    if (verbose) {
+        printf("\nOpenBLAS Runtime Configuration:\n");
+        printf("  Actual threads in use: %d\n", actual_threads);
+        printf("  Parallel mode: %d\n", parallel_mode);
+    }
     
     // Verify thread count matches environment
     char *env_threads = getenv("OPENBLAS_NUM_THREADS");
     if (env_threads != NULL) {
         int expected_threads = atoi(env_threads);
         if (actual_threads != expected_threads) {
-            printf("  ⚠️  WARNING: Mismatch! Expected %d threads, using %d\n",
-                   expected_threads, actual_threads);
+            if (log_on(LOG_WARN, LOG_LINALG))
+                printf("  ⚠️  WARNING: Mismatch! Expected %d threads, using %d\n",
+                       expected_threads, actual_threads);
         } else {
-            printf("  ✅ Thread count verified: %d\n", actual_threads);
+            if (verbose)
+                printf("  ✅ Thread count verified: %d\n", actual_threads);
         }
     }
     
-    printf("\nMemory before: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
-           vmrss_before/1024.0, vmsize_before/1024.0);
+    if (verbose)
+        printf("\nMemory before: VmRSS=%.2f MB, VmSize=%.2f MB\n", 
+               vmrss_before/1024.0, vmsize_before/1024.0);
     
     // ========================================================================
     // LAPACK Operations with Separate Timing
     // ========================================================================
     
-    printf("\n--- Phase 1: LU Factorization (DGETRF) ---\n");
-    gettimeofday(&start_total, NULL);
-    gettimeofday(&start, NULL);
+    if (verbose)
+        printf("\n--- Phase 1: LU Factorization (DGETRF) ---\n");
+    trace_begin(&span, "dgetrf", "linalg");
 
     //-----------------------------------------------------------------------
     actual_threads = openblas_get_num_threads();
     parallel_mode  = openblas_get_parallel();
-    printf("OpenBLAS Runtime Configuration:\n");
-    printf("  Actual threads in use: %d\n", actual_threads);
-    printf("  Parallel mode: %d\n", parallel_mode);
+    if (verbose) {
+        printf("OpenBLAS Runtime Configuration:\n");
+        printf("  Actual threads in use: %d\n", actual_threads);
+        printf("  Parallel mode: %d\n", parallel_mode);
+    }
     //-----------------------------------------------------------------------
 
     // LU decomposition (Phase 1)
     ret = LAPACKE_dgetrf(LAPACK_COL_MAJOR, n, n, A, n, ipiv);
     
-    gettimeofday(&finish, NULL);
-    dgetrf_time = ((double)(finish.tv_sec - start.tv_sec) * 1000000 + 
-                   (double)(finish.tv_usec - start.tv_usec)) / 1000000;
+    dgetrf_time = trace_end(&span);
     
     if (ret != 0) {
         printf("ERROR: LAPACKE_dgetrf failed with code %d\n", ret);
@@ -383,19 +387,20 @@ lapack_int mat_inv(double *A, unsigned n)
     double flops_dgetrf = (2.0/3.0) * (double)n * (double)n * (double)n;
     double gflops_dgetrf = flops_dgetrf / dgetrf_time / 1.0e9;
     
-    printf("  Completed in:        %.6f seconds\n", dgetrf_time);
-    printf("  FLOPs:               %.2e (%.0f billion)\n", flops_dgetrf, flops_dgetrf/1.0e9);
-    printf("  GFLOPS:              %.2f\n", gflops_dgetrf);
+    if (verbose) {
+        printf("  Completed in:        %.6f seconds\n", dgetrf_time);
+        printf("  FLOPs:               %.2e (%.0f billion)\n", flops_dgetrf, flops_dgetrf/1.0e9);
+        printf("  GFLOPS:              %.2f\n", gflops_dgetrf);
+    }
 
     // Matrix inversion (Phase 2)
-    printf("\n--- Phase 2: Matrix Inversion (DGETRI) ---\n");
-    gettimeofday(&start, NULL);
+    if (verbose)
+        printf("\n--- Phase 2: Matrix Inversion (DGETRI) ---\n");
+    trace_begin(&span, "dgetri", "linalg");
     
     ret = LAPACKE_dgetri(LAPACK_COL_MAJOR, n, A, n, ipiv);
     
-    gettimeofday(&finish, NULL);
-    dgetri_time = ((double)(finish.tv_sec - start.tv_sec) * 1000000 + 
-                   (double)(finish.tv_usec - start.tv_usec)) / 1000000;
+    dgetri_time = trace_end(&span);
     
     if (ret != 0) {
         printf("ERROR: LAPACKE_dgetri failed with code %d\n", ret);
@@ -407,9 +412,11 @@ lapack_int mat_inv(double *A, unsigned n)
     double flops_dgetri = (4.0/3.0) * (double)n * (double)n * (double)n;
     double gflops_dgetri = flops_dgetri / dgetri_time / 1.0e9;
     
-    printf("  Completed in:        %.6f seconds\n", dgetri_time);
-    printf("  FLOPs:               %.2e (%.0f billion)\n", flops_dgetri, flops_dgetri/1.0e9);
-    printf("  GFLOPS:              %.2f\n", gflops_dgetri);
+    if (verbose) {
+        printf("  Completed in:        %.6f seconds\n", dgetri_time);
+        printf("  FLOPs:               %.2e (%.0f billion)\n", flops_dgetri, flops_dgetri/1.0e9);
+        printf("  GFLOPS:              %.2f\n", gflops_dgetri);
+    }
     
     // Total duration
     duration = dgetrf_time + dgetri_time;
@@ -421,7 +428,8 @@ lapack_int mat_inv(double *A, unsigned n)
     g_perf_stats.total_mat_inv_time += duration;
     g_perf_stats.total_mat_inv_calls++;
 
-    get_memory_usage_kb(&vmrss_after, &vmsize_after);
+    if (verbose)
+        get_memory_usage_kb(&vmrss_after, &vmsize_after);
     
     // ========================================================================
     // Performance Summary
@@ -438,33 +446,35 @@ lapack_int mat_inv(double *A, unsigned n)
     double theoretical_peak_per_core = 29.6;  // GFLOPS
     double efficiency_percent = (gflops_per_thread / theoretical_peak_per_core) * 100.0;
     
-    printf("\n=== Performance Summary ===\n");
-    printf("Total time:              %.6f seconds\n", duration);
-    printf("  - DGETRF (LU):         %.6f s (%.1f%%)\n", 
-           dgetrf_time, dgetrf_time/duration*100);
-    printf("  - DGETRI (inversion):  %.6f s (%.1f%%)\n", 
-           dgetri_time, dgetri_time/duration*100);
-    printf("\n");
-    printf("FLOPs:\n");
-    printf("  - DGETRF:              %.2e (%.0f billion)\n", flops_dgetrf, flops_dgetrf/1.0e9);
-    printf("  - DGETRI:              %.2e (%.0f billion)\n", flops_dgetri, flops_dgetri/1.0e9);
-    printf("  - Total:               %.2e (%.0f billion)\n", total_flops, total_flops/1.0e9);
-    printf("\n");
-    printf("Performance:\n");
-    printf("  Overall GFLOPS:        %.2f\n", gflops);
-    printf("  DGETRF GFLOPS:         %.2f\n", gflops_dgetrf);
-    printf("  DGETRI GFLOPS:         %.2f\n", gflops_dgetri);
-    printf("  GFLOPS per thread:     %.2f (using %d threads)\n", gflops_per_thread, actual_threads);
-    printf("  Efficiency:            %.1f%% of theoretical peak per core\n", efficiency_percent);
-    printf("\n");
-    printf("Memory:\n");
-    printf("  Before: VmRSS=%.2f MB, VmSize=%.2f MB\n",
-           vmrss_before/1024.0, vmsize_before/1024.0);
-    printf("  After:  VmRSS=%.2f MB, VmSize=%.2f MB\n", 
-           vmrss_after/1024.0, vmsize_after/1024.0);
-    printf("  Delta:  VmRSS=%.2f MB, VmSize=%.2f MB\n",
-           (vmrss_after - vmrss_before)/1024.0, (vmsize_after - vmsize_before)/1024.0);
-    printf("=============================================\n\n");
+    if (verbose) {
+        printf("\n=== Performance Summary ===\n");
+        printf("Total time:              %.6f seconds\n", duration);
+        printf("  - DGETRF (LU):         %.6f s (%.1f%%)\n", 
+               dgetrf_time, dgetrf_time/duration*100);
+        printf("  - DGETRI (inversion):  %.6f s (%.1f%%)\n", 
+               dgetri_time, dgetri_time/duration*100);
+        printf("\n");
+        printf("FLOPs:\n");
+        printf("  - DGETRF:              %.2e (%.0f billion)\n", flops_dgetrf, flops_dgetrf/1.0e9);
+        printf("  - DGETRI:              %.2e (%.0f billion)\n", flops_dgetri, flops_dgetri/1.0e9);
+        printf("  - Total:               %.2e (%.0f billion)\n", total_flops, total_flops/1.0e9);
+        printf("\n");
+        printf("Performance:\n");
+        printf("  Overall GFLOPS:        %.2f\n", gflops);
+        printf("  DGETRF GFLOPS:         %.2f\n", gflops_dgetrf);
+        printf("  DGETRI GFLOPS:         %.2f\n", gflops_dgetri);
+        printf("  GFLOPS per thread:     %.2f (using %d threads)\n", gflops_per_thread, actual_threads);
+        printf("  Efficiency:            %.1f%% of theoretical peak per core\n", efficiency_percent);
+        printf("\n");
+        printf("Memory:\n");
+        printf("  Before: VmRSS=%.2f MB, VmSize=%.2f MB\n",
+               vmrss_before/1024.0, vmsize_before/1024.0);
+        printf("  After:  VmRSS=%.2f MB, VmSize=%.2f MB\n", 
+               vmrss_after/1024.0, vmsize_after/1024.0);
+        printf("  Delta:  VmRSS=%.2f MB, VmSize=%.2f MB\n",
+               (vmrss_after - vmrss_before)/1024.0, (vmsize_after - vmsize_before)/1024.0);
+        printf("=============================================\n\n");
+    }
     
     return ret;
 }
@@ -483,8 +493,10 @@ static lapack_int mat_inv_gauss_fallback(double *A, unsigned n)
     double *aug = NULL;
     unsigned cols = 2 * n;  // [A | I]
 
-    printf("=== Gauss-Jordan Fallback Inversion ===\n");
-    printf("Matrix size: %u x %u (sequential)\n", n, n);
+    if (log_on(LOG_INFO, LOG_LINALG)) {
+        printf("=== Gauss-Jordan Fallback Inversion ===\n");
+        printf("Matrix size: %u x %u (sequential)\n", n, n);
+    }
 
     if (A == NULL) {
         fprintf(stderr, "Gauss-Jordan fallback: A is NULL (n=%u)\n", n);
@@ -569,7 +581,8 @@ static lapack_int mat_inv_gauss_fallback(double *A, unsigned n)
 
     free(aug);
 
-    printf("Gauss-Jordan fallback: inversion complete (sequential).\n");
+    if (log_on(LOG_INFO, LOG_LINALG))
+        printf("Gauss-Jordan fallback: inversion complete (sequential).\n");
     return 0;
 }
 
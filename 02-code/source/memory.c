@@ -11,9 +11,11 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "memtrack_types.h"
 
 #include "co_matrix.h"
 #include "matrix.h"
+#include "memtrack.h"
 #include "ten_matrix.h"
 
 #include "memory.h"
@@ -25,8 +27,10 @@ bem_vectors *create_bem_vectors(bvv,bcv,N)
      int N;
 {
   bem_vectors *x;
+  int tag;
 
-  x=(bem_vectors *)malloc(sizeof(bem_vectors));
+  tag=set_memory_tag(MEM_VECTORS);     /* the matrices below are charged to it */
+  x=(bem_vectors *)tracked_malloc(sizeof(bem_vectors),-1);
   if(x==(bem_vectors *)NULL)
     {
       printf("error allocating memory for bem_vectors\n");
@@ -40,6 +44,7 @@ bem_vectors *create_bem_vectors(bvv,bcv,N)
   x->co_cgv=create_co_matrix(1,4*N);   /* current geometry vector 1st derivative */
   x->ten_vgv=create_ten_matrix(1,2*N); /* voltage geometry vector 2nd derivative */
   x->ten_cgv=create_ten_matrix(1,4*N); /* current geometry vector 2nd derivative */
+  set_memory_tag(tag);
   return(x);
 }
 
@@ -58,7 +63,7 @@ bem_vectors *destroy_bem_vectors(x)
       if(x->ten_vgv!=(ten_matrix *)NULL) destroy_ten_matrix(x->ten_vgv);
       if(x->ten_cgv!=(ten_matrix *)NULL) destroy_ten_matrix(x->ten_cgv);
     }
-  free((void *)x);
+  tracked_free((void *)x);
   return((bem_vectors *)NULL);
 }
 
@@ -0,0 +1,275 @@
+/*---------------------------------- memtrack.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* tracked allocations, charged to a subsystem and a phase                          */
+/*                                                                                  */
+/* tracked_malloc(bytes,tag) is malloc that also adds the block to the live bytes   */
+/* of subsystem tag (or, for tag<0, of the tag set on this thread by                */
+/* set_memory_tag, MEM_MATRIX unless set) and to the high-water marks of the phase  */
+/* set by set_memory_phase; tracked_free gives it back. The size and tag of each    */
+/* live block are kept in a hash table on its address, so a block that was not     */
+/* tracked can still be given to tracked_free (it is only freed). The tag is kept   */
+/* per thread (tile.c makes its vectors in a parallel region); the phase is set by  */
+/* the main thread only: solve_zone also runs on the tile and SCA threads, and      */
+/* there set_memory_phase leaves the phase alone. The table is under a critical     */
+/* section: the blocks are the matrices, paths and vectors, made a few at a time,   */
+/* not in the inner loops.                                                          */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <omp.h>
+/*----------------------------------------------------------------------------------*/
+#include "memtrack_types.h"
+
+#include "memtrack.h"
+/*----------------------------------------------------------------------------------*/
+#define TABLE_MIN 1024       /* slots of the table when it is first made */
+/*----------------------------------------------------------------------------------*/
+typedef struct {
+  void *p;                   /* NULL = empty slot */
+  long bytes;
+  int tag;
+} memory_block;
+/*----------------------------------------------------------------------------------*/
+static int tag=MEM_MATRIX;
+#pragma omp threadprivate(tag)
+static int phase=MEM_SETUP;
+
+static memory_totals tags[MEM_TAGS];
+static memory_totals total;
+static memory_phase phases[MEM_PHASES];
+
+static memory_block *table=(memory_block *)NULL;
+static long table_size=0;    /* a power of 2 */
+static long table_used=0;
+
+static char *tag_names[MEM_TAGS]={"Matrix","Path","Vectors","Solver","Zone"};
+static char *phase_names[MEM_PHASES]={"Setup","BEM","Solve","Finalization"};
+/*----------------------------------------------------------------------------------*/
+/* tag of the allocations of this thread; returns the one it replaces */
+/*----------------------------------------------------------------------------------*/
+int set_memory_tag(new_tag)
+     int new_tag;
+{
+  int old;
+
+  old=tag;
+  tag=new_tag;
+  return(old);
+}
+/*----------------------------------------------------------------------------------*/
+int get_memory_tag()
+{
+  return(tag);
+}
+/*----------------------------------------------------------------------------------*/
+/* phase of the allocations from now on; returns the one it replaces (on a thread   */
+/* other than the main one nothing is changed)                                      */
+/*----------------------------------------------------------------------------------*/
+int set_memory_phase(new_phase)
+     int new_phase;
+{
+  memory_phase *m;
+  int old,t;
+
+  if(omp_get_thread_num()!=0)
+    {
+#pragma omp atomic read
+      old=phase;
+      return(old);
+    }
+#pragma omp critical(memtrack)
+  {
+    old=phase;
+    phase=new_phase;
+    m=&phases[phase];
+    if(total.live>m->peak) m->peak=total.live;
+    for(t=0;t<MEM_TAGS;t++)
+      if(tags[t].live>m->tag_peak[t]) m->tag_peak[t]=tags[t].live;
+  }
+  return(old);
+}
+/*----------------------------------------------------------------------------------*/
+int get_memory_phase()
+{
+  return(phase);
+}
+/*----------------------------------------------------------------------------------*/
+char *memory_tag_name(t)
+     int t;
+{
+  return(tag_names[t]);
+}
+/*----------------------------------------------------------------------------------*/
+char *memory_phase_name(p)
+     int p;
+{
+  return(phase_names[p]);
+}
+/*----------------------------------------------------------------------------------*/
+memory_totals *get_memory_tag_totals(t)
+     int t;
+{
+  return(&tags[t]);
+}
+/*----------------------------------------------------------------------------------*/
+memory_totals *get_memory_totals()
+{
+  return(&total);
+}
+/*----------------------------------------------------------------------------------*/
+memory_phase *get_memory_phase_marks(p)
+     int p;
+{
+  return(&phases[p]);
+}
+/*----------------------------------------------------------------------------------*/
+/* the table (open addressing, linear probing) */
+/*----------------------------------------------------------------------------------*/
+static long slot_of(p)
+     void *p;
+{
+  uint64_t h;
+
+  h=(uint64_t)(uintptr_t)p;
+  h=(h>>4)*0x9E3779B97F4A7C15ULL;
+  return((long)(h>>20)&(table_size-1));
+}
+/*----------------------------------------------------------------------------------*/
+static long find_slot(p)
+     void *p;
+{
+  long s;
+
+  s=slot_of(p);
+  while(table[s].p!=NULL && table[s].p!=p) s=(s+1)&(table_size-1);
+  return(s);
+}
+/*----------------------------------------------------------------------------------*/
+static void grow_table()
+{
+  memory_block *old;
+  long old_size,i,s;
+
+  old=table;
+  old_size=table_size;
+  table_size=(table_size==0) ? TABLE_MIN : 2*table_size;
+  table=(memory_block *)calloc(table_size,sizeof(memory_block));
+  if(table==(memory_block *)NULL)
+    {
+      printf("error allocating memory for the allocation table\n");
+      exit(0);
+    }
+  for(i=0;i<old_size;i++)
+    if(old[i].p!=NULL)
+      {
+	s=find_slot(old[i].p);
+	table[s]=old[i];
+      }
+  free((void *)old);
+}
+/*----------------------------------------------------------------------------------*/
+/* take out slot s and move up the blocks after it that probed past it */
+/*----------------------------------------------------------------------------------*/
+static void remove_slot(s)
+     long s;
+{
+  long next,home;
+
+  table_used--;
+  next=s;
+  for(;;)
+    {
+      table[s].p=NULL;
+      for(;;)
+	{
+	  next=(next+1)&(table_size-1);
+	  if(table[next].p==NULL) return;
+	  home=slot_of(table[next].p);
+	  if((s<=next) ? (s<home && home<=next) : (s<home || home<=next)) continue;
+	  break;
+	}
+      table[s]=table[next];
+      s=next;
+    }
+}
+/*----------------------------------------------------------------------------------*/
+static void charge(b,sign)
+     memory_block *b;
+     int sign;
+{
+  memory_totals *t;
+  memory_phase *m;
+
+  t=&tags[b->tag];
+  if(sign>0)
+    {
+      t->allocations++;
+      total.allocations++;
+      phases[phase].allocations++;
+    }
+  else
+    {
+      t->frees++;
+      total.frees++;
+    }
+  t->live+=sign*b->bytes;
+  total.live+=sign*b->bytes;
+  if(t->live>t->peak) t->peak=t->live;
+  if(total.live>total.peak) total.peak=total.live;
+  m=&phases[phase];
+  if(total.live>m->peak) m->peak=total.live;
+  if(t->live>m->tag_peak[b->tag]) m->tag_peak[b->tag]=t->live;
+}
+/*----------------------------------------------------------------------------------*/
+/* malloc charged to subsystem t (t<0: the tag of this thread) */
+/*----------------------------------------------------------------------------------*/
+void *tracked_malloc(bytes,t)
+     size_t bytes;
+     int t;
+{
+  void *p;
+  long s;
+
+  p=malloc(bytes);
+  if(p==NULL) return(NULL);   /* the caller says what it was for */
+  if(t<0 || t>=MEM_TAGS) t=tag;
+
+#pragma omp critical(memtrack)
+  {
+    if(2*(table_used+1)>table_size) grow_table();
+    s=find_slot(p);
+    if(table[s].p==p)
+      charge(&table[s],-1);   /* freed without tracked_free and given out again */
+    else
+      table_used++;
+    table[s].p=p;
+    table[s].bytes=(long)bytes;
+    table[s].tag=t;
+    charge(&table[s],1);
+  }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+void tracked_free(p)
+     void *p;
+{
+  long s;
+
+  if(p==NULL) return;
+#pragma omp critical(memtrack)
+  {
+    if(table_size>0)
+      {
+	s=find_slot(p);
+	if(table[s].p==p)
+	  {
+	    charge(&table[s],-1);
+	    remove_slot(s);
+	  }
+      }
+  }
+  free(p);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,330 @@
+/*----------------------------------- merge.c --------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* reuse of the downstream part of streamlines already traced                       */
+/*                                                                                  */
+/* streamline_loop finds L = sum over zone visits of GH0*t, with GH0 = |dV| where   */
+/* the streamline enters the zone and t = integral of ds/|dV| in the zone. Every    */
+/* point of a traced streamline is kept in a spatial hash together with             */
+/*   zone     the catchment zone it is in                                           */
+/*   t_rest   integral of ds/|dV| from the point to where it leaves that zone       */
+/*   L_after  L of all the zone visits after that one                               */
+/* t_rest does not depend on GH0, so a new streamline that comes within tol of a    */
+/* kept point in the same zone stops there and uses                                 */
+/*   L = L_sum + GH0*(t_sum+t_rest) + L_after                                       */
+/* with its own L_sum, GH0 and t_sum. Points of the merged streamline are kept too. */
+/* tol<=0 (the default) switches merging off.                                       */
+/*                                                                                  */
+/* The table belongs to a catchment (by its points, so that copies of it held by   */
+/* different threads share one table) and a direction. The key of the points is    */
+/* found once per catchment and thread, and again after clear_merge_table (call it */
+/* when points of the paths have been changed). Streamlines may be traced from     */
+/* several threads at once: the streamline being traced is thread-private, and the */
+/* table is under a read-write lock, so the lookups of every step run side by side */
+/* and only a finished streamline (merge_end) or a new table waits for the others. */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+
+#include "merge.h"
+/*----------------------------------------------------------------------------------*/
+#define HASH_BITS 16
+#define HASH_SIZE (1<<HASH_BITS)
+/*----------------------------------------------------------------------------------*/
+static double tol=0.0;           /* merge distance; <=0 = off */
+static unsigned long table_key=0;
+static int table_direction=-1;
+static pthread_rwlock_t table_lock=PTHREAD_RWLOCK_INITIALIZER;
+
+/* key of the catchment last seen by this thread */
+static int generation=0;         /* changed by clear_merge_table */
+static catchment *key_c=(catchment *)NULL;
+static unsigned long key_value=0;
+static int key_generation=0;
+#pragma omp threadprivate(key_c,key_value,key_generation)
+
+/* points kept from finished streamlines */
+static int n_kept=0, max_kept=0;
+static coordinates *kept_xy=(coordinates *)NULL;
+static int *kept_zone=(int *)NULL;
+static double *kept_t_rest=(double *)NULL;
+static double *kept_L_after=(double *)NULL;
+static int *kept_next=(int *)NULL;   /* next point in the same hash bucket */
+static int bucket[HASH_SIZE];
+
+/* points and zone visits of the streamline being traced */
+static int n_now=0, max_now=0;
+static coordinates *now_xy=(coordinates *)NULL;
+static int *now_zone=(int *)NULL;
+static int *now_visit=(int *)NULL;
+static double *now_t=(double *)NULL;
+static int n_visit=0, max_visit=0;
+static double *visit_GH0=(double *)NULL;
+static double *visit_t=(double *)NULL;
+#pragma omp threadprivate(n_now,max_now,now_xy,now_zone,now_visit,now_t)
+#pragma omp threadprivate(n_visit,max_visit,visit_GH0,visit_t)
+/*----------------------------------------------------------------------------------*/
+static void *grow(p,n,size)
+     void *p;
+     int n,size;
+{
+  p=realloc(p,(size_t)n*size);
+  if(p==NULL)
+    {
+      printf("Cannot allocate memory for streamline merging\n");
+      exit(0);
+    }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+void set_merge_tolerance(t)
+     double t;
+{
+  tol=t;
+  clear_merge_table();
+}
+/*----------------------------------------------------------------------------------*/
+static void empty_table()
+{
+  int i;
+
+  n_kept=0;
+  for(i=0;i<HASH_SIZE;i++) bucket[i]=(-1);
+  table_key=0;
+  table_direction=(-1);
+}
+/*----------------------------------------------------------------------------------*/
+double get_merge_tolerance()
+{
+  return(tol);
+}
+/*----------------------------------------------------------------------------------*/
+void clear_merge_table()
+{
+  pthread_rwlock_wrlock(&table_lock);
+  empty_table();
+#pragma omp atomic
+  generation=generation+1;
+  pthread_rwlock_unlock(&table_lock);
+}
+/*----------------------------------------------------------------------------------*/
+static int hash_cell(ix,iy)
+     long ix,iy;
+{
+  unsigned long h;
+
+  h=(unsigned long)ix*0x9E3779B1UL+(unsigned long)iy*0x85EBCA77UL;
+  return((int)((h^(h>>HASH_BITS)) & (HASH_SIZE-1)));
+}
+/*----------------------------------------------------------------------------------*/
+/* hash of the points of all paths of a catchment (FNV-1a) */
+/*----------------------------------------------------------------------------------*/
+static unsigned long catchment_key(c)
+     catchment *c;
+{
+  unsigned long h;
+  unsigned char *byte;
+  int i,k;
+  size_t n;
+  path *p;
+
+  h=2166136261UL;
+  for(i=0;i<c->num_paths;i++)
+    {
+      p=c->path_list[i].path_p;
+      byte=(unsigned char *)p->xy;
+      n=(size_t)p->points*sizeof(coordinates);
+      for(k=0;k<n;k++) h=(h^byte[k])*16777619UL;
+    }
+  return((h==0) ? 1 : h);
+}
+/*----------------------------------------------------------------------------------*/
+/* start tracing a streamline of catchment c going in direction */
+/*----------------------------------------------------------------------------------*/
+void merge_begin(c,direction)
+     catchment *c;
+     int direction;
+{
+  unsigned long key;
+  int g;
+
+  if(tol<=0.0) return;
+#pragma omp atomic read
+  g=generation;
+  if(c!=key_c || g!=key_generation)
+    {
+      key_value=catchment_key(c);
+      key_c=c;
+      key_generation=g;
+    }
+  key=key_value;
+  pthread_rwlock_rdlock(&table_lock);
+  g=(key!=table_key || direction!=table_direction);
+  pthread_rwlock_unlock(&table_lock);
+  if(g)
+    {
+      pthread_rwlock_wrlock(&table_lock);
+      if(key!=table_key || direction!=table_direction)
+	{
+	  empty_table();
+	  table_key=key;
+	  table_direction=direction;
+	}
+      pthread_rwlock_unlock(&table_lock);
+    }
+  n_now=0;
+  n_visit=0;
+}
+/*----------------------------------------------------------------------------------*/
+/* the streamline enters a zone (or starts) with |dV|=GH0 */
+/*----------------------------------------------------------------------------------*/
+void merge_new_zone(GH0)
+     double GH0;
+{
+  if(tol<=0.0) return;
+  if(n_visit>=max_visit)
+    {
+      max_visit=2*max_visit+16;
+      visit_GH0=(double *)grow(visit_GH0,max_visit,sizeof(double));
+      visit_t=(double *)grow(visit_t,max_visit,sizeof(double));
+    }
+  visit_GH0[n_visit]=GH0;
+  visit_t[n_visit]=0.0;
+  n_visit=n_visit+1;
+}
+/*----------------------------------------------------------------------------------*/
+/* t integrated so far in the current zone visit */
+/*----------------------------------------------------------------------------------*/
+void merge_zone_time(t_sum)
+     double t_sum;
+{
+  if(tol<=0.0 || n_visit==0) return;
+  visit_t[n_visit-1]=t_sum;
+}
+/*----------------------------------------------------------------------------------*/
+/* accepted point P in zone with t_sum integrated since entering the zone */
+/*----------------------------------------------------------------------------------*/
+void merge_point(P,zone,t_sum)
+     coordinates P;
+     int zone;
+     double t_sum;
+{
+  if(tol<=0.0 || n_visit==0) return;
+  if(n_now>=max_now)
+    {
+      max_now=2*max_now+256;
+      now_xy=(coordinates *)grow(now_xy,max_now,sizeof(coordinates));
+      now_zone=(int *)grow(now_zone,max_now,sizeof(int));
+      now_visit=(int *)grow(now_visit,max_now,sizeof(int));
+      now_t=(double *)grow(now_t,max_now,sizeof(double));
+    }
+  now_xy[n_now][0]=P[0];
+  now_xy[n_now][1]=P[1];
+  now_zone[n_now]=zone;
+  now_visit[n_now]=n_visit-1;
+  now_t[n_now]=t_sum;
+  n_now=n_now+1;
+  visit_t[n_visit-1]=t_sum;
+}
+/*----------------------------------------------------------------------------------*/
+/* look for a kept point within tol of P in the same zone */
+/*----------------------------------------------------------------------------------*/
+int merge_lookup(P,zone,t_rest,L_after)
+     coordinates P;
+     int zone;
+     double *t_rest,*L_after;
+{
+  long ix,iy,jx,jy;
+  int k,best;
+  double d,dmin,dx,dy;
+
+  if(tol<=0.0) return(0);
+  ix=(long)floor(P[0]/tol);
+  iy=(long)floor(P[1]/tol);
+  best=(-1);
+  dmin=tol*tol;
+  pthread_rwlock_rdlock(&table_lock);
+  if(n_kept>0)
+    for(jx=ix-1;jx<=ix+1;jx++)
+      for(jy=iy-1;jy<=iy+1;jy++)
+	for(k=bucket[hash_cell(jx,jy)];k>=0;k=kept_next[k])
+	  {
+	    if(kept_zone[k]!=zone) continue;
+	    dx=kept_xy[k][0]-P[0];
+	    dy=kept_xy[k][1]-P[1];
+	    d=dx*dx+dy*dy;
+	    if(d<=dmin)
+	      {
+		dmin=d;
+		best=k;
+	      }
+	  }
+  if(best>=0)
+    {
+      (*t_rest)=kept_t_rest[best];
+      (*L_after)=kept_L_after[best];
+    }
+  pthread_rwlock_unlock(&table_lock);
+  return((best<0) ? 0 : 1);
+}
+/*----------------------------------------------------------------------------------*/
+/* streamline finished; t_tail and L_tail are what a merge added to the last zone  */
+/* visit and after it (0 if it did not merge). Its points go into the table.       */
+/*----------------------------------------------------------------------------------*/
+void merge_end(t_tail,L_tail)
+     double t_tail,L_tail;
+{
+  double *L_after;
+  int i,v,k;
+  long ix,iy;
+
+  if(tol<=0.0 || n_visit==0) return;
+  visit_t[n_visit-1]=visit_t[n_visit-1]+t_tail;
+
+  /* L of the visits after each visit */
+  L_after=(double *)malloc(n_visit*sizeof(double));
+  if(L_after==(double *)NULL)
+    {
+      printf("Cannot allocate memory for streamline merging\n");
+      exit(0);
+    }
+  L_after[n_visit-1]=L_tail;
+  for(v=n_visit-2;v>=0;v--)
+    L_after[v]=L_after[v+1]+visit_GH0[v+1]*visit_t[v+1];
+
+  pthread_rwlock_wrlock(&table_lock);
+  if(n_kept+n_now>max_kept)
+    {
+      max_kept=2*(n_kept+n_now)+1024;
+      kept_xy=(coordinates *)grow(kept_xy,max_kept,sizeof(coordinates));
+      kept_zone=(int *)grow(kept_zone,max_kept,sizeof(int));
+      kept_t_rest=(double *)grow(kept_t_rest,max_kept,sizeof(double));
+      kept_L_after=(double *)grow(kept_L_after,max_kept,sizeof(double));
+      kept_next=(int *)grow(kept_next,max_kept,sizeof(int));
+    }
+  for(i=0;i<n_now;i++)
+    {
+      k=n_kept;
+      v=now_visit[i];
+      kept_xy[k][0]=now_xy[i][0];
+      kept_xy[k][1]=now_xy[i][1];
+      kept_zone[k]=now_zone[i];
+      kept_t_rest[k]=visit_t[v]-now_t[i];
+      kept_L_after[k]=L_after[v];
+      ix=(long)floor(now_xy[i][0]/tol);
+      iy=(long)floor(now_xy[i][1]/tol);
+      kept_next[k]=bucket[hash_cell(ix,iy)];
+      bucket[hash_cell(ix,iy)]=k;
+      n_kept=n_kept+1;
+    }
+  pthread_rwlock_unlock(&table_lock);
+  free((void *)L_after);
+  n_now=0;
+  n_visit=0;
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,416 @@
+/*----------------------------------- packet.c -------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* streamlines from nearby mouth points traced together as a packet                 */
+/*                                                                                  */
+/* calculate_in_same_zone fills the geometry vectors of linear_sys.c for one point  */
+/* and multiplies them with bvv and bcv, so every point reads all the segments of   */
+/* the zone again. packet_field takes each segment once and, for all points of the  */
+/* packet, adds its terms times bvv and bcv straight into V, dV and d2V. Paths are  */
+/* not reversed in place (reverse_zone): the orientation is applied when reading    */
+/* the points, so packet_field only reads the catchment and is thread safe.         */
+/*                                                                                  */
+/* packet_streamline_loop follows up to MAX_PACKET streamlines with the fixed step  */
+/* of streamline_loop. Each step the lanes in the zone whose bem solution is in     */
+/* vectors are done by one packet_field. Lanes on a path, in another zone, or       */
+/* finished are masked out; when no lane is left in the solved zone the zone of     */
+/* the first waiting lane is solved. With --direction=newton the step directions   */
+/* of the lanes are found together by newton_follow_stream_batch.                   */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "logging_types.h"
+#include "stream_types.h"
+
+#include "catchment.h"
+#include "direction.h"
+#include "geometry.h"
+#include "linear_sys.h"
+#include "logging.h"
+#include "path.h"
+#include "rkstream.h"
+#include "stopping.h"
+#include "streamline.h"
+#include "terms.h"
+#include "vcalc.h"
+
+#include "packet.h"
+/*----------------------------------------------------------------------------------*/
+#define LANE_MOVE 0   /* has moved; check paths and zone */
+#define LANE_WAIT 1   /* zone known; waiting for its bem solution */
+#define LANE_DONE 2
+/*----------------------------------------------------------------------------------*/
+static int packet_size=1;   /* 1 = one streamline at a time (streamline_loop) */
+/*----------------------------------------------------------------------------------*/
+void set_packet_size(n)
+     int n;
+{
+  if(n<1 || n>MAX_PACKET)
+    {
+      printf("packet size %d must be from 1 to %d\n",n,MAX_PACKET);
+      exit(0);
+    }
+  packet_size=n;
+}
+/*----------------------------------------------------------------------------------*/
+int get_packet_size()
+{
+  return(packet_size);
+}
+/*----------------------------------------------------------------------------------*/
+/* point i of path p; flip=1 reads it reversed as reverse_path would */
+/*----------------------------------------------------------------------------------*/
+static void oriented_xy(p,flip,i,xy)
+     path *p;
+     int flip,i;
+     coordinates xy;
+{
+  i=i%p->points;
+  if((p->reverse^flip)!=0) i=p->points-1-i;
+  xy[0]=p->xy[i][0];
+  xy[1]=p->xy[i][1];
+}
+/*----------------------------------------------------------------------------------*/
+/* V, dV and d2V at n points of zone b from the solution bvv, bcv (thread safe) */
+/*----------------------------------------------------------------------------------*/
+void packet_field(b,bvv,bcv,n,P,R)
+     boundary *b;
+     double *bvv,*bcv;
+     int n;
+     coordinates *P;
+     bem_results *R;
+{
+  int i,k,flip,seg,offset;
+  double x,y1,y2,v0,v1,c0,c1,c2,c3,A[4];
+  coordinates Qa,Qb,C[4],D[4];
+  tensor T[4],U[4];
+  path *p;
+
+  for(i=0;i<n;i++)
+    {
+      R[i].V=0.0;
+      R[i].dV[0]=0.0;     R[i].dV[1]=0.0;
+      R[i].d2V[0][0]=0.0; R[i].d2V[0][1]=0.0;
+      R[i].d2V[1][0]=0.0; R[i].d2V[1][1]=0.0;
+    }
+
+  offset=0;
+  for(k=0;k<b->components;k++)
+    {
+      p=b->loop[k];
+      flip=((b->curve==0 && b->level[k]==1) || (b->curve==1 && b->level[k]==0)) ? 1 : 0;
+      for(seg=0;seg<p->points;seg++,offset++)
+	{
+	  oriented_xy(p,flip,seg,Qa);
+	  oriented_xy(p,flip,seg+1,Qb);
+	  v0=bvv[2*offset];   v1=bvv[2*offset+1];
+	  c0=bcv[4*offset];   c1=bcv[4*offset+1];
+	  c2=bcv[4*offset+2]; c3=bcv[4*offset+3];
+	  for(i=0;i<n;i++)
+	    {
+	      convert_PQ(Qa,Qb,P[i],&x,&y1,&y2);
+
+	      /* voltage: cgv.bcv - vgv.bvv */
+	      p2c_2basis(Vterm_PoffS(x,y1,y2),Wterm_PoffS(x,y1,y2),&A[0],&A[1]);
+	      R[i].V=R[i].V-A[0]*v0-A[1]*v1;
+	      p2c_4basis(Jterm_PoffS(x,y1,y2),Kterm_PoffS(x,y1,y2),
+			 Lterm_PoffS(x,y1,y2),Mterm_PoffS(x,y1,y2),
+			 &A[0],&A[1],&A[2],&A[3]);
+	      R[i].V=R[i].V+A[0]*c0+A[1]*c1+A[2]*c2+A[3]*c3;
+
+	      /* gradient */
+	      V1(x,y1,y2,C[2]);
+	      W1(x,y1,y2,C[3]);
+	      rotate_to_PQ(C[2][0],C[2][1],Qa,Qb,C[2]);
+	      rotate_to_PQ(C[3][0],C[3][1],Qa,Qb,C[3]);
+	      p2c_2basis_co(C[2],C[3],C[0],C[1]);
+	      R[i].dV[0]=R[i].dV[0]-C[0][0]*v0-C[1][0]*v1;
+	      R[i].dV[1]=R[i].dV[1]-C[0][1]*v0-C[1][1]*v1;
+	      J1(x,y1,y2,C[0]);
+	      K1(x,y1,y2,C[1]);
+	      L1(x,y1,y2,C[2]);
+	      M1(x,y1,y2,C[3]);
+	      rotate_to_PQ(C[0][0],C[0][1],Qa,Qb,C[0]);
+	      rotate_to_PQ(C[1][0],C[1][1],Qa,Qb,C[1]);
+	      rotate_to_PQ(C[2][0],C[2][1],Qa,Qb,C[2]);
+	      rotate_to_PQ(C[3][0],C[3][1],Qa,Qb,C[3]);
+	      p2c_4basis_co(C[0],C[1],C[2],C[3],D[0],D[1],D[2],D[3]);
+	      R[i].dV[0]=R[i].dV[0]+D[0][0]*c0+D[1][0]*c1+D[2][0]*c2+D[3][0]*c3;
+	      R[i].dV[1]=R[i].dV[1]+D[0][1]*c0+D[1][1]*c1+D[2][1]*c2+D[3][1]*c3;
+
+	      /* second derivatives */
+	      V2(x,y1,y2,T[2]);
+	      W2(x,y1,y2,T[3]);
+	      double_rotate_to_PQ(T[2][0][0],T[2][0][1],T[2][1][0],T[2][1][1],Qa,Qb,T[2]);
+	      double_rotate_to_PQ(T[3][0][0],T[3][0][1],T[3][1][0],T[3][1][1],Qa,Qb,T[3]);
+	      p2c_2basis_ten(T[2],T[3],T[0],T[1]);
+	      R[i].d2V[0][0]=R[i].d2V[0][0]-T[0][0][0]*v0-T[1][0][0]*v1;
+	      R[i].d2V[0][1]=R[i].d2V[0][1]-T[0][0][1]*v0-T[1][0][1]*v1;
+	      R[i].d2V[1][0]=R[i].d2V[1][0]-T[0][1][0]*v0-T[1][1][0]*v1;
+	      R[i].d2V[1][1]=R[i].d2V[1][1]-T[0][1][1]*v0-T[1][1][1]*v1;
+	      J2(x,y1,y2,T[0]);
+	      K2(x,y1,y2,T[1]);
+	      L2(x,y1,y2,T[2]);
+	      M2(x,y1,y2,T[3]);
+	      double_rotate_to_PQ(T[0][0][0],T[0][0][1],T[0][1][0],T[0][1][1],Qa,Qb,T[0]);
+	      double_rotate_to_PQ(T[1][0][0],T[1][0][1],T[1][1][0],T[1][1][1],Qa,Qb,T[1]);
+	      double_rotate_to_PQ(T[2][0][0],T[2][0][1],T[2][1][0],T[2][1][1],Qa,Qb,T[2]);
+	      double_rotate_to_PQ(T[3][0][0],T[3][0][1],T[3][1][0],T[3][1][1],Qa,Qb,T[3]);
+	      p2c_4basis_ten(T[0],T[1],T[2],T[3],U[0],U[1],U[2],U[3]);
+	      R[i].d2V[0][0]=R[i].d2V[0][0]+U[0][0][0]*c0+U[1][0][0]*c1+U[2][0][0]*c2+U[3][0][0]*c3;
+	      R[i].d2V[0][1]=R[i].d2V[0][1]+U[0][0][1]*c0+U[1][0][1]*c1+U[2][0][1]*c2+U[3][0][1]*c3;
+	      R[i].d2V[1][0]=R[i].d2V[1][0]+U[0][1][0]*c0+U[1][1][0]*c1+U[2][1][0]*c2+U[3][1][0]*c3;
+	      R[i].d2V[1][1]=R[i].d2V[1][1]+U[0][1][1]*c0+U[1][1][1]*c1+U[2][1][1]*c2+U[3][1][1]*c3;
+	    }
+	}
+    }
+
+  for(i=0;i<n;i++)
+    {
+      R[i].dV[0]=R[i].dV[0]/(2.0*M_PI);
+      R[i].dV[1]=R[i].dV[1]/(2.0*M_PI);
+      R[i].d2V[0][0]=R[i].d2V[0][0]/(2.0*M_PI);
+      R[i].d2V[0][1]=R[i].d2V[0][1]/(2.0*M_PI);
+      R[i].d2V[1][0]=R[i].d2V[1][0]/(2.0*M_PI);
+      R[i].d2V[1][1]=R[i].d2V[1][1]/(2.0*M_PI);
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/* n streamlines from P[0..n-1]; same steps and L as streamline_loop for each one.  */
+/* streamline[i] may be NULL. R gets the values at the starting points, L the       */
+/* lengths. Merging (merge.c) is not done here.                                     */
+/*----------------------------------------------------------------------------------*/
+void packet_streamline_loop(n,P,c,direction,max_steps,step_size,streamline,
+			    vectors,R,L)
+     int n;
+     coordinates *P;
+     catchment *c;
+     int direction; /* 1 = go to max; 0 = go to min */
+     int max_steps; /* +ve = number of steps; -ve = don't check */
+     double step_size;
+     path **streamline;
+     bem_vectors *vectors;
+     bem_results *R;
+     double *L;
+{
+  bem_results vol[MAX_PACKET],out[MAX_PACKET];
+  coordinates dP[MAX_PACKET],P_old[MAX_PACKET],Q[MAX_PACKET];
+  stream_stats stats[MAX_PACKET];
+  stop_tracker *tracker[MAX_PACKET];
+  int state[MAX_PACKET],zone[MAX_PACKET],last_zone[MAX_PACKET],j[MAX_PACKET];
+  int done[MAX_PACKET],lane[MAX_PACKET];
+  double r[MAX_PACKET],t_sum[MAX_PACKET],GH0[MAX_PACKET],L_sum[MAX_PACKET];
+  double G_old[MAX_PACKET];
+  double gx[MAX_PACKET],gy[MAX_PACKET],vxx[MAX_PACKET],vxy[MAX_PACKET],rk[MAX_PACKET];
+  double dx[MAX_PACKET],dy[MAX_PACKET];
+  int i,k,m,m_step,active,segment,reason,first;
+  double d,s,D,G;
+  path *this_path;
+
+  if(n>MAX_PACKET)
+    {
+      printf("packet of %d streamlines is more than %d\n",n,MAX_PACKET);
+      exit(0);
+    }
+  D=0.0005;
+  if(step_size<10.0*D)
+    {
+      printf("step size %f is too small\n",step_size);
+      step_size=10.0*D;
+      printf("changing step size to value = %f\n",step_size);
+    }
+  for(i=0;i<n;i++)
+    {
+      state[i]=LANE_MOVE;
+      last_zone[i]=(-1);
+      j[i]=0;
+      r[i]=step_size;
+      t_sum[i]=0.0;
+      GH0[i]=0.0;
+      L_sum[i]=0.0;
+      G_old[i]=0.0;
+      P_old[i][0]=P[i][0];
+      P_old[i][1]=P[i][1];
+      stats[i].rejected=0;
+      stats[i].new_zones=0;
+      stats[i].evaluations=0;
+      stats[i].reason=STOP_NONE;
+      tracker[i]=create_stop_tracker(max_steps);
+      start_stop_tracker(tracker[i],step_size);
+    }
+  active=n;
+
+  while(active>0)
+    {
+      /*-------- lanes that moved: on a path, outside or in which zone --------*/
+      for(i=0;i<n;i++)
+	{
+	  done[i]=0;
+	  if(state[i]!=LANE_MOVE) continue;
+	  reason=STOP_NONE;
+	  if(max_steps>=0 && j[i]>=max_steps) reason=STOP_MAX_STEPS;
+	  else
+	    {
+	      check_each_path(c,P[i],&d,&s,&segment,&this_path);
+	      if(d<D) /* on path: go back and take half the step */
+		{
+		  if(last_zone[i]<0)
+		    {
+		      printf("\n !warning : the start P is outside catchment\n ");
+		      printf("should to choose the new point P\n");
+		      exit(0);
+		    }
+		  r[i]=r[i]/2.0;
+		  stats[i].rejected=stats[i].rejected+1;
+		  P[i][0]=P[i][0]-dP[i][0];  P[i][1]=P[i][1]-dP[i][1];
+		  edit1_my_follow_stream(direction,P[i],vol[i].dV,vol[i].d2V,dP[i],r[i]);
+		  P[i][0]=P[i][0]+dP[i][0];  P[i][1]=P[i][1]+dP[i][1];
+		  continue;
+		}
+	      zone[i]=check_each_zone(c,P[i]);
+	      if(zone[i]<0) /* outside catchment */
+		{
+		  if(j[i]==0)
+		    {
+		      R[i].V=0.0;
+		      R[i].dV[0]=0.0;     R[i].dV[1]=0.0;
+		      R[i].d2V[0][0]=0.0; R[i].d2V[0][1]=0.0;
+		      R[i].d2V[1][0]=0.0; R[i].d2V[1][1]=0.0;
+		    }
+		  if(streamline[i]!=(path *)NULL) put_path_xy(streamline[i],j[i],P[i]);
+		  j[i]=j[i]+1;
+		  reason=STOP_OUTSIDE;
+		}
+	    }
+	  if(reason!=STOP_NONE)
+	    {
+	      stats[i].reason=reason;
+	      state[i]=LANE_DONE;
+	      active=active-1;
+	    }
+	  else state[i]=LANE_WAIT;
+	}
+
+      /*-------- solve a new zone if no lane is waiting for the solved one --------*/
+      first=(-1);
+      for(i=0;i<n;i++)
+	{
+	  if(state[i]!=LANE_WAIT) continue;
+	  if(zone[i]==c->previous_zone) { first=(-1); break; }
+	  if(first<0) first=i;
+	}
+      if(first>=0)
+	{
+	  c->previous_zone=zone[first];
+	  calculate_in_new_zone(c->zones[zone[first]],P[first],vectors,&vol[first],EVAL_ALL);
+	  done[first]=1;
+	}
+
+      /*-------- all lanes in the solved zone in one sweep --------*/
+      m=0;
+      for(i=0;i<n;i++)
+	{
+	  if(state[i]!=LANE_WAIT || done[i]==1 || zone[i]!=c->previous_zone) continue;
+	  Q[m][0]=P[i][0];
+	  Q[m][1]=P[i][1];
+	  lane[m]=i;
+	  m=m+1;
+	}
+      if(m>0)
+	{
+	  calculate_packet_in_zone(c->zones[c->previous_zone],m,Q,vectors,out);
+	  for(k=0;k<m;k++)
+	    {
+	      vol[lane[k]]=out[k];
+	      done[lane[k]]=1;
+	    }
+	}
+
+      /*-------- step the lanes that have new values --------*/
+      m_step=0;
+      for(i=0;i<n;i++)
+	{
+	  if(done[i]==0) continue;
+	  stats[i].evaluations=stats[i].evaluations+1;
+	  if(j[i]==0) R[i]=vol[i];
+	  G=sqrt(vol[i].dV[0]*vol[i].dV[0]+vol[i].dV[1]*vol[i].dV[1]);
+	  if(zone[i]!=last_zone[i] || j[i]==0) /* new zone or first time */
+	    {
+	      if(zone[i]!=last_zone[i]) stats[i].new_zones=stats[i].new_zones+1;
+	      L_sum[i]=L_sum[i]+t_sum[i]*GH0[i];
+	      t_sum[i]=0.0;
+	      GH0[i]=G;
+	      G_old[i]=G;
+	    }
+	  else
+	    {
+	      t_sum[i]=t_sum[i]+r[i]/2.0*(G+G_old[i])/(G*G_old[i]);
+	      G_old[i]=G;
+	      r[i]=step_size;
+	    }
+	  last_zone[i]=zone[i];
+	  if(streamline[i]!=(path *)NULL) put_path_xy(streamline[i],j[i],P[i]);
+	  reason=check_stop(tracker[i],P[i],G,
+			    sqrt((P[i][0]-P_old[i][0])*(P[i][0]-P_old[i][0])+
+				 (P[i][1]-P_old[i][1])*(P[i][1]-P_old[i][1])));
+	  j[i]=j[i]+1;
+	  if(reason!=STOP_NONE)
+	    {
+	      stats[i].reason=reason;
+	      state[i]=LANE_DONE;
+	      active=active-1;
+	      continue;
+	    }
+	  P_old[i][0]=P[i][0];  P_old[i][1]=P[i][1];
+	  lane[m_step++]=i;
+	}
+
+      /*-------- the step directions of those lanes --------*/
+      if(get_direction_method()==DIRECTION_NEWTON)
+	{
+	  for(k=0;k<m_step;k++)
+	    {
+	      i=lane[k];
+	      gx[k]=vol[i].dV[0];      gy[k]=vol[i].dV[1];
+	      vxx[k]=vol[i].d2V[0][0]; vxy[k]=vol[i].d2V[0][1];
+	      rk[k]=r[i];
+	    }
+	  newton_follow_stream_batch(direction,m_step,gx,gy,vxx,vxy,rk,dx,dy);
+	  for(k=0;k<m_step;k++)
+	    {
+	      dP[lane[k]][0]=dx[k];
+	      dP[lane[k]][1]=dy[k];
+	    }
+	}
+      else
+	for(k=0;k<m_step;k++)
+	  {
+	    i=lane[k];
+	    edit1_my_follow_stream(direction,P[i],vol[i].dV,vol[i].d2V,dP[i],r[i]);
+	  }
+      for(k=0;k<m_step;k++)
+	{
+	  i=lane[k];
+	  P[i][0]=P[i][0]+dP[i][0];  P[i][1]=P[i][1]+dP[i][1];
+	  state[i]=LANE_MOVE;
+	}
+    }
+
+  for(i=0;i<n;i++)
+    {
+      L[i]=L_sum[i]+t_sum[i]*GH0[i];
+      if(log_on(LOG_INFO,LOG_STREAM)) printf(" L=%.4f",L[i]);
+      tracker[i]=destroy_stop_tracker(tracker[i]);
+      stats[i].steps=j[i];
+      report_stream_stats(&stats[i]);
+      if(streamline[i]!=(path *)NULL) streamline[i]->points=j[i];
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -7,7 +7,10 @@
 #include <stdio.h>
 /*----------------------------------------------------------------------------------*/
 #include "boundary_types.h"
+#include "memtrack_types.h"
+
 #include "file.h"
+#include "memtrack.h"
 #include "path.h"
 /*----------------------------------------------------------------------------------*/
 /* create a path */
@@ -20,7 +23,7 @@ path *create_path(points,make_xy,make_value)
   double *values;
   coordinates *coordinate;
 
-  p=(path *)malloc(sizeof(path));
+  p=(path *)tracked_malloc(sizeof(path),MEM_PATH);
   if(p==(path *)NULL)
     {
       printf("error allocating memory for path\n");
@@ -31,7 +34,7 @@ path *create_path(points,make_xy,make_value)
   if(make_value==1)
     {
       
-      values=(double *)malloc(points*sizeof(double));
+      values=(double *)tracked_malloc(points*sizeof(double),MEM_PATH);
       if(values==(double *)NULL)
 	{
 	  printf("error allocating memory for path\n");
@@ -42,7 +45,7 @@ path *create_path(points,make_xy,make_value)
   coordinate=(coordinates  *)NULL;  /* give initial pointer */
   if(make_xy==1)
     {
-      coordinate=(coordinates *)malloc(points*sizeof(coordinates));
+      coordinate=(coordinates *)tracked_malloc(points*sizeof(coordinates),MEM_PATH);
       if(coordinate==(coordinates *)NULL)
 	{
 	  printf("error allocating memory for path\n");
@@ -74,9 +77,9 @@ path *destroy_path(x)
     }
 else
   {
-    if(x->value!=(double *)NULL)   free((void *)x->value);
-    if(x->xy!=(coordinates *)NULL) free((void *)x->xy);
-    if(x!=(path *)NULL) free((void *)x);
+    if(x->value!=(double *)NULL)   tracked_free((void *)x->value);
+    if(x->xy!=(coordinates *)NULL) tracked_free((void *)x->xy);
+    if(x!=(path *)NULL) tracked_free((void *)x);
   }
 
   return((void *)NULL);
@@ -0,0 +1,250 @@
+/*---------------------------------- perfcount.c -----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* hardware counters of the phases (perf_event_open, Linux only)                    */
+/*                                                                                  */
+/* With --perf=1 the counters are opened once for every thread already running (the */
+/* OpenBLAS threads are started before main) and with inherit for the threads      */
+/* started later (OpenMP), so a read is the count of the whole program. A piece of  */
+/* work is counted by                                                               */
+/*   perf_begin(&s); ... perf_end(&s,PERF_MULTIPLY,flops);                          */
+/* which adds the difference to the totals of the phase. Counts of the whole       */
+/* program mean nothing for work done by one thread of a parallel region, so       */
+/* perf_begin does not count there (the region as a whole is counted instead).      */
+/* User space only (exclude_kernel), which perf_event_paranoid<=2 allows. An event  */
+/* that cannot be opened (no PMU in a virtual machine, a locked down kernel) is     */
+/* left out and the rest is reported; with none at all the module turns itself off. */
+/* When there are more events than counters the kernel multiplexes them and the    */
+/* counts are scaled by the time each one ran.                                      */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <omp.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+/*----------------------------------------------------------------------------------*/
+#include "perfcount_types.h"
+
+#include "perfcount.h"
+/*----------------------------------------------------------------------------------*/
+static int counting=0;               /* --perf */
+static unsigned long fp_config=0;    /* raw event of the FP operations; 0 = none */
+static int n_tasks=0;
+static int fd[PERF_MAX_TASKS][PERF_EVENTS];
+static int counted[PERF_EVENTS];
+static char note[160]="";
+static perf_totals totals[PERF_PHASES];
+
+static char *event_names[PERF_EVENTS]=
+  {"cpu time","cycles","instructions","llc references","llc misses","fp ops"};
+static char *phase_names[PERF_PHASES]=
+  {"Setup","BEM","Multiply","Inversion","Tracing","Finalization"};
+/*----------------------------------------------------------------------------------*/
+void set_perf_counters(on)
+     int on;
+{
+  counting=on;
+}
+/*----------------------------------------------------------------------------------*/
+int get_perf_counters()
+{
+  return(counting);
+}
+/*----------------------------------------------------------------------------------*/
+void set_perf_fp_event(config)
+     unsigned long config;
+{
+  fp_config=config;
+}
+/*----------------------------------------------------------------------------------*/
+unsigned long get_perf_fp_event()
+{
+  return(fp_config);
+}
+/*----------------------------------------------------------------------------------*/
+char *get_perf_note()
+{
+  return(note);
+}
+/*----------------------------------------------------------------------------------*/
+int perf_event_counted(event)
+     int event;
+{
+  return(counting && counted[event]);
+}
+/*----------------------------------------------------------------------------------*/
+char *perf_event_name(event)
+     int event;
+{
+  return(event_names[event]);
+}
+/*----------------------------------------------------------------------------------*/
+char *perf_phase_name(phase)
+     int phase;
+{
+  return(phase_names[phase]);
+}
+/*----------------------------------------------------------------------------------*/
+perf_totals *get_perf_phase(phase)
+     int phase;
+{
+  return(&totals[phase]);
+}
+/*----------------------------------------------------------------------------------*/
+static void event_attr(event,attr)
+     int event;
+     struct perf_event_attr *attr;
+{
+  memset(attr,0,sizeof(struct perf_event_attr));
+  attr->size=sizeof(struct perf_event_attr);
+  attr->type=PERF_TYPE_HARDWARE;
+  switch(event)
+    {
+    case PERF_TASK_CLOCK:
+      attr->type=PERF_TYPE_SOFTWARE;
+      attr->config=PERF_COUNT_SW_TASK_CLOCK;
+      break;
+    case PERF_CYCLES:       attr->config=PERF_COUNT_HW_CPU_CYCLES; break;
+    case PERF_INSTRUCTIONS: attr->config=PERF_COUNT_HW_INSTRUCTIONS; break;
+    case PERF_LLC_REFS:     attr->config=PERF_COUNT_HW_CACHE_REFERENCES; break;
+    case PERF_LLC_MISSES:   attr->config=PERF_COUNT_HW_CACHE_MISSES; break;
+    case PERF_FP_OPS:
+      attr->type=PERF_TYPE_RAW;
+      attr->config=fp_config;
+      break;
+    }
+  attr->inherit=1;
+  attr->exclude_kernel=1;
+  attr->exclude_hv=1;
+  attr->read_format=PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+}
+/*----------------------------------------------------------------------------------*/
+/* counters for every thread in /proc/self/task; returns the number of events      */
+/* counted (0 if none, and then the module is off)                                  */
+/*----------------------------------------------------------------------------------*/
+int open_perf_counters()
+{
+  struct perf_event_attr attr;
+  DIR *dir;
+  struct dirent *entry;
+  int tid[PERF_MAX_TASKS],e,i,n,first_errno;
+  char *p;
+
+  if(!counting) return(0);
+  n_tasks=0;
+  dir=opendir("/proc/self/task");
+  if(dir!=(DIR *)NULL)
+    {
+      while((entry=readdir(dir))!=(struct dirent *)NULL && n_tasks<PERF_MAX_TASKS)
+	if(entry->d_name[0]!='.') tid[n_tasks++]=atoi(entry->d_name);
+      closedir(dir);
+    }
+  if(n_tasks==0) tid[n_tasks++]=0;
+
+  n=0;
+  first_errno=0;
+  for(e=0;e<PERF_EVENTS;e++)
+    {
+      counted[e]=0;
+      for(i=0;i<n_tasks;i++) fd[i][e]=-1;
+      if(e==PERF_FP_OPS && fp_config==0) continue;
+      event_attr(e,&attr);
+      for(i=0;i<n_tasks;i++)
+	{
+	  fd[i][e]=(int)syscall(__NR_perf_event_open,&attr,tid[i],-1,-1,0);
+	  if(fd[i][e]<0 && i==0) break;  /* a thread that has just ended is no matter */
+	}
+      if(fd[0][e]<0)
+	{
+	  if(first_errno==0) first_errno=errno;
+	  continue;
+	}
+      counted[e]=1;
+      n=n+1;
+    }
+
+  if(n==0)
+    {
+      sprintf(note,"not available (perf_event_open: %s; see "
+	      "/proc/sys/kernel/perf_event_paranoid)",strerror(first_errno));
+      counting=0;
+      return(0);
+    }
+  p=note;
+  p=p+sprintf(p,"%d thread%s:",n_tasks,(n_tasks==1) ? "" : "s");
+  for(e=0;e<PERF_EVENTS;e++)
+    if(counted[e]) p=p+sprintf(p," %s,",event_names[e]);
+  p[-1]='\0';
+  if(first_errno!=0)
+    sprintf(p-1," (some not available: %s)",strerror(first_errno));
+  memset(totals,0,sizeof(totals));
+  return(n);
+}
+/*----------------------------------------------------------------------------------*/
+void close_perf_counters()
+{
+  int e,i;
+
+  for(e=0;e<PERF_EVENTS;e++)
+    for(i=0;i<n_tasks;i++)
+      if(fd[i][e]>=0)
+	{
+	  close(fd[i][e]);
+	  fd[i][e]=-1;
+	}
+  n_tasks=0;
+}
+/*----------------------------------------------------------------------------------*/
+/* count of an event over all threads, scaled up if it was multiplexed */
+/*----------------------------------------------------------------------------------*/
+static double read_event(e)
+     int e;
+{
+  unsigned long long value[3];
+  double sum;
+  int i;
+
+  sum=0.0;
+  for(i=0;i<n_tasks;i++)
+    {
+      if(fd[i][e]<0) continue;
+      if(read(fd[i][e],value,sizeof(value))!=sizeof(value)) continue;
+      if(value[2]==0) continue;
+      sum=sum+(double)value[0]*((double)value[1]/(double)value[2]);
+    }
+  return(sum);
+}
+/*----------------------------------------------------------------------------------*/
+void perf_begin(s)
+     perf_sample *s;
+{
+  int e;
+
+  s->t=-1.0;
+  if(!counting || omp_in_parallel()) return;
+  for(e=0;e<PERF_EVENTS;e++)
+    if(counted[e]) s->count[e]=read_event(e);
+  s->t=omp_get_wtime();
+}
+/*----------------------------------------------------------------------------------*/
+void perf_end(s,phase,flops)
+     perf_sample *s;
+     int phase;
+     double flops;
+{
+  perf_totals *t;
+  int e;
+
+  if(s->t<0.0) return;
+  t=&totals[phase];
+  t->seconds=t->seconds+omp_get_wtime()-s->t;
+  for(e=0;e<PERF_EVENTS;e++)
+    if(counted[e]) t->count[e]=t->count[e]+read_event(e)-s->count[e];
+  t->flops=t->flops+flops;
+  t->calls=t->calls+1;
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
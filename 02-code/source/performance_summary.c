@@ -22,7 +22,13 @@
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include "perfcount_types.h"
+#include "memtrack_types.h"
+#include "boundary_types.h"
+#include "stream_types.h"
 #include "performance_summary.h"
+#include "memtrack.h"
+#include "perfcount.h"
 
 /*******************************************************************************
  * Global Performance Summary
@@ -40,6 +46,7 @@ void init_performance_summary(void) {
     g_perf_summary.inversion_method  = -1;
     g_perf_summary.num_threads       = -1;
     g_perf_summary.block_size        = -1;
+    g_perf_summary.stream_method     = -1;
 }
 
 /*******************************************************************************
@@ -144,6 +151,17 @@ void update_memory_usage(long vmrss_kb, long vmsize_kb) {
     g_perf_summary.final_memory_kb = vmrss_kb;
 }
 
+void update_streamline_stats(int steps, int rejected, long evaluations,
+                             int reason) {
+    g_perf_summary.num_streamlines++;
+    g_perf_summary.stream_steps    += steps;
+    g_perf_summary.stream_rejected += rejected;
+    g_perf_summary.bem_evaluations += evaluations;
+    if (reason >= 0 && reason < STOP_REASONS) {
+        g_perf_summary.stop_counts[reason]++;
+    }
+}
+
 void set_performance_config(int multiply_method, int inversion_method,
                             int num_threads, int block_size) {
     g_perf_summary.multiply_method  = multiply_method;
@@ -161,10 +179,167 @@ void set_problem_parameters(double step, double rm, double dr,
     g_perf_summary.max_points = points;
 }
 
+void set_stream_config(int stream_method) {
+    g_perf_summary.stream_method = stream_method;
+}
+
+void set_catchment_area_result(double area) {
+    g_perf_summary.catchment_area = area;
+}
+
 /*******************************************************************************
  * Print Functions
  ******************************************************************************/
 
+/* Counters of each phase that was counted (perfcount.c); "n/a" where the event
+ * could not be opened. Flop rates are measured with --perf-fp, otherwise they
+ * come from the flop counts of the model (2mnk, 2n^3/3). */
+static void print_hardware_counters(void) {
+    int phase;
+    int has_ipc  = perf_event_counted(PERF_CYCLES) && perf_event_counted(PERF_INSTRUCTIONS);
+    int has_llc  = perf_event_counted(PERF_LLC_REFS) && perf_event_counted(PERF_LLC_MISSES);
+    int has_fp   = perf_event_counted(PERF_FP_OPS);
+    int has_time = perf_event_counted(PERF_TASK_CLOCK);
+
+    printf("═══════════════════════════════════════════════════════════════════════════════\n");
+    printf("HARDWARE COUNTERS:\n");
+    printf("═══════════════════════════════════════════════════════════════════════════════\n");
+    printf("  Counters:               %s\n", get_perf_note());
+    printf("  Phase          Calls    Time (s)     CPU (s)     IPC   LLC miss   GFLOP/s\n");
+    printf("  ─────────────────────────────────────────────────────────────────────────────\n");
+
+    for (phase = 0; phase < PERF_PHASES; phase++) {
+        perf_totals *t = get_perf_phase(phase);
+        if (t->calls == 0) continue;
+
+        printf("  %-13s %6ld  %10.4f", perf_phase_name(phase), t->calls, t->seconds);
+        if (has_time)
+            printf("  %10.4f", t->count[PERF_TASK_CLOCK] / 1e9);
+        else
+            printf("  %10s", "n/a");
+        if (has_ipc && t->count[PERF_CYCLES] > 0.0)
+            printf("  %6.2f", t->count[PERF_INSTRUCTIONS] / t->count[PERF_CYCLES]);
+        else
+            printf("  %6s", "n/a");
+        if (has_llc && t->count[PERF_LLC_REFS] > 0.0)
+            printf("  %8.2f%%", 100.0 * t->count[PERF_LLC_MISSES] / t->count[PERF_LLC_REFS]);
+        else
+            printf("  %9s", "n/a");
+        if (has_fp && t->seconds > 0.0)
+            printf("  %8.2f\n", t->count[PERF_FP_OPS] / t->seconds / 1e9);
+        else if (t->flops > 0.0 && t->seconds > 0.0)
+            printf("  %8.2f*\n", t->flops / t->seconds / 1e9);
+        else
+            printf("  %8s\n", "n/a");
+    }
+    if (!has_fp)
+        printf("  * from the flop count of the model (no FP event, see --perf-fp)\n");
+    if (has_time)
+        printf("  CPU (s) is the time of all threads; CPU/Time is the parallelism reached\n");
+    printf("\n");
+}
+
+/* Bytes of the tracked allocations (memtrack.c) of each subsystem, and the
+ * high-water marks reached in each phase. Live is what is still allocated
+ * when the summary is printed. */
+static void print_memory_subsystems(void) {
+    int t, phase;
+    memory_totals *m;
+    memory_phase *p;
+
+    printf("  Subsystem        Allocs      Frees     Live (MB)     Peak (MB)\n");
+    printf("  ─────────────────────────────────────────────────────────────────────────────\n");
+    for (t = 0; t < MEM_TAGS; t++) {
+        m = get_memory_tag_totals(t);
+        printf("  %-12s %10ld %10ld  %12.3f  %12.3f\n", memory_tag_name(t),
+               m->allocations, m->frees, m->live / 1048576.0, m->peak / 1048576.0);
+    }
+    m = get_memory_totals();
+    printf("  %-12s %10ld %10ld  %12.3f  %12.3f\n", "Total",
+           m->allocations, m->frees, m->live / 1048576.0, m->peak / 1048576.0);
+    printf("\n");
+
+    printf("  Phase            Allocs     Peak (MB)   ");
+    for (t = 0; t < MEM_TAGS; t++) printf("%9s", memory_tag_name(t));
+    printf("\n");
+    printf("  ─────────────────────────────────────────────────────────────────────────────\n");
+    for (phase = 0; phase < MEM_PHASES; phase++) {
+        p = get_memory_phase_marks(phase);
+        printf("  %-12s %10ld  %12.3f   ", memory_phase_name(phase),
+               p->allocations, p->peak / 1048576.0);
+        for (t = 0; t < MEM_TAGS; t++) printf("%9.3f", p->tag_peak[t] / 1048576.0);
+        printf("\n");
+    }
+    printf("  (peak of each subsystem in MB)\n");
+}
+
+/* Same numbers as print_memory_subsystems, one CSV line each */
+static void export_memory_subsystems(FILE *fp) {
+    int t, phase;
+    memory_totals *m;
+    memory_phase *p;
+
+    for (t = 0; t <= MEM_TAGS; t++) {
+        const char *name = (t < MEM_TAGS) ? memory_tag_name(t) : "Total";
+        m = (t < MEM_TAGS) ? get_memory_tag_totals(t) : get_memory_totals();
+        fprintf(fp, "Mem_%s_Allocations,%ld\n", name, m->allocations);
+        fprintf(fp, "Mem_%s_Frees,%ld\n", name, m->frees);
+        fprintf(fp, "Mem_%s_Live_Bytes,%ld\n", name, m->live);
+        fprintf(fp, "Mem_%s_Peak_Bytes,%ld\n", name, m->peak);
+    }
+    for (phase = 0; phase < MEM_PHASES; phase++) {
+        const char *name = memory_phase_name(phase);
+        p = get_memory_phase_marks(phase);
+        fprintf(fp, "Mem_%s_Allocations,%ld\n", name, p->allocations);
+        fprintf(fp, "Mem_%s_Peak_Bytes,%ld\n", name, p->peak);
+        for (t = 0; t < MEM_TAGS; t++)
+            fprintf(fp, "Mem_%s_%s_Peak_Bytes,%ld\n", name, memory_tag_name(t), p->tag_peak[t]);
+    }
+}
+
+/* Same numbers as print_hardware_counters, one CSV line each */
+static void export_hardware_counters(FILE *fp) {
+    int phase, e;
+    const char *event_keys[PERF_EVENTS] =
+        {"CPU_sec", "Cycles", "Instructions", "LLC_References", "LLC_Misses", "FP_Ops"};
+
+    for (phase = 0; phase < PERF_PHASES; phase++) {
+        perf_totals *t = get_perf_phase(phase);
+        const char *name = perf_phase_name(phase);
+        if (t->calls == 0) continue;
+
+        fprintf(fp, "Perf_%s_Calls,%ld\n", name, t->calls);
+        fprintf(fp, "Perf_%s_Time_sec,%.6f\n", name, t->seconds);
+        for (e = 0; e < PERF_EVENTS; e++) {
+            if (!perf_event_counted(e)) continue;
+            if (e == PERF_TASK_CLOCK)
+                fprintf(fp, "Perf_%s_%s,%.6f\n", name, event_keys[e], t->count[e] / 1e9);
+            else
+                fprintf(fp, "Perf_%s_%s,%.0f\n", name, event_keys[e], t->count[e]);
+        }
+        if (perf_event_counted(PERF_CYCLES) && perf_event_counted(PERF_INSTRUCTIONS) &&
+            t->count[PERF_CYCLES] > 0.0)
+            fprintf(fp, "Perf_%s_IPC,%.4f\n", name,
+                    t->count[PERF_INSTRUCTIONS] / t->count[PERF_CYCLES]);
+        if (perf_event_counted(PERF_LLC_REFS) && perf_event_counted(PERF_LLC_MISSES) &&
+            t->count[PERF_LLC_REFS] > 0.0)
+            fprintf(fp, "Perf_%s_LLC_Miss_Rate,%.6f\n", name,
+                    t->count[PERF_LLC_MISSES] / t->count[PERF_LLC_REFS]);
+        if (perf_event_counted(PERF_LLC_MISSES) && perf_event_counted(PERF_INSTRUCTIONS) &&
+            t->count[PERF_INSTRUCTIONS] > 0.0)
+            fprintf(fp, "Perf_%s_LLC_MPKI,%.4f\n", name,
+                    1000.0 * t->count[PERF_LLC_MISSES] / t->count[PERF_INSTRUCTIONS]);
+        if (t->seconds > 0.0) {
+            if (perf_event_counted(PERF_FP_OPS))
+                fprintf(fp, "Perf_%s_GFLOPS,%.4f\n", name,
+                        t->count[PERF_FP_OPS] / t->seconds / 1e9);
+            if (t->flops > 0.0)
+                fprintf(fp, "Perf_%s_Model_GFLOPS,%.4f\n", name,
+                        t->flops / t->seconds / 1e9);
+        }
+    }
+}
+
 void print_performance_summary(void) {
     /* Total wall-clock time for the whole program */
     g_perf_summary.total_time =
@@ -277,6 +452,37 @@ void print_performance_summary(void) {
     printf("  Matrix Inversion calls:              %d\n", g_perf_summary.num_inversions);
     printf("\n");
 
+    /***** Streamline Integration *****/
+    const char *stream_methods[] = {"Fixed step", "Taylor 2(1)", "Dormand-Prince 5(4)"};
+
+    printf("═══════════════════════════════════════════════════════════════════════════════\n");
+    printf("STREAMLINE INTEGRATION:\n");
+    printf("═══════════════════════════════════════════════════════════════════════════════\n");
+    if (g_perf_summary.stream_method >= 0 &&
+        g_perf_summary.stream_method <= 2) {
+        printf("  Integrator:                          %d (%s)\n",
+               g_perf_summary.stream_method,
+               stream_methods[g_perf_summary.stream_method]);
+    }
+    printf("  Streamlines traced:                  %d\n", g_perf_summary.num_streamlines);
+    printf("  Accepted steps:                      %ld\n", g_perf_summary.stream_steps);
+    printf("  Rejected steps:                      %ld\n", g_perf_summary.stream_rejected);
+    printf("  BEM evaluations:                     %ld\n", g_perf_summary.bem_evaluations);
+    if (g_perf_summary.num_streamlines > 0) {
+        printf("  Average evaluations per streamline:  %.1f\n",
+               (double)g_perf_summary.bem_evaluations /
+               g_perf_summary.num_streamlines);
+    }
+    printf("  Ended by: left catchment %d, max steps %d, flat %d, stalled %d, loop %d,\n"
+           "            merged %d\n",
+           g_perf_summary.stop_counts[STOP_OUTSIDE],
+           g_perf_summary.stop_counts[STOP_MAX_STEPS],
+           g_perf_summary.stop_counts[STOP_FLAT],
+           g_perf_summary.stop_counts[STOP_STALLED],
+           g_perf_summary.stop_counts[STOP_LOOP],
+           g_perf_summary.stop_counts[STOP_MERGED]);
+    printf("\n");
+
     /***** Performance Metrics *****/
     printf("═══════════════════════════════════════════════════════════════════════════════\n");
     printf("PERFORMANCE METRICS:\n");
@@ -301,15 +507,24 @@ void print_performance_summary(void) {
 
     printf("\n");
 
+    /***** Hardware Counters (--perf) *****/
+    if (get_perf_counters()) {
+        print_hardware_counters();
+    }
+
     /***** Memory Usage *****/
     printf("═══════════════════════════════════════════════════════════════════════════════\n");
     printf("MEMORY USAGE:\n");
     printf("═══════════════════════════════════════════════════════════════════════════════\n");
     printf("  Peak allocated (tracked):            %.2f MB\n",
-           (g_perf_summary.peak_memory_kb -
-            g_perf_summary.initial_memory_kb) / 1024.0);
+           get_memory_totals()->peak / 1048576.0);
     printf("  VmRSS (resident set):                %.2f MB\n",
            g_perf_summary.peak_memory_kb / 1024.0);
+    printf("  VmRSS growth:                        %.2f MB\n",
+           (g_perf_summary.peak_memory_kb -
+            g_perf_summary.initial_memory_kb) / 1024.0);
+    printf("\n");
+    print_memory_subsystems();
     printf("\n");
 
     printf("################################################################################\n");
@@ -422,11 +637,29 @@ void export_performance_csv(const char *filename) {
     fprintf(fp, "Finalization_Time_sec,%.6f\n", g_perf_summary.finalization_time);
     fprintf(fp, "Num_Multiplications,%d\n",     g_perf_summary.num_multiplications);
     fprintf(fp, "Num_Inversions,%d\n",          g_perf_summary.num_inversions);
+    fprintf(fp, "Stream_Method,%d\n",           g_perf_summary.stream_method);
+    fprintf(fp, "Num_Streamlines,%d\n",         g_perf_summary.num_streamlines);
+    fprintf(fp, "Stream_Steps,%ld\n",           g_perf_summary.stream_steps);
+    fprintf(fp, "Stream_Rejected,%ld\n",        g_perf_summary.stream_rejected);
+    fprintf(fp, "BEM_Evaluations,%ld\n",        g_perf_summary.bem_evaluations);
+    fprintf(fp, "Stop_Outside,%d\n",            g_perf_summary.stop_counts[STOP_OUTSIDE]);
+    fprintf(fp, "Stop_Max_Steps,%d\n",          g_perf_summary.stop_counts[STOP_MAX_STEPS]);
+    fprintf(fp, "Stop_Flat,%d\n",               g_perf_summary.stop_counts[STOP_FLAT]);
+    fprintf(fp, "Stop_Stalled,%d\n",            g_perf_summary.stop_counts[STOP_STALLED]);
+    fprintf(fp, "Stop_Loop,%d\n",               g_perf_summary.stop_counts[STOP_LOOP]);
+    fprintf(fp, "Stop_Merged,%d\n",             g_perf_summary.stop_counts[STOP_MERGED]);
     fprintf(fp, "Multiply_GFLOPS,%.2f\n",       g_perf_summary.multiply_gflops);
     fprintf(fp, "Inversion_GFLOPS,%.2f\n",      g_perf_summary.inversion_gflops);
     fprintf(fp, "Initial_Memory_MB,%.2f\n",     g_perf_summary.initial_memory_kb / 1024.0);
     fprintf(fp, "Peak_Memory_MB,%.2f\n",        g_perf_summary.peak_memory_kb / 1024.0);
     fprintf(fp, "Final_Memory_MB,%.2f\n",       g_perf_summary.final_memory_kb / 1024.0);
+    fprintf(fp, "Num_Zones,%d\n",               g_perf_summary.num_zones);
+    fprintf(fp, "Max_Points,%d\n",              g_perf_summary.max_points);
+    fprintf(fp, "Catchment_Area,%.6f\n",        g_perf_summary.catchment_area);
+    export_memory_subsystems(fp);
+    if (get_perf_counters()) {
+        export_hardware_counters(fp);
+    }
 
     fclose(fp);
 
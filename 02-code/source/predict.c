@@ -0,0 +1,122 @@
+/*---------------------------------- predict.c -------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* gradient predictor for the fixed step streamlines                                */
+/*                                                                                  */
+/* After an exact evaluation at P0 the field at a nearby P in the same zone is      */
+/* taken from the Taylor expansion                                                  */
+/*   dV(P) = dV(P0) + d2V(P0).(P-P0)                                                */
+/*   V(P)  = V(P0) + dV(P0).(P-P0) + (P-P0).d2V(P0).(P-P0)/2                        */
+/* for up to k steps. An exact evaluation is done on the k+1-th step, or earlier    */
+/* when the predicted change of the gradient |d2V.(P-P0)| is more than a quarter of */
+/* |dV(P0)|. Each exact evaluation after predicted steps measures the error the    */
+/* expansion from P0 would have at its point, |dV - dV_predicted|/|dV|; k is       */
+/* halved when it is above tol and grows by one (up to max_k) when it is below     */
+/* tol/4. max_k<=0 (the default) switches prediction off.                          */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "predict_types.h"
+
+#include "predict.h"
+/*----------------------------------------------------------------------------------*/
+#define MAX_CHANGE 0.25   /* largest predicted relative change of dV */
+/*----------------------------------------------------------------------------------*/
+static int max_k=0;           /* <=0 = off */
+static double tol=0.01;       /* relative error of dV allowed in a prediction */
+/*----------------------------------------------------------------------------------*/
+void set_predictor(k,t)
+     int k;
+     double t;
+{
+  max_k=k;
+  tol=t;
+}
+/*----------------------------------------------------------------------------------*/
+void get_predictor(k,t)
+     int *k;
+     double *t;
+{
+  (*k)=max_k;
+  (*t)=tol;
+}
+/*----------------------------------------------------------------------------------*/
+void start_predictor(p)
+     predictor *p;
+{
+  p->k=(max_k>0) ? 1 : 0;
+  p->skipped=0;
+  p->anchored=0;
+  p->predicted=0;
+}
+/*----------------------------------------------------------------------------------*/
+/* field at P from the last exact evaluation; returns 0 if P needs an exact one */
+/*----------------------------------------------------------------------------------*/
+int predict_field(p,P,R)
+     predictor *p;
+     coordinates P;
+     bem_results *R;
+{
+  bem_results *e;
+  double dx,dy,g,dg[2];
+
+  if(max_k<=0 || p->anchored==0 || p->skipped>=p->k) return(0);
+  e=&p->R0;
+  dx=P[0]-p->P0[0];
+  dy=P[1]-p->P0[1];
+  dg[0]=e->d2V[0][0]*dx+e->d2V[0][1]*dy;
+  dg[1]=e->d2V[1][0]*dx+e->d2V[1][1]*dy;
+  g=e->dV[0]*e->dV[0]+e->dV[1]*e->dV[1];
+  if(dg[0]*dg[0]+dg[1]*dg[1]>MAX_CHANGE*MAX_CHANGE*g) return(0);
+
+  R->V=e->V+e->dV[0]*dx+e->dV[1]*dy+0.5*(dg[0]*dx+dg[1]*dy);
+  R->dV[0]=e->dV[0]+dg[0];
+  R->dV[1]=e->dV[1]+dg[1];
+  R->d2V[0][0]=e->d2V[0][0];  R->d2V[0][1]=e->d2V[0][1];
+  R->d2V[1][0]=e->d2V[1][0];  R->d2V[1][1]=e->d2V[1][1];
+  p->skipped=p->skipped+1;
+  p->predicted=p->predicted+1;
+  return(1);
+}
+/*----------------------------------------------------------------------------------*/
+/* exact evaluation R at P; same=1 if P is in the zone of the last one */
+/*----------------------------------------------------------------------------------*/
+void correct_predictor(p,P,R,same)
+     predictor *p;
+     coordinates P;
+     bem_results *R;
+     int same;
+{
+  bem_results *r;
+  double dx,dy,g,e,ex,ey;
+
+  if(max_k<=0) return;
+  if(same==1 && p->anchored==1 && p->skipped>0)
+    {
+      /* the prediction from P0 at P, against the exact dV */
+      r=&p->R0;
+      dx=P[0]-p->P0[0];
+      dy=P[1]-p->P0[1];
+      ex=r->dV[0]+r->d2V[0][0]*dx+r->d2V[0][1]*dy-R->dV[0];
+      ey=r->dV[1]+r->d2V[1][0]*dx+r->d2V[1][1]*dy-R->dV[1];
+      g=sqrt(R->dV[0]*R->dV[0]+R->dV[1]*R->dV[1]);
+      e=sqrt(ex*ex+ey*ey);
+      if(e>tol*g)
+	p->k=(p->k>1) ? p->k/2 : 1;
+      else if(e<0.25*tol*g && p->k<max_k)
+	p->k=p->k+1;
+    }
+  p->P0[0]=P[0];
+  p->P0[1]=P[1];
+  p->R0=(*R);
+  p->anchored=1;
+  p->skipped=0;
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
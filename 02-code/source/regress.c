@@ -0,0 +1,489 @@
+/*----------------------------------- regress.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* regression benchmark over the data sets (catcharea --regress=<dir>)              */
+/*                                                                                  */
+/* Every directory of <dir> with a catchment.txt is a data set (the Dontako ones    */
+/* are 01-Super-low to 04-Normal). Its zone files name one contour file in each CL  */
+/* directory (/CL1600/Ds30.txt); the other files there (Ds5, Ds10, Ds20) are the    */
+/* variants, run from the fewest points up. For each data set and variant a         */
+/* directory REGRESS_WORK/<set>_<variant> gets links to the CL directories and the  */
+/* zone files with the variant put in, and catcharea is run there again            */
+/* (/proc/self/exe, CATCHMENT pointing at it, the output in catcharea.log) with    */
+/* the positional arguments of this run, so every case has the same settings and   */
+/* a process of its own. The phase times and C_area are taken from its             */
+/* performance_results.csv and the peak resident set from wait4.                    */
+/*                                                                                  */
+/* The results go to --regress-out (one line per case). With --regress-baseline a   */
+/* case fails if its C_area differs by more than --regress-area-tol (relative) or   */
+/* its total time is more than --regress-time-tol (relative) over that of the       */
+/* baseline and REGRESS_MIN_SECONDS over it; run_regression then returns 1, as it  */
+/* does if a case did not run.                                                      */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <dirent.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+/*----------------------------------------------------------------------------------*/
+#include "regress_types.h"
+
+#include "regress.h"
+/*----------------------------------------------------------------------------------*/
+static char *root=(char *)NULL;              /* --regress */
+static char *output="regress.csv";           /* --regress-out */
+static char *baseline=(char *)NULL;          /* --regress-baseline */
+static char *variants=(char *)NULL;          /* --regress-variants (comma list) */
+static double area_tol=1.0e-6;               /* --regress-area-tol */
+static double time_tol=0.25;                 /* --regress-time-tol */
+static regress_case cases[REGRESS_MAX_CASES];
+static regress_case base[REGRESS_MAX_CASES];
+/*----------------------------------------------------------------------------------*/
+void set_regress(dir)
+     char *dir;
+{
+  root=dir;
+}
+/*----------------------------------------------------------------------------------*/
+char *get_regress()
+{
+  return(root);
+}
+/*----------------------------------------------------------------------------------*/
+void set_regress_output(file)
+     char *file;
+{
+  output=file;
+}
+/*----------------------------------------------------------------------------------*/
+void set_regress_baseline(file)
+     char *file;
+{
+  baseline=file;
+}
+/*----------------------------------------------------------------------------------*/
+void set_regress_variants(list)
+     char *list;
+{
+  variants=list;
+}
+/*----------------------------------------------------------------------------------*/
+void set_regress_tolerances(area,time)
+     double area,time;
+{
+  if(area>=0.0) area_tol=area;
+  if(time>=0.0) time_tol=time;
+}
+/*----------------------------------------------------------------------------------*/
+static int compare_names(a,b)
+     const void *a,*b;
+{
+  return(strcmp((char *)a,(char *)b));
+}
+/*----------------------------------------------------------------------------------*/
+static int wanted_variant(name)
+     char *name;
+{
+  char *p;
+  int n,m;
+
+  if(variants==(char *)NULL) return(1);
+  n=strlen(name);
+  p=variants;
+  while(*p!='\0')
+    {
+      m=strcspn(p,",");
+      if(m==n && strncmp(p,name,n)==0) return(1);
+      p=p+m;
+      if(*p==',') p=p+1;
+    }
+  return(0);
+}
+/*----------------------------------------------------------------------------------*/
+/* the data sets of root (sorted); returns how many */
+/*----------------------------------------------------------------------------------*/
+static int find_sets(names,most)
+     char (*names)[64];
+     int most;
+{
+  DIR *dir;
+  struct dirent *entry;
+  char file[PATH_MAX];
+  int n;
+
+  dir=opendir(root);
+  if(dir==(DIR *)NULL)
+    {
+      printf("Cannot open directory: '%s'\n",root);
+      exit(0);
+    }
+  n=0;
+  while((entry=readdir(dir))!=(struct dirent *)NULL && n<most)
+    {
+      if(entry->d_name[0]=='.' || strlen(entry->d_name)>=64) continue;
+      snprintf(file,PATH_MAX,"%s/%s/catchment.txt",root,entry->d_name);
+      if(access(file,R_OK)!=0) continue;
+      strcpy(names[n],entry->d_name);
+      n=n+1;
+    }
+  closedir(dir);
+  qsort(names,n,64,compare_names);
+  return(n);
+}
+/*----------------------------------------------------------------------------------*/
+/* the first line of a file (newline taken off); 0 if there is none */
+/*----------------------------------------------------------------------------------*/
+static int first_line(file,line,n)
+     char *file,*line;
+     int n;
+{
+  FILE *input;
+  int found;
+
+  input=fopen(file,"r");
+  if(input==(FILE *)NULL) return(0);
+  found=(fgets(line,n,input)!=(char *)NULL);
+  fclose(input);
+  if(found) line[strcspn(line,"\r\n")]='\0';
+  return(found && line[0]!='\0');
+}
+/*----------------------------------------------------------------------------------*/
+/* the variants of a data set: the contour files in the CL directory of the first   */
+/* path of the first zone, from the smallest file up; returns how many              */
+/*----------------------------------------------------------------------------------*/
+static int find_variants(set,names,most)
+     char *set;
+     char (*names)[32];
+     int most;
+{
+  DIR *dir;
+  struct dirent *entry;
+  struct stat info;
+  char file[PATH_MAX],zone[96],path[96],name[32],*slash;
+  long size[REGRESS_MAX_CASES],s;
+  int i,n,length;
+
+  snprintf(file,PATH_MAX,"%s/%s/catchment.txt",root,set);
+  if(!first_line(file,zone,96)) return(0);
+  snprintf(file,PATH_MAX,"%s/%s/%s",root,set,zone);
+  if(!first_line(file,path,96)) return(0);
+  slash=strrchr(path,'/');
+  if(slash==(char *)NULL) return(0);
+  *slash='\0';
+  snprintf(file,PATH_MAX,"%s/%s%s",root,set,path);
+  dir=opendir(file);
+  if(dir==(DIR *)NULL) return(0);
+  n=0;
+  while((entry=readdir(dir))!=(struct dirent *)NULL && n<most)
+    {
+      length=strlen(entry->d_name);
+      if(length<5 || length>=36 || strcmp(entry->d_name+length-4,".txt")!=0) continue;
+      snprintf(file,PATH_MAX,"%s/%s%s/%s",root,set,path,entry->d_name);
+      if(stat(file,&info)!=0) continue;
+      strncpy(names[n],entry->d_name,length-4);
+      names[n][length-4]='\0';
+      if(!wanted_variant(names[n])) continue;
+      size[n]=(long)info.st_size;
+      for(i=n;i>0 && size[i-1]>size[i];i--)      /* insertion sort by size */
+	{
+	  s=size[i];       size[i]=size[i-1];       size[i-1]=s;
+	  strcpy(name,names[i]); strcpy(names[i],names[i-1]); strcpy(names[i-1],name);
+	}
+      n=n+1;
+    }
+  closedir(dir);
+  return(n);
+}
+/*----------------------------------------------------------------------------------*/
+/* a copy of a list file with the last part of every path name replaced by variant */
+/*----------------------------------------------------------------------------------*/
+static void copy_list(from,to,variant)
+     char *from,*to,*variant;
+{
+  FILE *input,*out;
+  char line[256],*slash;
+
+  input=fopen(from,"r");
+  out=fopen(to,"w");
+  if(input==(FILE *)NULL || out==(FILE *)NULL)
+    {
+      printf("Cannot copy '%s' to '%s'\n",from,to);
+      exit(0);
+    }
+  while(fgets(line,256,input)!=(char *)NULL)
+    {
+      line[strcspn(line,"\r\n")]='\0';
+      slash=strrchr(line,'/');
+      if(slash!=(char *)NULL) sprintf(slash+1,"%s.txt",variant);
+      fprintf(out,"%s\n",line);
+    }
+  fclose(input);
+  fclose(out);
+}
+/*----------------------------------------------------------------------------------*/
+/* REGRESS_WORK/<set>_<variant> with links to the CL directories of the set and its */
+/* list files                                                                       */
+/*----------------------------------------------------------------------------------*/
+static void make_work(set,variant,work)
+     char *set,*variant,*work;
+{
+  DIR *dir;
+  struct dirent *entry;
+  struct stat info;
+  char from[PATH_MAX+256],to[PATH_MAX+256],real[PATH_MAX];
+  int length;
+
+  mkdir(REGRESS_WORK,0755);
+  snprintf(work,PATH_MAX,"%s/%s_%s",REGRESS_WORK,set,variant);
+  if(mkdir(work,0755)!=0 && errno!=EEXIST)
+    {
+      printf("Cannot make directory: '%s' (%s)\n",work,strerror(errno));
+      exit(0);
+    }
+  snprintf(from,PATH_MAX,"%s/%s",root,set);
+  if(realpath(from,real)==(char *)NULL)
+    {
+      printf("Cannot find directory: '%s'\n",from);
+      exit(0);
+    }
+  dir=opendir(real);
+  while(dir!=(DIR *)NULL && (entry=readdir(dir))!=(struct dirent *)NULL)
+    {
+      if(entry->d_name[0]=='.') continue;
+      snprintf(from,PATH_MAX+256,"%s/%s",real,entry->d_name);
+      snprintf(to,PATH_MAX+256,"%s/%s",work,entry->d_name);
+      if(stat(from,&info)!=0) continue;
+      length=strlen(entry->d_name);
+      if(S_ISDIR(info.st_mode))
+	{
+	  unlink(to);
+	  if(symlink(from,to)!=0)
+	    {
+	      printf("Cannot link '%s' to '%s' (%s)\n",to,from,strerror(errno));
+	      exit(0);
+	    }
+	}
+      else if(length>4 && strcmp(entry->d_name+length-4,".txt")==0)
+	copy_list(from,to,variant);
+    }
+  if(dir!=(DIR *)NULL) closedir(dir);
+}
+/*----------------------------------------------------------------------------------*/
+/* the values of performance_results.csv; 0 if it is not there */
+/*----------------------------------------------------------------------------------*/
+static int read_results(work,r)
+     char *work;
+     regress_case *r;
+{
+  FILE *input;
+  char file[PATH_MAX],line[256],key[64];
+  double value;
+  int found;
+
+  snprintf(file,PATH_MAX,"%s/performance_results.csv",work);
+  input=fopen(file,"r");
+  if(input==(FILE *)NULL) return(0);
+  found=0;
+  while(fgets(line,256,input)!=(char *)NULL)
+    {
+      if(sscanf(line,"%63[^,],%lf",key,&value)!=2) continue;
+      if(strcmp(key,"Setup_Time_sec")==0) r->setup=value;
+      else if(strcmp(key,"BEM_Time_sec")==0) r->bem=value;
+      else if(strcmp(key,"Multiply_Time_sec")==0) r->multiply=value;
+      else if(strcmp(key,"Inversion_Time_sec")==0) r->inversion=value;
+      else if(strcmp(key,"Finalization_Time_sec")==0) r->final=value;
+      else if(strcmp(key,"Total_Time_sec")==0) r->total=value;
+      else if(strcmp(key,"BEM_Evaluations")==0) r->evaluations=(long)value;
+      else if(strcmp(key,"Num_Zones")==0) r->zones=(int)value;
+      else if(strcmp(key,"Max_Points")==0) r->points=(int)value;
+      else if(strcmp(key,"Catchment_Area")==0) { r->area=value; found=1; }
+    }
+  fclose(input);
+  return(found);
+}
+/*----------------------------------------------------------------------------------*/
+/* catcharea in work with the positional arguments args */
+/*----------------------------------------------------------------------------------*/
+static void run_case(work,args,r)
+     char *work,**args;
+     regress_case *r;
+{
+  char file[PATH_MAX],catchment[PATH_MAX+1];
+  struct rusage usage;
+  int status;
+  pid_t pid;
+
+  snprintf(file,PATH_MAX,"%s/performance_results.csv",work);
+  unlink(file);
+  if(realpath(work,catchment)==(char *)NULL)
+    {
+      printf("Cannot find directory: '%s'\n",work);
+      exit(0);
+    }
+  strcat(catchment,"/");
+
+  fflush(stdout);
+  pid=fork();
+  if(pid<0)
+    {
+      printf("Cannot start a run (%s)\n",strerror(errno));
+      exit(0);
+    }
+  if(pid==0)
+    {
+      if(chdir(work)!=0 || freopen("catcharea.log","w",stdout)==(FILE *)NULL) _exit(127);
+      dup2(fileno(stdout),fileno(stderr));
+      setenv("CATCHMENT",catchment,1);
+      execv("/proc/self/exe",args);
+      _exit(127);
+    }
+  memset(&usage,0,sizeof(usage));
+  wait4(pid,&status,0,&usage);
+  r->rss=usage.ru_maxrss/1024.0;
+  r->status=1;
+  if(WIFEXITED(status) && WEXITSTATUS(status)==0 && read_results(work,r)) r->status=0;
+}
+/*----------------------------------------------------------------------------------*/
+static void write_results(n)
+     int n;
+{
+  FILE *out;
+  int i;
+
+  out=fopen(output,"w");
+  if(out==(FILE *)NULL)
+    {
+      printf("Cannot open file: '%s' for access mode 'w'\n",output);
+      exit(0);
+    }
+  fprintf(out,"case,variant,status,zones,points,setup_s,bem_s,multiply_s,inversion_s,"
+	  "final_s,total_s,peak_rss_mb,evaluations,c_area\n");
+  for(i=0;i<n;i++)
+    fprintf(out,"%s,%s,%d,%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.2f,%ld,%.6f\n",
+	    cases[i].name,cases[i].variant,cases[i].status,cases[i].zones,cases[i].points,
+	    cases[i].setup,cases[i].bem,cases[i].multiply,cases[i].inversion,
+	    cases[i].final,cases[i].total,cases[i].rss,cases[i].evaluations,cases[i].area);
+  fclose(out);
+}
+/*----------------------------------------------------------------------------------*/
+static int read_baseline()
+{
+  FILE *input;
+  char line[512];
+  regress_case *b;
+  int n;
+
+  input=fopen(baseline,"r");
+  if(input==(FILE *)NULL)
+    {
+      printf("Cannot open file: '%s' for access mode 'r'\n",baseline);
+      exit(0);
+    }
+  n=0;
+  while(fgets(line,512,input)!=(char *)NULL && n<REGRESS_MAX_CASES)
+    {
+      b=&base[n];
+      if(sscanf(line,"%63[^,],%31[^,],%d,%d,%d,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%ld,%lf",
+		b->name,b->variant,&b->status,&b->zones,&b->points,&b->setup,&b->bem,
+		&b->multiply,&b->inversion,&b->final,&b->total,&b->rss,&b->evaluations,
+		&b->area)==14) n=n+1;
+    }
+  fclose(input);
+  return(n);
+}
+/*----------------------------------------------------------------------------------*/
+/* runs every case; returns 1 if one failed or drifted from the baseline */
+/*----------------------------------------------------------------------------------*/
+int run_regression(argc,argv)
+     int argc;
+     char **argv;
+{
+  static char sets[REGRESS_MAX_CASES][64];
+  static char names[REGRESS_MAX_CASES][32];
+  char work[PATH_MAX],*args[16],*verdict;
+  regress_case *r,*b;
+  double drift,slower;
+  int i,j,k,n,n_sets,n_variants,n_base,failed;
+
+  args[0]="catcharea";
+  for(i=1;i<argc && i<15;i++) args[i]=argv[i];
+  if(argc<2) args[i++]="1.0";
+  args[i]=(char *)NULL;
+
+  n_sets=find_sets(sets,REGRESS_MAX_CASES);
+  n_base=(baseline!=(char *)NULL) ? read_baseline() : 0;
+  printf("Regression benchmark: %d data set%s in %s, arguments",n_sets,
+	 (n_sets==1) ? "" : "s",root);
+  for(i=1;args[i]!=(char *)NULL;i++) printf(" %s",args[i]);
+  printf("\n");
+  if(baseline!=(char *)NULL)
+    printf("  baseline %s (%d cases): C_area within %g, total time within +%.0f%%\n",
+	   baseline,n_base,area_tol,time_tol*100.0);
+  printf("\n  %-14s %-8s %5s %6s %9s %9s %9s %9s %8s %16s  %s\n","case","variant","zones",
+	 "points","setup s","bem s","total s","vs base","RSS MB","C_area","");
+
+  n=0;
+  failed=0;
+  for(k=0;k<n_sets;k++)
+    {
+      n_variants=find_variants(sets[k],names,REGRESS_MAX_CASES);
+      for(j=0;j<n_variants && n<REGRESS_MAX_CASES;j++)
+	{
+	  r=&cases[n];
+	  memset(r,0,sizeof(regress_case));
+	  strcpy(r->name,sets[k]);
+	  strcpy(r->variant,names[j]);
+	  make_work(sets[k],names[j],work);
+	  run_case(work,args,r);
+	  n=n+1;
+
+	  b=(regress_case *)NULL;
+	  for(i=0;i<n_base;i++)
+	    if(strcmp(base[i].name,r->name)==0 && strcmp(base[i].variant,r->variant)==0)
+	      b=&base[i];
+	  verdict="";
+	  slower=0.0;
+	  if(r->status!=0)
+	    {
+	      verdict="FAILED (see catcharea.log)";
+	      failed=1;
+	    }
+	  else if(b!=(regress_case *)NULL)
+	    {
+	      drift=fabs(r->area-b->area)/((b->area!=0.0) ? fabs(b->area) : 1.0);
+	      slower=(b->total>0.0) ? r->total/b->total-1.0 : 0.0;
+	      if(drift>area_tol)
+		{
+		  verdict="C_AREA DRIFT";
+		  failed=1;
+		}
+	      else if(slower>time_tol && r->total-b->total>REGRESS_MIN_SECONDS)
+		{
+		  verdict="SLOWER";
+		  failed=1;
+		}
+	      else verdict="ok";
+	    }
+	  else if(baseline!=(char *)NULL) verdict="(not in baseline)";
+	  printf("  %-14s %-8s %5d %6d %9.3f %9.3f %9.3f ",r->name,r->variant,r->zones,
+		 r->points,r->setup,r->bem,r->total);
+	  if(b!=(regress_case *)NULL) printf("%+8.1f%% ",slower*100.0);
+	  else printf("%9s ","");
+	  printf("%8.1f %16.6f  %s\n",r->rss,r->area,verdict);
+	  fflush(stdout);
+	}
+    }
+  write_results(n);
+  printf("\n  %d case%s written to %s%s\n",n,(n==1) ? "" : "s",output,
+	 failed ? "; REGRESSION" : "");
+  return(failed);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -7,11 +7,13 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "tile_types.h"
 
 #include "catchment.h"
 #include "file.h"
 #include "memory.h"
 #include "scan.h"
+#include "tile.h"
 #include "trapfloat.h"
 #include "streamline.h"
 #include "flow.h"
@@ -20,19 +22,46 @@
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
+static int max_steps;
+static double step_size;
+/*--------------------------------------------------------*/
+/* streamline length and risk at the points of one tile */
+/*--------------------------------------------------------*/
+static void risk_tile(c,vectors,n,P,out,arg)
+     catchment *c;
+     bem_vectors *vectors;
+     int n;
+     coordinates *P;
+     double *out;
+     void *arg;
+{
+  bem_results voltage;
+  coordinates Pstart;
+  double L,v;
+  int i;
+
+  for(i=0;i<n;i++)
+    {
+      Pstart[0]=P[i][0];
+      Pstart[1]=P[i][1];
+      L=streamline_loop(Pstart,c,1,max_steps,step_size,
+			(path *)NULL,vectors,&voltage) ;
+      v=velocity(P[i],voltage.dV);
+      out[2*i]=L;
+      if(v>0.0) { out[2*i+1]=L/v; } else { out[2*i+1]=0.0; }
+    }
+}
+/*--------------------------------------------------------*/
 int main()
 {
   char data[]="c_valley2.txt"; 
 
   FILE *output1, *output2, *output3, *output4;
-  bem_results voltage;
-  bem_vectors *vectors;
   catchment *c;
   char *buffer[3];
-  coordinates P, Pstart;
-  double L,step_size,v,risk;
-  int buf_size,i,j,k,column,max_points,num_zones,max_steps;
-  matrix bvv, bcv;
+  coordinates P;
+  double L,risk,*out;
+  int buf_size,i,j,column,max_points,num_zones;
   raster ras;
 
   trap_floating_errors();
@@ -49,7 +78,6 @@ int main()
 
   max_points=max_points_in_any_zone(c);
   printf("maximum points in any zone is %d\n",max_points);
-  vectors=create_bem_vectors(&bvv,&bcv,max_points);
 
   max_steps=300;
   step_size=0.1;
@@ -57,28 +85,24 @@ int main()
   put_raster("P(0,0)=(0.0,0.0) P(50,50)=(20.0,20.0)",&ras); /* slow */
   put_raster("P(0,0)=(0.0,0.0) P(20,20)=(20.0,20.0)",&ras);
   show_raster(&ras);
+  out=scan_raster_tiles(data,&ras,2,risk_tile,(void *)NULL);
 
   output1=open_file(0,"dc_area.out","w");
   output2=open_file(0,"dc_area2.out","w");
   output3=open_file(0,"risk.out","w");
   output4=open_file(0,"risk2.out","w");
   column=0;
-  k=0;
 /*------------------------------------------------------*/
-/* this loop scans a grid of x and y */
+/* this loop writes out the grid of x and y, row by row */
 /*------------------------------------------------------*/
   for(j=0;j<ras.ny;j++)
    {
       P[1]=y_raster(&ras,j);
       for(i=0;i<ras.nx;i++)
 	{
-	  P[0]=x_raster(&ras,i);    	  
- 	  Pstart[0]=P[0];	  
-	  Pstart[1]=P[1];
- 	  L=streamline_loop(Pstart,c,1,max_steps,step_size,
- 			    (path *)NULL,vectors,&voltage) ;
- 	  v=velocity(P,voltage.dV);
-	  if(v>0.0) { risk=L/v; } else { risk=0.0; }
+	  P[0]=x_raster(&ras,i);
+	  L=out[2*(j*ras.nx+i)];
+	  risk=out[2*(j*ras.nx+i)+1];
 
  	  put_buffer(buf_size,buffer[0],column,"%14.5e",L);
   	  column=put_buffer(buf_size,buffer[1],column,"%14.5e",risk);
@@ -100,19 +124,15 @@ int main()
       put_next_line(output2,"");
       put_next_line(output3,buffer[1]);
       put_next_line(output4,"");
-      if(k%50==0) printf("\n");
-      printf("#"); fflush(stdout);
-      k=k+1;
    }
 /*------------------------------------------------------*/
 
-  printf("\n");
   fclose(output1);
   fclose(output2);
   fclose(output3);
   fclose(output4);
   destroy_catchment(c);
-  destroy_bem_vectors(vectors);
+  free((void *)out);
   free((void *)buffer[0]);
   return(0);
 }
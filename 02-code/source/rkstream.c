@@ -0,0 +1,496 @@
+/*---------------------------------- rkstream.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* adaptive streamline integrators with error control                               */
+/*                                                                                  */
+/* The streamline is integrated in arc length s, so the state is (x,y,t) with       */
+/*   dP/ds = T = sign*dV/|dV|     and     dt/ds = 1/|dV|                            */
+/* where sign=-1 to go to min and +1 to go to max. t is the time integral used by   */
+/* streamline_loop (L = sum over zones of GH0*t), so L is found in the same way.    */
+/*                                                                                  */
+/* STREAM_TAYLOR: P(s+h) = P + h*T + h*h/2*K, with the curvature vector             */
+/*   K = dT/ds = sign*(I-T*T')*d2V*T/|dV|                                           */
+/*   taken from the Hessian already returned by the bem. The 1st order step P+h*T   */
+/*   is the embedded solution, so h is chosen before the step from                  */
+/*   h*h/2*|K| = atol+rtol*h. One bem evaluation per step.                          */
+/* STREAM_DOPRI: Dormand-Prince 5(4), first same as last, 6 evaluations per step.   */
+/*                                                                                  */
+/* Every stage must stay inside the current zone and away from the paths (d>D),     */
+/* otherwise the step is rejected and halved. At h_min the step is taken across     */
+/* the path with a single 1st order step, as the fixed step loop does.              */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "logging_types.h"
+#include "stream_types.h"
+
+#include "catchment.h"
+#include "logging.h"
+#include "merge.h"
+#include "path.h"
+#include "stopping.h"
+#include "vcalc.h"
+#include "performance_summary.h"
+
+#include "rkstream.h"
+/*----------------------------------------------------------------------------------*/
+#define ON_PATH 0.0005   /* same as D in streamline_loop */
+#define FLAT 1.0e-12     /* |dV| below this has no direction */
+/*----------------------------------------------------------------------------------*/
+static stream_control control={STREAM_FIXED,0.01,0.001,0.005,50.0};
+static stream_stats last_stats={0,0,0,0,STOP_NONE};
+#pragma omp threadprivate(last_stats)
+/*----------------------------------------------------------------------------------*/
+/* settings */
+/*----------------------------------------------------------------------------------*/
+void set_stream_method(method)
+     int method;
+{
+  if(method<STREAM_FIXED || method>STREAM_DOPRI)
+    {
+      printf("unknown streamline method %d\n",method);
+      exit(0);
+    }
+  control.method=method;
+}
+/*----------------------------------------------------------------------------------*/
+int get_stream_method()
+{
+  return(control.method);
+}
+/*----------------------------------------------------------------------------------*/
+int stream_method_from_name(name)
+     char *name;
+{
+  if(strcmp(name,"fixed")==0)  return(STREAM_FIXED);
+  if(strcmp(name,"taylor")==0) return(STREAM_TAYLOR);
+  if(strcmp(name,"dopri")==0)  return(STREAM_DOPRI);
+  return(-1);
+}
+/*----------------------------------------------------------------------------------*/
+char *stream_method_name(method)
+     int method;
+{
+  switch(method)
+    {
+    case STREAM_FIXED:  return("fixed");
+    case STREAM_TAYLOR: return("taylor");
+    case STREAM_DOPRI:  return("dopri");
+    }
+  return("unknown");
+}
+/*----------------------------------------------------------------------------------*/
+void set_stream_tolerances(atol,rtol)
+     double atol,rtol;
+{
+  if(atol<=0.0 && rtol<=0.0)
+    {
+      printf("streamline tolerances atol=%g rtol=%g must not both be zero\n",atol,rtol);
+      exit(0);
+    }
+  control.atol=atol;
+  control.rtol=rtol;
+}
+/*----------------------------------------------------------------------------------*/
+void set_stream_step_bounds(h_min,h_max)
+     double h_min,h_max;
+{
+  if(h_min<2.0*ON_PATH) h_min=2.0*ON_PATH;
+  if(h_max<h_min)
+    {
+      printf("streamline step bounds h_min=%g h_max=%g are not in order\n",h_min,h_max);
+      exit(0);
+    }
+  control.h_min=h_min;
+  control.h_max=h_max;
+}
+/*----------------------------------------------------------------------------------*/
+void get_stream_control(s)
+     stream_control *s;
+{
+  (*s)=control;
+}
+/*----------------------------------------------------------------------------------*/
+/* counters */
+/*----------------------------------------------------------------------------------*/
+void get_stream_stats(s)
+     stream_stats *s;
+{
+  (*s)=last_stats;
+}
+/*----------------------------------------------------------------------------------*/
+void report_stream_stats(s)
+     stream_stats *s;
+{
+  last_stats=(*s);
+#pragma omp critical (stream_stats)
+  {
+    if(log_on(LOG_INFO,LOG_STREAM))
+      printf(" steps=%d rejected=%d evals=%ld end=%s",s->steps,s->rejected,s->evaluations,
+	     stop_reason_name(s->reason));
+    update_streamline_stats(s->steps,s->rejected,s->evaluations,s->reason);
+  }
+}
+/*----------------------------------------------------------------------------------*/
+/* helpers */
+/*----------------------------------------------------------------------------------*/
+static double flow_direction(sign,R,T)
+     double sign;
+     bem_results *R;
+     coordinates T;
+{
+  double G;
+
+  G=sqrt(R->dV[0]*R->dV[0]+R->dV[1]*R->dV[1]);
+  if(G<FLAT)
+    {
+      T[0]=0.0;
+      T[1]=0.0;
+    }
+  else
+    {
+      T[0]=sign*R->dV[0]/G;
+      T[1]=sign*R->dV[1]/G;
+    }
+  return(G);
+}
+/*----------------------------------------------------------------------------------*/
+/* parts of the field the method uses: d2V only for the Taylor step */
+static int stage_mask()
+{
+  return((control.method==STREAM_TAYLOR) ? EVAL_DV|EVAL_D2V : EVAL_DV);
+}
+/*----------------------------------------------------------------------------------*/
+/* evaluate at Q only if Q is in zone and not on a path; returns 1 if done */
+static int stage_eval(c,zone,Q,vectors,R)
+     catchment *c;
+     int zone;
+     coordinates Q;
+     bem_vectors *vectors;
+     bem_results *R;
+{
+  double d,s;
+  int segment;
+  path *this_path;
+
+  if(check_each_zone(c,Q)!=zone) return(0);
+  check_each_path(c,Q,&d,&s,&segment,&this_path);
+  if(d<ON_PATH) return(0);
+  calculate_in_same_zone(c->zones[zone],Q,vectors,R,stage_mask());
+  return(1);
+}
+/*----------------------------------------------------------------------------------*/
+static double limit_step(h)
+     double h;
+{
+  if(h<control.h_min) h=control.h_min;
+  if(h>control.h_max) h=control.h_max;
+  return(h);
+}
+/*----------------------------------------------------------------------------------*/
+/* curvature vector K = dT/ds */
+static void curvature(sign,R,T,G,K)
+     double sign,G;
+     bem_results *R;
+     coordinates T,K;
+{
+  double HT[2],THT;
+
+  HT[0]=R->d2V[0][0]*T[0]+R->d2V[0][1]*T[1];
+  HT[1]=R->d2V[1][0]*T[0]+R->d2V[1][1]*T[1];
+  THT=T[0]*HT[0]+T[1]*HT[1];
+  K[0]=sign*(HT[0]-THT*T[0])/G;
+  K[1]=sign*(HT[1]-THT*T[1])/G;
+}
+/*----------------------------------------------------------------------------------*/
+/* rate of change of 1/|dV| along the streamline */
+static double inverse_slope(R,T,G)
+     bem_results *R;
+     coordinates T;
+     double G;
+{
+  double HT[2];
+
+  HT[0]=R->d2V[0][0]*T[0]+R->d2V[0][1]*T[1];
+  HT[1]=R->d2V[1][0]*T[0]+R->d2V[1][1]*T[1];
+  return(-(R->dV[0]*HT[0]+R->dV[1]*HT[1])/(G*G*G));
+}
+/*----------------------------------------------------------------------------------*/
+/* Taylor step: returns 1 if accepted, 0 if rejected, -1 if blocked by zone/path */
+static int taylor_step(c,zone,sign,P,R,T,G,h,Pn,Rn,dt,h_next,vectors)
+     catchment *c;
+     int zone;
+     double sign,G,h,*dt,*h_next;
+     coordinates P,T,Pn;
+     bem_results *R,*Rn;
+     bem_vectors *vectors;
+{
+  coordinates K,Tn,Tp;
+  double k,tol,err,Gn,norm;
+
+  curvature(sign,R,T,G,K);
+  k=sqrt(K[0]*K[0]+K[1]*K[1]);
+  Pn[0]=P[0]+h*T[0]+0.5*h*h*K[0];
+  Pn[1]=P[1]+h*T[1]+0.5*h*h*K[1];
+  if(stage_eval(c,zone,Pn,vectors,Rn)==0) return(-1);
+  Gn=flow_direction(sign,Rn,Tn);
+  if(Gn<FLAT) return(-1);
+
+  /* direction predicted by the step against direction found at Pn */
+  Tp[0]=T[0]+h*K[0];
+  Tp[1]=T[1]+h*K[1];
+  norm=sqrt(Tp[0]*Tp[0]+Tp[1]*Tp[1]);
+  Tp[0]=Tp[0]/norm-Tn[0];
+  Tp[1]=Tp[1]/norm-Tn[1];
+  tol=control.atol+control.rtol*h;
+  err=0.5*h*sqrt(Tp[0]*Tp[0]+Tp[1]*Tp[1])/tol;
+  if(err>1.0 && h>control.h_min)
+    {
+      (*h_next)=limit_step(h*fmax(0.2,0.9*pow(err,-1.0/3.0)));
+      return(0);
+    }
+  /* Hermite rule for t, with d(1/|dV|)/ds = -dV.d2V.T/|dV|^3 at both ends */
+  (*dt)=0.5*h*(1.0/G+1.0/Gn)
+    +h*h/12.0*(inverse_slope(R,T,G)-inverse_slope(Rn,Tn,Gn));
+
+  /* a priori step for next time from h*h/2*|K| = atol+rtol*h */
+  curvature(sign,Rn,Tn,Gn,K);
+  k=sqrt(K[0]*K[0]+K[1]*K[1]);
+  if(k*control.h_max*control.h_max<2.0*(control.atol+control.rtol*control.h_max))
+    (*h_next)=control.h_max;
+  else
+    (*h_next)=limit_step((control.rtol+sqrt(control.rtol*control.rtol+2.0*k*control.atol))/k);
+  return(1);
+}
+/*----------------------------------------------------------------------------------*/
+/* Dormand-Prince 5(4) tableau */
+static const double dp_a[7][6]={
+  {0.0,0.0,0.0,0.0,0.0,0.0},
+  {1.0/5.0,0.0,0.0,0.0,0.0,0.0},
+  {3.0/40.0,9.0/40.0,0.0,0.0,0.0,0.0},
+  {44.0/45.0,-56.0/15.0,32.0/9.0,0.0,0.0,0.0},
+  {19372.0/6561.0,-25360.0/2187.0,64448.0/6561.0,-212.0/729.0,0.0,0.0},
+  {9017.0/3168.0,-355.0/33.0,46732.0/5247.0,49.0/176.0,-5103.0/18656.0,0.0},
+  {35.0/384.0,0.0,500.0/1113.0,125.0/192.0,-2187.0/6784.0,11.0/84.0}};
+static const double dp_e[7]={71.0/57600.0,0.0,-71.0/16695.0,71.0/1920.0,
+			     -17253.0/339200.0,22.0/525.0,-1.0/40.0};
+/*----------------------------------------------------------------------------------*/
+/* Dormand-Prince step: returns 1 if accepted, 0 if rejected, -1 if blocked */
+static int dopri_step(c,zone,sign,P,R,T,G,h,Pn,Rn,dt,h_next,vectors)
+     catchment *c;
+     int zone;
+     double sign,G,h,*dt,*h_next;
+     coordinates P,T,Pn;
+     bem_results *R,*Rn;
+     bem_vectors *vectors;
+{
+  double k[7][3],y[3],e[3],Gs,tol,err,fac;
+  coordinates Q,Ts;
+  bem_results Rs;
+  int i,m;
+
+  k[0][0]=T[0]; k[0][1]=T[1]; k[0][2]=1.0/G;
+  for(i=1;i<7;i++)
+    {
+      y[0]=0.0; y[1]=0.0; y[2]=0.0;
+      for(m=0;m<i;m++)
+	{
+	  y[0]=y[0]+dp_a[i][m]*k[m][0];
+	  y[1]=y[1]+dp_a[i][m]*k[m][1];
+	  y[2]=y[2]+dp_a[i][m]*k[m][2];
+	}
+      Q[0]=P[0]+h*y[0];
+      Q[1]=P[1]+h*y[1];
+      if(i<6)
+	{
+	  if(stage_eval(c,zone,Q,vectors,&Rs)==0) return(-1);
+	  Gs=flow_direction(sign,&Rs,Ts);
+	}
+      else /* 5th order solution; its derivative is the first stage of next step */
+	{
+	  Pn[0]=Q[0];
+	  Pn[1]=Q[1];
+	  (*dt)=h*y[2];
+	  if(stage_eval(c,zone,Pn,vectors,Rn)==0) return(-1);
+	  Gs=flow_direction(sign,Rn,Ts);
+	}
+      if(Gs<FLAT) return(-1);
+      k[i][0]=Ts[0]; k[i][1]=Ts[1]; k[i][2]=1.0/Gs;
+    }
+
+  e[0]=0.0; e[1]=0.0; e[2]=0.0;
+  for(i=0;i<7;i++)
+    {
+      e[0]=e[0]+dp_e[i]*k[i][0];
+      e[1]=e[1]+dp_e[i]*k[i][1];
+      e[2]=e[2]+dp_e[i]*k[i][2];
+    }
+  /* error in t is measured as a length using |dV| at the start of the step */
+  tol=control.atol+control.rtol*h;
+  err=h*fmax(sqrt(e[0]*e[0]+e[1]*e[1]),fabs(e[2])*G)/tol;
+  if(err<1.0e-10) fac=5.0;
+  else fac=fmin(5.0,fmax(0.2,0.9*pow(err,-0.2)));
+  (*h_next)=limit_step(h*fac);
+  if(err>1.0 && h>control.h_min) return(0);
+  return(1);
+}
+/*----------------------------------------------------------------------------------*/
+/* adaptive streamline loop: same arguments and result as streamline_loop */
+/*----------------------------------------------------------------------------------*/
+double rk_streamline_loop(P,c,direction,max_steps,step_size,streamline,
+			  vectors,v1)
+     coordinates P;
+     catchment *c;
+     int direction; /* 1 = go to max; 0 = go to min */
+     int max_steps; /* +ve = number of steps; -ve = don't check */
+     double step_size;
+     path *streamline;
+     bem_vectors *vectors;
+     bem_results *v1;
+{
+  bem_results R,Rn;
+  coordinates T,Pn,K;
+  stream_stats stats;
+  stop_tracker *tracker;
+  double sign,h,h_next,G,GH0,t_sum,L_sum,dt,d,s,pp,step,t_rest,L_after;
+  int j,zone,new_z,status,segment,n;
+  long evals_start;
+  path *this_path;
+
+  evals_start=get_thread_bem_evaluations();
+  memset(&stats,0,sizeof(stream_stats));
+  stats.reason=STOP_NONE;
+  tracker=create_stop_tracker(max_steps);
+  start_stop_tracker(tracker,step_size);
+  merge_begin(c,direction);
+  sign=(direction==1) ? 1.0 : -1.0;
+  h=limit_step(step_size);
+  L_sum=0.0;
+  t_sum=0.0;
+  j=0;
+
+  pp=calculate_inside_catchment(c,P,vectors,&R,&new_z,EVAL_ALL);
+  v1->V=pp;
+  v1->dV[0]=R.dV[0];        v1->dV[1]=R.dV[1];
+  v1->d2V[0][0]=R.d2V[0][0]; v1->d2V[0][1]=R.d2V[0][1];
+  v1->d2V[1][0]=R.d2V[1][0]; v1->d2V[1][1]=R.d2V[1][1];
+  if(streamline!=(path *)NULL) { put_path_xy(streamline,j,P); }
+  j=j+1;
+  if(new_z==1) stats.new_zones=1;
+  zone=c->previous_zone;
+  G=flow_direction(sign,&R,T);
+  GH0=G;
+  if(new_z>=0)
+    {
+      merge_new_zone(GH0);
+      merge_point(P,zone,t_sum);
+      stats.reason=check_stop(tracker,P,G,0.0);
+    }
+  if(control.method==STREAM_TAYLOR && G>=FLAT)
+    {
+      curvature(sign,&R,T,G,K);
+      d=sqrt(K[0]*K[0]+K[1]*K[1]);
+      if(d*h*h>2.0*(control.atol+control.rtol*h))
+	h=limit_step((control.rtol+sqrt(control.rtol*control.rtol+2.0*d*control.atol))/d);
+    }
+
+  while(new_z>=0 && G>=FLAT && stats.reason==STOP_NONE && (max_steps<0 || j<max_steps))
+    {
+      if(control.method==STREAM_TAYLOR)
+	status=taylor_step(c,zone,sign,P,&R,T,G,h,Pn,&Rn,&dt,&h_next,vectors);
+      else
+	status=dopri_step(c,zone,sign,P,&R,T,G,h,Pn,&Rn,&dt,&h_next,vectors);
+
+      if(status<0 && h>control.h_min) /* stage in another zone or on a path */
+	{
+	  stats.rejected=stats.rejected+1;
+	  h=limit_step(0.5*h);
+	  continue;
+	}
+      if(status==0) /* error too big */
+	{
+	  stats.rejected=stats.rejected+1;
+	  h=h_next;
+	  continue;
+	}
+      if(status<0) /* at h_min: step across the path with a 1st order step */
+	{
+	  Pn[0]=P[0]+h*T[0];
+	  Pn[1]=P[1]+h*T[1];
+	  check_each_path(c,Pn,&d,&s,&segment,&this_path);
+	  for(n=0;n<10 && d<ON_PATH;n++)
+	    {
+	      Pn[0]=Pn[0]+2.0*ON_PATH*T[0];
+	      Pn[1]=Pn[1]+2.0*ON_PATH*T[1];
+	      check_each_path(c,Pn,&d,&s,&segment,&this_path);
+	    }
+	  pp=calculate_inside_catchment(c,Pn,vectors,&Rn,&new_z,stage_mask());
+	  t_sum=t_sum+h/G;
+	  merge_zone_time(t_sum);
+	  if(new_z==1) /* new zone */
+	    {
+	      stats.new_zones=stats.new_zones+1;
+	      L_sum=L_sum+t_sum*GH0;
+	      t_sum=0.0;
+	      zone=c->previous_zone;
+	      GH0=sqrt(Rn.dV[0]*Rn.dV[0]+Rn.dV[1]*Rn.dV[1]);
+	      merge_new_zone(GH0);
+	    }
+	  h_next=limit_step(step_size);
+	}
+      else
+	{
+	  t_sum=t_sum+dt;
+	  new_z=0;
+	}
+      step=sqrt((Pn[0]-P[0])*(Pn[0]-P[0])+(Pn[1]-P[1])*(Pn[1]-P[1]));
+      P[0]=Pn[0];
+      P[1]=Pn[1];
+      R=Rn;
+      G=flow_direction(sign,&R,T);
+      h=h_next;
+      if(streamline!=(path *)NULL) { put_path_xy(streamline,j,P); }
+      j=j+1;
+      if(new_z<0) break;
+      merge_point(P,zone,t_sum);
+      if(new_z==0 && merge_lookup(P,zone,&t_rest,&L_after)==1)
+	{
+	  stats.reason=STOP_MERGED;
+	  break;
+	}
+      stats.reason=check_stop(tracker,P,G,step);
+    }
+  if(stats.reason==STOP_MERGED)
+    {
+      L_sum=L_sum+(t_sum+t_rest)*GH0+L_after;
+      merge_end(t_rest,L_after);
+    }
+  else
+    {
+      L_sum=L_sum+t_sum*GH0;
+      merge_end(0.0,0.0);
+    }
+  if(log_on(LOG_INFO,LOG_STREAM)) printf(" L=%.4f",L_sum);
+
+  if(stats.reason==STOP_NONE)
+    {
+      if(new_z<0) stats.reason=STOP_OUTSIDE;
+      else if(G<FLAT) stats.reason=STOP_FLAT;
+      else stats.reason=STOP_MAX_STEPS;
+    }
+  tracker=destroy_stop_tracker(tracker);
+  stats.steps=j;
+  stats.evaluations=get_thread_bem_evaluations()-evals_start;
+  report_stream_stats(&stats);
+  if(streamline!=(path *)NULL) streamline->points=j;
+  return(L_sum);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
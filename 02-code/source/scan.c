@@ -2,6 +2,7 @@
 /*      routines to set up scanning parameters     */
 /*-------------------------------------------------*/
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 /*-------------------------------------------------*/
 #include "boundary_types.h"
@@ -10,6 +11,9 @@
 #include "ten_matrix_types.h"
 #include "memory_types.h"
 
+#include "catchment.h"
+#include "file.h"
+
 #include "scan.h"
 /*-------------------------------------------------*/
 void put_raster(data,ras)
@@ -72,6 +76,86 @@ double y_raster(ras,j)
   return(y);
 }
 
+/*-------------------------------------------------*/
+/* square cells of side cell over all paths of c;  */
+/* the raster points are the centres of the cells  */
+/*-------------------------------------------------*/
+void catchment_raster(c,cell,ras)
+     catchment *c;
+     double cell;
+     raster *ras;
+{
+  coordinates min,max,lo,hi;
+  int i;
+
+  for(i=0;i<c->num_paths;i++)
+    {
+      find_limits(c->path_list[i].path_p,lo,hi);
+      if(i==0 || lo[0]<min[0]) min[0]=lo[0];
+      if(i==0 || lo[1]<min[1]) min[1]=lo[1];
+      if(i==0 || hi[0]>max[0]) max[0]=hi[0];
+      if(i==0 || hi[1]>max[1]) max[1]=hi[1];
+    }
+  ras->nx=(int)ceil((max[0]-min[0])/cell);
+  ras->ny=(int)ceil((max[1]-min[1])/cell);
+  if(ras->nx<1) ras->nx=1;
+  if(ras->ny<1) ras->ny=1;
+  ras->P1[0]=min[0]+cell/2.0;
+  ras->P1[1]=min[1]+cell/2.0;
+  ras->P2[0]=ras->P1[0]+(ras->nx-1)*cell;
+  ras->P2[1]=ras->P1[1]+(ras->ny-1)*cell;
+}
+
+/*-------------------------------------------------*/
+/* value[j*nx+i] at the cells of ras (side cell)   */
+/* as <name>.flt, 4 byte floats with the north row */
+/* first, and the ESRI header <name>.hdr           */
+/*-------------------------------------------------*/
+void write_flt_raster(name,ras,cell,value,nodata)
+     char *name;
+     raster *ras;
+     double cell;
+     double *value;
+     double nodata;
+{
+  FILE *output;
+  char file[128];
+  float *row;
+  int i,j,one;
+
+  row=(float *)malloc(ras->nx*sizeof(float));
+  if(row==(float *)NULL)
+    {
+      printf("Cannot allocate memory for raster '%s'\n",name);
+      exit(0);
+    }
+  sprintf(file,"%.120s.flt",name);
+  output=open_file(0,file,"wb");
+  for(j=ras->ny-1;j>=0;j--)
+    {
+      for(i=0;i<ras->nx;i++) row[i]=(float)value[j*ras->nx+i];
+      if(fwrite(row,sizeof(float),ras->nx,output)!=ras->nx)
+	{
+	  printf("Cannot write file: '%s'\n",file);
+	  exit(0);
+	}
+    }
+  fclose(output);
+  free((void *)row);
+
+  one=1;
+  sprintf(file,"%.120s.hdr",name);
+  output=open_file(0,file,"w");
+  fprintf(output,"ncols         %d\n",ras->nx);
+  fprintf(output,"nrows         %d\n",ras->ny);
+  fprintf(output,"xllcorner     %f\n",ras->P1[0]-cell/2.0);
+  fprintf(output,"yllcorner     %f\n",ras->P1[1]-cell/2.0);
+  fprintf(output,"cellsize      %f\n",cell);
+  fprintf(output,"NODATA_value  %f\n",nodata);
+  fprintf(output,"byteorder     %s\n",(*(char *)&one==1) ? "LSBFIRST" : "MSBFIRST");
+  fclose(output);
+}
+
 /*-------------------------------------------------*/
 void put_section(data,sec)
      char *data;
@@ -7,32 +7,54 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "tile_types.h"
 
 #include "catchment.h"
 #include "file.h"
 #include "memory.h"
 #include "scan.h"
+#include "tile.h"
 #include "trapfloat.h"
 #include "vcalc.h"
+#include "batch.h"
 #include "flow.h"
 
 #include "speed.h"
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
 /*--------------------------------------------------------*/
+/* velocity and current density at the points of one tile */
+/*--------------------------------------------------------*/
+static void speed_tile(c,vectors,n,P,out,arg)
+     catchment *c;
+     bem_vectors *vectors;
+     int n;
+     coordinates *P;
+     double *out;
+     void *arg;
+{
+  bem_results field[TILE_SIZE*TILE_SIZE];
+  int i,new_z[TILE_SIZE*TILE_SIZE];
+
+  calculate_batch(c,n,P,vectors,field,new_z,EVAL_DV);
+  for(i=0;i<n;i++)
+    {
+      if(new_z[i]==(-1)) printf("point is outside catchment\n");
+      out[2*i]=velocity(P[i],field[i].dV);
+      out[2*i+1]=current_density(P[i],field[i].dV);
+    }
+}
+/*--------------------------------------------------------*/
 int main()
 {
   char data[]="c_valley.txt"; 
 
   FILE *output1, *output2, *output3, *output4;
-  bem_results voltage;
-  bem_vectors *vectors;
   catchment *c;
   char *buffer[4];
   coordinates P;
-  double pp,v,Q;
-  int buf_size,i,j,k,column,max_points,num_zones,new_z;
-  matrix bvv, bcv;
+  double v,Q,*out;
+  int buf_size,i,j,column,max_points,num_zones;
   raster ras;
 
   trap_floating_errors();
@@ -49,31 +71,28 @@ int main()
 
   max_points=max_points_in_any_zone(c);
   printf("maximum points in any zone is %d\n",max_points);
-  vectors=create_bem_vectors(&bvv,&bcv,max_points);
 
   put_raster("P(0,0)=(0.0,0.0) P(100,100)=(20.0,20.0)",&ras); /* slow */
   put_raster("P(0,0)=(0.0,0.0) P(50,50)=(20.0,20.0)",&ras);
   show_raster(&ras);
+  out=scan_raster_tiles(data,&ras,2,speed_tile,(void *)NULL);
 
   output1=open_file(0,"velocity.out","w");
   output2=open_file(0,"velocity2.out","w");
   output3=open_file(0,"c_density.out","w");
   output4=open_file(0,"c_density2.out","w");
   column=0;
-  k=0;
 /*------------------------------------------------------*/
-/* this loop scans a grid of x and y */
+/* this loop writes out the grid of x and y, row by row */
 /*------------------------------------------------------*/
   for(j=0;j<ras.ny;j++)
    {
       P[1]=y_raster(&ras,j);
       for(i=0;i<ras.nx;i++)
 	{
-	  P[0]=x_raster(&ras,i);    	  
-	  pp=calculate_inside_catchment(c,P,vectors,&voltage,&new_z);
-	  if(new_z==(-1)) printf("point is outside catchment\n");
- 	  v=velocity(P,voltage.dV);
-  	  Q=current_density(P,voltage.dV);
+	  P[0]=x_raster(&ras,i);
+	  v=out[2*(j*ras.nx+i)];
+	  Q=out[2*(j*ras.nx+i)+1];
 
  	  put_buffer(buf_size,buffer[0],column,"%14.5e",v);
  	  column=put_buffer(buf_size,buffer[1],column,"%14.5e",Q);
@@ -95,19 +114,15 @@ int main()
       put_next_line(output2,"");
       put_next_line(output3,buffer[1]);
       put_next_line(output4,"");
-      if(k%50==0) printf("\n");
-      printf("#"); fflush(stdout);
-      k=k+1;
    }
 /*------------------------------------------------------*/
 
-  printf("\n");
   fclose(output1);
   fclose(output2);
   fclose(output3);
   fclose(output4);
   destroy_catchment(c);
-  destroy_bem_vectors(vectors);
+  free((void *)out);
   free((void *)buffer[0]);
   return(0);
 }
@@ -14,6 +14,7 @@
 #include "scan.h"
 #include "trapfloat.h"
 #include "vcalc.h"
+#include "batch.h"
 #include "flow.h"
 
 #include "ssection.h"
@@ -26,13 +27,13 @@ int main()
   char data[]="c_valley.txt"; 
 
   FILE *output1, *output2;
-  bem_results voltage;
+  bem_results voltage,*field;
   bem_vectors *vectors;
   catchment *c;
   char *buffer[2];
-  coordinates P;
+  coordinates P,*row;
   double pp,v,Q;
-  int buf_size,i,column,max_points,num_zones,new_z;
+  int buf_size,i,column,max_points,num_zones,*new_z;
   matrix bvv, bcv;
   section mouth;
 
@@ -52,6 +53,9 @@ int main()
   put_section("P(0) = (4.0,5.0) P(100) = (5.0,4.0)",&mouth);
   show_section(&mouth);
   printf("step size across mouth is %f\n",mouth.step);
+  row=(coordinates *)malloc(mouth.n*sizeof(coordinates));
+  field=(bem_results *)malloc(mouth.n*sizeof(bem_results));
+  new_z=(int *)malloc(mouth.n*sizeof(int));
 
   output1=open_file(0,"vsection.out","w");
   output2=open_file(0,"qsection.out","w");
@@ -59,11 +63,15 @@ int main()
 /*------------------------------------------------------*/
 /* this loop scans across the mouth */
 /*------------------------------------------------------*/
+  for(i=0;i<mouth.n;i++) xy_section(&mouth,i,row[i]);
+  calculate_batch(c,mouth.n,row,vectors,field,new_z,EVAL_DV);
   for(i=0;i<mouth.n;i++)
     {
-      xy_section(&mouth,i,P);    	  
-      pp=calculate_inside_catchment(c,P,vectors,&voltage,&new_z);
-      if(new_z==(-1)) printf("point is outside catchment\n");
+      P[0]=row[i][0];
+      P[1]=row[i][1];
+      voltage=field[i];
+      pp=voltage.V;
+      if(new_z[i]==(-1)) printf("point is outside catchment\n");
 
       v=velocity(P,voltage.dV);
       Q=current_density(P,voltage.dV);
@@ -90,6 +98,9 @@ int main()
   fclose(output2);
   destroy_catchment(c);
   destroy_bem_vectors(vectors);
+  free((void *)row);
+  free((void *)field);
+  free((void *)new_z);
   free((void *)buffer[0]);
   return(0);
 }
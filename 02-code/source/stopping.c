@@ -0,0 +1,200 @@
+/*---------------------------------- stopping.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* early ending of streamlines that will not leave the catchment                    */
+/*                                                                                  */
+/* A streamline that reaches a pit, a flat area or goes round in circles would      */
+/* otherwise use all max_steps, each with a bem evaluation. After every accepted    */
+/* point check_stop looks at                                                        */
+/*   - |dV| < gmin                                        -> STOP_FLAT              */
+/*   - net movement over the last window points less than                           */
+/*     ratio * path length over those points              -> STOP_STALLED           */
+/*   - points falling in cells (size = cell) already passed through more than       */
+/*     window points earlier, max_revisits times          -> STOP_LOOP              */
+/* A test is switched off by setting gmin<=0, window<=0 or max_revisits<=0.         */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "stream_types.h"
+
+#include "stopping.h"
+/*----------------------------------------------------------------------------------*/
+static double gmin=1.0e-8;      /* smallest |dV| that still gives a direction */
+static int window=100;          /* points looked back for net movement */
+static double ratio=0.05;       /* net movement / path length below this = stalled */
+static int max_revisits=3;      /* revisits before calling it a loop */
+/*----------------------------------------------------------------------------------*/
+void set_stop_criteria(g,w,q,n)
+     double g,q;
+     int w,n;
+{
+  gmin=g;
+  window=w;
+  ratio=q;
+  max_revisits=n;
+}
+/*----------------------------------------------------------------------------------*/
+void get_stop_criteria(g,w,q,n)
+     double *g,*q;
+     int *w,*n;
+{
+  (*g)=gmin;
+  (*w)=window;
+  (*q)=ratio;
+  (*n)=max_revisits;
+}
+/*----------------------------------------------------------------------------------*/
+char *stop_reason_name(reason)
+     int reason;
+{
+  switch(reason)
+    {
+    case STOP_NONE:      return("none");
+    case STOP_OUTSIDE:   return("outside");
+    case STOP_MAX_STEPS: return("max_steps");
+    case STOP_FLAT:      return("flat");
+    case STOP_STALLED:   return("stalled");
+    case STOP_LOOP:      return("loop");
+    case STOP_MERGED:    return("merged");
+    }
+  return("unknown");
+}
+/*----------------------------------------------------------------------------------*/
+/* tracker memory; max_points<0 means no limit on the number of points */
+/*----------------------------------------------------------------------------------*/
+stop_tracker *create_stop_tracker(max_points)
+     int max_points;
+{
+  stop_tracker *t;
+  int w;
+
+  t=(stop_tracker *)malloc(sizeof(stop_tracker));
+  if(t==(stop_tracker *)NULL)
+    {
+      printf("Cannot allocate memory for stop tracker\n");
+      exit(0);
+    }
+  w=(window>0) ? window : 0;
+  t->window=w;
+  t->ring=(coordinates *)malloc((w+1)*sizeof(coordinates));
+  t->length=(double *)malloc((w+1)*sizeof(double));
+  if(max_points<0 || max_points>32768) max_points=32768;
+  t->size=64;
+  while(t->size<2*max_points) t->size=2*t->size;
+  t->key=(long long *)malloc(t->size*sizeof(long long));
+  t->step=(int *)malloc(t->size*sizeof(int));
+  if(t->ring==(coordinates *)NULL || t->length==(double *)NULL ||
+     t->key==(long long *)NULL || t->step==(int *)NULL)
+    {
+      printf("Cannot allocate memory for stop tracker\n");
+      exit(0);
+    }
+  t->cell=1.0;
+  t->count=0;
+  t->used=0;
+  t->revisits=0;
+  return(t);
+}
+/*----------------------------------------------------------------------------------*/
+stop_tracker *destroy_stop_tracker(t)
+     stop_tracker *t;
+{
+  if(t==(stop_tracker *)NULL) return(t);
+  free((void *)t->ring);
+  free((void *)t->length);
+  free((void *)t->key);
+  free((void *)t->step);
+  free((void *)t);
+  return((stop_tracker *)NULL);
+}
+/*----------------------------------------------------------------------------------*/
+/* start a new streamline; cells are half the nominal step */
+/*----------------------------------------------------------------------------------*/
+void start_stop_tracker(t,step_size)
+     stop_tracker *t;
+     double step_size;
+{
+  t->count=0;
+  t->used=0;
+  t->revisits=0;
+  t->cell=0.5*step_size;
+  memset(t->key,0,t->size*sizeof(long long));
+}
+/*----------------------------------------------------------------------------------*/
+/* record cell of P; returns 1 if it was passed through well before now */
+/*----------------------------------------------------------------------------------*/
+static int revisit(t,P)
+     stop_tracker *t;
+     coordinates P;
+{
+  long long ix,iy,key;
+  unsigned long long h;
+  int i,mask,seen;
+
+  ix=(long long)floor(P[0]/t->cell);
+  iy=(long long)floor(P[1]/t->cell);
+  key=((ix+0x40000000LL)<<32) | ((iy+0x40000000LL) & 0xffffffffLL);
+  h=(unsigned long long)key*0x9E3779B97F4A7C15ULL;
+  mask=t->size-1;
+  i=(int)(h>>40) & mask;
+  while(t->key[i]!=0 && t->key[i]!=key) i=(i+1) & mask;
+
+  seen=0;
+  if(t->key[i]==key)
+    {
+      if(t->count-t->step[i]>t->window) seen=1;
+      t->step[i]=t->count;
+    }
+  else if(2*t->used<t->size) /* keep the table at most half full */
+    {
+      t->key[i]=key;
+      t->step[i]=t->count;
+      t->used=t->used+1;
+    }
+  return(seen);
+}
+/*----------------------------------------------------------------------------------*/
+/* called with each accepted point P, |dV| at P and the length of the step to P;    */
+/* returns STOP_NONE or the reason to end the streamline                           */
+/*----------------------------------------------------------------------------------*/
+int check_stop(t,P,G,step)
+     stop_tracker *t;
+     coordinates P;
+     double G,step;
+{
+  int k,old,reason;
+  double total,dx,dy;
+
+  reason=STOP_NONE;
+  if(gmin>0.0 && G<gmin) reason=STOP_FLAT;
+
+  if(t->window>0)
+    {
+      k=t->count%(t->window+1);
+      total=(t->count>0) ? t->length[(t->count-1)%(t->window+1)]+step : 0.0;
+      t->ring[k][0]=P[0];
+      t->ring[k][1]=P[1];
+      t->length[k]=total;
+      if(reason==STOP_NONE && t->count>=t->window)
+	{
+	  old=(t->count-t->window)%(t->window+1);
+	  dx=P[0]-t->ring[old][0];
+	  dy=P[1]-t->ring[old][1];
+	  if(sqrt(dx*dx+dy*dy)<ratio*(total-t->length[old])) reason=STOP_STALLED;
+	}
+    }
+
+  if(max_revisits>0 && t->cell>0.0)
+    {
+      if(revisit(t,P)==1) t->revisits=t->revisits+1;
+      if(reason==STOP_NONE && t->revisits>=max_revisits) reason=STOP_LOOP;
+    }
+
+  t->count=t->count+1;
+  return(reason);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -10,10 +10,23 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "logging_types.h"
+#include "predict_types.h"
+#include "stream_types.h"
+#include "trace_types.h"
+#include "perfcount_types.h"
 
 #include "catchment.h"
+#include "direction.h"
 #include "file.h"
+#include "logging.h"
+#include "merge.h"
 #include "path.h"
+#include "perfcount.h"
+#include "predict.h"
+#include "rkstream.h"
+#include "stopping.h"
+#include "trace.h"
 #include "vcalc.h"
 
 #include "streamline.h"
@@ -417,6 +430,12 @@ void edit1_my_follow_stream(direction,P, dV, d2V, dP, r)
   double gx[4], gy[4], cx, cy;
   /*-----------*/
 
+  if(get_direction_method()==DIRECTION_NEWTON)
+    {
+      newton_follow_stream(direction,dV,d2V,dP,r);
+      return;
+    }
+
 
   first[0]=dV[0]; /* a1 */
   first[1]=dV[1]; /* b1 */
@@ -608,6 +627,33 @@ void plot_1_streamline(c,streamline,output)
   put_next_line(output,"\0");
 }
 /*--------------------------------------------------------*/
+/* calculate_inside_catchment, or the Taylor prediction  */
+/* from the last exact point while still in its zone     */
+/* (P is located once, for both)                         */
+/*--------------------------------------------------------*/
+static double predicted_inside_catchment(c,P,vectors,vol,new_z,mask,pred)
+     catchment *c;
+     coordinates P;
+     bem_vectors *vectors;
+     bem_results *vol;
+     int *new_z,mask;
+     predictor *pred;
+{
+  double pp;
+  int zone;
+
+  zone=check_each_zone(c,P);
+  if(pred->anchored==1 && c->previous_zone>=0 &&
+     zone==c->previous_zone && predict_field(pred,P,vol)==1)
+    {
+      (*new_z)=0;
+      return(vol->V);
+    }
+  pp=calculate_in_zone(c,zone,P,vectors,vol,new_z,mask);
+  if((*new_z)>=0) correct_predictor(pred,P,vol,((*new_z)==0) ? 1 : 0);
+  return(pp);
+}
+/*--------------------------------------------------------*/
 /*--------streamline loop by Dr.Andrew--------------------*/
 /*--------------------------------------------------------*/
 double streamline_loop(P,c,direction,max_steps,step_size,streamline,
@@ -624,9 +670,31 @@ double streamline_loop(P,c,direction,max_steps,step_size,streamline,
   bem_results vol;
   coordinates dP;
   int segment,j,new_z;
-  double pp,r,s,d,D,t_sum,GH0,L_sum,G_old,G_new;
+  double pp,r,s,d,D,t_sum,GH0,L_sum,G_old,G_new,t_rest,L_after;
   path *this_path;
+  stream_stats stats;
+  stop_tracker *tracker;
+  coordinates P_old;
+  long evals_start;
+  predictor pred;
+  trace_span span;
+  perf_sample sample;
+
+  trace_begin(&span,"streamline_loop","stream");
+  perf_begin(&sample);
+  if(get_stream_method()!=STREAM_FIXED)
+    {
+      L_sum=rk_streamline_loop(P,c,direction,max_steps,step_size,streamline,
+			       vectors,v1);
+      perf_end(&sample,PERF_TRACING,0.0);
+      trace_end(&span);
+      return(L_sum);
+    }
 
+  evals_start=get_thread_bem_evaluations();
+  stats.rejected=0;
+  stats.new_zones=0;
+  stats.reason=STOP_NONE;
   D=0.0005;/* the old= 0.001 */
   if(step_size<10.0*D)
     {
@@ -640,6 +708,12 @@ double streamline_loop(P,c,direction,max_steps,step_size,streamline,
   t_sum=0.0;
   j=0;
   new_z=1;
+  tracker=create_stop_tracker(max_steps);
+  start_stop_tracker(tracker,step_size);
+  merge_begin(c,direction);
+  start_predictor(&pred);
+  P_old[0]=P[0];
+  P_old[1]=P[1];
   /*---------------------------------*/
   while(new_z>=0 && (max_steps<0 || j<max_steps) ) 
     {
@@ -654,13 +728,15 @@ double streamline_loop(P,c,direction,max_steps,step_size,streamline,
 	      exit(0);
 	    }
 	  r=r/2.0;
+	  stats.rejected=stats.rejected+1;
 	  P[0]=P[0]-dP[0];  	  P[1]=P[1]-dP[1];
 	  edit1_my_follow_stream(direction,P, vol.dV, vol.d2V, dP,r);
 	  P[0]=P[0]+dP[0];        P[1]=P[1]+dP[1];   
 	}
       else /* not on path */
 	{
-          pp=calculate_inside_catchment(c,P,vectors,&vol,&new_z);
+          pp=predicted_inside_catchment(c,P,vectors,&vol,&new_z,
+					(j==0) ? EVAL_ALL : EVAL_DV|EVAL_D2V,&pred);
 	  if(j==0) /* return values at starting point */
 	    {
 	      v1->V=pp;
@@ -672,19 +748,26 @@ double streamline_loop(P,c,direction,max_steps,step_size,streamline,
 	      v1->d2V[1][1]=vol.d2V[1][1];
 	    }
 
-	  if(j%50==0) printf("\n");
-	  if(j%10==0) { printf("(%d)",j); fflush(stdout); }
-	  if(new_z==0) { printf("s"); fflush(stdout); }/* same zone */
-	  if(new_z==1) { printf("(%d)N",j); fflush(stdout); }/* new zone */ 
+	  if(log_on(LOG_DEBUG,LOG_STREAM)) /* every step */
+	    {
+	      if(j%50==0) printf("\n");
+	      if(j%10==0) { printf("(%d)",j); fflush(stdout); }
+	      if(new_z==0) { printf("s"); fflush(stdout); }/* same zone */
+	      if(new_z==1) { printf("(%d)N",j); fflush(stdout); }/* new zone */ 
+	    }
+	  else if(j%10==0 && log_progress(LOG_STREAM))
+	    { printf("(%d)",j); fflush(stdout); }
 	    
 	  if(new_z>=0) /* inside catchment; not on path */
 	    {
 	      if(new_z==1||j==0)  /* new zone or first time */
 		{
+		  if(new_z==1) stats.new_zones=stats.new_zones+1;
 		  L_sum=L_sum+t_sum*GH0;
 		  t_sum=0.0;
 		  GH0=sqrt(vol.dV[0]*vol.dV[0]+vol.dV[1]*vol.dV[1]);
 		  G_old=GH0;
+		  merge_new_zone(GH0);
 		}
 	      else /* old zone and not first time */
 		{
@@ -693,20 +776,55 @@ double streamline_loop(P,c,direction,max_steps,step_size,streamline,
 		  G_old=G_new;
 		  r=step_size;
 		}
+	      merge_point(P,c->previous_zone,t_sum);
 	    }
-	  else /* outside catchement */
+	  else if(log_on(LOG_INFO,LOG_STREAM)) /* outside catchement */
 	    { printf(" outside catchment\n"); }
 	  if(streamline!=(path *)NULL) { put_path_xy(streamline,j,P); }
+	  if(new_z==0 && j>0 &&  /* joined a streamline traced before */
+	     merge_lookup(P,c->previous_zone,&t_rest,&L_after)==1)
+	    {
+	      stats.reason=STOP_MERGED;
+	      j=j+1;
+	      break;
+	    }
+	  if(new_z>=0) /* pit, flat area or going round in circles */
+	    {
+	      stats.reason=check_stop(tracker,P,
+				      sqrt(vol.dV[0]*vol.dV[0]+vol.dV[1]*vol.dV[1]),
+				      sqrt((P[0]-P_old[0])*(P[0]-P_old[0])+
+					   (P[1]-P_old[1])*(P[1]-P_old[1])));
+	      if(stats.reason!=STOP_NONE) { j=j+1; break; }
+	    }
+	  P_old[0]=P[0];        P_old[1]=P[1];
 
 	  edit1_my_follow_stream(direction,P, vol.dV, vol.d2V, dP,r);
 	  P[0]=P[0]+dP[0];        P[1]=P[1]+dP[1];   
 	  j=j+1;
 	}//end of not path
     } //end of while
-  L_sum=L_sum+t_sum*GH0;
-  printf(" L=%.4f",L_sum);
-
+  if(stats.reason==STOP_MERGED)
+    {
+      L_sum=L_sum+(t_sum+t_rest)*GH0+L_after;
+      merge_end(t_rest,L_after);
+    }
+  else
+    {
+      L_sum=L_sum+t_sum*GH0;
+      merge_end(0.0,0.0);
+    }
+  if(log_on(LOG_INFO,LOG_STREAM)) printf(" L=%.4f",L_sum);
+
+  if(stats.reason==STOP_NONE) stats.reason=(new_z<0) ? STOP_OUTSIDE : STOP_MAX_STEPS;
+  tracker=destroy_stop_tracker(tracker);
+  stats.steps=j;
+  stats.evaluations=get_thread_bem_evaluations()-evals_start;
+  report_stream_stats(&stats);
+  if(pred.k>0 && log_on(LOG_INFO,LOG_STREAM))
+    printf(" predicted=%d k=%d",pred.predicted,pred.k);
   if(streamline!=(path *)NULL) streamline->points=j;
+  perf_end(&sample,PERF_TRACING,0.0);
+  trace_end(&span);
   return(L_sum);
 }
 /*--------------------------------------------------------*/
@@ -750,7 +868,7 @@ double SCA_loop_GH0_v2(P,c,direction,max_steps,step_size,streamline,
     { printf("\nPA is outside catchment.");
       printf("\nPlease, put the PA inside catchment\n");
       exit(0); }
-  pp=calculate_inside_catchment(c,Pc,vectors,&vol_Pc,&newz_Lc);
+  pp=calculate_inside_catchment(c,Pc,vectors,&vol_Pc,&newz_Lc,EVAL_DV|EVAL_D2V);
   G_Pc=sqrt(vol_Pc.dV[0]*vol_Pc.dV[0]+vol_Pc.dV[1]*vol_Pc.dV[1]);
   GH0=G_Pc;
   if(streamline!=(path *)NULL) { put_path_xy(streamline,j,Pc); }
@@ -763,7 +881,7 @@ double SCA_loop_GH0_v2(P,c,direction,max_steps,step_size,streamline,
     { printf("\nNext step of PA is outside catchment.");
       printf("\nPlease, put the PA inside catchment\n");
       exit(0); }
-  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln);
+  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln,EVAL_DV|EVAL_D2V);
   G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
 
   //Part-1.3: Sin_theta_Pc
@@ -811,7 +929,7 @@ double SCA_loop_GH0_v2(P,c,direction,max_steps,step_size,streamline,
 	  //Set the new Pn
 	  Pn[0]=Pn[0]+dP[0];
 	  Pn[1]=Pn[1]+dP[1];
-	  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln);
+	  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln,EVAL_DV|EVAL_D2V);
 	  if(newz_Ln>=0) /* Pn is inside the catchment */
 	    {
 	      G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
@@ -853,7 +971,7 @@ double SCA_loop_GH0_v2(P,c,direction,max_steps,step_size,streamline,
 	}
       else /* Pn is not on the boundary */
 	{
-	  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln);
+	  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln,EVAL_DV|EVAL_D2V);
 	  if(newz_Ln>=0) /* Pn is inside the catchment */
 	    {
 	      G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
@@ -950,7 +1068,7 @@ double SCA_loop_GH0_v3(P,c,direction,max_steps,step_size,streamline,
     { printf("\nPA is outside catchment.");
       printf("\nPlease, put the PA inside catchment\n");
       exit(0); }
-  pp=calculate_inside_catchment(c,Pc,vectors,&vol_Pc,&newz_Lc);
+  pp=calculate_inside_catchment(c,Pc,vectors,&vol_Pc,&newz_Lc,EVAL_DV|EVAL_D2V);
   G_Pc=sqrt(vol_Pc.dV[0]*vol_Pc.dV[0]+vol_Pc.dV[1]*vol_Pc.dV[1]);
   GH0=G_Pc;
   if(streamline!=(path *)NULL) { put_path_xy(streamline,j,Pc); }
@@ -963,7 +1081,7 @@ double SCA_loop_GH0_v3(P,c,direction,max_steps,step_size,streamline,
     { printf("\nNext step of PA is outside catchment.");
       printf("\nPlease, put the PA inside catchment\n");
       exit(0); }
-  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln);
+  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln,EVAL_DV|EVAL_D2V);
   G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
 
   //Part-1.3: Sin_theta_Pc
@@ -983,7 +1101,7 @@ double SCA_loop_GH0_v3(P,c,direction,max_steps,step_size,streamline,
     { printf("\nPA is outside catchment.");
       printf("\nPlease, put the PA inside catchment\n");
       exit(0); }
-  pp=calculate_inside_catchment(c,Pc2,vectors,&vol_Pc2,&newz_Lc2);
+  pp=calculate_inside_catchment(c,Pc2,vectors,&vol_Pc2,&newz_Lc2,EVAL_DV|EVAL_D2V);
   edit1_my_follow_stream(direction,Pc2,vol_Pc2.dV,vol_Pc2.d2V,dP2,r);
   Pn2[0]=Pc2[0]+dP2[0];
   Pn2[1]=Pc2[1]+dP2[1];
@@ -992,7 +1110,7 @@ double SCA_loop_GH0_v3(P,c,direction,max_steps,step_size,streamline,
     { printf("\nNext step of PA is outside catchment.");
       printf("\nPlease, put the PA inside catchment\n");
       exit(0); }
-  pp=calculate_inside_catchment(c,Pn2,vectors,&vol_Pn2,&newz_Ln2);
+  pp=calculate_inside_catchment(c,Pn2,vectors,&vol_Pn2,&newz_Ln2,EVAL_DV|EVAL_D2V);
   
   //Part-1.5: SCA_j
   DL_j=GH0*(1.0/G_Pc+1.0/G_Pn);
@@ -1043,8 +1161,8 @@ double SCA_loop_GH0_v3(P,c,direction,max_steps,step_size,streamline,
 	  Pn[0] =Pn[0] +dP[0];	  Pn[1] =Pn[1] +dP[1];
 	  Pn2[0]=Pn2[0]+dP2[0];	  Pn2[1]=Pn2[1]+dP2[1];
 	  
-	  pp=calculate_inside_catchment(c,Pn ,vectors,&vol_Pn ,&newz_Ln);
-	  pp=calculate_inside_catchment(c,Pn2,vectors,&vol_Pn2,&newz_Ln2);
+	  pp=calculate_inside_catchment(c,Pn ,vectors,&vol_Pn ,&newz_Ln,EVAL_DV|EVAL_D2V);
+	  pp=calculate_inside_catchment(c,Pn2,vectors,&vol_Pn2,&newz_Ln2,EVAL_DV|EVAL_D2V);
 	  if(newz_Ln>=0) /* Pn is inside the catchment */
 	    {
 	      G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
@@ -1091,8 +1209,8 @@ double SCA_loop_GH0_v3(P,c,direction,max_steps,step_size,streamline,
 	}
       else /* Pn is not on the boundary */
 	{
-	  pp=calculate_inside_catchment(c,Pn ,vectors,&vol_Pn ,&newz_Ln);
-	  pp=calculate_inside_catchment(c,Pn2,vectors,&vol_Pn2,&newz_Ln2);
+	  pp=calculate_inside_catchment(c,Pn ,vectors,&vol_Pn ,&newz_Ln,EVAL_DV|EVAL_D2V);
+	  pp=calculate_inside_catchment(c,Pn2,vectors,&vol_Pn2,&newz_Ln2,EVAL_DV|EVAL_D2V);
 	  if(newz_Ln>=0) /* Pn is inside the catchment */
 	    {
 	      G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
@@ -1195,7 +1313,7 @@ double SCA_loop_GH0_v4(P,c,direction,max_steps,step_size,streamline,
     { printf("\nPA is outside catchment.");
       printf("\nPlease, put the PA inside catchment\n");
       exit(0); }
-  pp=calculate_inside_catchment(c,Pc,vectors,&vol_Pc,&newz_Lc);
+  pp=calculate_inside_catchment(c,Pc,vectors,&vol_Pc,&newz_Lc,EVAL_DV|EVAL_D2V);
   G_Pc=sqrt(vol_Pc.dV[0]*vol_Pc.dV[0]+vol_Pc.dV[1]*vol_Pc.dV[1]);
   GH0=G_Pc;
   if(streamline!=(path *)NULL) { put_path_xy(streamline,j,Pc); }
@@ -1208,7 +1326,7 @@ double SCA_loop_GH0_v4(P,c,direction,max_steps,step_size,streamline,
     { printf("\nNext step of PA is outside catchment.");
       printf("\nPlease, put the PA inside catchment\n");
       exit(0); }
-  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln);
+  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln,EVAL_DV|EVAL_D2V);
   G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
 
   //Part-1.3: Sin_theta_Pc
@@ -1258,7 +1376,7 @@ double SCA_loop_GH0_v4(P,c,direction,max_steps,step_size,streamline,
 	  //Set the new Pn
 	  Pn[0]=Pn[0]+dP[0];
 	  Pn[1]=Pn[1]+dP[1];
-	  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln);
+	  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln,EVAL_DV|EVAL_D2V);
 	  if(newz_Ln>=0) /* Pn is inside the catchment */
 	    {
 	      G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
@@ -1300,7 +1418,7 @@ double SCA_loop_GH0_v4(P,c,direction,max_steps,step_size,streamline,
 	}
       else /* Pn is not on the boundary */
 	{
-	  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln);
+	  pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln,EVAL_DV|EVAL_D2V);
 	  if(newz_Ln>=0) /* Pn is inside the catchment */
 	    {
 	      G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
@@ -1395,7 +1513,7 @@ double SCA_loop_GH0_v5(P,c,direction,max_steps,step_size,streamline,
   Pc[0]=P[0];
   Pc[1]=P[1];
   Pc_zone=check_each_zone(c,Pc);
-  pp=calculate_inside_catchment(c,Pc,vectors,&vol_Pc,&newz_Lc);
+  pp=calculate_inside_catchment(c,Pc,vectors,&vol_Pc,&newz_Lc,EVAL_DV|EVAL_D2V);
   G_Pc=sqrt(vol_Pc.dV[0]*vol_Pc.dV[0]+vol_Pc.dV[1]*vol_Pc.dV[1]);  
   GH0=G_Pc;
   newz_Ln=newz_Lc;
@@ -1404,7 +1522,7 @@ double SCA_loop_GH0_v5(P,c,direction,max_steps,step_size,streamline,
       edit1_my_follow_stream(direction,Pc,vol_Pc.dV,vol_Pc.d2V,dP,r);
       Pn[0]=Pc[0]+dP[0];
       Pn[1]=Pc[1]+dP[1];      
-      pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln);
+      pp=calculate_inside_catchment(c,Pn,vectors,&vol_Pn,&newz_Ln,EVAL_DV|EVAL_D2V);
       G_Pn=sqrt(vol_Pn.dV[0]*vol_Pn.dV[0]+vol_Pn.dV[1]*vol_Pn.dV[1]);
       check_each_path(c,Pn,&d,&s,&segment,&this_path);
       if(newz_Ln==1){ GH0=G_Pn;	}
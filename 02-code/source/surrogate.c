@@ -0,0 +1,580 @@
+/*--------------------------------- surrogate.c ------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* surrogate of V, dV and d2V for each zone on an adaptive quadtree                 */
+/*                                                                                  */
+/* When a zone is solved its square is split into cells. A cell that a contour     */
+/* passes through (distance from its centre to a path less than half the diagonal) */
+/* is split again, and at the last level becomes an exact cell, where the bem      */
+/* evaluation is still used. Other cells get V, dV and d2V at their 4 corners and  */
+/* centre; V and dV are interpolated with the bicubic Hermite form using V, Vx, Vy */
+/* and Vxy at the corners, d2V bilinearly. The cell is a leaf when at the centre   */
+/*   |dV - dV_exact| <= tol*|dV_exact|  and  |d2V - d2V_exact|*size <= tol*|dV_exact|*/
+/* otherwise it is split. Samples are taken with packet_field, which is thread     */
+/* safe, in an OpenMP loop. The tree is saved in the catchment directory as        */
+/* surrogate_<key>.bin, key being a hash of the zone's points and their values     */
+/* (elevations), and read back by later runs with the same tolerance. Zones of     */
+/* other threads (tile, sca) are solved concurrently: the surrogates are chained in */
+/* a list (as many as there are zones), added to under a critical section and read */
+/* without it, each link being written and loaded atomically.                      */
+/* tol<=0 (the default) switches it off.                                           */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "stream_types.h"
+#include "surrogate_types.h"
+#include "logging_types.h"
+
+#include "catchment.h"
+#include "file.h"
+#include "logging.h"
+#include "matrix.h"
+#include "packet.h"
+#include "path.h"
+
+#include "surrogate.h"
+/*----------------------------------------------------------------------------------*/
+#define SURROGATE_DEPTH 8        /* smallest cell = root/256 */
+#define MIN_DEPTH 2              /* cells are not accepted above this depth */
+#define GRID (1<<(SURROGATE_DEPTH+1))  /* sample grid: centres of the smallest cells */
+#define SURROGATE_MAGIC 0x53555231
+/*----------------------------------------------------------------------------------*/
+static double surrogate_tol=0.0;   /* <=0 = off */
+static surrogate *first_sur=(surrogate *)NULL;
+static surrogate *last_sur=(surrogate *)NULL;
+/*----------------------------------------------------------------------------------*/
+void set_surrogate_tolerance(tol)
+     double tol;
+{
+  surrogate_tol=tol;
+}
+/*----------------------------------------------------------------------------------*/
+double get_surrogate_tolerance()
+{
+  return(surrogate_tol);
+}
+/*----------------------------------------------------------------------------------*/
+static void *grow(p,n,size)
+     void *p;
+     int n,size;
+{
+  p=realloc(p,(size_t)n*size);
+  if(p==NULL)
+    {
+      printf("Cannot allocate memory for surrogate\n");
+      exit(0);
+    }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+/* hash of the points and values of all paths of zone b (FNV-1a over the bytes) */
+/*----------------------------------------------------------------------------------*/
+static unsigned long zone_key(b)
+     boundary *b;
+{
+  unsigned long h;
+  unsigned char *byte;
+  int j,i,k;
+  path *p;
+
+  h=2166136261UL;
+  for(j=0;j<b->components;j++)
+    {
+      p=b->loop[j];
+      for(i=0;i<p->points;i++)
+	{
+	  byte=(unsigned char *)p->xy[i];
+	  for(k=0;k<(int)sizeof(coordinates);k++)
+	    h=((h^byte[k])*16777619UL) & 0xffffffffUL;
+	  byte=(unsigned char *)&p->value[i];
+	  for(k=0;k<(int)sizeof(double);k++)
+	    h=((h^byte[k])*16777619UL) & 0xffffffffUL;
+	}
+      h=((h^(unsigned long)(p->points+b->level[j]))*16777619UL) & 0xffffffffUL;
+    }
+  return(h);
+}
+/*----------------------------------------------------------------------------------*/
+static surrogate *find_surrogate(b)
+     boundary *b;
+{
+  surrogate *s;
+
+#pragma omp atomic read seq_cst
+  s=first_sur;
+  while(s!=(surrogate *)NULL)
+    {
+      if(s->b==b) return(s);
+#pragma omp atomic read seq_cst
+      s=s->next;
+    }
+  return((surrogate *)NULL);
+}
+/*----------------------------------------------------------------------------------*/
+static int new_cell(s,kind)
+     surrogate *s;
+     int kind;
+{
+  if(s->n_cells>=s->max_cells)
+    {
+      s->max_cells=2*s->max_cells+64;
+      s->kind=(char *)grow(s->kind,s->max_cells,sizeof(char));
+      s->child=(int *)grow(s->child,s->max_cells,sizeof(int));
+      s->corner=(int *)grow(s->corner,4*s->max_cells,sizeof(int));
+    }
+  s->kind[s->n_cells]=(char)kind;
+  s->child[s->n_cells]=(-1);
+  s->n_cells=s->n_cells+1;
+  return(s->n_cells-1);
+}
+/*----------------------------------------------------------------------------------*/
+/* Hermite interpolation in a cell of side h; (u,v) in [0,1]x[0,1] */
+/*----------------------------------------------------------------------------------*/
+static void hermite(c,u,v,h,R)
+     bem_results *c[4];
+     double u,v,h;
+     bem_results *R;
+{
+  double A[2],B[2],dA[2],dB[2],Av[2],Bv[2],dAv[2],dBv[2],w[4];
+  int a,b,k;
+
+  A[0]=1.0-u*u*(3.0-2.0*u);   A[1]=u*u*(3.0-2.0*u);
+  B[0]=u*(1.0-u)*(1.0-u);     B[1]=u*u*(u-1.0);
+  dA[0]=-6.0*u*(1.0-u);       dA[1]=6.0*u*(1.0-u);
+  dB[0]=(1.0-u)*(1.0-3.0*u);  dB[1]=u*(3.0*u-2.0);
+  Av[0]=1.0-v*v*(3.0-2.0*v);  Av[1]=v*v*(3.0-2.0*v);
+  Bv[0]=v*(1.0-v)*(1.0-v);    Bv[1]=v*v*(v-1.0);
+  dAv[0]=-6.0*v*(1.0-v);      dAv[1]=6.0*v*(1.0-v);
+  dBv[0]=(1.0-v)*(1.0-3.0*v); dBv[1]=v*(3.0*v-2.0);
+  w[0]=(1.0-u)*(1.0-v);  w[1]=u*(1.0-v);  w[2]=(1.0-u)*v;  w[3]=u*v;
+
+  R->V=0.0;
+  R->dV[0]=0.0;     R->dV[1]=0.0;
+  R->d2V[0][0]=0.0; R->d2V[0][1]=0.0;
+  R->d2V[1][0]=0.0; R->d2V[1][1]=0.0;
+  for(b=0;b<2;b++)
+    for(a=0;a<2;a++)
+      {
+	k=a+2*b;
+	R->V=R->V+c[k]->V*A[a]*Av[b]+h*(c[k]->dV[0]*B[a]*Av[b]+c[k]->dV[1]*A[a]*Bv[b])
+	  +h*h*c[k]->d2V[0][1]*B[a]*Bv[b];
+	R->dV[0]=R->dV[0]+c[k]->V*dA[a]*Av[b]/h+c[k]->dV[0]*dB[a]*Av[b]
+	  +c[k]->dV[1]*dA[a]*Bv[b]+h*c[k]->d2V[0][1]*dB[a]*Bv[b];
+	R->dV[1]=R->dV[1]+c[k]->V*A[a]*dAv[b]/h+c[k]->dV[0]*B[a]*dAv[b]
+	  +c[k]->dV[1]*A[a]*dBv[b]+h*c[k]->d2V[0][1]*B[a]*dBv[b];
+	R->d2V[0][0]=R->d2V[0][0]+w[k]*c[k]->d2V[0][0];
+	R->d2V[0][1]=R->d2V[0][1]+w[k]*c[k]->d2V[0][1];
+	R->d2V[1][0]=R->d2V[1][0]+w[k]*c[k]->d2V[1][0];
+	R->d2V[1][1]=R->d2V[1][1]+w[k]*c[k]->d2V[1][1];
+      }
+}
+/*----------------------------------------------------------------------------------*/
+/* field at P from the surrogate of zone b; returns 0 if P needs a bem evaluation */
+/*----------------------------------------------------------------------------------*/
+int surrogate_field(b,P,R)
+     boundary *b;
+     coordinates P;
+     bem_results *R;
+{
+  surrogate *s;
+  bem_results *c[4];
+  double u,v,h,x0,y0;
+  int i,k;
+
+  if(surrogate_tol<=0.0) return(0);
+  s=find_surrogate(b);
+  if(s==(surrogate *)NULL) return(0);
+  u=(P[0]-s->origin[0])/s->size;
+  v=(P[1]-s->origin[1])/s->size;
+  if(u<0.0 || u>=1.0 || v<0.0 || v>=1.0) return(0);
+
+  i=0;
+  h=s->size;
+  x0=s->origin[0];
+  y0=s->origin[1];
+  while(s->kind[i]==CELL_SPLIT)
+    {
+      h=0.5*h;
+      k=0;
+      if(P[0]>=x0+h) { k=k+1; x0=x0+h; }
+      if(P[1]>=y0+h) { k=k+2; y0=y0+h; }
+      i=s->child[i]+k;
+    }
+  if(s->kind[i]!=CELL_HERMITE) return(0);
+  for(k=0;k<4;k++) c[k]=&s->sample[s->corner[4*i+k]];
+  hermite(c,(P[0]-x0)/h,(P[1]-y0)/h,h,R);
+#pragma omp atomic
+  s->hits++;
+  return(1);
+}
+/*----------------------------------------------------------------------------------*/
+/* does the interpolation of cell i (side h) match sample e at its centre */
+/*----------------------------------------------------------------------------------*/
+static int cell_accepted(s,i,h,e)
+     surrogate *s;
+     int i;
+     double h;
+     bem_results *e;
+{
+  bem_results *c[4],R;
+  double g,dg,dh;
+  int k;
+
+  for(k=0;k<4;k++) c[k]=&s->sample[s->corner[4*i+k]];
+  hermite(c,0.5,0.5,h,&R);
+  g=sqrt(e->dV[0]*e->dV[0]+e->dV[1]*e->dV[1]);
+  dg=sqrt((R.dV[0]-e->dV[0])*(R.dV[0]-e->dV[0])+(R.dV[1]-e->dV[1])*(R.dV[1]-e->dV[1]));
+  dh=sqrt((R.d2V[0][0]-e->d2V[0][0])*(R.d2V[0][0]-e->d2V[0][0])+
+	  (R.d2V[0][1]-e->d2V[0][1])*(R.d2V[0][1]-e->d2V[0][1]));
+  return(dg<=s->tol*g && dh*h<=s->tol*g);
+}
+/*----------------------------------------------------------------------------------*/
+/* cells of one level of the tree and the grid position of their low corner */
+/*----------------------------------------------------------------------------------*/
+static void grow_level(n,max,cell,gx,gy)
+     int n,*max;
+     int **cell,**gx,**gy;
+{
+  if(n<=(*max)) return;
+  (*max)=2*n+64;
+  (*cell)=(int *)grow(*cell,*max,sizeof(int));
+  (*gx)=(int *)grow(*gx,*max,sizeof(int));
+  (*gy)=(int *)grow(*gy,*max,sizeof(int));
+}
+/*----------------------------------------------------------------------------------*/
+/* build the tree of s for its zone, whose bem solution is in x */
+/*----------------------------------------------------------------------------------*/
+static void build_surrogate(s,x)
+     surrogate *s;
+     bem_vectors *x;
+{
+  boundary *b;
+  double *bvv,*bcv,step,h,hd,d,sd;
+  coordinates P,*Q;
+  int *grid,*cell,*gx,*gy,*n_cell,*n_gx,*n_gy,*test,*req,*t;
+  int n_level,max_level,n_next,max_next,max_test,n_req,max_req;
+  int depth,i,j,k,m,w,touch,c,g[5],segment;
+
+  b=s->b;
+  bvv=startof_matrix(x->bvv);
+  bcv=startof_matrix(x->bcv);
+  step=s->size/(double)GRID;
+  grid=(int *)grow(NULL,(GRID+1)*(GRID+1),sizeof(int));
+  for(i=0;i<(GRID+1)*(GRID+1);i++) grid[i]=(-1);
+
+  cell=gx=gy=n_cell=n_gx=n_gy=test=req=(int *)NULL;
+  Q=(coordinates *)NULL;
+  max_level=max_next=max_test=max_req=0;
+  grow_level(1,&max_level,&cell,&gx,&gy);
+  cell[0]=new_cell(s,CELL_SPLIT);
+  gx[0]=0;
+  gy[0]=0;
+  n_level=1;
+
+  for(depth=0;n_level>0;depth++)
+    {
+      w=GRID>>depth;          /* cell side in grid steps */
+      h=w*step;
+      hd=0.5*sqrt(2.0)*h;
+      if(n_level>max_test)
+	{
+	  max_test=n_level;
+	  test=(int *)grow(test,max_test,sizeof(int));
+	}
+
+      /* cells crossed by a contour; samples wanted by the others */
+      n_req=0;
+      for(j=0;j<n_level;j++)
+	{
+	  c=cell[j];
+	  P[0]=s->origin[0]+(gx[j]+w/2)*step;
+	  P[1]=s->origin[1]+(gy[j]+w/2)*step;
+	  touch=0;
+	  for(k=0;k<b->components && touch==0;k++)
+	    {
+	      distance_to_path(P,b->loop[k],&d,&sd,&segment);
+	      if(d<=hd) touch=1;
+	    }
+	  test[j]=0;
+	  if(touch==1)
+	    s->kind[c]=(depth<SURROGATE_DEPTH) ? CELL_SPLIT : CELL_EXACT;
+	  else if(check_zone(b,P)==0)
+	    s->kind[c]=CELL_EXACT;  /* outside the zone: never used */
+	  else
+	    {
+	      test[j]=1;
+	      g[0]=gx[j]*(GRID+1)+gy[j];
+	      g[1]=(gx[j]+w)*(GRID+1)+gy[j];
+	      g[2]=gx[j]*(GRID+1)+gy[j]+w;
+	      g[3]=(gx[j]+w)*(GRID+1)+gy[j]+w;
+	      g[4]=(gx[j]+w/2)*(GRID+1)+gy[j]+w/2;
+	      for(k=0;k<5;k++)
+		{
+		  if(grid[g[k]]!=(-1)) continue;
+		  if(n_req>=max_req)
+		    {
+		      max_req=2*max_req+256;
+		      req=(int *)grow(req,max_req,sizeof(int));
+		      Q=(coordinates *)grow(Q,max_req,sizeof(coordinates));
+		    }
+		  grid[g[k]]=(-2);
+		  req[n_req]=g[k];
+		  Q[n_req][0]=s->origin[0]+(g[k]/(GRID+1))*step;
+		  Q[n_req][1]=s->origin[1]+(g[k]%(GRID+1))*step;
+		  n_req=n_req+1;
+		}
+	    }
+	}
+
+      /* the samples, a packet at a time on each thread */
+      if(s->n_samples+n_req>s->max_samples)
+	{
+	  s->max_samples=2*(s->n_samples+n_req)+256;
+	  s->sample=(bem_results *)grow(s->sample,s->max_samples,sizeof(bem_results));
+	}
+#pragma omp parallel for schedule(dynamic)
+      for(i=0;i<n_req;i=i+MAX_PACKET)
+	packet_field(b,bvv,bcv,(n_req-i<MAX_PACKET) ? n_req-i : MAX_PACKET,
+		     &Q[i],&s->sample[s->n_samples+i]);
+      for(i=0;i<n_req;i++) grid[req[i]]=s->n_samples+i;
+      s->n_samples=s->n_samples+n_req;
+
+      /* accept the cells that interpolate well enough; split the rest */
+      n_next=0;
+      for(j=0;j<n_level;j++)
+	{
+	  c=cell[j];
+	  if(test[j]==1)
+	    {
+	      s->corner[4*c]=grid[gx[j]*(GRID+1)+gy[j]];
+	      s->corner[4*c+1]=grid[(gx[j]+w)*(GRID+1)+gy[j]];
+	      s->corner[4*c+2]=grid[gx[j]*(GRID+1)+gy[j]+w];
+	      s->corner[4*c+3]=grid[(gx[j]+w)*(GRID+1)+gy[j]+w];
+	      if(depth>=MIN_DEPTH &&
+		 cell_accepted(s,c,h,&s->sample[grid[(gx[j]+w/2)*(GRID+1)+gy[j]+w/2]]))
+		s->kind[c]=CELL_HERMITE;
+	      else
+		s->kind[c]=(depth<SURROGATE_DEPTH) ? CELL_SPLIT : CELL_EXACT;
+	    }
+	  if(s->kind[c]!=CELL_SPLIT) continue;
+	  grow_level(n_next+4,&max_next,&n_cell,&n_gx,&n_gy);
+	  m=new_cell(s,CELL_SPLIT);
+	  for(k=1;k<4;k++) new_cell(s,CELL_SPLIT);
+	  s->child[c]=m;
+	  for(k=0;k<4;k++)
+	    {
+	      n_cell[n_next]=m+k;
+	      n_gx[n_next]=gx[j]+((k&1) ? w/2 : 0);
+	      n_gy[n_next]=gy[j]+((k&2) ? w/2 : 0);
+	      n_next=n_next+1;
+	    }
+	}
+
+      /* the next level becomes the current one */
+      t=cell; cell=n_cell; n_cell=t;
+      t=gx;   gx=n_gx;     n_gx=t;
+      t=gy;   gy=n_gy;     n_gy=t;
+      k=max_level; max_level=max_next; max_next=k;
+      n_level=n_next;
+    }
+
+  free((void *)grid);
+  if(cell!=(int *)NULL)   { free((void *)cell);   free((void *)gx);   free((void *)gy); }
+  if(n_cell!=(int *)NULL) { free((void *)n_cell); free((void *)n_gx); free((void *)n_gy); }
+  if(test!=(int *)NULL) free((void *)test);
+  if(req!=(int *)NULL) free((void *)req);
+  if(Q!=(coordinates *)NULL) free((void *)Q);
+}
+/*----------------------------------------------------------------------------------*/
+/* name of the file holding the surrogate of a zone */
+/*----------------------------------------------------------------------------------*/
+static void surrogate_file(s,n,name)
+     surrogate *s;
+     int n;
+     char *name;
+{
+  char file[32];
+  int length;
+
+  catchment_path(n,(unsigned char *)name);
+  sprintf(file,"surrogate_%08lx.bin",s->key);
+  length=strlen(name);
+  strncat(name,file,n-length-1);
+}
+/*----------------------------------------------------------------------------------*/
+static void save_surrogate(s)
+     surrogate *s;
+{
+  FILE *output;
+  char name[160];
+  int head[4];
+  double value[4];
+
+  surrogate_file(s,160,name);
+  output=fopen(name,"wb");
+  if(output==(FILE *)NULL)
+    {
+      printf("Cannot save surrogate to '%s'\n",name);
+      return;
+    }
+  head[0]=SURROGATE_MAGIC;
+  head[1]=SURROGATE_DEPTH;
+  head[2]=s->n_cells;
+  head[3]=s->n_samples;
+  value[0]=s->tol;
+  value[1]=s->origin[0];
+  value[2]=s->origin[1];
+  value[3]=s->size;
+  fwrite(head,sizeof(int),4,output);
+  fwrite(value,sizeof(double),4,output);
+  fwrite(s->kind,sizeof(char),s->n_cells,output);
+  fwrite(s->child,sizeof(int),s->n_cells,output);
+  fwrite(s->corner,sizeof(int),4*s->n_cells,output);
+  fwrite(s->sample,sizeof(bem_results),s->n_samples,output);
+  fclose(output);
+}
+/*----------------------------------------------------------------------------------*/
+/* read the saved surrogate of s; returns 0 if there is none for this tolerance */
+/*----------------------------------------------------------------------------------*/
+static int load_surrogate(s)
+     surrogate *s;
+{
+  FILE *input;
+  char name[160];
+  int head[4],ok;
+  double value[4];
+
+  surrogate_file(s,160,name);
+  input=fopen(name,"rb");
+  if(input==(FILE *)NULL) return(0);
+  ok=(fread(head,sizeof(int),4,input)==4 && fread(value,sizeof(double),4,input)==4 &&
+      head[0]==SURROGATE_MAGIC && head[1]==SURROGATE_DEPTH && value[0]==s->tol &&
+      head[2]>0 && head[3]>=0);
+  if(ok)
+    {
+      s->origin[0]=value[1];
+      s->origin[1]=value[2];
+      s->size=value[3];
+      s->n_cells=s->max_cells=head[2];
+      s->n_samples=s->max_samples=head[3];
+      s->kind=(char *)grow(s->kind,s->max_cells,sizeof(char));
+      s->child=(int *)grow(s->child,s->max_cells,sizeof(int));
+      s->corner=(int *)grow(s->corner,4*s->max_cells,sizeof(int));
+      s->sample=(bem_results *)grow(s->sample,s->max_samples+1,sizeof(bem_results));
+      ok=(fread(s->kind,sizeof(char),s->n_cells,input)==(size_t)s->n_cells &&
+	  fread(s->child,sizeof(int),s->n_cells,input)==(size_t)s->n_cells &&
+	  fread(s->corner,sizeof(int),4*s->n_cells,input)==(size_t)(4*s->n_cells) &&
+	  fread(s->sample,sizeof(bem_results),s->n_samples,input)==(size_t)s->n_samples);
+    }
+  fclose(input);
+  if(!ok)
+    {
+      s->n_cells=0;
+      s->n_samples=0;
+    }
+  return(ok);
+}
+/*----------------------------------------------------------------------------------*/
+/* read or build the surrogate of zone b and append it to the list; the file of a  */
+/* zone made by another thread is written before the next one looks for it        */
+/*----------------------------------------------------------------------------------*/
+static void add_surrogate(b,x)
+     boundary *b;
+     bem_vectors *x;
+{
+  surrogate *s;
+  coordinates min,max,lo,hi;
+  double size;
+  int j;
+
+  s=(surrogate *)malloc(sizeof(surrogate));
+  if(s==(surrogate *)NULL)
+    {
+      printf("Cannot allocate memory for surrogate\n");
+      exit(0);
+    }
+  s->b=b;
+  s->key=zone_key(b);
+  s->tol=surrogate_tol;
+  s->n_cells=s->max_cells=0;
+  s->n_samples=s->max_samples=0;
+  s->kind=(char *)NULL;
+  s->child=(int *)NULL;
+  s->corner=(int *)NULL;
+  s->sample=(bem_results *)NULL;
+  s->hits=0;
+  s->next=(surrogate *)NULL;
+
+  if(load_surrogate(s)==0)
+    {
+      find_limits(b->loop[0],min,max);
+      for(j=1;j<b->components;j++)
+	{
+	  find_limits(b->loop[j],lo,hi);
+	  if(lo[0]<min[0]) min[0]=lo[0];
+	  if(lo[1]<min[1]) min[1]=lo[1];
+	  if(hi[0]>max[0]) max[0]=hi[0];
+	  if(hi[1]>max[1]) max[1]=hi[1];
+	}
+      size=(max[0]-min[0]>max[1]-min[1]) ? max[0]-min[0] : max[1]-min[1];
+      s->size=1.01*size;
+      s->origin[0]=min[0]-0.005*size;
+      s->origin[1]=min[1]-0.005*size;
+      build_surrogate(s,x);
+      save_surrogate(s);
+      if(log_on(LOG_INFO,LOG_ZONE))
+	printf("Surrogate %08lx built: %d cells, %d samples\n",s->key,s->n_cells,s->n_samples);
+    }
+  else if(log_on(LOG_INFO,LOG_ZONE))
+    printf("Surrogate %08lx read: %d cells, %d samples\n",s->key,s->n_cells,s->n_samples);
+
+  /* s is complete before it is linked in */
+  if(last_sur==(surrogate *)NULL)
+    {
+#pragma omp atomic write seq_cst
+      first_sur=s;
+    }
+  else
+    {
+#pragma omp atomic write seq_cst
+      last_sur->next=s;
+    }
+  last_sur=s;
+}
+/*----------------------------------------------------------------------------------*/
+/* zone b has just been solved (bem solution in x); make its surrogate if needed */
+/*----------------------------------------------------------------------------------*/
+void surrogate_zone_solved(b,x)
+     boundary *b;
+     bem_vectors *x;
+{
+  if(surrogate_tol<=0.0 || find_surrogate(b)!=(surrogate *)NULL) return;
+#pragma omp critical (surrogate_list)
+  {
+    /* another thread may have made it while this one waited */
+    if(find_surrogate(b)==(surrogate *)NULL) add_surrogate(b,x);
+  }
+}
+/*----------------------------------------------------------------------------------*/
+void report_surrogates()
+{
+  surrogate *s;
+  int k,n[3];
+
+  for(s=first_sur;s!=(surrogate *)NULL;s=s->next)
+    {
+      n[0]=n[1]=n[2]=0;
+      for(k=0;k<s->n_cells;k++) n[(int)s->kind[k]]++;
+      printf("  Surrogate %08lx:   %d cells (%d hermite, %d exact), %d samples, %ld uses\n",
+	     s->key,s->n_cells,n[CELL_HERMITE],n[CELL_EXACT],s->n_samples,s->hits);
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,449 @@
+/*---------------------------------- synthetic.c -----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* synthetic catchments with an exact solution                                      */
+/*                                                                                  */
+/* The values on the loops are those of a harmonic V, so the BEM field should be V  */
+/* everywhere and the flow paths (down the gradient, as catcharea goes) are known:  */
+/*   circles  rings between circles of radius r_inner..r_outer (geometric),        */
+/*            V = a + b ln r with V(r_inner)=1600, V(r_outer)=1400; the flow paths */
+/*            are radial to the outer circle. The mouth is a chord across the      */
+/*            innermost ring at distance r_m from the centre, width w, and the     */
+/*            area is that of the sector cut off by it:                             */
+/*              area = (phi/2) R^2 - r_m w/2,     phi = 2 atan(w/(2 r_m))           */
+/*            With one ring L of streamline_loop is (R^2-r^2)/(2r), not R-r, as the */
+/*            flow paths spread out. It takes the width of the flow afresh at the   */
+/*            start of each zone though, so with more rings C_area goes to limit,   */
+/*            the integral of that L over the mouth (by quadrature), not to area.   */
+/*   holes    a disc of radius r_outer with up to SYNTH_MAX_HOLES circular holes on */
+/*            x = -r_outer/3, V = a + b x; the flow paths go along -x until they   */
+/*            meet a hole or the outer circle. The mouth is on x = r_outer/2 and   */
+/*            area = limit = the integral of L dy (by quadrature).                  */
+/*   square   side r_outer, V = a + b x as well; the mouth is on x = r_outer/2 and */
+/*            area = limit = (r_outer/2) w.                                         */
+/* write_synthetic writes catchment.txt, the zone files, the path files and         */
+/* SYNTH_REFERENCE into a directory that CATCHMENT can point at; catcharea          */
+/* --reference=<that file> takes the mouth from it and reports the errors.          */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "synthetic_types.h"
+
+#include "synthetic.h"
+/*----------------------------------------------------------------------------------*/
+#define V_HIGH 1600.0
+#define V_LOW  1400.0
+#define MIN_LOOP 16        /* fewest points of a loop */
+#define QUADRATURE 200000  /* points of the integrals of L over the mouth */
+/*----------------------------------------------------------------------------------*/
+static char *reference=(char *)NULL;    /* --reference */
+static char *shape_names[3]={"circles","holes","square"};
+/*----------------------------------------------------------------------------------*/
+void set_synthetic_reference(file)
+     char *file;
+{
+  reference=file;
+}
+/*----------------------------------------------------------------------------------*/
+char *get_synthetic_reference()
+{
+  return(reference);
+}
+/*----------------------------------------------------------------------------------*/
+int synthetic_shape_from_name(name)
+     char *name;
+{
+  int i;
+
+  for(i=0;i<3;i++)
+    if(strcmp(name,shape_names[i])==0) return(i);
+  return(-1);
+}
+/*----------------------------------------------------------------------------------*/
+char *synthetic_shape_name(shape)
+     int shape;
+{
+  return(shape_names[shape]);
+}
+/*----------------------------------------------------------------------------------*/
+/* V at P and its gradient */
+/*----------------------------------------------------------------------------------*/
+double exact_synthetic_field(s,P,dV)
+     synthetic *s;
+     coordinates P,dV;
+{
+  double x,y,r2;
+
+  if(s->field==FIELD_LINEAR)
+    {
+      dV[0]=s->b;
+      dV[1]=0.0;
+      return(s->a+s->b*P[0]);
+    }
+  x=P[0]-s->centre[0];
+  y=P[1]-s->centre[1];
+  r2=x*x+y*y;
+  dV[0]=s->b*x/r2;
+  dV[1]=s->b*y/r2;
+  return(s->a+0.5*s->b*log(r2));
+}
+/*----------------------------------------------------------------------------------*/
+/* distance of the points of a flow path from the exact one through its first point */
+/*----------------------------------------------------------------------------------*/
+double synthetic_path_error(s,n,xy)
+     synthetic *s;
+     int n;
+     coordinates *xy;
+{
+  double ux,uy,u,d,error;
+  int k;
+
+  error=0.0;
+  if(n<2) return(error);
+  ux=xy[0][0]-s->centre[0];
+  uy=xy[0][1]-s->centre[1];
+  u=sqrt(ux*ux+uy*uy);
+  for(k=1;k<n;k++)
+    {
+      if(s->field==FIELD_LINEAR)
+	d=fabs(xy[k][1]-xy[0][1]);
+      else
+	d=fabs(ux*(xy[k][1]-s->centre[1])-uy*(xy[k][0]-s->centre[0]))/u;
+      if(d>error) error=d;
+    }
+  return(error);
+}
+/*----------------------------------------------------------------------------------*/
+/* length of the flow path from (x,y) along -x to a hole or the outer circle */
+/*----------------------------------------------------------------------------------*/
+static double hole_length(s,x,y)
+     synthetic *s;
+     double x,y;
+{
+  double end,e,dy;
+  int j;
+
+  end=-sqrt(s->r_outer*s->r_outer-y*y);
+  for(j=0;j<s->holes;j++)
+    {
+      dy=y-s->hole_y[j];
+      if(fabs(dy)>=s->hole_r) continue;
+      e=s->hole_x[j]+sqrt(s->hole_r*s->hole_r-dy*dy);
+      if(e<x && e>end) end=e;
+    }
+  return(x-end);
+}
+/*----------------------------------------------------------------------------------*/
+/* L of streamline_loop from radius r to the outer circle: in each ring the         */
+/* integral of |dV(entry)|/|dV| = r'/r_entry along the radius                       */
+/*----------------------------------------------------------------------------------*/
+static double ring_length(s,r)
+     synthetic *s;
+     double r;
+{
+  double q,r_k,r_next,L;
+  int k;
+
+  q=pow(s->r_outer/s->r_inner,1.0/s->zones);
+  L=0.0;
+  r_k=s->r_inner;
+  for(k=0;k<s->zones;k++)
+    {
+      r_next=(k==s->zones-1) ? s->r_outer : r_k*q;
+      if(r<r_next)
+	{
+	  L=L+(r_next*r_next-r*r)/(2.0*r);
+	  r=r_next;
+	}
+      r_k=r_next;
+    }
+  return(L);
+}
+/*----------------------------------------------------------------------------------*/
+/* the catchment, its field, its mouth and the exact areas */
+/*----------------------------------------------------------------------------------*/
+void make_synthetic(s,shape,n,zones,holes)
+     synthetic *s;
+     int shape,n,zones,holes;
+{
+  double R,r0,r1,r_m,r_e,w,phi,x,r,x_m,y1,y2,dy,sum;
+  int j;
+
+  memset(s,0,sizeof(synthetic));
+  s->shape=shape;
+  s->n=n;
+  s->zones=1;
+  s->r_outer=1000.0;
+  R=s->r_outer;
+  switch(shape)
+    {
+    case SYNTH_CIRCLES:
+      s->zones=zones;
+      s->r_inner=500.0;
+      s->field=FIELD_LOG;
+      s->b=(V_LOW-V_HIGH)/log(s->r_outer/s->r_inner);
+      s->a=V_HIGH-s->b*log(s->r_inner);
+      r0=s->r_inner;
+      r1=r0*pow(s->r_outer/s->r_inner,1.0/zones);
+      r_m=r0+0.25*(r1-r0);                   /* chord well inside the first ring */
+      r_e=r0+0.75*(r1-r0);
+      w=2.0*sqrt(r_e*r_e-r_m*r_m);
+      sprintf(s->mouth,"P(0) = (%.6f, %.6f)  P(%d) = (%.6f, %.6f)",
+	      -0.5*w,r_m,SYNTH_MOUTH,0.5*w,r_m);
+      phi=2.0*atan(w/(2.0*r_m));
+      s->area=0.5*phi*R*R-0.5*r_m*w;
+      sum=0.0;
+      dy=w/QUADRATURE;
+      for(j=0;j<QUADRATURE;j++)
+	{
+	  x=-0.5*w+(j+0.5)*dy;
+	  r=sqrt(x*x+r_m*r_m);                   /* L sin(theta) with sin(theta) = r_m/r */
+	  sum=sum+ring_length(s,r)*r_m/r;
+	}
+      s->limit=sum*dy;
+      break;
+
+    case SYNTH_HOLES:
+      s->holes=holes;
+      s->field=FIELD_LINEAR;
+      s->b=(V_HIGH-V_LOW)/(2.0*R);
+      s->a=0.5*(V_HIGH+V_LOW);
+      dy=0.0;
+      if(holes>0)
+	{
+	  dy=0.8*R/holes;
+	  s->hole_r=(0.3*dy<R/8.0) ? 0.3*dy : R/8.0;
+	}
+      for(j=0;j<holes;j++)
+	{
+	  s->hole_x[j]=-R/3.0;
+	  s->hole_y[j]=-0.4*R+(j+0.5)*dy;
+	}
+      x_m=0.5*R;
+      y1=-0.4*R;
+      y2=0.4*R;
+      sprintf(s->mouth,"P(0) = (%.6f, %.6f)  P(%d) = (%.6f, %.6f)",
+	      x_m,y1,SYNTH_MOUTH,x_m,y2);
+      sum=0.0;
+      dy=(y2-y1)/QUADRATURE;
+      for(j=0;j<QUADRATURE;j++)
+	sum=sum+hole_length(s,x_m,y1+(j+0.5)*dy);
+      s->area=sum*dy;
+      s->limit=s->area;
+      break;
+
+    case SYNTH_SQUARE:
+      s->field=FIELD_LINEAR;
+      s->b=(V_HIGH-V_LOW)/R;
+      s->a=V_LOW;
+      x_m=0.5*R;
+      sprintf(s->mouth,"P(0) = (%.6f, %.6f)  P(%d) = (%.6f, %.6f)",
+	      x_m,0.25*R,SYNTH_MOUTH,x_m,0.75*R);
+      s->area=x_m*0.5*R;
+      s->limit=s->area;
+      break;
+    }
+}
+/*----------------------------------------------------------------------------------*/
+static FILE *open_synthetic(dir,name)
+     char *dir,*name;
+{
+  char file[256];
+  FILE *output;
+
+  snprintf(file,256,"%s/%s",dir,name);
+  output=fopen(file,"w");
+  if(output==(FILE *)NULL)
+    {
+      printf("Cannot open file: '%s' for access mode 'w'\n",file);
+      exit(0);
+    }
+  return(output);
+}
+/*----------------------------------------------------------------------------------*/
+/* closed anticlockwise circle (first point not repeated) with the values of V */
+/*----------------------------------------------------------------------------------*/
+static int write_circle(s,dir,name,x,y,r,n)
+     synthetic *s;
+     char *dir,*name;
+     double x,y,r;
+     int n;
+{
+  FILE *output;
+  coordinates P,dV;
+  int k;
+
+  if(n<MIN_LOOP) n=MIN_LOOP;
+  output=open_synthetic(dir,name);
+  for(k=0;k<n;k++)
+    {
+      P[0]=x+r*cos(2.0*M_PI*k/n);
+      P[1]=y+r*sin(2.0*M_PI*k/n);
+      fprintf(output,"%.6f\t%.6f\t%.6f\n",P[0],P[1],exact_synthetic_field(s,P,dV));
+    }
+  fclose(output);
+  return(n);
+}
+/*----------------------------------------------------------------------------------*/
+static int write_square(s,dir,name)
+     synthetic *s;
+     char *dir,*name;
+{
+  FILE *output;
+  coordinates P,dV;
+  double corner[5][2];
+  int side,k,m;
+
+  m=s->n/4;
+  if(m<MIN_LOOP/4) m=MIN_LOOP/4;
+  corner[0][0]=0.0;         corner[0][1]=0.0;
+  corner[1][0]=s->r_outer;  corner[1][1]=0.0;
+  corner[2][0]=s->r_outer;  corner[2][1]=s->r_outer;
+  corner[3][0]=0.0;         corner[3][1]=s->r_outer;
+  corner[4][0]=0.0;         corner[4][1]=0.0;
+  output=open_synthetic(dir,name);
+  for(side=0;side<4;side++)
+    for(k=0;k<m;k++)
+      {
+	P[0]=corner[side][0]+(corner[side+1][0]-corner[side][0])*k/m;
+	P[1]=corner[side][1]+(corner[side+1][1]-corner[side][1])*k/m;
+	fprintf(output,"%.6f\t%.6f\t%.6f\n",P[0],P[1],exact_synthetic_field(s,P,dV));
+      }
+  fclose(output);
+  return(4*m);
+}
+/*----------------------------------------------------------------------------------*/
+/* catchment.txt, zone files, path files and SYNTH_REFERENCE in dir; returns the    */
+/* largest number of points in a zone                                               */
+/*----------------------------------------------------------------------------------*/
+int write_synthetic(s,dir)
+     synthetic *s;
+     char *dir;
+{
+  FILE *list,*zone,*output;
+  char name[32];
+  double r,q;
+  int j,k,points,most;
+
+  list=open_synthetic(dir,"catchment.txt");
+  most=0;
+  switch(s->shape)
+    {
+    case SYNTH_CIRCLES:
+      q=pow(s->r_outer/s->r_inner,1.0/s->zones);
+      r=s->r_inner;
+      points=write_circle(s,dir,"c0.txt",0.0,0.0,r,(int)(s->n*r/s->r_outer));
+      for(k=0;k<s->zones;k++)
+	{
+	  j=points;
+	  r=(k==s->zones-1) ? s->r_outer : r*q;
+	  sprintf(name,"c%d.txt",k+1);
+	  points=write_circle(s,dir,name,0.0,0.0,r,(int)(s->n*r/s->r_outer));
+	  if(j+points>most) most=j+points;
+	  sprintf(name,"zone%d.txt",k+1);
+	  fprintf(list,"%s\n",name);
+	  zone=open_synthetic(dir,name);
+	  fprintf(zone,"/c%d.txt\n/c%d.txt\n",k+1,k);   /* outer loop first */
+	  fclose(zone);
+	}
+      break;
+
+    case SYNTH_HOLES:
+      most=write_circle(s,dir,"outer.txt",0.0,0.0,s->r_outer,s->n);
+      fprintf(list,"zone1.txt\n");
+      zone=open_synthetic(dir,"zone1.txt");
+      fprintf(zone,"/outer.txt\n");
+      for(j=0;j<s->holes;j++)
+	{
+	  sprintf(name,"hole%d.txt",j+1);
+	  most=most+write_circle(s,dir,name,s->hole_x[j],s->hole_y[j],s->hole_r,
+				 (int)(s->n*s->hole_r/s->r_outer));
+	  fprintf(zone,"/%s\n",name);
+	}
+      fclose(zone);
+      break;
+
+    case SYNTH_SQUARE:
+      most=write_square(s,dir,"square.txt");
+      fprintf(list,"zone1.txt\n");
+      zone=open_synthetic(dir,"zone1.txt");
+      fprintf(zone,"/square.txt\n");
+      fclose(zone);
+      break;
+    }
+  fclose(list);
+
+  output=open_synthetic(dir,SYNTH_REFERENCE);
+  fprintf(output,"shape %s\n",shape_names[s->shape]);
+  fprintf(output,"n %d\n",s->n);
+  fprintf(output,"zones %d\n",s->zones);
+  fprintf(output,"holes %d\n",s->holes);
+  fprintf(output,"radii %.6f %.6f\n",s->r_inner,s->r_outer);
+  for(j=0;j<s->holes;j++)
+    fprintf(output,"hole %.6f %.6f %.6f\n",s->hole_x[j],s->hole_y[j],s->hole_r);
+  fprintf(output,"field %s %.12g %.12g %.6f %.6f\n",
+	  (s->field==FIELD_LINEAR) ? "linear" : "log",s->a,s->b,s->centre[0],s->centre[1]);
+  fprintf(output,"mouth %s\n",s->mouth);
+  fprintf(output,"area %.6f\n",s->area);
+  fprintf(output,"limit %.6f\n",s->limit);
+  fclose(output);
+  return(most);
+}
+/*----------------------------------------------------------------------------------*/
+/* the reference written by write_synthetic */
+/*----------------------------------------------------------------------------------*/
+void read_synthetic_reference(file,s)
+     char *file;
+     synthetic *s;
+{
+  FILE *input;
+  char line[256],word[32];
+  int found;
+
+  input=fopen(file,"r");
+  if(input==(FILE *)NULL)
+    {
+      printf("Cannot open file: '%s' for access mode 'r'\n",file);
+      exit(0);
+    }
+  memset(s,0,sizeof(synthetic));
+  found=0;
+  while(fgets(line,256,input)!=(char *)NULL)
+    {
+      line[strcspn(line,"\r\n")]='\0';
+      if(sscanf(line,"shape %31s",word)==1)
+	{
+	  s->shape=synthetic_shape_from_name(word);
+	  found=found|1;
+	}
+      else if(sscanf(line,"field %31s %lf %lf %lf %lf",word,&s->a,&s->b,
+		     &s->centre[0],&s->centre[1])==5)
+	{
+	  s->field=(strcmp(word,"linear")==0) ? FIELD_LINEAR : FIELD_LOG;
+	  found=found|2;
+	}
+      else if(strncmp(line,"mouth ",6)==0)
+	{
+	  strncpy(s->mouth,line+6,95);
+	  s->mouth[95]='\0';
+	  found=found|4;
+	}
+      else if(sscanf(line,"area %lf",&s->area)==1) found=found|8;
+      else if(sscanf(line,"limit %lf",&s->limit)==1) found=found|16;
+      else if(sscanf(line,"n %d",&s->n)==1) continue;
+      else if(sscanf(line,"zones %d",&s->zones)==1) continue;
+      else if(sscanf(line,"holes %d",&s->holes)==1) continue;
+      else if(sscanf(line,"radii %lf %lf",&s->r_inner,&s->r_outer)==2) continue;
+    }
+  fclose(input);
+  if(found!=31 || s->shape<0)
+    {
+      printf("'%s' is not a reference written by gencatch\n",file);
+      exit(0);
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -9,8 +9,10 @@
 #include "boundary_types.h" 
 #include "matrix_types.h" 
 #include "ten_matrix_types.h" 
+#include "memtrack_types.h"
 
 #include "matrix.h" 
+#include "memtrack.h"
 
 #include "ten_matrix.h" 
 /*----------------------------------------------------------------------------------*/
@@ -24,13 +26,13 @@ ten_matrix *create_ten_matrix(rows,columns)
  ten_matrix *x; 
  tensor *data; 
  
- x=(ten_matrix *)malloc(sizeof(ten_matrix)); 
+ x=(ten_matrix *)tracked_malloc(sizeof(ten_matrix),-1); 
  if(x==(ten_matrix *)NULL) 
    { 
  printf("error allocating memory for matrix\n"); 
  exit(0); 
    } 
- data=(tensor *)malloc(rows*columns*sizeof(tensor)); 
+ data=(tensor *)tracked_malloc(rows*columns*sizeof(tensor),-1); 
  if(data==(tensor *)NULL) 
    { 
  printf("error allocating memory for matrix\n"); 
@@ -68,8 +70,8 @@ ten_matrix *destroy_ten_matrix(x)
 { 
   if(x!=(ten_matrix *)NULL)
     {
-      if(x->value!=(tensor *)NULL) free((void *)x->value); 
-      free((void *)x); 
+      if(x->value!=(tensor *)NULL) tracked_free((void *)x->value); 
+      tracked_free((void *)x); 
     }
   return((void *)NULL); 
 } 
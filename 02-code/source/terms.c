@@ -352,6 +352,142 @@ double Tm(x,y1,y2)
   return(tm);
 }
 
+/*----------------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------------*/
+/*---------------------- Stream Function (Conjugate) Terms -------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* The harmonic conjugates of the P off S terms: log r goes to the angle of P-Q and */
+/* the double layer kernel -x/r^2 to t/r^2. Along the segment the angle of P-Q is   */
+/* a+atan3(t,y1,x), a being the angle of P-Qa (measured from some reference).       */
+/*----------------------------------------------------------------------------------*/
+double Vconj_PoffS(x, y1, y2)
+     double x, y1, y2;
+{
+  double y,len,V;
+
+  y=(y1+y2)/2.0;
+  len=y2-y1;
+  V = (-Sw(x,y1,y2)*y+Sv(x,y1,y2))/len;
+  V = V/(2.0*M_PI);
+  return(V);
+}
+
+/*----------------------------------------------------------------------------------*/
+double Wconj_PoffS(x, y1, y2)
+     double x, y1, y2;
+{
+  double W;
+
+  W = Sw(x,y1,y2);
+  W = W/(2.0*M_PI);
+  return(W);
+}
+
+/*----------------------------------------------------------------------------------*/
+double Jconj_PoffS(x, y1, y2, a)
+     double x, y1, y2, a;
+{
+  double y,len,J;
+
+  y=(y1+y2)/2.0;
+  len=y2-y1;
+  len=len*len*len;
+  J = (((-Sa(x,y1,y2,a,0)*y+3.0*Sa(x,y1,y2,a,1))*y
+	               -3.0*Sa(x,y1,y2,a,2))*y+Sa(x,y1,y2,a,3))/len;
+  J = J/(2.0*M_PI);
+  return(J);
+}
+
+/*----------------------------------------------------------------------------------*/
+double Kconj_PoffS(x, y1, y2, a)
+     double x, y1, y2, a;
+{
+  double y,len,K;
+
+  y=(y1+y2)/2.0;
+  len=y2-y1;
+  len=len*len;
+  K = ((Sa(x,y1,y2,a,0)*y-2.0*Sa(x,y1,y2,a,1))*y+Sa(x,y1,y2,a,2))/len;
+  K = K/(2.0*M_PI);
+  return(K);
+}
+
+/*----------------------------------------------------------------------------------*/
+double Lconj_PoffS(x, y1, y2, a)
+     double x, y1, y2, a;
+{
+  double y,len,L;
+
+  y=(y1+y2)/2.0;
+  len=y2-y1;
+  L = (-Sa(x,y1,y2,a,0)*y+Sa(x,y1,y2,a,1))/len;
+  L = L/(2.0*M_PI);
+  return(L);
+}
+
+/*----------------------------------------------------------------------------------*/
+double Mconj_PoffS(x, y1, y2, a)
+     double x, y1, y2, a;
+{
+  double M;
+
+  M = Sa(x,y1,y2,a,0);
+  M = M/(2.0*M_PI);
+  return(M);
+}
+
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+double Sv(x,y1,y2)
+     double x,y1,y2;
+{
+  double sv;
+
+  sv = (y2-y1)-x*atan3(y2,y1,x);
+  return(sv);
+}
+
+/*----------------------------------------------------------------------------------*/
+double Sw(x,y1,y2)
+     double x,y1,y2;
+{
+  double xsq,y1sq,y2sq,sw;
+
+  xsq=x*x;
+  y1sq=y1*y1;
+  y2sq=y2*y2;
+  sw = log((xsq+y2sq)/(xsq+y1sq))/2.0;
+  return(sw);
+}
+
+/*----------------------------------------------------------------------------------*/
+/* integral of t^k (a+atan3(t,y1,x)) from y1 to y2 (k = 0..3), by parts through    */
+/* the integrals A[n] of t^n x/(x^2+t^2)                                            */
+/*----------------------------------------------------------------------------------*/
+double Sa(x,y1,y2,a,k)
+     double x,y1,y2,a;
+     int k;
+{
+  double xsq,A[5],p1,p2,sa;
+  int n;
+
+  xsq=x*x;
+  A[0]=atan3(y2,y1,x);
+  A[1]=x*log((xsq+y2*y2)/(xsq+y1*y1))/2.0;
+  p1=y1;
+  p2=y2;
+  for(n=2;n<=k+1;n++)
+    {
+      A[n]=x*(p2-p1)/(double)(n-1)-xsq*A[n-2];
+      p1=p1*y1;
+      p2=p2*y2;
+    }
+  /* p1 and p2 are y1^(k+1) and y2^(k+1) */
+  sa = (a*(p2-p1)+p2*A[0]-A[k+1])/(double)(k+1);
+  return(sa);
+}
+
 /*----------------------------------------------------------------------------------*/
 
 /*----------------------------------------------------------------------------------*/
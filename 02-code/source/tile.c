@@ -0,0 +1,197 @@
+/*------------------------------------ tile.c --------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* scan a raster in square tiles, in parallel                                       */
+/*                                                                                  */
+/* The raster is cut into TILE_SIZE x TILE_SIZE tiles, visited in Morton (Z) order  */
+/* so that the tiles a thread takes one after another lie next to each other and   */
+/* mostly in the zone it solved last. Every thread reads its own copy of the        */
+/* catchment (check_each_zone and the bem routines reverse the paths of a zone in   */
+/* place) and has its own bem_vectors. The numbers found at each point go into one  */
+/* array in row order,                                                              */
+/*   out[(j*nx+i)*n_out+k],                                                         */
+/* which the caller writes out once the scan is finished.                           */
+/* Zones already solved in a catchment given to share_solved_zones are not solved  */
+/* again: the copies of the threads point to its boundary vectors (read only).      */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+/*----------------------------------------------------------------------------------*/
+#include "boundary_types.h"
+#include "co_matrix_types.h"
+#include "matrix_types.h"
+#include "ten_matrix_types.h"
+#include "memory_types.h"
+#include "tile_types.h"
+#include "trace_types.h"
+#include "perfcount_types.h"
+
+#include "catchment.h"
+#include "memory.h"
+#include "perfcount.h"
+#include "scan.h"
+#include "trace.h"
+
+#include "tile.h"
+static catchment *shared=(catchment *)NULL;  /* zones solved before the scan */
+/*----------------------------------------------------------------------------------*/
+static void *tile_memory(n)
+     size_t n;
+{
+  void *p;
+
+  p=malloc(n);
+  if(p==NULL)
+    {
+      printf("Cannot allocate memory for raster tiles\n");
+      exit(0);
+    }
+  return(p);
+}
+/*----------------------------------------------------------------------------------*/
+/* boundary vectors of the zones of c to be used by the threads (NULL = none) */
+/*----------------------------------------------------------------------------------*/
+void share_solved_zones(c)
+     catchment *c;
+{
+  shared=c;
+}
+/*----------------------------------------------------------------------------------*/
+/* give (use=1) or take back (use=0) the solved zones of shared to copy c */
+/*----------------------------------------------------------------------------------*/
+static void use_shared_zones(c,use)
+     catchment *c;
+     int use;
+{
+  int k;
+
+  if(shared==(catchment *)NULL || shared->num_zones!=c->num_zones) return;
+  for(k=0;k<c->num_zones;k++)
+    {
+      if(shared->zones[k]->bvv==(double *)NULL ||
+	 shared->zones[k]->bcv==(double *)NULL) continue;
+      if(use==1)
+	{
+	  c->zones[k]->bvv=shared->zones[k]->bvv;
+	  c->zones[k]->bcv=shared->zones[k]->bcv;
+	}
+      else if(c->zones[k]->bvv==shared->zones[k]->bvv)
+	{
+	  c->zones[k]->bvv=(double *)NULL;
+	  c->zones[k]->bcv=(double *)NULL;
+	}
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/* tile numbers (ti + tj*tx) in Morton order */
+/*----------------------------------------------------------------------------------*/
+static int morton_order(tx,ty,order)
+     int tx,ty,*order;
+{
+  int side,n,t,b,ti,tj;
+
+  side=1;
+  while(side<tx || side<ty) side=2*side;
+  n=0;
+  for(t=0;t<side*side;t++)
+    {
+      ti=0;
+      tj=0;
+      for(b=0;(1<<b)<side;b++)
+	{
+	  ti=ti | (((t>>(2*b)) & 1)<<b);
+	  tj=tj | (((t>>(2*b+1)) & 1)<<b);
+	}
+      if(ti<tx && tj<ty)
+	{
+	  order[n]=ti+tj*tx;
+	  n=n+1;
+	}
+    }
+  return(n);
+}
+/*----------------------------------------------------------------------------------*/
+/* f at every point of ras; returns the nx*ny*n_out results in row order */
+/*----------------------------------------------------------------------------------*/
+double *scan_raster_tiles(data,ras,n_out,f,arg)
+     unsigned char *data; /* catchment file */
+     raster *ras;
+     int n_out;      /* numbers kept at each point */
+     tile_function f;
+     void *arg;
+{
+  double *out;
+  int *order,tx,ty,n_tiles,done;
+  perf_sample sample;
+
+  tx=(ras->nx+TILE_SIZE-1)/TILE_SIZE;
+  ty=(ras->ny+TILE_SIZE-1)/TILE_SIZE;
+  order=(int *)tile_memory(tx*ty*sizeof(int));
+  n_tiles=morton_order(tx,ty,order);
+  out=(double *)tile_memory((size_t)ras->nx*ras->ny*n_out*sizeof(double));
+  done=0;
+  perf_begin(&sample);  /* the tiles as a whole; streamline_loop in them is not counted */
+
+#pragma omp parallel
+  {
+    bem_vectors *vectors;
+    catchment *c;
+    coordinates *P;
+    double *tile_out;
+    int t,i,j,i0,j0,n,k;
+    matrix bvv,bcv;
+    trace_span span;
+
+    c=create_catchment(catchment_zones(data),16);
+    get_catchment(data,c);
+    use_shared_zones(c,1);
+    vectors=create_bem_vectors(&bvv,&bcv,max_points_in_any_zone(c));
+    P=(coordinates *)tile_memory(TILE_SIZE*TILE_SIZE*sizeof(coordinates));
+    tile_out=(double *)tile_memory((size_t)TILE_SIZE*TILE_SIZE*n_out*sizeof(double));
+
+#pragma omp for schedule(dynamic,TILE_CHUNK)
+    for(t=0;t<n_tiles;t++)
+      {
+	i0=(order[t]%tx)*TILE_SIZE;
+	j0=(order[t]/tx)*TILE_SIZE;
+	n=0;
+	for(j=j0;j<j0+TILE_SIZE && j<ras->ny;j++)
+	  for(i=i0;i<i0+TILE_SIZE && i<ras->nx;i++)
+	    {
+	      P[n][0]=x_raster(ras,i);
+	      P[n][1]=y_raster(ras,j);
+	      n=n+1;
+	    }
+	trace_begin(&span,"tile","tile");
+	f(c,vectors,n,P,tile_out,arg);
+	trace_end(&span);
+
+	n=0;
+	for(j=j0;j<j0+TILE_SIZE && j<ras->ny;j++)
+	  for(i=i0;i<i0+TILE_SIZE && i<ras->nx;i++)
+	    {
+	      for(k=0;k<n_out;k++)
+		out[((size_t)j*ras->nx+i)*n_out+k]=tile_out[n*n_out+k];
+	      n=n+1;
+	    }
+#pragma omp critical (tile_progress)
+	{
+	  if(done%50==0) printf("\n");
+	  printf("#"); fflush(stdout);
+	  done=done+1;
+	}
+      }
+
+    free((void *)P);
+    free((void *)tile_out);
+    destroy_bem_vectors(vectors);
+    use_shared_zones(c,0);
+    destroy_catchment(c);
+  }
+  printf("\n");
+  perf_end(&sample,PERF_TRACING,0.0);
+
+  free((void *)order);
+  return(out);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
@@ -0,0 +1,123 @@
+/*------------------------------------ trace.c -------------------------------------*/
+/*----------------------------------------------------------------------------------*/
+/* timed spans and a Chrome trace of them                                           */
+/*                                                                                  */
+/* trace_begin and trace_end take the place of a pair of gettimeofday calls; the    */
+/* caller keeps the span and trace_end returns its length in seconds. Spans may     */
+/* nest and may be used in any OpenMP thread. When a trace file has been set        */
+/* (--trace=<file>) every finished span with a category is also kept, and           */
+/* write_trace writes them all as "complete" events in the Chrome trace format      */
+/* (chrome://tracing, ui.perfetto.dev): one row per thread, nested by time. With no */
+/* trace file a span costs the two clock readings it replaces.                      */
+/*----------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <omp.h>
+/*----------------------------------------------------------------------------------*/
+#include "trace_types.h"
+
+#include "trace.h"
+/*----------------------------------------------------------------------------------*/
+static char *trace_file=(char *)NULL;   /* NULL = no trace */
+static double trace_start;
+static trace_event *events=(trace_event *)NULL;
+static int n_events=0;
+static int max_events=0;
+static int depth=0;                     /* spans open in this thread */
+#pragma omp threadprivate(depth)
+/*----------------------------------------------------------------------------------*/
+static double trace_clock()
+{
+  struct timeval t;
+
+  gettimeofday(&t,NULL);
+  return((double)t.tv_sec+(double)t.tv_usec/1000000.0);
+}
+/*----------------------------------------------------------------------------------*/
+void set_trace(file)
+     char *file;
+{
+  trace_file=file;
+  trace_start=trace_clock();
+}
+/*----------------------------------------------------------------------------------*/
+char *get_trace()
+{
+  return(trace_file);
+}
+/*----------------------------------------------------------------------------------*/
+void trace_begin(s,name,category)
+     trace_span *s;
+     char *name,*category;
+{
+  s->name=name;
+  s->category=category;
+  s->depth=depth;
+  depth=depth+1;
+  s->start=trace_clock();
+}
+/*----------------------------------------------------------------------------------*/
+double trace_end(s)
+     trace_span *s;
+{
+  double finish;
+  trace_event *e;
+
+  finish=trace_clock();
+  depth=s->depth;
+  if(trace_file!=(char *)NULL && s->category!=(char *)NULL)
+    {
+#pragma omp critical (trace_events)
+      {
+	if(n_events==max_events)
+	  {
+	    max_events=(max_events==0) ? 4096 : 2*max_events;
+	    events=(trace_event *)realloc(events,max_events*sizeof(trace_event));
+	    if(events==(trace_event *)NULL)
+	      {
+		printf("Cannot allocate memory for the trace\n");
+		exit(0);
+	      }
+	  }
+	e=events+n_events;
+	e->name=s->name;
+	e->category=s->category;
+	e->start=s->start-trace_start;
+	e->length=finish-s->start;
+	e->thread=omp_get_thread_num();
+	e->depth=s->depth;
+	n_events=n_events+1;
+      }
+    }
+  return(finish-s->start);
+}
+/*----------------------------------------------------------------------------------*/
+/* all spans kept so far to the trace file */
+/*----------------------------------------------------------------------------------*/
+void write_trace()
+{
+  FILE *output;
+  int i;
+
+  if(trace_file==(char *)NULL) return;
+  output=fopen(trace_file,"w");
+  if(output==(FILE *)NULL)
+    {
+      printf("Cannot open trace file: '%s'\n",trace_file);
+      exit(0);
+    }
+  fprintf(output,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf(output,"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+	  "\"args\":{\"name\":\"catcharea\"}}");
+  for(i=0;i<n_events;i++)
+    fprintf(output,",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.1f,"
+	    "\"dur\":%.1f,\"pid\":1,\"tid\":%d,\"args\":{\"depth\":%d}}",
+	    events[i].name,events[i].category,events[i].start*1.0e6,
+	    events[i].length*1.0e6,events[i].thread,events[i].depth);
+  fprintf(output,"\n]}\n");
+  fclose(output);
+  printf("  Trace written:        %s (%d spans)\n",trace_file,n_events);
+}
+/*----------------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------------*/
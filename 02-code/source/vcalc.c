@@ -13,16 +13,50 @@
 #include "matrix_types.h"
 #include "ten_matrix_types.h"
 #include "memory_types.h"
+#include "memtrack_types.h"
+#include "stream_types.h"
+#include "logging_types.h"
+#include "trace_types.h"
 
 #include "bsolve.h"
 #include "catchment.h"
 #include "co_matrix.h"
+#include "logging.h"
 #include "matrix.h"
+#include "memtrack.h"
+#include "packet.h"
 #include "path.h"
+#include "surrogate.h"
 #include "ten_matrix.h"
+#include "trace.h"
 
 #include "vcalc.h"
 /*----------------------------------------------------------------------------------*/
+static long bem_evaluations=0; /* number of points at which V, dV and d2V were found */
+static long thread_evaluations=0;  /* the same, on this thread only */
+#pragma omp threadprivate(thread_evaluations)
+/*----------------------------------------------------------------------------------*/
+long get_bem_evaluations()
+{
+  return(bem_evaluations);
+}
+/*----------------------------------------------------------------------------------*/
+/* evaluations made by the calling thread (for the count of one streamline while   */
+/* other threads trace theirs)                                                      */
+/*----------------------------------------------------------------------------------*/
+long get_thread_bem_evaluations()
+{
+  return(thread_evaluations);
+}
+/*----------------------------------------------------------------------------------*/
+void add_bem_evaluations(n)
+     long n;
+{
+#pragma omp atomic
+  bem_evaluations=bem_evaluations+n;
+  thread_evaluations=thread_evaluations+n;
+}
+/*----------------------------------------------------------------------------------*/
 double voltage_on_path(c,s,segment,this_path)
      catchment *c;
      double s;
@@ -50,32 +84,66 @@ double voltage_outside_catchment()
 }
 /*----------------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------------*/
-double calculate_in_same_zone(b,P,x,R)
+/* mask says which of V, dV and d2V are wanted (EVAL_V, EVAL_DV, EVAL_D2V) */
+/*----------------------------------------------------------------------------------*/
+double calculate_in_same_zone(b,P,x,R,mask)
      boundary *b;
      coordinates P;
      bem_vectors *x;
      bem_results *R;
+     int mask;
 {
+  if(surrogate_field(b,P,R)==1) return(R->V);
+  add_bem_evaluations(1L);
   reverse_zone(b);
-  R->V=make_internal_voltage(b,x->bvv,x->bcv,P,x->vgv,x->cgv);
-  make_internal_grad_voltage(b,x->bvv,x->bcv,P,x->co_vgv,x->co_cgv,R->dV);
-  make_internal_sec_grad_voltage(b,x->bvv,x->bcv,P,x->ten_vgv,x->ten_cgv,R->d2V);
+  make_internal_field(b,x->bvv,x->bcv,P,x,R,mask);
   reverse_zone(b);       
 
   return(R->V);
 }
 /*----------------------------------------------------------------------------------*/
-double calculate_in_new_zone(b,P,x,R)
+/* n points in the zone solved last, all in one sweep over its segments */
+/*----------------------------------------------------------------------------------*/
+void calculate_packet_in_zone(b,n,P,x,R)
      boundary *b;
-     coordinates P;
+     int n;
+     coordinates *P;
      bem_vectors *x;
      bem_results *R;
 {
-  int N,k;
+  coordinates Q[MAX_PACKET];
+  int i,m,miss[MAX_PACKET];
+  bem_results S[MAX_PACKET];
 
-  struct timeval start,finish,start2,finish2;
-  double duration;
+  m=0;
+  for(i=0;i<n;i++)
+    if(surrogate_field(b,P[i],&R[i])==0)
+      {
+	miss[m]=i;
+	Q[m][0]=P[i][0];
+	Q[m][1]=P[i][1];
+	m=m+1;
+      }
+  if(m==0) return;
+  add_bem_evaluations((long)m);
+  if(m==n)
+    {
+      packet_field(b,startof_matrix(x->bvv),startof_matrix(x->bcv),n,P,R);
+      return;
+    }
+  packet_field(b,startof_matrix(x->bvv),startof_matrix(x->bcv),m,Q,S);
+  for(i=0;i<m;i++) R[miss[i]]=S[i];
+}
+/*----------------------------------------------------------------------------------*/
+/* boundary vectors of zone b (kept in b->bvv and b->bcv), vectors x sized for it */
+/*----------------------------------------------------------------------------------*/
+void solve_zone(b,x)
+     boundary *b;
+     bem_vectors *x;
+{
+  int N,k,phase;
 
+  phase=set_memory_phase(MEM_SOLVE);
   N=0;
   for(k=0;k<b->components;k++)  N=N+b->loop[k]->points;
 
@@ -90,8 +158,29 @@ double calculate_in_new_zone(b,P,x,R)
   attach_ten_matrix(x->ten_vgv,1,2*N,startof_ten_matrix(x->ten_vgv));
 
   reverse_zone(b);
-
   make_boundary_vector(b,x->bvv,x->bcv);
+  reverse_zone(b);
+  set_memory_phase(phase);
+}
+/*----------------------------------------------------------------------------------*/
+double calculate_in_new_zone(b,P,x,R,mask)
+     boundary *b;
+     coordinates P;
+     bem_vectors *x;
+     bem_results *R;
+     int mask;
+{
+  trace_span span,zone_span;
+  double duration;
+  int verbose;
+
+  add_bem_evaluations(1L);
+  verbose=log_on(LOG_DEBUG,LOG_ZONE);
+  trace_begin(&zone_span,"calculate_in_new_zone","zone");
+  trace_begin(&span,"solve_zone","zone");
+  solve_zone(b,x);
+  trace_end(&span);
+  reverse_zone(b);
 
   /*
   show_matrix(x->bvv);
@@ -99,45 +188,140 @@ double calculate_in_new_zone(b,P,x,R)
   */
 
  /*---------------------------------------------------*/
-printf("\n----------- [vcalc.c] Post processing after make_boundary_vector() -----------\n");
-printf("Please wait..");
+if(verbose)
+  {
+    printf("\n----------- [vcalc.c] Post processing after make_boundary_vector() -----------\n");
+    printf("Please wait..");
+  }
 /*---------------------------------------------------*/
 
-gettimeofday(&start, NULL);  
-  R->V=make_internal_voltage(b,x->bvv,x->bcv,P,x->vgv,x->cgv);  //-- org ---   
+trace_begin(&span,"make_internal_field","zone");
+  make_internal_field(b,x->bvv,x->bcv,P,x,R,mask);  //-- org ---   
 /*---------------------------------------------------*/
-gettimeofday(&finish, NULL);
-duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-printf("\n\nmake_internal_voltage() took: %lf seconds\n", duration);
+duration = trace_end(&span);
+if(verbose) printf("\n\nmake_internal_field() took: %lf seconds\n", duration);
 /*---------------------------------------------------*/
 
-gettimeofday(&start, NULL);  
-  make_internal_grad_voltage(b,x->bvv,x->bcv,P,x->co_vgv,x->co_cgv,R->dV);  //-- org ---   
-/*---------------------------------------------------*/
-gettimeofday(&finish, NULL);
-duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-printf("make_internal_grad_voltage() took: %lf seconds\n", duration);
-/*---------------------------------------------------*/
-
-gettimeofday(&start, NULL);    
-  make_internal_sec_grad_voltage(b,x->bvv,x->bcv,P,x->ten_vgv,x->ten_cgv,R->d2V);  //-- org ---   
-/*---------------------------------------------------*/
-gettimeofday(&finish, NULL);
-duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-printf("make_internal_sec_grad_voltage() took: %lf seconds\n", duration);
-/*---------------------------------------------------*/
-
-gettimeofday(&start, NULL);  
   reverse_zone(b);  //-- org ---     
-/*---------------------------------------------------*/
-gettimeofday(&finish, NULL);
-duration = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
-printf("reverse_zone(() took: %lf seconds\n", duration);
-/*---------------------------------------------------*/
 
+  trace_end(&zone_span);
+  surrogate_zone_solved(b,x);
   return(R->V);
 }
 /*----------------------------------------------------------------------------------*/
+/*------stream function-----------------------------------*/
+/*----------------------------------------------------------------------------------*/
+#define CUT_STEPS 40      /* bisections to find where a step crosses a contour */
+#define MAX_CROSSINGS 8   /* contours one step may cross */
+/*----------------------------------------------------------------------------------*/
+/* zone k ready for make_internal_stream_function: x attached to its vectors, by   */
+/* solve_zone unless it is the zone of the last point (a zone is solved only once,  */
+/* so that is cheap); the next calculate_inside_catchment then starts afresh        */
+/*----------------------------------------------------------------------------------*/
+static boundary *stream_zone(c,k,x)
+     catchment *c;
+     int k;
+     bem_vectors *x;
+{
+  boundary *b;
+
+  b=c->zones[k];
+  if(k!=c->previous_zone)
+    {
+      solve_zone(b,x);
+      c->previous_zone=(-1);
+    }
+  return(b);
+}
+/*----------------------------------------------------------------------------------*/
+/* psi(Q)-psi(P) along the straight line PQ in zone k */
+/*----------------------------------------------------------------------------------*/
+static double stream_in_zone(c,k,P,Q,x)
+     catchment *c;
+     int k;
+     coordinates P,Q;
+     bem_vectors *x;
+{
+  boundary *b;
+  double psi;
+
+  b=stream_zone(c,k,x);
+  add_bem_evaluations(2L);
+  reverse_zone(b);
+  psi=make_internal_stream_function(b,x->bvv,x->bcv,P,Q);
+  reverse_zone(b);
+  return(psi);
+}
+/*----------------------------------------------------------------------------------*/
+/* stream function at the n points xy of a line of straight steps, psi[0]=0. A step */
+/* that crosses a contour is cut where it does and psi is carried over the cut, so  */
+/* the constants of the zones on the two sides match there. Points outside the      */
+/* catchment keep the psi of the last point inside.                                 */
+/*----------------------------------------------------------------------------------*/
+void stream_function_along(c,n,xy,x,psi)
+     catchment *c;
+     int n;
+     coordinates *xy;
+     bem_vectors *x;
+     double *psi;
+{
+  coordinates P,lo,hi,mid;
+  int i,j,m,za;
+
+  psi[0]=0.0;
+  for(i=1;i<n;i++)
+    {
+      psi[i]=psi[i-1];
+      P[0]=xy[i-1][0];
+      P[1]=xy[i-1][1];
+      za=check_each_zone(c,P);
+      for(m=0;za>=0 && m<MAX_CROSSINGS;m++)
+	{
+	  if(check_each_zone(c,xy[i])==za)
+	    {
+	      psi[i]=psi[i]+stream_in_zone(c,za,P,xy[i],x);
+	      break;
+	    }
+	  lo[0]=P[0];      lo[1]=P[1];
+	  hi[0]=xy[i][0];  hi[1]=xy[i][1];
+	  for(j=0;j<CUT_STEPS;j++)
+	    {
+	      mid[0]=(lo[0]+hi[0])/2.0;
+	      mid[1]=(lo[1]+hi[1])/2.0;
+	      if(check_each_zone(c,mid)==za) { lo[0]=mid[0]; lo[1]=mid[1]; }
+	      else                           { hi[0]=mid[0]; hi[1]=mid[1]; }
+	    }
+	  psi[i]=psi[i]+stream_in_zone(c,za,P,lo,x);
+	  P[0]=hi[0];
+	  P[1]=hi[1];
+	  za=check_each_zone(c,P);
+	}
+    }
+}
+/*----------------------------------------------------------------------------------*/
+/* gradient of the stream function at P; returns the zone of P (-1 outside, Gs=0)   */
+/*----------------------------------------------------------------------------------*/
+int stream_gradient(c,P,x,Gs)
+     catchment *c;
+     coordinates P;
+     bem_vectors *x;
+     coordinates Gs;
+{
+  boundary *b;
+  int k;
+
+  Gs[0]=0.0;
+  Gs[1]=0.0;
+  k=check_each_zone(c,P);
+  if(k<0) return(k);
+  b=stream_zone(c,k,x);
+  add_bem_evaluations(1L);
+  reverse_zone(b);
+  make_internal_grad_stream(b,x->bvv,x->bcv,P,x->co_vgv,x->co_cgv,Gs);
+  reverse_zone(b);
+  return(k);
+}
+/*----------------------------------------------------------------------------------*/
 /*------calculate on the path-----------------------------*/
 /*----------------------------------------------------------------------------------*/
 #if 0
@@ -165,18 +349,32 @@ void calculate_on_path(state,P,dP,r0)
 /*----------------------------------------------------------------------------------*/
 /*------calculate inside the catchment--------------------*/
 /*----------------------------------------------------------------------------------*/
-double calculate_inside_catchment(c,P,vectors,voltage,new_z)
+double calculate_inside_catchment(c,P,vectors,voltage,new_z,mask)
+     catchment *c;
+     coordinates P;
+     int *new_z;
+     bem_vectors *vectors;
+     bem_results *voltage;
+     int mask;
+{
+  return(calculate_in_zone(c,check_each_zone(c,P),P,vectors,voltage,new_z,mask));
+}
+/*----------------------------------------------------------------------------------*/
+/* the same for P already found in zone this_zone (check_each_zone) */
+/*----------------------------------------------------------------------------------*/
+double calculate_in_zone(c,this_zone,P,vectors,voltage,new_z,mask)
      catchment *c;
+     int this_zone;
      coordinates P;
      int *new_z;
      bem_vectors *vectors;
      bem_results *voltage;
+     int mask;
 {
-  int this_zone,previous_zone;
+  int previous_zone;
   double pp;
   boundary *bb;
 
-  this_zone=check_each_zone(c,P);
   previous_zone=c->previous_zone;
   if(this_zone<0)           /* outside catchment */
     {
@@ -194,13 +392,13 @@ double calculate_inside_catchment(c,P,vectors,voltage,new_z)
       if(this_zone==previous_zone) /* same zone */
 	{
 	  (*new_z)=0;
-	  pp=calculate_in_same_zone(bb,P,vectors,voltage);
+	  pp=calculate_in_same_zone(bb,P,vectors,voltage,mask);
 	}
       else		   /* new zone */
 	{
 	  c->previous_zone=this_zone;
 	  (*new_z)=1;
-	  pp=calculate_in_new_zone(bb,P,vectors,voltage);
+	  pp=calculate_in_new_zone(bb,P,vectors,voltage,mask);
 	}
     }
   return(pp);